@@ -54,6 +54,8 @@
 /* USER CODE BEGIN 0 */
   extern void configureTimerForRunTimeStats(void);
   extern unsigned long getRunTimeCounterValue(void);
+  /* TRACE_ENABLE=1时定义traceXXX内核钩子 */
+  #include "trace.h"
 /* USER CODE END 0 */
 #endif
 #ifndef CMSIS_device_header
@@ -76,10 +78,12 @@
 #define configMAX_TASK_NAME_LEN                  ( 16 )
 #define configGENERATE_RUN_TIME_STATS            1
 #define configUSE_TRACE_FACILITY                 1
-#define configUSE_STATS_FORMATTING_FUNCTIONS     1
+#define configUSE_STATS_FORMATTING_FUNCTIONS     0
 #define configUSE_16_BIT_TICKS                   0
 #define configUSE_MUTEXES                        1
 #define configQUEUE_REGISTRY_SIZE                8
+#define configCHECK_FOR_STACK_OVERFLOW           2
+#define configUSE_MALLOC_FAILED_HOOK             1
 #define configUSE_RECURSIVE_MUTEXES              1
 #define configUSE_COUNTING_SEMAPHORES            1
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION  0
@@ -177,6 +181,8 @@ standard names. */
 
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+/* ulTaskGetIdleRunTimeCounter() for the CPU load in the USB telemetry */
+#define INCLUDE_xTaskGetIdleTaskHandle       1
 /* USER CODE END Defines */
 
 #endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,108 @@
+/**
+******************************************************************************
+* @file           : bootprof.h
+* @brief          : 启动过程计时
+* @date           : 2025
+******************************************************************************
+* @attention
+*
+* Reset_Handler第一条指令就使能DWT周期计数器(CYCCNT从0开始)，之后在
+* 各启动阶段结束处(CubeMX生成函数末尾的USER CODE段)调用BootProf_Mark()
+* 记下CYCCNT。USB枚举完成后由BootProf_Poll()按时间顺序把每个阶段的时刻
+* 和耗时记入TLOG(每次调用一条)，之后新出现的阶段(第一次播放)再补记一条。
+*
+* 时间换算: SystemClock_Config之前HCLK为HSI(16MHz)，之后为SystemCoreClock
+* (96MHz)，SystemClock_Config本身按16MHz计(切换到PLL是它的最后一步)。
+* CYCCNT约44秒回绕，上电后这么久还没有枚举的话计时没有意义。
+*
+* SystemInit在__main分散加载之前运行，时间戳数组放在UNINIT段(.bss.noinit)
+* 中，不会被清零；BootProf_Init()在main入口清除上一次复位留下的其余项。
+*
+* 编译期开关: BOOTPROF_ENABLE=0时全部为空。
+*
+******************************************************************************
+*/
+
+#ifndef __BOOTPROF_H__
+#define __BOOTPROF_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+/* 配置选项
+ * -------------------------------------------------------------------*/
+
+#ifndef BOOTPROF_ENABLE
+#define BOOTPROF_ENABLE 1
+#endif
+
+/* 类型定义
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief 启动阶段, 时间戳记在阶段结束处
+ */
+typedef enum {
+  BOOT_MS_RESET = 0,  // Reset_Handler使能CYCCNT(恒为0)
+  BOOT_MS_SYSINIT,    // SystemInit: FPU、向量表复制到SRAM
+  BOOT_MS_MAIN,       // __main: 分散加载(RAM代码、RW/ZI)
+  BOOT_MS_HAL,        // HAL_Init
+  BOOT_MS_CLOCK,      // SystemClock_Config: HSE + PLL 96MHz
+  BOOT_MS_USB,        // MX_USB_DEVICE_Init: USBD_Start上拉D+
+  BOOT_MS_GPIO_DMA,   // MX_GPIO_Init + MX_DMA_Init(没有USER CODE段, 在MX_I2S2_Init开头记)
+  BOOT_MS_I2S2,       // MX_I2S2_Init
+  BOOT_MS_TIM5,       // MX_TIM5_Init(默认任务中)
+  BOOT_MS_USART1,     // MX_USART1_UART_Init(默认任务中)
+  BOOT_MS_TIM3,       // MX_TIM3_Init(默认任务中)
+  BOOT_MS_APP,        // main中其余初始化
+  BOOT_MS_KERNEL,     // 调度器启动, 默认任务开始运行
+  BOOT_MS_ENUM,       // SET_CONFIGURATION, 枚举完成
+  BOOT_MS_AUDIO,      // 主机第一次开始播放
+  BOOT_MS_NUM
+} BootProf_MilestoneTypeDef;
+
+/* 函数声明
+ * -------------------------------------------------------------------*/
+
+#if BOOTPROF_ENABLE
+
+extern uint32_t bootprof_cycles[BOOT_MS_NUM];
+
+/**
+ * @brief  记录一个阶段, 只记第一次
+ * @note   可在中断中及__main之前调用
+ */
+static inline void BootProf_Mark(BootProf_MilestoneTypeDef ms) {
+  if (bootprof_cycles[ms] == 0U) {
+    bootprof_cycles[ms] = DWT->CYCCNT;
+  }
+}
+
+/**
+ * @brief  清除上次复位留下的时间戳并记录BOOT_MS_MAIN, 在main入口调用
+ */
+void BootProf_Init(void);
+
+/**
+ * @brief  枚举完成后记录启动时间, 在任务中周期调用
+ */
+void BootProf_Poll(void);
+
+#else
+
+#define BootProf_Mark(ms) ((void)0)
+#define BootProf_Init() ((void)0)
+#define BootProf_Poll() ((void)0)
+
+#endif /* BOOTPROF_ENABLE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BOOTPROF_H__ */
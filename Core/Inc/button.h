@@ -0,0 +1,124 @@
+/**
+******************************************************************************
+* @file           : button.h
+* @brief          : 通用按键消抖与手势识别（平台无关）
+* @date           : 2025
+******************************************************************************
+* @attention
+*
+* 积分器消抖 + 手势状态机，与rotary.h一样只通过函数指针读引脚，
+* 不依赖任何硬件，可直接在PC上用录下的抖动波形回放验证。
+*
+* 消抖: 每次调用采样一次，按下则积分器+1、松开则-1，范围
+*       0~BUTTON_INTEGRATOR_MAX；到达上限才认为按下，回到0才认为松开。
+*       抖动只会让积分器来回摆动，不会产生多余的按下/松开。
+*
+* 手势(以调用次数计时，1ms调用一次时单位即ms):
+*   BUTTON_EVT_PRESS    稳定按下
+*   BUTTON_EVT_RELEASE  稳定松开
+*   BUTTON_EVT_LONG     按住BUTTON_LONG_TICKS
+*   BUTTON_EVT_REPEAT   长按之后每BUTTON_REPEAT_TICKS一次
+*   BUTTON_EVT_DOUBLE   短按松开后BUTTON_DOUBLE_TICKS内再次按下
+*                       (与第二次的PRESS同时给出)
+*
+* 使用说明：
+*   1. 实现一个GPIO读取函数
+*   2. 在初始化时将函数指针和有效电平传入
+*   3. 以固定周期调用Button_Process()，处理返回的事件位
+*
+******************************************************************************
+*/
+
+#ifndef __BUTTON_H__
+#define __BUTTON_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* 配置选项
+ * -------------------------------------------------------------------*/
+
+#ifndef BUTTON_INTEGRATOR_MAX
+#define BUTTON_INTEGRATOR_MAX 5U   // 积分器上限(调用次数)
+#endif
+
+#ifndef BUTTON_LONG_TICKS
+#define BUTTON_LONG_TICKS 800U     // 长按阈值
+#endif
+
+#ifndef BUTTON_REPEAT_TICKS
+#define BUTTON_REPEAT_TICKS 150U   // 长按后的重复间隔
+#endif
+
+#ifndef BUTTON_DOUBLE_TICKS
+#define BUTTON_DOUBLE_TICKS 300U   // 双击: 松开到再次按下的最大间隔
+#endif
+
+/* 事件定义(可同时出现多个)
+ * -----------------------------------------------------------------*/
+
+#define BUTTON_EVT_NONE 0x00U
+#define BUTTON_EVT_PRESS 0x01U
+#define BUTTON_EVT_RELEASE 0x02U
+#define BUTTON_EVT_LONG 0x04U
+#define BUTTON_EVT_REPEAT 0x08U
+#define BUTTON_EVT_DOUBLE 0x10U
+
+/* 类型定义
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief GPIO读取函数指针类型
+ * @param user_data: 用户自定义数据
+ * @retval true=高电平, false=低电平
+ */
+typedef bool (*Button_ReadPinFunc)(void *user_data);
+
+/**
+ * @brief 按键句柄结构体
+ * @note  每个按键需要一个独立的句柄实例
+ */
+typedef struct {
+  Button_ReadPinFunc read_pin; /**< 引脚读取函数指针 */
+  void *user_data;             /**< 传给read_pin的用户数据 */
+  bool active_level;           /**< 按下时的电平 */
+
+  uint8_t integrator;          /**< 消抖积分器（内部使用） */
+  bool pressed;                /**< 消抖后的状态（内部使用） */
+  bool long_fired;             /**< 本次按下已触发长按（内部使用） */
+  bool double_armed;           /**< 上次是短按，可构成双击（内部使用） */
+  bool was_double;             /**< 本次按下是双击（内部使用） */
+  uint16_t timer;              /**< 按住/松开计时（内部使用） */
+} Button_HandleTypeDef;
+
+/* 函数声明
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  初始化按键
+ * @param  hbutton: 按键句柄指针
+ * @param  read_pin: 引脚读取函数
+ * @param  user_data: 传递给read_pin的用户数据
+ * @param  active_level: 按下时的电平(上拉接地的按键为false)
+ */
+void Button_Init(Button_HandleTypeDef *hbutton, Button_ReadPinFunc read_pin,
+                 void *user_data, bool active_level);
+
+/**
+ * @brief  采样一次并推进手势状态机
+ * @param  hbutton: 按键句柄指针
+ * @retval BUTTON_EVT_xxx的组合, 无事件时为BUTTON_EVT_NONE
+ * @note   以固定周期调用(推荐1ms)，计时均以调用次数为单位
+ */
+uint8_t Button_Process(Button_HandleTypeDef *hbutton);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BUTTON_H__ */
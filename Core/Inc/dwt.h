@@ -0,0 +1,62 @@
+/**
+******************************************************************************
+* @file           : dwt.h
+* @brief          : DWT周期计数器(CYCCNT)辅助函数
+* @date           : 2025
+******************************************************************************
+* @attention
+*
+* CYCCNT是Cortex-M4内核自带的32位周期计数器，随HCLK(96MHz)递增，
+* 约44.7秒回绕一次。用于ISR/函数耗时测量、启动计时和运行时统计。
+*
+* 使用前调用一次DWT_Init()，之后用DWT_GetCycles()读取当前周期数，
+* 两次读数相减(无符号)即为经过的周期数，回绕时结果依然正确。
+*
+******************************************************************************
+*/
+
+#ifndef __DWT_H__
+#define __DWT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx.h"
+
+/* 函数实现
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  使能DWT周期计数器
+ * @note   重复调用是安全的，已经启动时不会清零计数值
+ */
+static inline void DWT_Init(void) {
+  if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0U) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0U;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  }
+}
+
+/**
+ * @brief  读取当前周期数
+ * @retval CYCCNT值(HCLK周期)
+ */
+static inline uint32_t DWT_GetCycles(void) { return DWT->CYCCNT; }
+
+/**
+ * @brief  周期数转换为微秒
+ * @param  cycles: 周期数
+ * @retval 微秒
+ */
+static inline uint32_t DWT_CyclesToUs(uint32_t cycles) {
+  return cycles / (SystemCoreClock / 1000000U);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DWT_H__ */
@@ -0,0 +1,150 @@
+/**
+******************************************************************************
+* @file           : health.h
+* @brief          : 二进制任务健康快照(RTT通道2)
+* @date           : 2025
+******************************************************************************
+* @attention
+*
+* 用uxTaskGetSystemState()一次取出全部任务状态，编码成定长二进制记录
+* 写入RTT上行通道HEALTH_RTT_CHANNEL("Health")，格式化交给主机端
+* Tools/health_decode.py，目标端不做任何sprintf。
+*
+* 每次快照写一条记录:
+*   Health_HeaderTypeDef + ntasks * Health_TaskTypeDef
+* 首次见到某个任务号时先写一条Health_NameTypeDef，主机据此显示任务名。
+*
+* 运行时间单位与FreeRTOS运行时统计相同(DWT周期 >> RTSTATS_PRESCALE_SHIFT)，
+* 均为相对上一次快照的增量，占用率 = 任务增量 / run_delta。
+*
+* 内存水位:
+*   - 任务栈: uxTaskGetSystemState()给出的栈剩余最小值
+*   - 堆: 当前/历史最小剩余，vPortGetHeapStats()的最大空闲块和空闲块数
+*     反映碎片；pvPortMalloc失败由vApplicationMallocFailedHook计数
+*   - MSP(中断栈): Health_Init()把启动文件STACK段中当前SP以下的部分
+*     涂成HEALTH_PAINT，快照时从栈底向上找第一个被改写的字
+*   - USB类数据池: USBD_static_pool_stats()给出的池大小和历史最大使用，
+*     分配失败时置位告警
+* 任一项越过下面的阈值时置位warn对应位，新出现的告警再用TLOG记录一条。
+* 任务栈溢出由configCHECK_FOR_STACK_OVERFLOW=2检查，钩子中停机。
+*
+* 所有多字节字段均为小端。
+*
+******************************************************************************
+*/
+
+#ifndef __HEALTH_H__
+#define __HEALTH_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+/* 配置
+ * -------------------------------------------------------------------*/
+
+#define HEALTH_RTT_CHANNEL 2U     // RTT上行通道号
+#define HEALTH_BUFFER_SIZE 512U   // 通道缓冲大小
+#define HEALTH_MAX_TASKS 12U      // 单次快照最多任务数
+#define HEALTH_MAX_NUMBER 32U     // 跟踪增量的最大任务号(uxTCBNumber)
+#define HEALTH_NAME_LEN 16U       // configMAX_TASK_NAME_LEN
+
+#define HEALTH_STACK_WARN_WORDS 32U   // 任务栈剩余最小值低于此值告警(字)
+#define HEALTH_HEAP_WARN_BYTES 1024U  // 堆历史最小剩余低于此值告警
+#define HEALTH_BLOCK_WARN_BYTES 512U  // 最大空闲块低于此值告警(碎片)
+#define HEALTH_MSP_WARN_BYTES 512U    // MSP剩余低于此值告警
+#define HEALTH_PAINT 0xA5A5A5A5U      // MSP涂色值
+
+/* 协议定义
+ * -------------------------------------------------------------------*/
+
+#define HEALTH_SYNC 0xA5U           // 记录起始字节
+#define HEALTH_REC_SNAPSHOT 0x01U   // 快照
+#define HEALTH_REC_NAME 0x02U       // 任务名
+
+#define HEALTH_WARN_STACK 0x01U     // 有任务栈剩余低于阈值
+#define HEALTH_WARN_HEAP 0x02U      // 堆历史最小剩余低于阈值
+#define HEALTH_WARN_FRAG 0x04U      // 最大空闲块低于阈值
+#define HEALTH_WARN_MSP 0x08U       // MSP剩余低于阈值
+#define HEALTH_WARN_MALLOC 0x10U    // 发生过pvPortMalloc失败
+#define HEALTH_WARN_USB_POOL 0x20U  // USB类数据池分配失败过
+
+/* 类型定义
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief 快照头 (HEALTH_REC_SNAPSHOT)
+ */
+typedef __PACKED_STRUCT {
+  uint8_t sync;            // HEALTH_SYNC
+  uint8_t type;            // HEALTH_REC_SNAPSHOT
+  uint8_t ntasks;          // 之后的任务条目数
+  uint8_t dropped;         // RTT缓冲满被丢弃的快照数(饱和到255)
+  uint32_t tick;           // xTaskGetTickCount()
+  uint32_t run_delta;      // 总运行时间增量
+  uint32_t heap_free;      // xPortGetFreeHeapSize()
+  uint32_t heap_min;       // xPortGetMinimumEverFreeHeapSize()
+  uint32_t heap_largest;   // 最大空闲块
+  uint16_t heap_blocks;    // 空闲块数
+  uint16_t msp_used;       // MSP历史最大使用(字节)
+  uint16_t msp_size;       // MSP总大小(字节)
+  uint8_t warn;            // HEALTH_WARN_xxx
+  uint8_t malloc_failed;   // pvPortMalloc失败次数(饱和到255)
+  uint32_t cycles;         // 上一次快照本身耗费的DWT周期数
+  uint16_t usb_pool_size;  // USB类数据池大小(字节)
+  uint16_t usb_pool_high;  // USB类数据池历史最大使用(字节)
+} Health_HeaderTypeDef;
+
+/**
+ * @brief 任务条目
+ */
+typedef __PACKED_STRUCT {
+  uint8_t number;          // uxTCBNumber
+  uint8_t state;           // eTaskState: 0运行 1就绪 2阻塞 3挂起 4删除
+  uint8_t prio;            // 当前优先级
+  uint8_t base_prio;       // 基础优先级(优先级继承前)
+  uint16_t stack_hwm;      // 栈剩余最小值(字)
+  uint16_t reserved;
+  uint32_t run_delta;      // 运行时间增量
+} Health_TaskTypeDef;
+
+/**
+ * @brief 任务名 (HEALTH_REC_NAME)
+ */
+typedef __PACKED_STRUCT {
+  uint8_t sync;            // HEALTH_SYNC
+  uint8_t type;            // HEALTH_REC_NAME
+  uint8_t number;          // uxTCBNumber
+  uint8_t reserved;
+  char name[HEALTH_NAME_LEN];
+} Health_NameTypeDef;
+
+/* 函数声明
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  配置RTT健康通道并给MSP涂色
+ * @note   在main中TLog_Init()之前调用, 先占用固定通道号
+ */
+void Health_Init(void);
+
+/**
+ * @brief  采集并发送一次快照
+ * @note   只在任务中调用
+ */
+void Health_Snapshot(void);
+
+/**
+ * @brief  记录一次pvPortMalloc失败(vApplicationMallocFailedHook中调用)
+ */
+void Health_MallocFailed(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HEALTH_H__ */
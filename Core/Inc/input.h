@@ -0,0 +1,102 @@
+/**
+******************************************************************************
+* @file           : input.h
+* @brief          : 按键事件队列与输入任务
+* @date           : 2025
+******************************************************************************
+* @attention
+*
+* TIM5的1ms中断调用Input_Tick()：按键由button.c积分器消抖并识别
+* 按下/松开/长按/重复/双击，每个手势作为带DWT时间戳的事件写入无锁环形
+* 队列，再用线程标志唤醒输入任务。输入任务阻塞等待标志，有事件才运行，
+* 发送HID媒体键等都在任务中完成。
+*
+* 编码器每完成一步也投递一个事件(EXTI1/2边沿中断中解码，或TIM5轮询)，
+* 时间戳即该步的时刻，value为加速后的步数，音量键在输入任务中按步数发送。
+*
+* 队列只有一个写端(优先级5的中断，彼此不会抢占)和一个读端(输入任务)，
+* 读写索引各自只由一方修改，不需要关中断。队列满时丢弃新事件并计数。
+*
+* 任务中调用USBD_HID_SendKey()时进入临界区(BASEPRI屏蔽OTG_FS/TIM5)，
+* 满足HID驱动对调用优先级的要求。
+*
+******************************************************************************
+*/
+
+#ifndef __INPUT_H__
+#define __INPUT_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* 配置
+ * -------------------------------------------------------------------*/
+
+#define INPUT_QUEUE_LEN 16U        // 事件队列深度(2的幂)
+
+/* 类型定义
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief 按键
+ */
+typedef enum {
+  INPUT_BTN_KEY = 0,     // KEY(PA0), 静音
+  INPUT_BTN_ROTARY_SW,   // 编码器按键, 播放/暂停
+  INPUT_BTN_NUM
+} Input_ButtonTypeDef;
+
+/**
+ * @brief 事件类型
+ */
+typedef enum {
+  INPUT_EVT_PRESS = 0,   // 按下(消抖后)
+  INPUT_EVT_RELEASE,     // 松开
+  INPUT_EVT_LONG,        // 长按
+  INPUT_EVT_REPEAT,      // 长按后重复
+  INPUT_EVT_DOUBLE,      // 双击(紧跟第二次PRESS)
+  INPUT_EVT_ROTARY_CW,   // 编码器顺时针一步, 音量+
+  INPUT_EVT_ROTARY_CCW,  // 编码器逆时针一步, 音量-
+} Input_EventTypeTypeDef;
+
+/**
+ * @brief 输入事件
+ */
+typedef struct {
+  uint8_t type;          // Input_EventTypeTypeDef
+  uint8_t button;        // Input_ButtonTypeDef, 编码器事件为0
+  uint16_t value;        // 编码器步数(按键事件为0)
+  uint32_t ts;           // DWT周期数
+} Input_EventTypeDef;
+
+/* 函数声明
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  创建事件队列和输入任务(MX_FREERTOS_Init中调用)
+ */
+void Input_Init(void);
+
+/**
+ * @brief  按键采样, 在TIM5的1ms中断中调用
+ */
+void Input_Tick(void);
+
+/**
+ * @brief  中断中投递一个事件
+ * @param  type: Input_EventTypeTypeDef
+ * @param  button: Input_ButtonTypeDef
+ * @param  value: 编码器步数, 按键事件为0
+ * @note   只能在优先级5的中断中调用(单写端)
+ */
+void Input_PostFromISR(uint8_t type, uint8_t button, uint16_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __INPUT_H__ */
@@ -0,0 +1,112 @@
+/**
+******************************************************************************
+* @file           : irq_prof.h
+* @brief          : 中断延迟与执行时间剖析
+* @date           : 2025
+******************************************************************************
+* @attention
+*
+* 编译期开关: 在工程宏定义中加入 IRQ_PROF_ENABLE=1 才会生效，
+* 默认关闭时所有宏展开为空，延迟参数表达式也不会被求值，没有任何开销。
+*
+* 对每个被剖析的中断(与runtime_stats.h使用同一组编号)记录:
+*   - 执行时间: 入口/出口DWT周期数之差, min/max/mean + 对数直方图
+*   - 延迟: 从硬件事件到进入ISR的周期数, 只对能从外设反推事件时刻的中断测量
+*       TIM5:        计数器从更新事件开始计数, CNT*(PSC+1)即延迟
+*       DMA1_Stream4: 半传输/传输完成时NDTR已知, 进入时NDTR少了多少个半字
+*                    乘以半字周期即延迟(分辨率约1000周期)
+*     OTG_FS和EXTI没有硬件时间戳，延迟记为0
+*   - 排队: 进入时距上一个被剖析ISR退出不到IRQ_PROF_CHAIN_CYCLES，
+*     认为本中断在等它(尾链), 按"被谁挡住"计数
+*
+* 直方图第i格统计 [2^(i+6), 2^(i+7)) 周期，第0格包含更小的值，
+* 最后一格包含更大的值。96MHz下第0格<1.3us，第7格>=85us。
+*
+* 所有被剖析中断优先级相同(5)，互不抢占，统计数据无需加锁；
+* 任务中读取时关中断拷贝。
+*
+******************************************************************************
+*/
+
+#ifndef __IRQ_PROF_H__
+#define __IRQ_PROF_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "stm32f4xx.h"
+#include "runtime_stats.h"
+
+/* 配置
+ * -------------------------------------------------------------------*/
+
+#ifndef IRQ_PROF_ENABLE
+#define IRQ_PROF_ENABLE 0
+#endif
+
+#define IRQ_PROF_BUCKETS 8U        // 直方图格数
+#define IRQ_PROF_CHAIN_CYCLES 48U  // 尾链判定阈值(退出到下一个入口)
+
+#if IRQ_PROF_ENABLE
+
+/* 类型定义
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief 单个时间量的统计
+ */
+typedef struct {
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+  uint32_t hist[IRQ_PROF_BUCKETS];
+} IrqProf_StatTypeDef;
+
+/**
+ * @brief 单个中断的剖析数据
+ */
+typedef struct {
+  uint32_t count;
+  IrqProf_StatTypeDef exec;               // 执行时间
+  IrqProf_StatTypeDef latency;            // 事件到入口
+  uint32_t blocked_by[RTS_ISR_NUM];       // 尾链在哪个中断之后
+} IrqProf_TypeDef;
+
+/* 函数声明
+ * -------------------------------------------------------------------*/
+
+void IrqProf_Enter(RTStats_IsrTypeDef id, uint32_t t0, uint32_t latency);
+void IrqProf_Exit(RTStats_IsrTypeDef id, uint32_t t0, uint32_t t1);
+uint32_t IrqProf_DmaLatency(void);
+void IrqProf_Get(RTStats_IsrTypeDef id, IrqProf_TypeDef *out, uint8_t reset);
+void IrqProf_Print(void);
+
+/**
+ * @brief  TIM5入口延迟: 计数器自更新事件以来的计数乘以预分频
+ * @note   TIM5时钟(APB1x2)等于HCLK
+ */
+static inline uint32_t IrqProf_Tim5Latency(void) {
+  return TIM5->CNT * (TIM5->PSC + 1U);
+}
+
+/* 剖析宏, t0为入口处DWT_GetCycles() */
+#define IRQ_PROF_ENTER(id, t0, latency) IrqProf_Enter((id), (t0), (latency))
+#define IRQ_PROF_EXIT(id, t0) IrqProf_Exit((id), (t0), DWT->CYCCNT)
+#define IRQ_PROF_PRINT() IrqProf_Print()
+
+#else
+
+#define IRQ_PROF_ENTER(id, t0, latency) ((void)0)
+#define IRQ_PROF_EXIT(id, t0) ((void)0)
+#define IRQ_PROF_PRINT() ((void)0)
+
+#endif /* IRQ_PROF_ENABLE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IRQ_PROF_H__ */
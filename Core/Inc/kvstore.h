@@ -0,0 +1,142 @@
+/**
+******************************************************************************
+* @file           : kvstore.h
+* @brief          : 双扇区日志式键值存储（平台无关）
+* @date           : 2025
+******************************************************************************
+* @attention
+*
+* 两个同样大小的Flash扇区轮流使用，同一时刻只有一个是活动扇区:
+*
+*   扇区: [magic][seq] [记录] [记录] ... [0xFF...]
+*   记录: [key:16][len:16][crc32] [数据, 补齐到4字节]
+*
+* 写入只在活动扇区末尾追加记录，同一个key以最后一条有效记录为准，
+* 所以每次修改只编程几个字，不擦除。活动扇区写满时把每个key的最新值
+* 复制到另一个(已擦除的)扇区，最后写扇区头(seq+1)使其生效——
+* 两个扇区交替承担擦除，擦写次数平均分摊。
+*
+* 掉电安全:
+*   - 记录先写头再写数据，写了一半的记录CRC不对，读取时跳过
+*   - 编程失败的记录补写头、CRC清零作废，后面的记录写在它之后
+*   - 压缩时新扇区头最后写，中途掉电旧扇区仍然有效
+*   - 上电时两个扇区都有效则取seq大的，另一个等待擦除
+*
+* 擦除(扇区擦除会让Flash读取停顿数百毫秒)从不在KV_Set()中进行:
+* 压缩后旧扇区只标记为待擦除，由调用者在安全的时机调用KV_EraseSpare()。
+* 备用扇区未擦除时活动扇区又写满，KV_Set()返回KV_BUSY。
+*
+* 只通过KV_FlashTypeDef中的函数指针擦写，读取直接访问映射地址，
+* 在PC上用两块RAM模拟即可验证记录解析与压缩。
+*
+******************************************************************************
+*/
+
+#ifndef __KVSTORE_H__
+#define __KVSTORE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* 配置选项
+ * -------------------------------------------------------------------*/
+
+#define KV_MAX_VALUE 32U    // 单条记录数据最大字节数
+#define KV_MAX_KEYS 32U     // 压缩时最多保留的不同key数
+
+/* 类型定义
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief 返回值
+ */
+typedef enum {
+  KV_OK = 0,
+  KV_ERROR,       // 参数错误或擦写失败
+  KV_NOT_FOUND,   // 没有这个key
+  KV_BUSY,        // 需要先擦除备用扇区(KV_EraseSpare)
+} KV_StatusTypeDef;
+
+/**
+ * @brief Flash访问接口
+ * @note  program的dst为sector[]中的地址，4字节对齐，len为4的倍数，
+ *        与Flash一样只能把1写成0
+ */
+typedef struct {
+  const uint8_t *sector[2];  /**< 两个扇区的读地址 */
+  uint32_t sector_size;      /**< 扇区大小(字节) */
+  bool (*erase)(void *ctx, uint8_t sector);
+  bool (*program)(void *ctx, const uint8_t *dst, const void *src, uint32_t len);
+  void *ctx;                 /**< 传给erase/program的用户数据 */
+} KV_FlashTypeDef;
+
+/**
+ * @brief 存储句柄
+ */
+typedef struct {
+  const KV_FlashTypeDef *flash;
+  uint8_t active;            /**< 活动扇区(内部使用) */
+  bool erase_pending;        /**< 备用扇区等待擦除(内部使用) */
+  uint32_t seq;              /**< 活动扇区序号(内部使用) */
+  uint32_t write_off;        /**< 下一条记录的偏移(内部使用) */
+} KV_HandleTypeDef;
+
+/* 函数声明
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  扫描两个扇区，恢复存储状态
+ * @param  hkv: 存储句柄
+ * @param  flash: Flash访问接口(须一直有效)
+ * @retval KV_OK, 擦写失败时KV_ERROR
+ * @note   两个扇区都没有有效扇区头(首次上电)时会擦除并格式化扇区0，
+ *         在开始音频流之前调用
+ */
+KV_StatusTypeDef KV_Init(KV_HandleTypeDef *hkv, const KV_FlashTypeDef *flash);
+
+/**
+ * @brief  读取一个key的最新值
+ * @param  hkv: 存储句柄
+ * @param  key: 键(0xFFFF保留)
+ * @param  buf: 输出缓冲
+ * @param  size: 缓冲大小, 值更长时截断
+ * @param  len: 输出值的实际长度, 可为NULL
+ * @retval KV_OK或KV_NOT_FOUND
+ */
+KV_StatusTypeDef KV_Get(KV_HandleTypeDef *hkv, uint16_t key, void *buf,
+                        uint32_t size, uint32_t *len);
+
+/**
+ * @brief  写入一个key
+ * @param  hkv: 存储句柄
+ * @param  key: 键(0xFFFF保留)
+ * @param  data: 数据
+ * @param  len: 长度(不超过KV_MAX_VALUE)
+ * @retval KV_OK, KV_BUSY(需要先KV_EraseSpare), KV_ERROR
+ * @note   值与当前值相同时不写入；只编程，不擦除
+ */
+KV_StatusTypeDef KV_Set(KV_HandleTypeDef *hkv, uint16_t key, const void *data,
+                        uint32_t len);
+
+/**
+ * @brief  是否有备用扇区等待擦除
+ */
+bool KV_ErasePending(const KV_HandleTypeDef *hkv);
+
+/**
+ * @brief  擦除备用扇区
+ * @retval KV_OK或KV_ERROR
+ * @note   Flash停顿数百毫秒，由调用者选择时机
+ */
+KV_StatusTypeDef KV_EraseSpare(KV_HandleTypeDef *hkv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KVSTORE_H__ */
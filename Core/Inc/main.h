@@ -61,7 +61,6 @@ void Error_Handler(void);
 #define LED_GPIO_Port GPIOC
 #define KEY_Pin GPIO_PIN_0
 #define KEY_GPIO_Port GPIOA
-#define KEY_EXTI_IRQn EXTI0_IRQn
 #define ROTARY_DT_Pin GPIO_PIN_1
 #define ROTARY_DT_GPIO_Port GPIOB
 #define ROTARY_DT_EXTI_IRQn EXTI1_IRQn
@@ -70,7 +69,6 @@ void Error_Handler(void);
 #define ROTARY_CLK_EXTI_IRQn EXTI2_IRQn
 #define ROTARY_SW_Pin GPIO_PIN_10
 #define ROTARY_SW_GPIO_Port GPIOB
-#define ROTARY_SW_EXTI_IRQn EXTI15_10_IRQn
 
 /* USER CODE BEGIN Private defines */
 
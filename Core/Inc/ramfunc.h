@@ -0,0 +1,45 @@
+/**
+******************************************************************************
+* @file           : ramfunc.h
+* @brief          : 将热点函数放入SRAM执行的段标注
+* @date           : 2025
+******************************************************************************
+* @attention
+*
+* 96MHz下Flash需要3个等待周期(FLASH_LATENCY_3)，ART加速器未命中时
+* 跳转会产生停顿。音频路径上的ISR用RAMFUNC标注后链接到.RamFunc段，
+* 由分散加载文件(MDK-ARM/STM32F411CEU6.sct)放到RW_IRAM_CODE执行域，
+* 启动时由__main从Flash拷贝到SRAM，执行周期数与Flash状态无关。
+*
+* 不能修改源码的HAL/USB库函数，直接在分散加载文件中按
+* .text.<函数名>段名选择(工程已开启One ELF Section per Function)。
+*
+* 未定义USE_RAMFUNC时RAMFUNC为空，所有函数仍在Flash中执行，
+* 便于对比两种情况下的周期数。
+*
+******************************************************************************
+*/
+
+#ifndef __RAMFUNC_H__
+#define __RAMFUNC_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(USE_RAMFUNC)
+#if defined(__ICCARM__)
+#define RAMFUNC __ramfunc
+#else
+/* noinline: 防止被内联回Flash中的调用者 */
+#define RAMFUNC __attribute__((section(".RamFunc"), noinline))
+#endif
+#else
+#define RAMFUNC
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RAMFUNC_H__ */
@@ -15,6 +15,13 @@
 *   1. 实现两个GPIO读取函数
 *   2. 在初始化时将函数指针传入
 *   3. 周期性调用Rotary_Process()
+*   4. (可选)用Rotary_SetAccel()设置加速表，再把Rotary_Process()的结果
+*      和当前时间交给Rotary_Accelerate()，快速旋转时一步输出多步
+*
+* 多编码器:
+*   编码器较多时用Rotary_ProcessBatch()：调用者把每个GPIO端口的输入
+*   寄存器各读一次，所有编码器都从这几个快照中取位推进状态机，
+*   没有逐引脚的函数指针调用。
 *
 ******************************************************************************
 */
@@ -28,18 +35,9 @@ extern "C" {
 
 /* Includes ------------------------------------------------------------------*/
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
-/* 配置选项
- * -------------------------------------------------------------------*/
-
-/**
- * @brief 启用半步模式
- * @note  半步模式会在每个格雷码的00和11位置都触发事件，分辨率翻倍
- *        如果发现编码器"转两格才响应一次"，请取消注释此行
- */
-#define ROTARY_HALF_STEP
-
 /* 返回值定义
  * -----------------------------------------------------------------*/
 
@@ -61,9 +59,41 @@ extern "C" {
  */
 #define ROTARY_DIR_CCW 0x20
 
+/**
+ * @brief 批量解码的事件位(每个编码器占2位)
+ */
+#define ROTARY_BATCH_MAX 16
+#define ROTARY_BATCH_CW(i) (1UL << (2U * (i)))
+#define ROTARY_BATCH_CCW(i) (2UL << (2U * (i)))
+
 /* 类型定义
  * -------------------------------------------------------------------*/
 
+/**
+ * @brief 步进模式(每个编码器可以不同)
+ * @note  半步: 格雷码00和11位置都触发事件，每格2次(默认)
+ *        全步: 只在00位置触发，每格1次(对应机械咔嗒声)
+ *        四分之一步: 每个合法跳变都触发，每格4次，没有状态机消抖，
+ *                    适合光电等无抖动的编码器
+ *        如果发现编码器"转两格才响应一次"，请改用半步或四分之一步
+ */
+typedef enum {
+  ROTARY_MODE_HALF = 0,
+  ROTARY_MODE_FULL,
+  ROTARY_MODE_QUARTER,
+  ROTARY_MODE_NUM
+} Rotary_StepModeTypeDef;
+
+/**
+ * @brief 加速表项
+ * @note  平滑后的步间隔不超过max_interval时每步输出steps步，
+ *        时间单位与传给Rotary_Accelerate()的now一致(如us)
+ */
+typedef struct {
+  uint32_t max_interval; /**< 步间隔上限 */
+  uint8_t steps;         /**< 对应的输出步数 */
+} Rotary_AccelTypeDef;
+
 /**
  * @brief GPIO读取函数指针类型
  * @param user_data: 用户自定义数据（可传入引脚编号、端口地址等）
@@ -71,6 +101,19 @@ extern "C" {
  */
 typedef bool (*Rotary_ReadPinFunc)(void *user_data);
 
+/**
+ * @brief 批量解码的编码器描述
+ * @note  A/B相可以在不同端口，port为传给Rotary_ProcessBatch()的快照下标
+ */
+typedef struct {
+  uint8_t port_a; /**< A相所在端口快照下标 */
+  uint8_t bit_a;  /**< A相位号(0-31) */
+  uint8_t port_b; /**< B相所在端口快照下标 */
+  uint8_t bit_b;  /**< B相位号(0-31) */
+  uint8_t mode;   /**< Rotary_StepModeTypeDef */
+  uint8_t state;  /**< 当前状态机状态（内部使用，初始化为0） */
+} Rotary_BatchTypeDef;
+
 /**
  * @brief 旋转编码器句柄结构体
  * @note  每个编码器需要一个独立的句柄实例
@@ -82,7 +125,14 @@ typedef struct {
   Rotary_ReadPinFunc read_pin_b; /**< B相读取函数指针 */
   void *user_data_b;             /**< B相用户数据（传给read_pin_b） */
 
+  const uint8_t (*table)[4]; /**< 当前步进模式的状态表（内部使用） */
   uint8_t state; /**< 当前状态机状态（内部使用） */
+
+  const Rotary_AccelTypeDef *accel; /**< 加速表，按max_interval升序，NULL=不加速 */
+  uint8_t accel_len;                /**< 加速表项数 */
+  uint8_t last_dir;                 /**< 上一步方向（内部使用） */
+  uint32_t last_time;               /**< 上一步时间（内部使用） */
+  uint32_t interval;                /**< 平滑后的步间隔（内部使用） */
 } Rotary_HandleTypeDef;
 
 /* 函数声明
@@ -192,6 +242,77 @@ void Rotary_Init(Rotary_HandleTypeDef *hrotary, Rotary_ReadPinFunc read_pin_a,
  */
 uint8_t Rotary_Process(Rotary_HandleTypeDef *hrotary);
 
+/**
+ * @brief  设置步进模式
+ * @param  hrotary: 编码器句柄指针
+ * @param  mode: Rotary_StepModeTypeDef, Rotary_Init()之后默认为ROTARY_MODE_HALF
+ */
+void Rotary_SetStepMode(Rotary_HandleTypeDef *hrotary, uint8_t mode);
+
+/**
+ * @brief  用已读出的引脚状态推进状态机
+ * @param  hrotary: 编码器句柄指针
+ * @param  pinstate: bit1=B相, bit0=A相
+ * @retval 同Rotary_Process()
+ *
+ * @note   Rotary_Process()读引脚后调用此函数；能一次读出两相的场合
+ *         (如同一端口的IDR)可直接调用，省去两次函数指针调用
+ */
+static inline uint8_t Rotary_ProcessPins(Rotary_HandleTypeDef *hrotary,
+                                         uint8_t pinstate) {
+  // 当前状态低4位为行、引脚状态为列查表, 高4位即方向事件
+  hrotary->state = hrotary->table[hrotary->state & 0x0F][pinstate & 0x03];
+  return hrotary->state & 0x30;
+}
+
+/**
+ * @brief  设置加速表
+ * @param  hrotary: 编码器句柄指针
+ * @param  table: 加速表(按max_interval升序)，NULL表示不加速
+ * @param  len: 表项数
+ *
+ * @example 以us为单位，转得越快每格步数越多:
+ *   static const Rotary_AccelTypeDef accel[] = {
+ *       {4000, 8}, {10000, 4}, {25000, 2},
+ *   };
+ *   Rotary_SetAccel(&rotary, accel, 3);
+ */
+void Rotary_SetAccel(Rotary_HandleTypeDef *hrotary,
+                     const Rotary_AccelTypeDef *table, uint8_t len);
+
+/**
+ * @brief  按旋转速度把一步换算成多步
+ * @param  hrotary: 编码器句柄指针
+ * @param  dir: Rotary_Process()的返回值
+ * @param  now: 当前时间(单位与加速表一致，允许回绕)
+ * @retval 带符号步数: 顺时针为正，逆时针为负，ROTARY_DIR_NONE返回0
+ *
+ * @note   步间隔取新间隔与旧值的平均(整数运算，可在中断中调用)，
+ *         反向后的第一步固定为1步
+ */
+int16_t Rotary_Accelerate(Rotary_HandleTypeDef *hrotary, uint8_t dir,
+                          uint32_t now);
+
+/**
+ * @brief  批量处理多个编码器
+ * @param  encoders: 编码器描述数组
+ * @param  num: 编码器个数(最多ROTARY_BATCH_MAX)
+ * @param  ports: 各端口输入寄存器的快照
+ * @retval 事件位图: 第i个编码器顺时针为ROTARY_BATCH_CW(i)，
+ *         逆时针为ROTARY_BATCH_CCW(i)，无事件为0
+ *
+ * @example STM32上两个端口各读一次IDR:
+ *   static Rotary_BatchTypeDef enc[2] = {
+ *       {1, 2, 1, 1, ROTARY_MODE_HALF, 0},   // PB2/PB1
+ *       {0, 8, 0, 9, ROTARY_MODE_FULL, 0},   // PA8/PA9
+ *   };
+ *   uint32_t ports[2] = {GPIOA->IDR, GPIOB->IDR};
+ *   uint32_t events = Rotary_ProcessBatch(enc, 2, ports);
+ *   if (events & ROTARY_BATCH_CW(0)) { ... }
+ */
+uint32_t Rotary_ProcessBatch(Rotary_BatchTypeDef *encoders, uint8_t num,
+                             const uint32_t *ports);
+
 /**
  * @brief  获取编码器当前引脚状态(调试用)
  * @param  hrotary: 编码器句柄指针
@@ -0,0 +1,106 @@
+/**
+******************************************************************************
+* @file           : runtime_stats.h
+* @brief          : 基于DWT周期计数器的运行时统计
+* @date           : 2025
+******************************************************************************
+* @attention
+*
+* 取代TIM4 1ms节拍作为FreeRTOS运行时统计时钟:
+*   - 时基为CYCCNT(96MHz)，软件扩展为64位，不会回绕
+*   - FreeRTOS 10.3.1的任务计数器只有32位，按周期计数约44.7秒回绕一次，
+*     因此默认右移RTSTATS_PRESCALE_SHIFT位后再交给内核(预分频模式)
+*   - RTSTATS_PRESCALE_SHIFT设为0即为逐周期计数，适合只看增量的场合
+*     (如遥测中的CPU占用)
+*
+* 另外累计OTG_FS、DMA1_Stream4、TIM5和EXTI中断的执行周期，
+* 用RTStats_Print()按1秒窗口把各ISR的CPU占比记入TLOG。
+*
+* 64位扩展依赖每44秒内至少读一次计数器，任务切换时内核会调用
+* getRunTimeCounterValue()，正常运行时远远满足。
+*
+******************************************************************************
+*/
+
+#ifndef __RUNTIME_STATS_H__
+#define __RUNTIME_STATS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+/* 配置
+ * -------------------------------------------------------------------*/
+
+/* 交给FreeRTOS的计数值右移位数: 5 => 3MHz, 0.33us分辨率, 约23.8分钟回绕 */
+#ifndef RTSTATS_PRESCALE_SHIFT
+#define RTSTATS_PRESCALE_SHIFT 5U
+#endif
+
+/* 类型定义
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief 被统计耗时的中断
+ */
+typedef enum {
+  RTS_ISR_OTG_FS = 0, // OTG_FS_IRQHandler
+  RTS_ISR_DMA,        // DMA1_Stream4_IRQHandler (I2S2 TX)
+  RTS_ISR_TIM5,       // TIM5_IRQHandler (1ms节拍, 编码器)
+  RTS_ISR_EXTI,       // EXTI1/2 (编码器)
+  RTS_ISR_NUM
+} RTStats_IsrTypeDef;
+
+/* 全局变量
+ * -------------------------------------------------------------------*/
+
+extern volatile uint64_t rts_isr_cycles[RTS_ISR_NUM];
+extern volatile uint32_t rts_isr_count[RTS_ISR_NUM];
+
+/* 函数声明
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  读取64位周期计数
+ * @note   任务和中断中均可调用
+ * @retval 上电以来的HCLK周期数
+ */
+uint64_t RTStats_Cycles64(void);
+
+/**
+ * @brief  读取上电以来的微秒数
+ * @note   由64位周期数换算，低32位约71分钟回绕一次，两次读数无符号相减
+ *         对回绕安全。DWT_GetCycles()直接换算的微秒数在44.7秒处跳回0，
+ *         不能用来求间隔
+ * @retval 微秒(低32位)
+ */
+static inline uint32_t RTStats_Micros(void) {
+  return (uint32_t)(RTStats_Cycles64() / (SystemCoreClock / 1000000U));
+}
+
+/**
+ * @brief  按1秒窗口通过TLOG记录各ISR耗时占比
+ * @note   在任务中调用，窗口为两次调用之间的时间
+ */
+void RTStats_Print(void);
+
+/**
+ * @brief  累计一次ISR执行周期
+ * @note   只在优先级相同的被统计中断中调用，彼此不会抢占
+ * @param  id: 中断编号
+ * @param  cycles: DWT周期数
+ */
+static inline void RTStats_IsrCycles(RTStats_IsrTypeDef id, uint32_t cycles) {
+  rts_isr_cycles[id] += cycles;
+  rts_isr_count[id]++;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RUNTIME_STATS_H__ */
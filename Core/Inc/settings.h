@@ -0,0 +1,71 @@
+/**
+******************************************************************************
+* @file           : settings.h
+* @brief          : 用户设置掉电保存
+* @date           : 2025
+******************************************************************************
+* @attention
+*
+* 静音状态保存在Flash扇区2/3(0x08008000~0x0800FFFF，各16KB，由分散加载
+* 文件从程序区中留出)，存储格式见kvstore.h。
+*
+* 写入时机:
+*   - USB中断中调用Settings_SetMute()只改RAM并标记，最后一次修改后
+*     SETTINGS_DELAY_MS没有新修改才写Flash，连续切换只产生一条记录
+*   - 写记录(几个字，每字约16us)在默认任务中随时进行: 音频路径的中断代码
+*     和I2S DMA都只访问SRAM，不受Flash编程停顿影响
+*   - 擦除扇区(数百毫秒，期间CPU取指停顿)只在USB已配置、且持续
+*     SETTINGS_ERASE_IDLE_MS没有音频流时进行: 枚举和刚配置后主机的请求
+*     不会等在擦除后面。备用扇区未擦除前写满时记录推迟到擦除之后
+*
+******************************************************************************
+*/
+
+#ifndef __SETTINGS_H__
+#define __SETTINGS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* 配置
+ * -------------------------------------------------------------------*/
+
+#define SETTINGS_DELAY_MS 2000U    // 最后一次修改后多久写入Flash
+#define SETTINGS_ERASE_IDLE_MS 1000U  // USB已配置且没有音频流多久后才擦除
+
+/* 设置项的键, 新增设置项在后面追加, 已用的值不要改 */
+/* 0x0001: 曾用于音量, 特征单元没有音量控制, 已弃用 */
+#define SETTINGS_KEY_MUTE 0x0002U
+
+/* 函数声明
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  从Flash恢复设置, 在启动USB之前调用
+ */
+void Settings_Init(void);
+
+/**
+ * @brief  写入到期的修改、在空闲时擦除备用扇区, 在任务中周期调用
+ */
+void Settings_Poll(void);
+
+/**
+ * @brief  读取设置
+ */
+uint8_t Settings_GetMute(void);
+
+/**
+ * @brief  修改设置, 可在中断中调用
+ */
+void Settings_SetMute(uint8_t mute);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SETTINGS_H__ */
@@ -0,0 +1,160 @@
+/**
+******************************************************************************
+* @file           : telemetry.h
+* @brief          : USB厂商接口遥测记录与参数写入
+* @date           : 2025
+******************************************************************************
+* @attention
+*
+* 复合设备中的厂商(Vendor)接口用于调试(同样的记录和命令也可以走USART1，
+* 见uartlink.h)：
+*   - 批量IN端点周期性上报固定32字节的状态记录(音频缓冲水位、时钟漂移、
+*     CPU占用、各ISR最大周期数等)，主机端读取工具见Tools/usb_telemetry.py
+*   - 紧跟状态记录发送一条HID记录: 本周期媒体键报告数、队列溢出数以及
+*     报告从入队到被主机取走的延迟
+*   - 批量OUT端点接收参数命令，每条6字节:
+*       [0x5A][参数ID][数值(uint32,小端)]   写入
+*       [0x5B][参数ID][任意]                只读，ACK中带回当前值
+*     一个包内可以连续放多条，处理完回一条ACK记录(对应最后一条命令)
+*
+* 记录写入非阻塞环形缓冲，缓冲满时直接丢弃并计数，遥测永远不会阻塞音频。
+*
+* 所有多字节字段均为小端。
+*
+******************************************************************************
+*/
+
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+/* 协议定义
+ * -------------------------------------------------------------------*/
+
+#define TLM_SYNC            0xA5U   // 记录起始字节
+#define TLM_CMD_SYNC        0x5AU   // 写参数命令起始字节
+#define TLM_CMD_GET         0x5BU   // 读参数命令起始字节
+#define TLM_RECORD_SIZE     32U     // 每条记录固定长度
+
+#define TLM_REC_STATUS      0x01U   // 周期状态记录
+#define TLM_REC_ACK         0x02U   // 参数写入应答
+#define TLM_REC_HID         0x03U   // HID媒体键延迟统计
+
+#define TLM_PARAM_PERIOD    0x01U   // 上报周期(ms), 10~10000
+#define TLM_PARAM_ENABLE    0x02U   // 0=停止上报, 1=开始上报
+#define TLM_PARAM_UART_BAUD 0x03U   // USART1波特率, 应答发出后切换
+
+#define TLM_ACK_OK          0x00U
+#define TLM_ACK_BAD_ID      0x01U
+#define TLM_ACK_BAD_VALUE   0x02U
+
+/* 类型定义
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief 被测量耗时的中断
+ */
+typedef enum {
+  TLM_ISR_USB = 0, // OTG_FS_IRQHandler
+  TLM_ISR_DMA,     // DMA1_Stream4_IRQHandler (I2S2 TX)
+  TLM_ISR_TIM5,    // TIM5_IRQHandler (1ms节拍, 编码器)
+  TLM_ISR_NUM
+} Telemetry_IsrTypeDef;
+
+/**
+ * @brief 状态记录 (TLM_REC_STATUS)
+ */
+typedef __PACKED_STRUCT {
+  uint8_t sync;                     // TLM_SYNC
+  uint8_t type;                     // TLM_REC_STATUS
+  uint16_t seq;                     // 记录序号, 用于主机检测丢包
+  uint32_t tick_ms;                 // HAL_GetTick()
+  uint16_t buf_fill;                // 音频缓冲中待播放字节数, 0xFFFF=未播放
+  int16_t drift_ppm;                // 主机相对I2S的时钟偏差, 正值=主机偏快
+  uint16_t cpu_load;                // CPU占用, 单位0.01%
+  uint16_t dropped;                 // 环形缓冲满丢弃的记录数
+  uint32_t isr_max[TLM_ISR_NUM];    // 本周期内各ISR最大周期数
+  uint32_t heap_free;               // FreeRTOS剩余堆
+} Telemetry_StatusTypeDef;
+
+/**
+ * @brief 参数写入应答 (TLM_REC_ACK)
+ */
+typedef __PACKED_STRUCT {
+  uint8_t sync;    // TLM_SYNC
+  uint8_t type;    // TLM_REC_ACK
+  uint16_t seq;
+  uint32_t tick_ms;
+  uint8_t param;   // 参数ID
+  uint8_t status;  // TLM_ACK_xxx
+  uint16_t reserved;
+  uint32_t value;  // 写入后(或读到)的参数值
+  uint8_t pad[TLM_RECORD_SIZE - 16U];
+} Telemetry_AckTypeDef;
+
+/**
+ * @brief HID延迟统计 (TLM_REC_HID), 每条记录后清零
+ */
+typedef __PACKED_STRUCT {
+  uint8_t sync;          // TLM_SYNC
+  uint8_t type;          // TLM_REC_HID
+  uint16_t seq;
+  uint32_t tick_ms;
+  uint32_t reports;      // 本周期主机取走的报告数
+  uint32_t overflows;    // 队列满被丢弃的按键次数
+  uint32_t lat_last;     // 最近一个报告的延迟(DWT周期)
+  uint32_t lat_max;      // 本周期最大延迟
+  uint32_t lat_avg;      // 本周期平均延迟
+  uint32_t reserved;
+} Telemetry_HidTypeDef;
+
+/* 全局变量
+ * -------------------------------------------------------------------*/
+
+extern volatile uint32_t tlm_isr_max[TLM_ISR_NUM];
+
+/* 函数声明
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  初始化遥测模块(使能DWT周期计数器)
+ */
+void Telemetry_Init(void);
+
+/**
+ * @brief  遥测轮询, 在任务中周期调用
+ * @note   到达上报周期时采样并写入厂商接口, 同时发送待处理的ACK
+ */
+void Telemetry_Poll(void);
+
+/**
+ * @brief  处理厂商接口OUT端点或USART1收到的命令
+ * @note   在OTG_FS或USART1中断中调用(后者屏蔽了OTG_FS), 只修改参数并登记ACK
+ * @param  buf: 数据
+ * @param  len: 长度
+ */
+void Telemetry_Command(const uint8_t *buf, uint32_t len);
+
+/**
+ * @brief  记录一次ISR耗时, 保留本周期最大值
+ * @param  id: 中断编号
+ * @param  cycles: DWT周期数
+ */
+static inline void Telemetry_IsrCycles(Telemetry_IsrTypeDef id, uint32_t cycles) {
+  if (cycles > tlm_isr_max[id]) {
+    tlm_isr_max[id] = cycles;
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TELEMETRY_H__ */
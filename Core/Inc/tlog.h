@@ -0,0 +1,114 @@
+/**
+******************************************************************************
+* @file           : tlog.h
+* @brief          : 令牌化延迟日志(每个上下文一个RTT通道)
+* @date           : 2025
+******************************************************************************
+* @attention
+*
+* TLOG(fmt, ...)不在目标端格式化：格式串放在.tlog_fmt段，运行时只把
+* 格式串地址、DWT时间戳和最多TLOG_MAX_ARGS个32位参数写入RTT，
+* 由主机端Tools/tlog_expand.py按ELF文件还原成文本。
+*
+* 每个写入上下文有自己的RTT上行通道(SEGGER_RTT_AllocUpBuffer分配)，
+* 同一通道永远只有一个写入者，因此用SEGGER_RTT_WriteSkipNoLock，
+* 不走SEGGER_RTT_LOCK(BASEPRI 0x20)，日志不会推迟音频中断:
+*   "TLog USB"   OTG_FS中断
+*   "TLog DMA"   DMA1_Stream4中断(I2S音频)
+*   "TLog ISR"   其余中断, 必须与上面两个同为优先级5, 彼此不抢占
+*   "TLog main"  调度器启动前的main
+*   <任务名>     每个任务第一次记录时分配, 最多TLOG_TASK_CTX个
+* ISR通道在TLog_Init()中分配；任务通道的分配只发生一次，之后查表即可。
+* 通道用完时该上下文的日志直接丢弃。任务通道名指向TCB中的任务名，
+* 记录日志的任务不能被删除。
+*
+* 记录格式(小端):
+*   [fmt:u32][ts:u32][arg0:u32]...   参数个数由主机按格式串确定
+* 主机端把各通道的抓取文件按时间戳合并。
+*
+* 限制:
+*   - 只支持整数类转换(%d %u %x %c %p等)，不支持浮点
+*   - %s的参数必须指向Flash中的常量字符串(主机从ELF中读取)
+*   - 参数个数必须与格式串一致，编译器不检查
+*
+* 编译期开关: TLOG_ENABLE=0时TLOG展开为空，参数不求值。
+*
+******************************************************************************
+*/
+
+#ifndef __TLOG_H__
+#define __TLOG_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* 配置
+ * -------------------------------------------------------------------*/
+
+#ifndef TLOG_ENABLE
+#define TLOG_ENABLE 1
+#endif
+
+#define TLOG_BUFFER_SIZE 256U     // 每个通道的缓冲大小
+#define TLOG_TASK_CTX 6U          // 任务通道数(含main)
+#define TLOG_MAX_ARGS 6U          // 每条日志最多参数个数
+
+#if TLOG_ENABLE
+
+/* 函数声明
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  分配中断上下文的RTT日志通道
+ * @note   在SEGGER_RTT_Init()和固定通道(trace.h, health.h)配置之后调用
+ */
+void TLog_Init(void);
+
+/**
+ * @brief  填入时间戳并写入当前上下文的通道
+ * @param  rec: [fmt][ts][args...], ts由本函数填写
+ * @param  len: 记录字节数
+ */
+void TLog_Write(uint32_t *rec, uint32_t len);
+
+/* 参数个数与逐个转换为uint32_t */
+#define TLOG_NARG(...) TLOG_NARG_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define TLOG_NARG_(_0, _1, _2, _3, _4, _5, _6, n, ...) n
+#define TLOG_CAT(a, b) TLOG_CAT_(a, b)
+#define TLOG_CAT_(a, b) a##b
+#define TLOG_ARGS_0()
+#define TLOG_ARGS_1(a) , (uint32_t)(a)
+#define TLOG_ARGS_2(a, b) , (uint32_t)(a), (uint32_t)(b)
+#define TLOG_ARGS_3(a, b, c) TLOG_ARGS_2(a, b), (uint32_t)(c)
+#define TLOG_ARGS_4(a, b, c, d) TLOG_ARGS_3(a, b, c), (uint32_t)(d)
+#define TLOG_ARGS_5(a, b, c, d, e) TLOG_ARGS_4(a, b, c, d), (uint32_t)(e)
+#define TLOG_ARGS_6(a, b, c, d, e, f) TLOG_ARGS_5(a, b, c, d, e), (uint32_t)(f)
+
+/**
+ * @brief  记录一条日志, 任务和中断中均可调用
+ * @param  fmt: 字符串字面量
+ */
+#define TLOG(fmt, ...)                                                              \
+  do {                                                                              \
+    static const char tlog_fmt_[] __attribute__((section(".tlog_fmt"), used)) = fmt; \
+    uint32_t tlog_rec_[] = {(uint32_t)tlog_fmt_,                                    \
+                            0U TLOG_CAT(TLOG_ARGS_, TLOG_NARG(__VA_ARGS__))(__VA_ARGS__)}; \
+    TLog_Write(tlog_rec_, sizeof(tlog_rec_));                                       \
+  } while (0)
+
+#else
+
+#define TLog_Init() ((void)0)
+#define TLOG(fmt, ...) ((void)0)
+
+#endif /* TLOG_ENABLE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TLOG_H__ */
@@ -0,0 +1,135 @@
+/**
+******************************************************************************
+* @file           : trace.h
+* @brief          : FreeRTOS二进制事件跟踪(RTT通道1)
+* @date           : 2025
+******************************************************************************
+* @attention
+*
+* 编译期开关: 在工程宏定义中加入 TRACE_ENABLE=1 才会生效，默认关闭时
+* 内核跟踪钩子和TRACE_ISR_xxx宏都展开为空。
+*
+* 事件写入独立的RTT上行通道TRACE_RTT_CHANNEL("Trace")，跳过模式：
+* 缓冲满时整条事件丢弃，永不阻塞。主机端用J-Link RTT Logger抓取
+* 该通道到文件，再用Tools/trace2chrome.py转换为Chrome/Perfetto JSON。
+*
+* 记录格式(小端):
+*   [type:u8][id:u8][arg:u16][ts:u32]          8字节, ts为DWT周期数
+*   TRC_START:       之后跟 [SystemCoreClock:u32]
+*   TRC_TASK_CREATE: 之后跟 [name:configMAX_TASK_NAME_LEN字节]
+*
+* 写入时只用BASEPRI屏蔽优先级>=5的中断(几个周期)，再调用
+* SEGGER_RTT_WriteSkipNoLock，不走RTT自带的关中断锁。部分内核钩子
+* (如traceBLOCKING_ON_QUEUE_RECEIVE)只是挂起调度器，仍可被ISR打断，
+* 所以这层屏蔽不能省。不要在优先级高于5的中断里使用本模块。
+*
+******************************************************************************
+*/
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* 配置
+ * -------------------------------------------------------------------*/
+
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE 0
+#endif
+
+#define TRACE_RTT_CHANNEL 1U      // RTT上行通道号
+#define TRACE_BUFFER_SIZE 4096U   // 通道缓冲大小
+
+/* 事件类型
+ * -------------------------------------------------------------------*/
+
+#define TRC_START 0x01U             // 跟踪开始, 附带时钟频率
+#define TRC_TASK_CREATE 0x02U       // id=任务号, 附带任务名
+#define TRC_TASK_IN 0x03U           // id=任务号
+#define TRC_TASK_OUT 0x04U          // id=任务号
+#define TRC_ISR_ENTER 0x05U         // id=RTStats_IsrTypeDef
+#define TRC_ISR_EXIT 0x06U
+#define TRC_QUEUE_SEND 0x07U        // arg=队列地址低16位
+#define TRC_QUEUE_SEND_FAIL 0x08U
+#define TRC_QUEUE_RECV 0x09U
+#define TRC_QUEUE_RECV_FAIL 0x0AU
+#define TRC_QUEUE_BLOCK_SEND 0x0BU
+#define TRC_QUEUE_BLOCK_RECV 0x0CU
+#define TRC_NOTIFY 0x0DU            // id=被通知任务号
+#define TRC_NOTIFY_TAKE 0x0EU       // id=当前任务号
+#define TRC_NOTIFY_BLOCK 0x0FU
+
+#if TRACE_ENABLE
+
+/* 函数声明
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  配置RTT跟踪通道并写入TRC_START
+ * @note   在创建任何任务之前调用(SEGGER_RTT_Init之后)
+ */
+void Trace_Init(void);
+
+/**
+ * @brief  写入一条8字节事件
+ * @param  type: TRC_xxx
+ * @param  id: 任务号/中断号
+ * @param  arg: 附加参数
+ */
+void Trace_Event(uint8_t type, uint8_t id, uint16_t arg);
+
+/**
+ * @brief  写入任务创建事件(附任务名)
+ * @param  num: 任务号(uxTCBNumber)
+ * @param  name: 任务名
+ */
+void Trace_TaskCreate(uint32_t num, const char *name);
+
+#define TRACE_ISR_ENTER(id) Trace_Event(TRC_ISR_ENTER, (uint8_t)(id), 0U)
+#define TRACE_ISR_EXIT(id) Trace_Event(TRC_ISR_EXIT, (uint8_t)(id), 0U)
+
+/* FreeRTOS跟踪钩子, 在tasks.c/queue.c中展开, 可直接访问TCB/队列 */
+#define TRC_QUEUE_ID(q) ((uint16_t)(uint32_t)(q))
+
+#define traceTASK_CREATE(pxNewTCB) Trace_TaskCreate((pxNewTCB)->uxTCBNumber, (pxNewTCB)->pcTaskName)
+#define traceTASK_SWITCHED_IN() Trace_Event(TRC_TASK_IN, (uint8_t)pxCurrentTCB->uxTCBNumber, 0U)
+#define traceTASK_SWITCHED_OUT() Trace_Event(TRC_TASK_OUT, (uint8_t)pxCurrentTCB->uxTCBNumber, 0U)
+
+#define traceQUEUE_SEND(q) Trace_Event(TRC_QUEUE_SEND, 0U, TRC_QUEUE_ID(q))
+#define traceQUEUE_SEND_FROM_ISR(q) Trace_Event(TRC_QUEUE_SEND, 0U, TRC_QUEUE_ID(q))
+#define traceQUEUE_SEND_FAILED(q) Trace_Event(TRC_QUEUE_SEND_FAIL, 0U, TRC_QUEUE_ID(q))
+#define traceQUEUE_SEND_FROM_ISR_FAILED(q) Trace_Event(TRC_QUEUE_SEND_FAIL, 0U, TRC_QUEUE_ID(q))
+#define traceQUEUE_RECEIVE(q) Trace_Event(TRC_QUEUE_RECV, 0U, TRC_QUEUE_ID(q))
+#define traceQUEUE_RECEIVE_FROM_ISR(q) Trace_Event(TRC_QUEUE_RECV, 0U, TRC_QUEUE_ID(q))
+#define traceQUEUE_RECEIVE_FAILED(q) Trace_Event(TRC_QUEUE_RECV_FAIL, 0U, TRC_QUEUE_ID(q))
+#define traceQUEUE_RECEIVE_FROM_ISR_FAILED(q) Trace_Event(TRC_QUEUE_RECV_FAIL, 0U, TRC_QUEUE_ID(q))
+#define traceBLOCKING_ON_QUEUE_SEND(q) Trace_Event(TRC_QUEUE_BLOCK_SEND, 0U, TRC_QUEUE_ID(q))
+#define traceBLOCKING_ON_QUEUE_RECEIVE(q) Trace_Event(TRC_QUEUE_BLOCK_RECV, 0U, TRC_QUEUE_ID(q))
+
+#define traceTASK_NOTIFY() Trace_Event(TRC_NOTIFY, (uint8_t)pxTCB->uxTCBNumber, 0U)
+#define traceTASK_NOTIFY_FROM_ISR() Trace_Event(TRC_NOTIFY, (uint8_t)pxTCB->uxTCBNumber, 0U)
+#define traceTASK_NOTIFY_GIVE_FROM_ISR() Trace_Event(TRC_NOTIFY, (uint8_t)pxTCB->uxTCBNumber, 0U)
+#define traceTASK_NOTIFY_TAKE() Trace_Event(TRC_NOTIFY_TAKE, (uint8_t)pxCurrentTCB->uxTCBNumber, 0U)
+#define traceTASK_NOTIFY_WAIT() Trace_Event(TRC_NOTIFY_TAKE, (uint8_t)pxCurrentTCB->uxTCBNumber, 0U)
+#define traceTASK_NOTIFY_TAKE_BLOCK() Trace_Event(TRC_NOTIFY_BLOCK, (uint8_t)pxCurrentTCB->uxTCBNumber, 0U)
+#define traceTASK_NOTIFY_WAIT_BLOCK() Trace_Event(TRC_NOTIFY_BLOCK, (uint8_t)pxCurrentTCB->uxTCBNumber, 0U)
+
+#else
+
+#define Trace_Init() ((void)0)
+#define TRACE_ISR_ENTER(id) ((void)0)
+#define TRACE_ISR_EXIT(id) ((void)0)
+
+#endif /* TRACE_ENABLE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TRACE_H__ */
@@ -0,0 +1,98 @@
+/**
+******************************************************************************
+* @file           : uartlink.h
+* @brief          : USART1 DMA诊断串口(COBS帧)
+* @date           : 2025
+******************************************************************************
+* @attention
+*
+* 没有调试器时用串口读遥测、写参数，内容与USB厂商接口相同(telemetry.h):
+*   - 设备发出: 每条遥测记录(32字节)一帧
+*   - 主机发出: 一帧放一条或多条6字节参数命令
+*
+* 帧格式(所有多字节字段小端):
+*
+*   COBS( 负载 | CRC-16/CCITT-FALSE(负载) ) 0x00
+*
+* COBS编码后帧内没有0x00，0x00只做帧分隔，丢字节或上电中途接入时
+* 接收方丢弃到下一个0x00即可重新同步，CRC错误的帧直接丢弃。
+*
+* 没有逐字节中断:
+*   - 发送: 帧编码后写入环形缓冲，DMA2_Stream7一次发送一段连续区域，
+*     发送完成中断中接着发下一段；缓冲满时丢弃整帧并计数
+*   - 接收: DMA2_Stream2循环接收到UARTLINK_RX_SIZE缓冲，只在半满、满和
+*     线路空闲(IDLE)时进中断，中断中解析新收到的字节，命令交给
+*     Telemetry_Command()
+* 串口和DMA中断优先级为6，低于音频路径(5)，不会推迟音频中断。
+*
+* 波特率: 上电为UARTLINK_BAUD，可用参数TLM_PARAM_UART_BAUD在运行时修改，
+* 应答仍以旧波特率发出，发送缓冲排空后切换。APB2为96MHz，
+* 超过6Mbaud时自动改用8倍过采样，最高12Mbaud。
+*
+******************************************************************************
+*/
+
+#ifndef __UARTLINK_H__
+#define __UARTLINK_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* 配置
+ * -------------------------------------------------------------------*/
+
+#define UARTLINK_BAUD 115200U        // 上电默认波特率
+#define UARTLINK_BAUD_MIN 9600U
+#define UARTLINK_TX_SIZE 1024U       // 发送环形缓冲(2的幂)
+#define UARTLINK_RX_SIZE 256U        // 接收DMA循环缓冲
+#define UARTLINK_MAX_PAYLOAD 64U     // 单帧最大负载
+
+/* 函数声明
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  设置默认波特率并启动DMA接收, 在MX_USART1_UART_Init之后调用
+ */
+void UartLink_Init(void);
+
+/**
+ * @brief  执行挂起的波特率切换, 在发送帧的任务中周期调用
+ */
+void UartLink_Poll(void);
+
+/**
+ * @brief  编码并发送一帧
+ * @param  payload: 负载
+ * @param  len: 长度(不超过UARTLINK_MAX_PAYLOAD)
+ * @retval false: 缓冲满或正在切换波特率, 帧被丢弃
+ * @note   只能在一个任务中调用
+ */
+bool UartLink_Send(const void *payload, uint32_t len);
+
+/**
+ * @brief  波特率是否可用
+ * @note   可在中断中调用
+ */
+bool UartLink_BaudValid(uint32_t baud);
+
+/**
+ * @brief  请求切换波特率, 已在缓冲中的帧发完后生效
+ * @note   与UartLink_Send在同一任务中调用, 之后发送的帧在切换前被丢弃
+ */
+void UartLink_SetBaud(uint32_t baud);
+
+/**
+ * @brief  当前波特率
+ */
+uint32_t UartLink_GetBaud(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UARTLINK_H__ */
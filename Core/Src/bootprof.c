@@ -0,0 +1,108 @@
+/**
+******************************************************************************
+* @file           : bootprof.c
+* @brief          : 启动过程计时
+******************************************************************************
+* @attention
+*
+* 见bootprof.h。
+*
+******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "bootprof.h"
+#include "tlog.h"
+
+#if BOOTPROF_ENABLE
+
+/* 私有变量
+ * -----------------------------------------------------------------*/
+
+// 分散加载文件中的RW_IRAM_NOINIT(UNINIT)区, __main不清零
+uint32_t bootprof_cycles[BOOT_MS_NUM] __attribute__((section(".bss.noinit")));
+
+static uint32_t bootprof_reported;   // 已记录的阶段(位图)
+static uint32_t bootprof_last_us;    // 上一个记录阶段的时刻
+
+// TLOG的%s只记地址, 名字由tlog_expand.py从ELF读回
+static const char *const bootprof_name[BOOT_MS_NUM] = {
+    "Reset_Handler",
+    "SystemInit",
+    "__main",
+    "HAL_Init",
+    "SystemClock_Config",
+    "MX_USB_DEVICE_Init",
+    "MX_GPIO/DMA_Init",
+    "MX_I2S2_Init",
+    "MX_TIM5_Init",
+    "MX_USART1_Init",
+    "MX_TIM3_Init",
+    "App init",
+    "Scheduler start",
+    "USB configured",
+    "First audio",
+};
+
+/* 私有函数
+ * -----------------------------------------------------------------*/
+
+/**
+ * @brief  周期数换算为复位后的微秒数
+ */
+static uint32_t BootProf_ToUs(uint32_t cycles) {
+  uint32_t clock = bootprof_cycles[BOOT_MS_CLOCK];
+
+  if ((clock == 0U) || (cycles <= clock)) {
+    return cycles / (HSI_VALUE / 1000000U);
+  }
+  return (clock / (HSI_VALUE / 1000000U)) + ((cycles - clock) / (SystemCoreClock / 1000000U));
+}
+
+/* 函数实现
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  清除上次复位留下的时间戳并记录BOOT_MS_MAIN
+ */
+void BootProf_Init(void) {
+  for (uint32_t i = BOOT_MS_MAIN; i < BOOT_MS_NUM; i++) {
+    bootprof_cycles[i] = 0U;
+  }
+  bootprof_cycles[BOOT_MS_RESET] = 0U;
+  BootProf_Mark(BOOT_MS_MAIN);
+}
+
+/**
+ * @brief  枚举完成后记录启动时间, 每次调用一个阶段
+ */
+void BootProf_Poll(void) {
+  uint32_t next = BOOT_MS_NUM;
+  uint32_t us;
+
+  if ((bootprof_cycles[BOOT_MS_ENUM] == 0U) ||
+      (bootprof_reported == ((1UL << BOOT_MS_NUM) - 1U))) {
+    return;
+  }
+
+  // 按时间顺序记录: 选出未记录阶段中最早的一个。一次只写一条,
+  // 15条一起写会超过TLOG_BUFFER_SIZE, 调试器来不及读走就被跳过
+  for (uint32_t i = 0U; i < BOOT_MS_NUM; i++) {
+    if ((bootprof_reported & (1UL << i)) || ((i != BOOT_MS_RESET) && (bootprof_cycles[i] == 0U))) {
+      continue;
+    }
+    if ((next == BOOT_MS_NUM) || (bootprof_cycles[i] < bootprof_cycles[next])) {
+      next = i;
+    }
+  }
+  if (next == BOOT_MS_NUM) {
+    return;
+  }
+  bootprof_reported |= 1UL << next;
+
+  us = BootProf_ToUs(bootprof_cycles[next]);
+  TLOG("boot: %-18s %9u us +%u", bootprof_name[next], us, us - bootprof_last_us);
+  bootprof_last_us = us;
+}
+
+#endif /* BOOTPROF_ENABLE */
@@ -0,0 +1,97 @@
+/**
+******************************************************************************
+* @file           : button.c
+* @brief          : 通用按键消抖与手势识别实现（平台无关）
+******************************************************************************
+* @attention
+*
+* 状态与计时:
+*
+*   松开 --积分器到上限--> 按下: PRESS (+DOUBLE)   timer清零开始计按住时间
+*   按下: timer到LONG_TICKS -> LONG, 之后timer每到REPEAT_TICKS -> REPEAT
+*   按下 --积分器回到0--> 松开: RELEASE          timer清零开始计松开时间
+*
+* 双击只在"上一次是短按(没有触发LONG，自身也不是双击)且松开不超过
+* DOUBLE_TICKS"时成立，所以连按三下只会得到一次DOUBLE。
+*
+******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "button.h"
+
+/* 函数实现
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  初始化按键
+ */
+void Button_Init(Button_HandleTypeDef *hbutton, Button_ReadPinFunc read_pin,
+                 void *user_data, bool active_level) {
+  hbutton->read_pin = read_pin;
+  hbutton->user_data = user_data;
+  hbutton->active_level = active_level;
+
+  hbutton->integrator = 0U;
+  hbutton->pressed = false;
+  hbutton->long_fired = false;
+  hbutton->double_armed = false;
+  hbutton->was_double = false;
+  hbutton->timer = 0xFFFFU;
+}
+
+/**
+ * @brief  采样一次并推进手势状态机
+ */
+uint8_t Button_Process(Button_HandleTypeDef *hbutton) {
+  bool level = hbutton->read_pin(hbutton->user_data);
+  uint8_t events = BUTTON_EVT_NONE;
+
+  // 步骤1: 积分器消抖
+  if (level == hbutton->active_level) {
+    if (hbutton->integrator < BUTTON_INTEGRATOR_MAX) {
+      hbutton->integrator++;
+    }
+  } else if (hbutton->integrator > 0U) {
+    hbutton->integrator--;
+  }
+
+  // 步骤2: 稳定状态变化
+  if (!hbutton->pressed && (hbutton->integrator >= BUTTON_INTEGRATOR_MAX)) {
+    hbutton->pressed = true;
+    events |= BUTTON_EVT_PRESS;
+    hbutton->was_double = hbutton->double_armed && (hbutton->timer <= BUTTON_DOUBLE_TICKS);
+    if (hbutton->was_double) {
+      events |= BUTTON_EVT_DOUBLE;
+    }
+    hbutton->long_fired = false;
+    hbutton->timer = 0U;
+    return events;
+  }
+  if (hbutton->pressed && (hbutton->integrator == 0U)) {
+    hbutton->pressed = false;
+    events |= BUTTON_EVT_RELEASE;
+    hbutton->double_armed = !hbutton->long_fired && !hbutton->was_double;
+    hbutton->timer = 0U;
+    return events;
+  }
+
+  // 步骤3: 计时
+  if (hbutton->timer < 0xFFFFU) {
+    hbutton->timer++;
+  }
+  if (hbutton->pressed) {
+    if (!hbutton->long_fired) {
+      if (hbutton->timer >= BUTTON_LONG_TICKS) {
+        hbutton->long_fired = true;
+        hbutton->timer = 0U;
+        events |= BUTTON_EVT_LONG;
+      }
+    } else if (hbutton->timer >= BUTTON_REPEAT_TICKS) {
+      hbutton->timer = 0U;
+      events |= BUTTON_EVT_REPEAT;
+    }
+  }
+
+  return events;
+}
@@ -28,6 +28,16 @@
 #include "stdio.h"
 #include "string.h"
 #include "SEGGER_RTT.h"
+#include "telemetry.h"
+#include "runtime_stats.h"
+#include "irq_prof.h"
+#include "health.h"
+#include "input.h"
+#include "settings.h"
+#include "bootprof.h"
+#include "uartlink.h"
+#include "tim.h"
+#include "usart.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -48,12 +58,20 @@
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN Variables */
 extern volatile long long FreeRTOSRunTimeTicks;
+/* defaultTask stack (256 words, set in the .ioc): the deepest paths are
+   Settings_Poll into KV_Compact/KV_Write (~260 bytes) and Telemetry_Poll into
+   UartLink_Send (~250 bytes); RTStats_Print/BootProf_Poll only build a TLOG
+   record. An interrupt plus the PendSV save add up to 204 bytes with the FPU
+   context, which would leave 128 words (512 bytes) with no margin. The snapshot
+   stack_hwm (Tools/health_decode.py) must stay above HEALTH_STACK_WARN_WORDS. */
+/* Name of the task that overflowed, for the debugger after the hook stopped */
+static char stack_overflow_task[configMAX_TASK_NAME_LEN];
 /* USER CODE END Variables */
 /* Definitions for defaultTask */
 osThreadId_t defaultTaskHandle;
 const osThreadAttr_t defaultTask_attributes = {
   .name = "defaultTask",
-  .stack_size = 128 * 4,
+  .stack_size = 256 * 4,
   .priority = (osPriority_t) osPriorityNormal,
 };
 
@@ -64,15 +82,17 @@ const osThreadAttr_t defaultTask_attributes = {
 
 void StartDefaultTask(void *argument);
 
-extern void MX_USB_DEVICE_Init(void);
 void MX_FREERTOS_Init(void); /* (MISRA C 2004 rule 8.1) */
 
 /* Hook prototypes */
 void configureTimerForRunTimeStats(void);
 unsigned long getRunTimeCounterValue(void);
+void vApplicationStackOverflowHook(xTaskHandle xTask, signed char *pcTaskName);
+void vApplicationMallocFailedHook(void);
 
 /* USER CODE BEGIN 1 */
-/* Functions needed when configGENERATE_RUN_TIME_STATS is on */
+/* Functions needed when configGENERATE_RUN_TIME_STATS is on,
+   overridden by the DWT based versions in runtime_stats.c */
 __weak void configureTimerForRunTimeStats(void)
 {
   FreeRTOSRunTimeTicks = 0;
@@ -84,6 +104,46 @@ return FreeRTOSRunTimeTicks;
 }
 /* USER CODE END 1 */
 
+/* USER CODE BEGIN 4 */
+void vApplicationStackOverflowHook(xTaskHandle xTask, signed char *pcTaskName)
+{
+   /* Run time stack overflow checking is performed if
+   configCHECK_FOR_STACK_OVERFLOW is defined to 1 or 2. This hook function is
+   called if a stack overflow is detected. */
+  /* The task's stack and possibly its TCB are corrupt: no printf, copy at most
+     configMAX_TASK_NAME_LEN bytes of the name, write it raw and stop like configASSERT */
+  uint32_t n = 0U;
+
+  taskDISABLE_INTERRUPTS();
+  while ((n < (configMAX_TASK_NAME_LEN - 1U)) && (pcTaskName[n] != '\0'))
+  {
+    stack_overflow_task[n] = (char)pcTaskName[n];
+    n++;
+  }
+  (void)SEGGER_RTT_WriteNoLock(0U, "stack overflow: ", 16U);
+  (void)SEGGER_RTT_WriteNoLock(0U, stack_overflow_task, n);
+  (void)SEGGER_RTT_WriteNoLock(0U, "\r\n", 2U);
+  for( ;; );
+}
+/* USER CODE END 4 */
+
+/* USER CODE BEGIN 5 */
+void vApplicationMallocFailedHook(void)
+{
+   /* vApplicationMallocFailedHook() will only be called if
+   configUSE_MALLOC_FAILED_HOOK is set to 1 in FreeRTOSConfig.h. It is a hook
+   function that will get called if a call to pvPortMalloc() fails.
+   pvPortMalloc() is called internally by the kernel whenever a task, queue,
+   timer or semaphore is created. It is also called by various parts of the
+   demo application. If heap_1.c or heap_2.c are used, then the size of the
+   heap available to pvPortMalloc() is defined by configTOTAL_HEAP_SIZE in
+   FreeRTOSConfig.h, and the xPortGetFreeHeapSize() API function can be used
+   to query the size of free heap space that remains (although it does not
+   provide information on how the remaining heap might be fragmented). */
+  Health_MallocFailed();
+}
+/* USER CODE END 5 */
+
 /**
   * @brief  FreeRTOS initialization
   * @param  None
@@ -116,6 +176,7 @@ void MX_FREERTOS_Init(void) {
 
   /* USER CODE BEGIN RTOS_THREADS */
   /* add threads, ... */
+  Input_Init();
   /* USER CODE END RTOS_THREADS */
 
   /* USER CODE BEGIN RTOS_EVENTS */
@@ -133,48 +194,34 @@ void MX_FREERTOS_Init(void) {
 /* USER CODE END Header_StartDefaultTask */
 void StartDefaultTask(void *argument)
 {
-  /* init code for USB_DEVICE */
-  MX_USB_DEVICE_Init();
   /* USER CODE BEGIN StartDefaultTask */
-  extern uint8_t key_press;
-  extern uint8_t rotary_key_press;
-  static char pcWriteBuffer[400];
+  // USB在main中最先初始化(MX_USB_DEVICE_Init不生成调用), 见main.c
+  BootProf_Mark(BOOT_MS_KERNEL);
+  // 音频用不到的外设在调度器启动后才初始化(.ioc中不生成调用), 见main.c
+  MX_TIM5_Init();
+  MX_USART1_UART_Init();
+  MX_TIM3_Init();
+  HAL_TIM_Base_Start_IT(&htim5);  // 1ms: 按键消抖, 编码器轮询
   static TickType_t lastPrintTick = 0;
+  Telemetry_Init();
+  UartLink_Init();    // USART1 DMA link, same records as the vendor interface
   /* Infinite loop */
   for(;;)
   {
+    Telemetry_Poll();
+    UartLink_Poll();    // deferred baud switch after the ACK drained
+    Settings_Poll();
+    BootProf_Poll();   // boot milestones into TLOG once enumerated
     TickType_t nowTicks = xTaskGetTickCount();
     if ((nowTicks - lastPrintTick) >= pdMS_TO_TICKS(1000))
     {
         lastPrintTick = nowTicks;
-        SEGGER_RTT_printf(0,"---------------------------------------------\r\n");
-        memset(pcWriteBuffer, 0, 400);
-        SEGGER_RTT_printf(0,"Task           State   Prio    Stack   Num\r\n");
-        vTaskList(pcWriteBuffer);   // Get memory info
-        SEGGER_RTT_printf(0,"%s", pcWriteBuffer);
-        SEGGER_RTT_printf(0,"---------------------------------------------\r\n");
-        memset(pcWriteBuffer, 0, 400);
-        SEGGER_RTT_printf(0,"Task           Run Count       Usage\r\n");
-        vTaskGetRunTimeStats(pcWriteBuffer);   // Get CPU usage info
-        SEGGER_RTT_printf(0,"%s", pcWriteBuffer);
-    }
-    if(key_press)
-    {
-      key_press=0;
-      osDelay(10);
-      if (HAL_GPIO_ReadPin(KEY_GPIO_Port, KEY_Pin) == GPIO_PIN_RESET) {      
-        while (HAL_GPIO_ReadPin(KEY_GPIO_Port, KEY_Pin) == GPIO_PIN_RESET) {osDelay(1);}
-      }
-    }
-    if(rotary_key_press)
-    {
-      rotary_key_press=0;
-      osDelay(10);
-      if (HAL_GPIO_ReadPin(ROTARY_SW_GPIO_Port, ROTARY_SW_Pin) == GPIO_PIN_RESET) {      
-        while (HAL_GPIO_ReadPin(ROTARY_SW_GPIO_Port, ROTARY_SW_Pin) == GPIO_PIN_RESET) {osDelay(1);}
-      }
+        Health_Snapshot();  // binary task table on RTT channel 2, see Tools/health_decode.py
+        RTStats_Print();   // ISR cycles in the last window
+        IRQ_PROF_PRINT();  // only with IRQ_PROF_ENABLE=1
     }
-    osDelay(1);
+    // Buttons are handled by inputTask (input.c); 10 ms is the shortest telemetry period
+    osDelay(10);
   }
   /* USER CODE END StartDefaultTask */
 }
@@ -0,0 +1,194 @@
+/**
+******************************************************************************
+* @file           : health.c
+* @brief          : 二进制任务健康快照(RTT通道2)
+******************************************************************************
+* @attention
+*
+* 记录格式见health.h，主机端解码见Tools/health_decode.py。
+*
+******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "health.h"
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "dwt.h"
+#include "tlog.h"
+#include "SEGGER_RTT.h"
+#include "usbd_conf.h"
+
+/* 启动文件中的STACK段(MSP), armlink按段名生成 */
+extern uint32_t STACK$$Base[];
+extern uint32_t STACK$$Limit[];
+
+/* 私有变量
+ * -----------------------------------------------------------------*/
+
+static uint8_t health_buffer[HEALTH_BUFFER_SIZE];
+
+static TaskStatus_t health_status[HEALTH_MAX_TASKS];
+
+// 一次快照的完整记录, 一次写入RTT
+static struct {
+  Health_HeaderTypeDef hdr;
+  Health_TaskTypeDef task[HEALTH_MAX_TASKS];
+} health_rec;
+
+static uint32_t health_prev_run[HEALTH_MAX_NUMBER];   // 按任务号记录上次运行时间
+static uint32_t health_prev_total;
+static uint32_t health_named;                          // 已发送任务名的任务号位图
+static uint32_t health_cycles;
+static uint8_t health_dropped;
+static volatile uint8_t health_malloc_failed;
+static uint8_t health_warn;                            // 上次快照的告警位
+
+/* 私有函数
+ * -----------------------------------------------------------------*/
+
+/**
+ * @brief  MSP历史最大使用
+ * @retval 字节数
+ */
+static uint32_t Health_MspUsed(void) {
+  const uint32_t *p = STACK$$Base;
+
+  while ((p < STACK$$Limit) && (*p == HEALTH_PAINT)) {
+    p++;
+  }
+  return (uint32_t)(STACK$$Limit - p) * 4U;
+}
+
+/* 函数实现
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  配置RTT健康通道并给MSP涂色
+ */
+void Health_Init(void) {
+  // 当前SP以下留64字节给本函数和可能打断它的中断
+  uint32_t *top = (uint32_t *)((__get_MSP() - 64U) & ~3U);
+
+  for (uint32_t *p = STACK$$Base; p < top; p++) {
+    *p = HEALTH_PAINT;
+  }
+  (void)SEGGER_RTT_ConfigUpBuffer(HEALTH_RTT_CHANNEL, "Health", health_buffer,
+                                  sizeof(health_buffer), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+}
+
+/**
+ * @brief  采集并发送一次快照
+ */
+void Health_Snapshot(void) {
+  uint32_t t0 = DWT_GetCycles();
+  uint32_t total;
+  UBaseType_t n;
+  uint32_t len;
+  HeapStats_t heap;
+  USBD_PoolStatsTypeDef pool;
+  uint32_t msp_size = (uint32_t)(STACK$$Limit - STACK$$Base) * 4U;
+  uint32_t msp_used = Health_MspUsed();
+  uint8_t warn = 0U;
+  uint8_t low_task = 0U;
+
+  n = uxTaskGetSystemState(health_status, HEALTH_MAX_TASKS, &total);
+
+  for (UBaseType_t i = 0; i < n; i++) {
+    const TaskStatus_t *s = &health_status[i];
+    Health_TaskTypeDef *t = &health_rec.task[i];
+    uint32_t num = (uint32_t)s->xTaskNumber;
+
+    t->number = (uint8_t)num;
+    t->state = (uint8_t)s->eCurrentState;
+    t->prio = (uint8_t)s->uxCurrentPriority;
+    t->base_prio = (uint8_t)s->uxBasePriority;
+    t->stack_hwm = (uint16_t)s->usStackHighWaterMark;
+    if (s->usStackHighWaterMark < HEALTH_STACK_WARN_WORDS) {
+      warn |= HEALTH_WARN_STACK;
+      low_task = (uint8_t)num;
+    }
+    t->reserved = 0U;
+    t->run_delta = 0U;
+    if (num < HEALTH_MAX_NUMBER) {
+      t->run_delta = s->ulRunTimeCounter - health_prev_run[num];
+      health_prev_run[num] = s->ulRunTimeCounter;
+
+      if ((health_named & (1UL << num)) == 0U) {
+        Health_NameTypeDef rec = {HEALTH_SYNC, HEALTH_REC_NAME, (uint8_t)num, 0U, {0}};
+
+        strncpy(rec.name, s->pcTaskName, HEALTH_NAME_LEN);
+        if (SEGGER_RTT_WriteSkipNoLock(HEALTH_RTT_CHANNEL, &rec, sizeof(rec)) == sizeof(rec)) {
+          health_named |= 1UL << num;
+        }
+      }
+    }
+  }
+
+  vPortGetHeapStats(&heap);
+  if (heap.xMinimumEverFreeBytesRemaining < HEALTH_HEAP_WARN_BYTES) {
+    warn |= HEALTH_WARN_HEAP;
+  }
+  if (heap.xSizeOfLargestFreeBlockInBytes < HEALTH_BLOCK_WARN_BYTES) {
+    warn |= HEALTH_WARN_FRAG;
+  }
+  if ((msp_size - msp_used) < HEALTH_MSP_WARN_BYTES) {
+    warn |= HEALTH_WARN_MSP;
+  }
+  if (health_malloc_failed != 0U) {
+    warn |= HEALTH_WARN_MALLOC;
+  }
+  USBD_static_pool_stats(&pool);
+  if (pool.failures != 0U) {
+    warn |= HEALTH_WARN_USB_POOL;
+  }
+  if ((warn & (uint8_t)~health_warn) != 0U) {
+    TLOG("health: warn 0x%02x, low stack task %u, heap min %u, largest %u, msp free %u",
+         warn, low_task, heap.xMinimumEverFreeBytesRemaining,
+         heap.xSizeOfLargestFreeBlockInBytes, msp_size - msp_used);
+    if ((warn & (uint8_t)~health_warn & HEALTH_WARN_USB_POOL) != 0U) {
+      TLOG("health: usb pool %u of %u bytes, %u failed allocations", pool.high_water, pool.size,
+           pool.failures);
+    }
+  }
+  health_warn = warn;
+
+  health_rec.hdr.sync = HEALTH_SYNC;
+  health_rec.hdr.type = HEALTH_REC_SNAPSHOT;
+  health_rec.hdr.ntasks = (uint8_t)n;
+  health_rec.hdr.dropped = health_dropped;
+  health_rec.hdr.tick = xTaskGetTickCount();
+  health_rec.hdr.run_delta = total - health_prev_total;
+  health_rec.hdr.heap_free = heap.xAvailableHeapSpaceInBytes;
+  health_rec.hdr.heap_min = heap.xMinimumEverFreeBytesRemaining;
+  health_rec.hdr.heap_largest = heap.xSizeOfLargestFreeBlockInBytes;
+  health_rec.hdr.heap_blocks = (uint16_t)heap.xNumberOfFreeBlocks;
+  health_rec.hdr.msp_used = (uint16_t)msp_used;
+  health_rec.hdr.msp_size = (uint16_t)msp_size;
+  health_rec.hdr.warn = warn;
+  health_rec.hdr.malloc_failed = health_malloc_failed;
+  health_rec.hdr.cycles = health_cycles;
+  health_rec.hdr.usb_pool_size = (uint16_t)pool.size;
+  health_rec.hdr.usb_pool_high = (uint16_t)pool.high_water;
+  health_prev_total = total;
+
+  len = sizeof(Health_HeaderTypeDef) + n * sizeof(Health_TaskTypeDef);
+  // 只有defaultTask写本通道, 不需要RTT锁
+  if ((SEGGER_RTT_WriteSkipNoLock(HEALTH_RTT_CHANNEL, &health_rec, len) != len) &&
+      (health_dropped < 255U)) {
+    health_dropped++;
+  }
+
+  health_cycles = DWT_GetCycles() - t0;
+}
+
+/**
+ * @brief  记录一次pvPortMalloc失败
+ */
+void Health_MallocFailed(void) {
+  if (health_malloc_failed < 255U) {
+    health_malloc_failed++;
+  }
+  TLOG("health: pvPortMalloc failed, free %u", xPortGetFreeHeapSize());
+}
@@ -21,7 +21,7 @@
 #include "i2s.h"
 
 /* USER CODE BEGIN 0 */
-
+#include "bootprof.h"
 /* USER CODE END 0 */
 
 I2S_HandleTypeDef hi2s2;
@@ -32,7 +32,7 @@ void MX_I2S2_Init(void)
 {
 
   /* USER CODE BEGIN I2S2_Init 0 */
-
+  BootProf_Mark(BOOT_MS_GPIO_DMA);
   /* USER CODE END I2S2_Init 0 */
 
   /* USER CODE BEGIN I2S2_Init 1 */
@@ -52,7 +52,7 @@ void MX_I2S2_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN I2S2_Init 2 */
-
+  BootProf_Mark(BOOT_MS_I2S2);
   /* USER CODE END I2S2_Init 2 */
 
 }
@@ -0,0 +1,219 @@
+/**
+******************************************************************************
+* @file           : input.c
+* @brief          : 按键事件队列与输入任务
+******************************************************************************
+* @attention
+*
+* 见input.h。
+*
+******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "input.h"
+#include "main.h"
+#include "button.h"
+#include "cmsis_os.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "dwt.h"
+#include "tlog.h"
+#ifdef USE_USBD_COMPOSITE
+#include "usbd_hid.h"
+#endif
+
+/* 私有类型
+ * -----------------------------------------------------------------*/
+
+typedef struct {
+  GPIO_TypeDef *port;
+  uint16_t pin;
+} Input_PinTypeDef;
+
+/* 私有变量
+ * -----------------------------------------------------------------*/
+
+#define INPUT_FLAG_EVENT 0x0001U   // 输入任务的线程标志: 队列有新事件
+
+#ifdef USE_USBD_COMPOSITE
+extern USBD_HandleTypeDef hUsbDeviceFS;
+
+static const uint8_t input_hid_key[INPUT_BTN_NUM] = {
+    HID_CC_MUTE,
+    HID_CC_PLAY_PAUSE,
+};
+#endif
+
+static const Input_PinTypeDef input_pins[INPUT_BTN_NUM] = {
+    {KEY_GPIO_Port, KEY_Pin},
+    {ROTARY_SW_GPIO_Port, ROTARY_SW_Pin},
+};
+
+// Button_Process返回的事件位与Input_EventTypeTypeDef的对应关系
+static const struct {
+  uint8_t bit;
+  uint8_t type;
+} input_evt_map[] = {
+    {BUTTON_EVT_PRESS, INPUT_EVT_PRESS},
+    {BUTTON_EVT_DOUBLE, INPUT_EVT_DOUBLE},
+    {BUTTON_EVT_LONG, INPUT_EVT_LONG},
+    {BUTTON_EVT_REPEAT, INPUT_EVT_REPEAT},
+    {BUTTON_EVT_RELEASE, INPUT_EVT_RELEASE},
+};
+
+static Button_HandleTypeDef input_buttons[INPUT_BTN_NUM];
+
+// 单写单读环形队列: head只由中断修改, tail只由输入任务修改
+static Input_EventTypeDef input_ring[INPUT_QUEUE_LEN];
+static volatile uint32_t input_head;
+static volatile uint32_t input_tail;
+
+static osThreadId_t input_task;
+static const osThreadAttr_t input_task_attributes = {
+  .name = "inputTask",
+  .stack_size = 128 * 4,
+  .priority = (osPriority_t) osPriorityAboveNormal,
+};
+
+static volatile uint32_t input_overflows;              // 队列满丢弃的事件数
+
+/* 私有函数
+ * -----------------------------------------------------------------*/
+
+/**
+ * @brief  读按键引脚
+ */
+static bool Input_ReadPin(void *user_data) {
+  const Input_PinTypeDef *p = (const Input_PinTypeDef *)user_data;
+  return HAL_GPIO_ReadPin(p->port, p->pin) == GPIO_PIN_SET;
+}
+
+/**
+ * @brief  从队列取一个事件
+ * @retval 0: 队列空
+ */
+static uint8_t Input_Get(Input_EventTypeDef *e) {
+  uint32_t tail = input_tail;
+
+  if (tail == input_head) {
+    return 0U;
+  }
+  __DMB();  // 先看到head再读槽位
+  *e = input_ring[tail & (INPUT_QUEUE_LEN - 1U)];
+  __DMB();  // 读完槽位再释放给写端
+  input_tail = tail + 1U;
+  return 1U;
+}
+
+/**
+ * @brief  处理一个事件
+ */
+static void Input_Handle(const Input_EventTypeDef *e) {
+  if ((e->type == INPUT_EVT_ROTARY_CW) || (e->type == INPUT_EVT_ROTARY_CCW)) {
+#ifdef USE_USBD_COMPOSITE
+    uint8_t key = (e->type == INPUT_EVT_ROTARY_CW) ? HID_CC_VOLUME_UP : HID_CC_VOLUME_DOWN;
+
+    // 加速后一步对应多次按键, HID队列满时剩余的丢弃
+    for (uint16_t i = 0U; i < e->value; i++) {
+      uint8_t ret;
+      taskENTER_CRITICAL();
+      ret = USBD_HID_SendKey(&hUsbDeviceFS, key);
+      taskEXIT_CRITICAL();
+      if (ret != USBD_OK) {
+        break;
+      }
+    }
+#endif
+    return;
+  }
+  if (e->button >= INPUT_BTN_NUM) {
+    return;
+  }
+  TLOG("input: button %u event %u, overflows %u", e->button, e->type, input_overflows);
+  if (e->type != INPUT_EVT_PRESS) {
+    return;
+  }
+
+#ifdef USE_USBD_COMPOSITE
+  // HID队列与OTG_FS中断共享, 临界区(BASEPRI)屏蔽OTG_FS后调用
+  taskENTER_CRITICAL();
+  (void)USBD_HID_SendKey(&hUsbDeviceFS, input_hid_key[e->button]);
+  taskEXIT_CRITICAL();
+#endif
+}
+
+/**
+ * @brief  输入任务: 阻塞等待事件
+ */
+static void Input_Task(void *argument) {
+  Input_EventTypeDef e;
+
+  (void)argument;
+  for (;;) {
+    (void)osThreadFlagsWait(INPUT_FLAG_EVENT, osFlagsWaitAny, osWaitForever);
+    while (Input_Get(&e)) {
+      Input_Handle(&e);
+    }
+  }
+}
+
+/* 函数实现
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  初始化按键并创建输入任务
+ */
+void Input_Init(void) {
+  for (uint32_t i = 0U; i < INPUT_BTN_NUM; i++) {
+    // 两个按键都是上拉输入, 按下为低电平
+    Button_Init(&input_buttons[i], Input_ReadPin, (void *)&input_pins[i], false);
+  }
+  input_task = osThreadNew(Input_Task, NULL, &input_task_attributes);
+}
+
+/**
+ * @brief  按键采样, 在TIM5的1ms中断中调用
+ */
+void Input_Tick(void) {
+  // TIM5在调度器启动前就已运行
+  if (input_task == NULL) {
+    return;
+  }
+  for (uint32_t i = 0U; i < INPUT_BTN_NUM; i++) {
+    uint8_t events = Button_Process(&input_buttons[i]);
+    if (events == BUTTON_EVT_NONE) {
+      continue;
+    }
+    for (uint32_t j = 0U; j < sizeof(input_evt_map) / sizeof(input_evt_map[0]); j++) {
+      if (events & input_evt_map[j].bit) {
+        Input_PostFromISR(input_evt_map[j].type, (uint8_t)i, 0U);
+      }
+    }
+  }
+}
+
+/**
+ * @brief  中断中投递一个事件
+ */
+void Input_PostFromISR(uint8_t type, uint8_t button, uint16_t value) {
+  uint32_t head = input_head;
+
+  if (input_task == NULL) {
+    input_overflows++;
+    return;
+  }
+  if ((head - input_tail) >= INPUT_QUEUE_LEN) {
+    input_overflows++;
+  } else {
+    Input_EventTypeDef *e = &input_ring[head & (INPUT_QUEUE_LEN - 1U)];
+    e->type = type;
+    e->button = button;
+    e->value = value;
+    e->ts = DWT_GetCycles();
+    __DMB();  // 槽位写完再发布head
+    input_head = head + 1U;
+  }
+  // 队列满时也唤醒, 让任务尽快腾出空间
+  (void)osThreadFlagsSet(input_task, INPUT_FLAG_EVENT);
+}
@@ -0,0 +1,173 @@
+/**
+******************************************************************************
+* @file           : irq_prof.c
+* @brief          : 中断延迟与执行时间剖析
+******************************************************************************
+* @attention
+*
+* 只在IRQ_PROF_ENABLE=1时编译，见irq_prof.h。
+*
+******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "irq_prof.h"
+
+#if IRQ_PROF_ENABLE
+
+#include <string.h>
+#include "i2s.h"
+#include "SEGGER_RTT.h"
+#include "ramfunc.h"
+
+/* 私有变量
+ * -----------------------------------------------------------------*/
+
+static IrqProf_TypeDef prof[RTS_ISR_NUM];
+
+static uint32_t prof_last_exit;              // 上一个被剖析ISR的退出时刻
+static uint8_t prof_last_id = RTS_ISR_NUM;   // 上一个被剖析ISR
+
+static const char *const prof_name[RTS_ISR_NUM] = {
+    "OTG_FS ", "DMA1_S4", "TIM5   ", "EXTI   ",
+};
+
+/* 私有函数
+ * -----------------------------------------------------------------*/
+
+/**
+ * @brief  直方图格号
+ * @param  cycles: 周期数
+ * @retval 0 ~ IRQ_PROF_BUCKETS-1
+ */
+static inline uint32_t IrqProf_Bucket(uint32_t cycles) {
+  uint32_t b = 32U - __CLZ(cycles >> 7);
+  return (b < IRQ_PROF_BUCKETS) ? b : (IRQ_PROF_BUCKETS - 1U);
+}
+
+/**
+ * @brief  累计一个样本
+ */
+static inline void IrqProf_Add(IrqProf_StatTypeDef *s, uint32_t v, uint32_t first) {
+  if (first || (v < s->min)) {
+    s->min = v;
+  }
+  if (v > s->max) {
+    s->max = v;
+  }
+  s->sum += v;
+  s->hist[IrqProf_Bucket(v)]++;
+}
+
+/**
+ * @brief  输出一组统计
+ */
+static void IrqProf_PrintStat(const char *what, const IrqProf_StatTypeDef *s, uint32_t n) {
+  SEGGER_RTT_printf(0, "  %s min %u max %u mean %u |", what, (unsigned)s->min,
+                    (unsigned)s->max, (unsigned)(s->sum / n));
+  for (uint32_t i = 0; i < IRQ_PROF_BUCKETS; i++) {
+    SEGGER_RTT_printf(0, " %u", (unsigned)s->hist[i]);
+  }
+  SEGGER_RTT_printf(0, "\r\n");
+}
+
+/* 函数实现
+ * -------------------------------------------------------------------*/
+
+// Enter/Exit/DmaLatency由SRAM中的ISR调用, 同样放入SRAM
+
+/**
+ * @brief  ISR入口
+ * @param  id: 中断编号
+ * @param  t0: 入口DWT周期数
+ * @param  latency: 事件到入口的周期数, 无法测量时为0
+ */
+RAMFUNC void IrqProf_Enter(RTStats_IsrTypeDef id, uint32_t t0, uint32_t latency) {
+  IrqProf_TypeDef *p = &prof[id];
+
+  if ((prof_last_id < RTS_ISR_NUM) && ((t0 - prof_last_exit) < IRQ_PROF_CHAIN_CYCLES)) {
+    p->blocked_by[prof_last_id]++;
+  }
+  IrqProf_Add(&p->latency, latency, p->count == 0U);
+}
+
+/**
+ * @brief  ISR出口
+ * @param  id: 中断编号
+ * @param  t0: 入口DWT周期数
+ * @param  t1: 出口DWT周期数
+ */
+RAMFUNC void IrqProf_Exit(RTStats_IsrTypeDef id, uint32_t t0, uint32_t t1) {
+  IrqProf_TypeDef *p = &prof[id];
+
+  IrqProf_Add(&p->exec, t1 - t0, p->count == 0U);
+  p->count++;
+  prof_last_exit = t1;
+  prof_last_id = (uint8_t)id;
+}
+
+/**
+ * @brief  DMA1_Stream4入口延迟, 必须在HAL清除标志之前调用
+ * @retval 周期数, 没有HT/TC标志时为0
+ */
+RAMFUNC uint32_t IrqProf_DmaLatency(void) {
+  uint32_t hisr = DMA1->HISR;
+  uint32_t ndtr = hi2s2.hdmatx->Instance->NDTR;
+  uint32_t size = hi2s2.TxXferSize;   // 循环模式下每轮的半字数
+  uint32_t expect;
+
+  // TC时NDTR已重装为size, HT时为size/2, 之后每发送一个半字减1
+  if (hisr & DMA_HISR_TCIF4) {
+    expect = size;
+  } else if (hisr & DMA_HISR_HTIF4) {
+    expect = size / 2U;
+  } else {
+    return 0U;
+  }
+  if (ndtr > expect) {
+    return 0U;
+  }
+  // 16位立体声: 每个采样周期发送2个半字
+  return (expect - ndtr) * (SystemCoreClock / (hi2s2.Init.AudioFreq * 2U));
+}
+
+/**
+ * @brief  读取一个中断的剖析数据
+ * @param  id: 中断编号
+ * @param  out: 输出
+ * @param  reset: 读后清零
+ */
+void IrqProf_Get(RTStats_IsrTypeDef id, IrqProf_TypeDef *out, uint8_t reset) {
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  *out = prof[id];
+  if (reset) {
+    memset(&prof[id], 0, sizeof(prof[id]));
+  }
+  __set_PRIMASK(primask);
+}
+
+/**
+ * @brief  通过RTT输出并清零全部剖析数据
+ */
+void IrqProf_Print(void) {
+  IrqProf_TypeDef p;
+
+  SEGGER_RTT_printf(0, "IRQ profile (cycles, hist <128 <256 ... >=8192)\r\n");
+  for (uint32_t i = 0; i < RTS_ISR_NUM; i++) {
+    IrqProf_Get((RTStats_IsrTypeDef)i, &p, 1U);
+    if (p.count == 0U) {
+      continue;
+    }
+    SEGGER_RTT_printf(0, "%s n %u  blocked by", prof_name[i], (unsigned)p.count);
+    for (uint32_t j = 0; j < RTS_ISR_NUM; j++) {
+      SEGGER_RTT_printf(0, " %u", (unsigned)p.blocked_by[j]);
+    }
+    SEGGER_RTT_printf(0, "\r\n");
+    IrqProf_PrintStat("exec", &p.exec, p.count);
+    IrqProf_PrintStat("lat ", &p.latency, p.count);
+  }
+}
+
+#endif /* IRQ_PROF_ENABLE */
@@ -0,0 +1,364 @@
+/**
+******************************************************************************
+* @file           : kvstore.c
+* @brief          : 双扇区日志式键值存储实现（平台无关）
+******************************************************************************
+* @attention
+*
+* 见kvstore.h。记录扫描规则:
+*   - key和len都是0xFFFF: 日志结束，此处即下一条记录的写入位置
+*   - len超过KV_MAX_VALUE或越过扇区末尾: 日志损坏，视为扇区已满，
+*     下次写入时压缩
+*   - CRC不对: 写了一半的记录，跳过
+*
+******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "kvstore.h"
+#include <string.h>
+
+/* 私有宏定义
+ * -----------------------------------------------------------------*/
+
+#define KV_MAGIC 0x3153564BU       // "KVS1"
+#define KV_SECTOR_HEADER 8U        // magic + seq
+#define KV_RECORD_HEADER 8U        // key + len + crc
+#define KV_KEY_NONE 0xFFFFU
+#define KV_PAD(len) (((len) + 3U) & ~3U)
+
+/* 私有类型
+ * -----------------------------------------------------------------*/
+
+typedef struct {
+  uint16_t key;
+  uint16_t len;
+  uint32_t crc;
+} KV_RecordTypeDef;
+
+typedef enum {
+  KV_REC_VALID = 0,
+  KV_REC_BAD,      // CRC错误, 跳过
+  KV_REC_END,      // 日志结束
+  KV_REC_CORRUPT,  // 无法继续解析
+} KV_RecTypeDef;
+
+/* 私有函数
+ * -----------------------------------------------------------------*/
+
+/**
+ * @brief  CRC-32(IEEE 802.3), 逐位计算, 记录很短不需要查表
+ */
+static uint32_t KV_Crc32(uint32_t crc, const uint8_t *data, uint32_t len) {
+  crc = ~crc;
+  while (len--) {
+    crc ^= *data++;
+    for (uint8_t i = 0; i < 8U; i++) {
+      crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+    }
+  }
+  return ~crc;
+}
+
+/**
+ * @brief  记录的CRC: 覆盖key、len和数据
+ */
+static uint32_t KV_RecordCrc(uint16_t key, uint16_t len, const uint8_t *data) {
+  uint8_t hdr[4] = {(uint8_t)key, (uint8_t)(key >> 8), (uint8_t)len, (uint8_t)(len >> 8)};
+  return KV_Crc32(KV_Crc32(0U, hdr, 4U), data, len);
+}
+
+/**
+ * @brief  解析off处的记录
+ */
+static KV_RecTypeDef KV_Parse(const KV_HandleTypeDef *hkv, uint8_t sector, uint32_t off,
+                              KV_RecordTypeDef *rec) {
+  const uint8_t *base = hkv->flash->sector[sector];
+  uint32_t size = hkv->flash->sector_size;
+
+  if (off + KV_RECORD_HEADER > size) {
+    return KV_REC_END;
+  }
+  memcpy(rec, base + off, sizeof(*rec));
+  if ((rec->key == KV_KEY_NONE) && (rec->len == 0xFFFFU)) {
+    return KV_REC_END;
+  }
+  if ((rec->len > KV_MAX_VALUE) || (off + KV_RECORD_HEADER + KV_PAD(rec->len) > size)) {
+    return KV_REC_CORRUPT;
+  }
+  if ((rec->key == KV_KEY_NONE) ||
+      (KV_RecordCrc(rec->key, rec->len, base + off + KV_RECORD_HEADER) != rec->crc)) {
+    return KV_REC_BAD;
+  }
+  return KV_REC_VALID;
+}
+
+/**
+ * @brief  在扇区中查找key的最新有效记录
+ * @param  end: 输出日志末尾(下一条记录的写入位置), 损坏时为扇区大小
+ * @retval 记录偏移, 0表示没有找到
+ */
+static uint32_t KV_Find(const KV_HandleTypeDef *hkv, uint8_t sector, uint16_t key,
+                        uint32_t *end) {
+  KV_RecordTypeDef rec;
+  uint32_t off = KV_SECTOR_HEADER;
+  uint32_t found = 0U;
+
+  for (;;) {
+    KV_RecTypeDef r = KV_Parse(hkv, sector, off, &rec);
+    if (r == KV_REC_END) {
+      break;
+    }
+    if (r == KV_REC_CORRUPT) {
+      off = hkv->flash->sector_size;
+      break;
+    }
+    if ((r == KV_REC_VALID) && (rec.key == key)) {
+      found = off;
+    }
+    off += KV_RECORD_HEADER + KV_PAD(rec.len);
+  }
+  if (end != NULL) {
+    *end = off;
+  }
+  return found;
+}
+
+/**
+ * @brief  扇区头是否有效
+ */
+static bool KV_SectorValid(const KV_HandleTypeDef *hkv, uint8_t sector, uint32_t *seq) {
+  uint32_t hdr[2];
+
+  memcpy(hdr, hkv->flash->sector[sector], sizeof(hdr));
+  *seq = hdr[1];
+  return (hdr[0] == KV_MAGIC) && (hdr[1] != 0xFFFFFFFFU);
+}
+
+/**
+ * @brief  扇区是否全部为0xFF
+ */
+static bool KV_SectorBlank(const KV_HandleTypeDef *hkv, uint8_t sector) {
+  const uint8_t *p = hkv->flash->sector[sector];
+
+  for (uint32_t i = 0U; i < hkv->flash->sector_size; i += 4U) {
+    uint32_t w;
+    memcpy(&w, p + i, 4U);
+    if (w != 0xFFFFFFFFU) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief  在sector的off处写一条记录
+ */
+static bool KV_Write(KV_HandleTypeDef *hkv, uint8_t sector, uint32_t off, uint16_t key,
+                     const void *data, uint16_t len) {
+  uint32_t buf[(KV_RECORD_HEADER + KV_MAX_VALUE) / 4U];
+  KV_RecordTypeDef rec = {key, len, KV_RecordCrc(key, len, (const uint8_t *)data)};
+
+  // 头在前, 数据在后, 按地址顺序编程; 补齐部分保持0xFF
+  memset(buf, 0xFF, sizeof(buf));
+  memcpy(buf, &rec, sizeof(rec));
+  memcpy((uint8_t *)buf + KV_RECORD_HEADER, data, len);
+  return hkv->flash->program(hkv->flash->ctx, hkv->flash->sector[sector] + off, buf,
+                             KV_RECORD_HEADER + KV_PAD(len));
+}
+
+/**
+ * @brief  作废KV_Write()没写完的记录: 头按原值补写, CRC写0, 解析时按len跳过
+ * @retval false: 头也写不进去, 这个位置之后不能再解析
+ */
+static bool KV_Kill(KV_HandleTypeDef *hkv, uint8_t sector, uint32_t off, uint16_t key,
+                    uint16_t len) {
+  KV_RecordTypeDef rec = {key, len, 0U};
+
+  return hkv->flash->program(hkv->flash->ctx, hkv->flash->sector[sector] + off, &rec,
+                             sizeof(rec));
+}
+
+/**
+ * @brief  把活动扇区中每个key的最新值复制到备用扇区, 然后切换
+ * @note   正要写入的key也复制旧值, 否则新记录写入前掉电会丢失这个key
+ */
+static KV_StatusTypeDef KV_Compact(KV_HandleTypeDef *hkv) {
+  uint16_t keys[KV_MAX_KEYS];
+  uint32_t nkeys = 0U;
+  uint8_t src = hkv->active;
+  uint8_t dst = src ^ 1U;
+  uint32_t off = KV_SECTOR_HEADER;
+  uint32_t out = KV_SECTOR_HEADER;
+  uint32_t hdr[2];
+  KV_RecordTypeDef rec;
+  KV_RecTypeDef r;
+
+  if (hkv->erase_pending) {
+    return KV_BUSY;
+  }
+
+  // 步骤1: 收集出现过的key
+  while (((r = KV_Parse(hkv, src, off, &rec)) != KV_REC_END) && (r != KV_REC_CORRUPT)) {
+    if (r == KV_REC_VALID) {
+      uint32_t i;
+      for (i = 0U; (i < nkeys) && (keys[i] != rec.key); i++) {
+      }
+      if ((i == nkeys) && (nkeys < KV_MAX_KEYS)) {
+        keys[nkeys++] = rec.key;
+      }
+    }
+    off += KV_RECORD_HEADER + KV_PAD(rec.len);
+  }
+
+  // 步骤2: 复制每个key的最新记录
+  for (uint32_t i = 0U; i < nkeys; i++) {
+    uint32_t at = KV_Find(hkv, src, keys[i], NULL);
+    const uint8_t *p = hkv->flash->sector[src] + at;
+    memcpy(&rec, p, sizeof(rec));
+    if (!KV_Write(hkv, dst, out, rec.key, p + KV_RECORD_HEADER, rec.len)) {
+      hkv->erase_pending = true;  // 备用扇区已写脏, 擦除后才能再压缩
+      return KV_ERROR;
+    }
+    out += KV_RECORD_HEADER + KV_PAD(rec.len);
+  }
+
+  // 步骤3: 最后写扇区头, 新扇区从此生效, 旧扇区待擦除
+  hdr[0] = KV_MAGIC;
+  hdr[1] = hkv->seq + 1U;
+  if (!hkv->flash->program(hkv->flash->ctx, hkv->flash->sector[dst], hdr, sizeof(hdr))) {
+    hkv->erase_pending = true;
+    return KV_ERROR;
+  }
+  hkv->active = dst;
+  hkv->seq = hdr[1];
+  hkv->write_off = out;
+  hkv->erase_pending = true;
+  return KV_OK;
+}
+
+/* 函数实现
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  扫描两个扇区，恢复存储状态
+ */
+KV_StatusTypeDef KV_Init(KV_HandleTypeDef *hkv, const KV_FlashTypeDef *flash) {
+  uint32_t seq0, seq1;
+  bool valid0, valid1;
+
+  hkv->flash = flash;
+  valid0 = KV_SectorValid(hkv, 0U, &seq0);
+  valid1 = KV_SectorValid(hkv, 1U, &seq1);
+
+  if (!valid0 && !valid1) {
+    // 首次上电: 格式化扇区0
+    uint32_t hdr[2] = {KV_MAGIC, 1U};
+    if (!KV_SectorBlank(hkv, 0U) && !flash->erase(flash->ctx, 0U)) {
+      return KV_ERROR;
+    }
+    if (!flash->program(flash->ctx, flash->sector[0], hdr, sizeof(hdr))) {
+      return KV_ERROR;
+    }
+    valid0 = true;
+    seq0 = 1U;
+  }
+
+  // 两个都有效说明压缩后旧扇区还没擦, 序号大的(允许回绕)是新的
+  if (valid0 && (!valid1 || ((int32_t)(seq0 - seq1) > 0))) {
+    hkv->active = 0U;
+    hkv->seq = seq0;
+  } else {
+    hkv->active = 1U;
+    hkv->seq = seq1;
+  }
+  hkv->erase_pending = !KV_SectorBlank(hkv, hkv->active ^ 1U);
+  (void)KV_Find(hkv, hkv->active, KV_KEY_NONE, &hkv->write_off);
+  return KV_OK;
+}
+
+/**
+ * @brief  读取一个key的最新值
+ */
+KV_StatusTypeDef KV_Get(KV_HandleTypeDef *hkv, uint16_t key, void *buf,
+                        uint32_t size, uint32_t *len) {
+  KV_RecordTypeDef rec;
+  const uint8_t *p;
+  uint32_t at = KV_Find(hkv, hkv->active, key, NULL);
+
+  if ((at == 0U) || (key == KV_KEY_NONE)) {
+    return KV_NOT_FOUND;
+  }
+  p = hkv->flash->sector[hkv->active] + at;
+  memcpy(&rec, p, sizeof(rec));
+  memcpy(buf, p + KV_RECORD_HEADER, (rec.len < size) ? rec.len : size);
+  if (len != NULL) {
+    *len = rec.len;
+  }
+  return KV_OK;
+}
+
+/**
+ * @brief  写入一个key
+ */
+KV_StatusTypeDef KV_Set(KV_HandleTypeDef *hkv, uint16_t key, const void *data,
+                        uint32_t len) {
+  uint32_t at;
+  uint32_t need = KV_RECORD_HEADER + KV_PAD(len);
+
+  if ((key == KV_KEY_NONE) || (len > KV_MAX_VALUE)) {
+    return KV_ERROR;
+  }
+
+  // 值没有变化时不写, 省一次编程
+  at = KV_Find(hkv, hkv->active, key, NULL);
+  if (at != 0U) {
+    const uint8_t *p = hkv->flash->sector[hkv->active] + at;
+    KV_RecordTypeDef rec;
+    memcpy(&rec, p, sizeof(rec));
+    if ((rec.len == len) && (memcmp(p + KV_RECORD_HEADER, data, len) == 0)) {
+      return KV_OK;
+    }
+  }
+
+  if (hkv->write_off + need > hkv->flash->sector_size) {
+    KV_StatusTypeDef st = KV_Compact(hkv);
+    if (st != KV_OK) {
+      return st;
+    }
+    if (hkv->write_off + need > hkv->flash->sector_size) {
+      return KV_ERROR;  // 压缩后仍放不下, 扇区相对key数太小
+    }
+  }
+  if (!KV_Write(hkv, hkv->active, hkv->write_off, key, data, (uint16_t)len)) {
+    // 写了一半的位置再编程只会把位与进去: 作废它, 下一条写在后面;
+    // 作废也失败就当扇区已满, 下次写入时压缩
+    hkv->write_off = KV_Kill(hkv, hkv->active, hkv->write_off, key, (uint16_t)len)
+                         ? hkv->write_off + need
+                         : hkv->flash->sector_size;
+    return KV_ERROR;
+  }
+  hkv->write_off += need;
+  return KV_OK;
+}
+
+/**
+ * @brief  是否有备用扇区等待擦除
+ */
+bool KV_ErasePending(const KV_HandleTypeDef *hkv) {
+  return hkv->erase_pending;
+}
+
+/**
+ * @brief  擦除备用扇区
+ */
+KV_StatusTypeDef KV_EraseSpare(KV_HandleTypeDef *hkv) {
+  if (!hkv->erase_pending) {
+    return KV_OK;
+  }
+  if (!hkv->flash->erase(hkv->flash->ctx, hkv->active ^ 1U)) {
+    return KV_ERROR;
+  }
+  hkv->erase_pending = false;
+  return KV_OK;
+}
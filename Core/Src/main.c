@@ -32,6 +32,15 @@
 #include "SEGGER_RTT.h"
 #include "rotary.h"
 #include "usbd_audio_if.h"
+#include "ramfunc.h"
+#include "dwt.h"
+#include "trace.h"
+#include "tlog.h"
+#include "health.h"
+#include "input.h"
+#include "settings.h"
+#include "bootprof.h"
+#include "runtime_stats.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -41,7 +50,8 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
-
+// 编码器解码方式: 0=EXTI1/2边沿中断(默认), 1=TIM5 1ms轮询(抖动严重的编码器)
+#define ROTARY_POLL 0
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -53,16 +63,22 @@
 
 /* USER CODE BEGIN PV */
 volatile long long FreeRTOSRunTimeTicks;
-volatile uint8_t key_press = 0;
-volatile uint8_t rotary_key_press = 0;
 Rotary_HandleTypeDef hrotary;
+// 编码器加速表(us): 平滑步间隔越短, 每步发送的音量键越多
+static const Rotary_AccelTypeDef rotary_accel[] = {
+  {4000U, 8U},
+  {10000U, 4U},
+  {25000U, 2U},
+};
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 void MX_FREERTOS_Init(void);
 /* USER CODE BEGIN PFP */
-
+#ifdef RAMFUNC_BENCH
+static void RamFunc_Benchmark(void);
+#endif
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -73,6 +89,34 @@ bool read_rotary_a(void *data) {
 bool read_rotary_b(void *data) {
   return HAL_GPIO_ReadPin(ROTARY_DT_GPIO_Port, ROTARY_DT_Pin) == GPIO_PIN_SET;
 }
+
+/**
+  * @brief  推进编码器状态机, 完成一步时投递带时间戳的事件
+  * @note   只在优先级5的中断(EXTI1/2或TIM5)中调用, 彼此不会抢占
+  */
+static void Rotary_Update(void)
+{
+  // CLK(A相)与DT(B相)同在GPIOB, 读一次IDR即可, 不经函数指针
+  uint32_t idr = ROTARY_CLK_GPIO_Port->IDR;
+  uint8_t pins = (uint8_t)((((idr & ROTARY_DT_Pin) != 0U) << 1) | ((idr & ROTARY_CLK_Pin) != 0U));
+  uint8_t result = Rotary_ProcessPins(&hrotary, pins);
+  int16_t steps;
+
+  if (result == ROTARY_DIR_NONE)
+  {
+    return;
+  }
+  // 时间戳用64位周期数换算的us: CYCCNT/96在44.7s处跳回0, 相减得到的间隔是错的
+  steps = Rotary_Accelerate(&hrotary, result, RTStats_Micros());
+  if (steps > 0)
+  {
+    Input_PostFromISR(INPUT_EVT_ROTARY_CW, 0U, (uint16_t)steps);
+  }
+  else
+  {
+    Input_PostFromISR(INPUT_EVT_ROTARY_CCW, 0U, (uint16_t)-steps);
+  }
+}
 /* USER CODE END 0 */
 
 /**
@@ -83,7 +127,7 @@ int main(void)
 {
 
   /* USER CODE BEGIN 1 */
-
+  BootProf_Init();
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -92,27 +136,45 @@ int main(void)
   HAL_Init();
 
   /* USER CODE BEGIN Init */
-
+  BootProf_Mark(BOOT_MS_HAL);
   /* USER CODE END Init */
 
   /* Configure the system clock */
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
-
+  BootProf_Mark(BOOT_MS_CLOCK);
+  // 日志通道只依赖DWT和RAM, 在USB中断可能出现之前就绪
+  SEGGER_RTT_Init();
+  Trace_Init();   // 在创建任务之前, 以记录全部TASK_CREATE
+  Health_Init();
+  TLog_Init();    // 在固定通道之后分配
+  // 首次上电要擦除扇区(约250ms, CPU停顿): 在上拉D+之前完成, 否则主机复位
+  // 后收不到SETUP的应答, 枚举超时。AUDIO_Init_FS也要用恢复的静音状态
+  Settings_Init();
+  // USB尽早启动: 上拉D+后主机先要等100ms连接消抖, 其余初始化与之重叠。
+  // USB只依赖时钟, 枚举到SET_CONFIGURATION时下面的外设早已就绪。
+  // .ioc中MX_USB_DEVICE_Init设为不生成调用, 不再在默认任务中初始化
+  MX_USB_DEVICE_Init();
+  // 在MX_GPIO_Init使能EXTI1/2之前初始化
+  Rotary_Init(&hrotary, read_rotary_a, NULL, read_rotary_b, NULL);
+  Rotary_SetAccel(&hrotary, rotary_accel, sizeof(rotary_accel) / sizeof(rotary_accel[0]));
   /* USER CODE END SysInit */
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
   MX_DMA_Init();
-  MX_TIM5_Init();
-  MX_USART1_UART_Init();
-  MX_TIM3_Init();
   MX_I2S2_Init();
   /* USER CODE BEGIN 2 */
-  SEGGER_RTT_Init();
-  Rotary_Init(&hrotary, read_rotary_a, NULL, read_rotary_b, NULL);
-  HAL_TIM_Base_Start_IT(&htim5);
+  // TIM5、USART1、TIM3与音频无关, .ioc中设为不生成调用, 在默认任务中初始化
+#if ROTARY_POLL
+  HAL_NVIC_DisableIRQ(ROTARY_DT_EXTI_IRQn);
+  HAL_NVIC_DisableIRQ(ROTARY_CLK_EXTI_IRQn);
+#endif
+#ifdef RAMFUNC_BENCH
+  RamFunc_Benchmark();
+#endif
+  BootProf_Mark(BOOT_MS_APP);
   /* USER CODE END 2 */
 
   /* Init scheduler */
@@ -185,37 +247,23 @@ void SystemClock_Config(void)
 /* USER CODE BEGIN 4 */
 void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
 {
-    if(GPIO_Pin == KEY_Pin)
+#if !ROTARY_POLL
+    // A/B任一相的边沿都推进状态机, 空闲时没有中断
+    if((GPIO_Pin == ROTARY_DT_Pin) || (GPIO_Pin == ROTARY_CLK_Pin))
     {
-      static uint32_t key_last_tick = 0;
-      uint32_t now = HAL_GetTick();
-      if (now - key_last_tick < 50) {
-          return; //消抖50ms
-      }
-      key_last_tick = now;
-      key_press = 1;
-    }
-
-    if(GPIO_Pin == ROTARY_SW_Pin)
-    {
-      static uint32_t rotary_key_last_tick = 0;
-      uint32_t now = HAL_GetTick();
-      if (now - rotary_key_last_tick < 50) {
-          return; //消抖50ms
-      }
-      rotary_key_last_tick = now;
-      rotary_key_press = 1;
+      Rotary_Update();
     }
+#endif
 }
 
-void HAL_I2S_TxHalfCpltCallback(I2S_HandleTypeDef *hi2s)
+RAMFUNC void HAL_I2S_TxHalfCpltCallback(I2S_HandleTypeDef *hi2s)
 {
 	if(hi2s == &hi2s2){
 		HalfTransfer_CallBack_FS();
 	}
 }
  
-void HAL_I2S_TxCpltCallback(I2S_HandleTypeDef *hi2s)
+RAMFUNC void HAL_I2S_TxCpltCallback(I2S_HandleTypeDef *hi2s)
 {
 	if(hi2s == &hi2s2){
 		TransferComplete_CallBack_FS();
@@ -241,6 +289,61 @@ void AudioCard_Play(uint16_t* buff, uint16_t size)//声卡模式开始播放
 {
 	HAL_I2S_Transmit_DMA(&hi2s2, buff, size);
 }
+ 
+void AudioCard_Resync(uint16_t* buff, uint16_t size)//漂移校正: 按新长度重启循环DMA
+{
+	// 循环DMA一直处于BUSY_TX, 再调HAL_I2S_Transmit_DMA只会返回HAL_BUSY, 所以先停再启
+	// 由TC中断调用, DMA刚回绕到缓冲区开头, 重启只重放FIFO里的几个采样; 长度不变时什么也不做
+	if(hi2s2.TxXferSize == size){
+		return;
+	}
+	HAL_I2S_DMAStop(&hi2s2);
+	HAL_I2S_Transmit_DMA(&hi2s2, buff, size);
+}
+
+#ifdef RAMFUNC_BENCH
+/**
+  * @brief  测量放入SRAM的热点函数的执行周期数
+  * @note   分别在定义/不定义USE_RAMFUNC时编译运行，对比RTT输出。
+  *         USB未启动时I2S回调在USBD_AUDIO_Sync入口即返回，测的是调用路径开销。
+  */
+static void RamFunc_Benchmark(void)
+{
+  uint32_t min_rot = 0xFFFFFFFFU, max_rot = 0U;
+  uint32_t min_i2s = 0xFFFFFFFFU, max_i2s = 0U;
+  uint32_t min_bat = 0xFFFFFFFFU, max_bat = 0U;
+  // 与hrotary同一个编码器, 每次只读一次GPIOB->IDR
+  Rotary_BatchTypeDef enc[1] = {{0U, 2U, 0U, 1U, ROTARY_MODE_HALF, 0U}};
+
+  DWT_Init();
+  for (uint32_t i = 0; i < 1000U; i++)
+  {
+    uint32_t t0 = DWT_GetCycles();
+    (void)Rotary_Process(&hrotary);
+    uint32_t t1 = DWT_GetCycles();
+    HAL_I2S_TxHalfCpltCallback(&hi2s2);
+    uint32_t t2 = DWT_GetCycles();
+    uint32_t port = ROTARY_CLK_GPIO_Port->IDR;
+    (void)Rotary_ProcessBatch(enc, 1U, &port);
+    uint32_t t3 = DWT_GetCycles();
+
+    if (t1 - t0 < min_rot) min_rot = t1 - t0;
+    if (t1 - t0 > max_rot) max_rot = t1 - t0;
+    if (t2 - t1 < min_i2s) min_i2s = t2 - t1;
+    if (t2 - t1 > max_i2s) max_i2s = t2 - t1;
+    if (t3 - t2 < min_bat) min_bat = t3 - t2;
+    if (t3 - t2 > max_bat) max_bat = t3 - t2;
+  }
+#ifdef USE_RAMFUNC
+  SEGGER_RTT_printf(0, "RAMFUNC bench (SRAM)\r\n");
+#else
+  SEGGER_RTT_printf(0, "RAMFUNC bench (Flash)\r\n");
+#endif
+  SEGGER_RTT_printf(0, "Rotary_Process      min %u max %u cycles\r\n", min_rot, max_rot);
+  SEGGER_RTT_printf(0, "Rotary batch (1)    min %u max %u cycles\r\n", min_bat, max_bat);
+  SEGGER_RTT_printf(0, "I2S TxHalfCplt path min %u max %u cycles\r\n", min_i2s, max_i2s);
+}
+#endif
 
 /* USER CODE END 4 */
 
@@ -275,18 +378,12 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
       HAL_GPIO_TogglePin(LED_GPIO_Port, LED_Pin);
     }
 
-    // 调用编码器处理函数
-    uint8_t result = Rotary_Process(&hrotary);
-    // 根据返回值更新计数器
-    if (result == ROTARY_DIR_CW) // 顺时针
-    {
+    // 按键消抖与手势识别, 事件交给输入任务
+    Input_Tick();
 
-    }
-    else if (result == ROTARY_DIR_CCW) // 逆时针
-    {
-
-    }
-    // result == ROTARY_DIR_NONE时不做处理
+#if ROTARY_POLL
+    Rotary_Update();
+#endif
   }
   /* USER CODE END Callback 1 */
 }
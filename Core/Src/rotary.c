@@ -43,15 +43,14 @@
 // 状态机起始状态
 #define R_START 0x0
 
-#ifdef ROTARY_HALF_STEP
 // ========== 半步模式状态定义 ==========
 // 半步模式在00和11位置都触发事件，分辨率翻倍
 
-#define R_CCW_BEGIN 0x1   // 开始逆时针旋转(从00进入)
-#define R_CW_BEGIN 0x2    // 开始顺时针旋转(从00进入)
-#define R_START_M 0x3     // 中间状态(11位置)
-#define R_CW_BEGIN_M 0x4  // 开始顺时针旋转(从11进入)
-#define R_CCW_BEGIN_M 0x5 // 开始逆时针旋转(从11进入)
+#define H_CCW_BEGIN 0x1   // 开始逆时针旋转(从00进入)
+#define H_CW_BEGIN 0x2    // 开始顺时针旋转(从00进入)
+#define H_START_M 0x3     // 中间状态(11位置)
+#define H_CW_BEGIN_M 0x4  // 开始顺时针旋转(从11进入)
+#define H_CCW_BEGIN_M 0x5 // 开始逆时针旋转(从11进入)
 
 /**
  * @brief 半步模式状态转移表
@@ -59,26 +58,25 @@
  *        列索引: 引脚状态 00,01,10,11 (B相<<1 | A相)
  *        表值: 新状态 (低4位=状态编号, 高4位=方向事件)
  */
-static const uint8_t state_table[6][4] = {
+static const uint8_t half_table[6][4] = {
     // 当前状态          引脚状态: 00          01          10          11
-    /* R_START      */ {R_START_M, R_CW_BEGIN, R_CCW_BEGIN, R_START},
-    /* R_CCW_BEGIN  */ {R_START_M | ROTARY_DIR_CCW, R_START, R_CCW_BEGIN, R_START},
-    /* R_CW_BEGIN   */ {R_START_M | ROTARY_DIR_CW, R_CW_BEGIN, R_START, R_START},
-    /* R_START_M    */ {R_START_M, R_CCW_BEGIN_M, R_CW_BEGIN_M, R_START},
-    /* R_CW_BEGIN_M */ {R_START_M, R_START_M, R_CW_BEGIN_M, R_START | ROTARY_DIR_CW},
-    /* R_CCW_BEGIN_M*/ {R_START_M, R_CCW_BEGIN_M, R_START_M, R_START | ROTARY_DIR_CCW},
+    /* R_START      */ {H_START_M, H_CW_BEGIN, H_CCW_BEGIN, R_START},
+    /* H_CCW_BEGIN  */ {H_START_M | ROTARY_DIR_CCW, R_START, H_CCW_BEGIN, R_START},
+    /* H_CW_BEGIN   */ {H_START_M | ROTARY_DIR_CW, H_CW_BEGIN, R_START, R_START},
+    /* H_START_M    */ {H_START_M, H_CCW_BEGIN_M, H_CW_BEGIN_M, R_START},
+    /* H_CW_BEGIN_M */ {H_START_M, H_START_M, H_CW_BEGIN_M, R_START | ROTARY_DIR_CW},
+    /* H_CCW_BEGIN_M*/ {H_START_M, H_CCW_BEGIN_M, H_START_M, R_START | ROTARY_DIR_CCW},
 };
 
-#else
 // ========== 全步模式状态定义 ==========
 // 全步模式只在00位置触发事件(对应机械咔嗒声)
 
-#define R_CW_FINAL 0x1  // 顺时针即将完成
-#define R_CW_BEGIN 0x2  // 顺时针开始
-#define R_CW_NEXT 0x3   // 顺时针进行中
-#define R_CCW_BEGIN 0x4 // 逆时针开始
-#define R_CCW_FINAL 0x5 // 逆时针即将完成
-#define R_CCW_NEXT 0x6  // 逆时针进行中
+#define F_CW_FINAL 0x1  // 顺时针即将完成
+#define F_CW_BEGIN 0x2  // 顺时针开始
+#define F_CW_NEXT 0x3   // 顺时针进行中
+#define F_CCW_BEGIN 0x4 // 逆时针开始
+#define F_CCW_FINAL 0x5 // 逆时针即将完成
+#define F_CCW_NEXT 0x6  // 逆时针进行中
 
 /**
  * @brief 全步模式状态转移表
@@ -87,21 +85,44 @@ static const uint8_t state_table[6][4] = {
  *        表值: 新状态 (低4位=状态编号, 高4位=方向事件)
  *
  * 状态转移路径示例(顺时针):
- *   R_START(00) -> R_CW_BEGIN(10) -> R_CW_NEXT(11) -> R_CW_FINAL(01) ->
+ *   R_START(00) -> F_CW_BEGIN(10) -> F_CW_NEXT(11) -> F_CW_FINAL(01) ->
  * R_START|DIR_CW(00)
  */
-static const uint8_t state_table[7][4] = {
+static const uint8_t full_table[7][4] = {
     // 当前状态          引脚状态: 00              01              10              11
-    /* R_START     */ {R_START, R_CW_BEGIN, R_CCW_BEGIN, R_START},
-    /* R_CW_FINAL  */ {R_CW_NEXT, R_START, R_CW_FINAL, R_START | ROTARY_DIR_CW},
-    /* R_CW_BEGIN  */ {R_CW_NEXT, R_CW_BEGIN, R_START, R_START},
-    /* R_CW_NEXT   */ {R_CW_NEXT, R_CW_BEGIN, R_CW_FINAL, R_START},
-    /* R_CCW_BEGIN */ {R_CCW_NEXT, R_START, R_CCW_BEGIN, R_START},
-    /* R_CCW_FINAL */ {R_CCW_NEXT, R_CCW_FINAL, R_START, R_START | ROTARY_DIR_CCW},
-    /* R_CCW_NEXT  */ {R_CCW_NEXT, R_CCW_FINAL, R_CCW_BEGIN, R_START},
+    /* R_START     */ {R_START, F_CW_BEGIN, F_CCW_BEGIN, R_START},
+    /* F_CW_FINAL  */ {F_CW_NEXT, R_START, F_CW_FINAL, R_START | ROTARY_DIR_CW},
+    /* F_CW_BEGIN  */ {F_CW_NEXT, F_CW_BEGIN, R_START, R_START},
+    /* F_CW_NEXT   */ {F_CW_NEXT, F_CW_BEGIN, F_CW_FINAL, R_START},
+    /* F_CCW_BEGIN */ {F_CCW_NEXT, R_START, F_CCW_BEGIN, R_START},
+    /* F_CCW_FINAL */ {F_CCW_NEXT, F_CCW_FINAL, R_START, R_START | ROTARY_DIR_CCW},
+    /* F_CCW_NEXT  */ {F_CCW_NEXT, F_CCW_FINAL, F_CCW_BEGIN, R_START},
 };
 
-#endif
+// ========== 四分之一步模式 ==========
+// 状态就是上一次的引脚状态，每个合法的格雷码跳变都触发事件(每格4次)，
+// 跳过一个状态的非法跳变只同步状态不出事件
+
+/**
+ * @brief 四分之一步模式状态转移表
+ * @note  顺时针时(B相<<1 | A相)依次为: 11 -> 01 -> 00 -> 10 -> 11，与半步/全步表一致
+ */
+static const uint8_t quarter_table[4][4] = {
+    // 上次引脚状态      引脚状态: 00                01                10                11
+    /* 00 */ {0x0, 0x1 | ROTARY_DIR_CCW, 0x2 | ROTARY_DIR_CW, 0x3},
+    /* 01 */ {0x0 | ROTARY_DIR_CW, 0x1, 0x2, 0x3 | ROTARY_DIR_CCW},
+    /* 10 */ {0x0 | ROTARY_DIR_CCW, 0x1, 0x2, 0x3 | ROTARY_DIR_CW},
+    /* 11 */ {0x0, 0x1 | ROTARY_DIR_CW, 0x2 | ROTARY_DIR_CCW, 0x3},
+};
+
+/**
+ * @brief 各步进模式的状态表, 下标为Rotary_StepModeTypeDef
+ */
+static const uint8_t (*const mode_tables[ROTARY_MODE_NUM])[4] = {
+    half_table,
+    full_table,
+    quarter_table,
+};
 
 /* 函数实现
  * -------------------------------------------------------------------*/
@@ -125,8 +146,16 @@ void Rotary_Init(Rotary_HandleTypeDef *hrotary, Rotary_ReadPinFunc read_pin_a,
   hrotary->read_pin_b = read_pin_b;
   hrotary->user_data_b = user_data_b;
 
-  // 2. 初始化状态机为起始状态
+  // 2. 默认半步模式, 状态机从起始状态开始
+  hrotary->table = half_table;
   hrotary->state = R_START;
+
+  // 3. 默认不加速
+  hrotary->accel = NULL;
+  hrotary->accel_len = 0;
+  hrotary->last_dir = ROTARY_DIR_NONE;
+  hrotary->last_time = 0;
+  hrotary->interval = 0;
 }
 
 /**
@@ -144,19 +173,91 @@ uint8_t Rotary_Process(Rotary_HandleTypeDef *hrotary) {
   // 可能的值: 0b00, 0b01, 0b10, 0b11
   uint8_t pinstate = (pin_b_state << 1) | pin_a_state;
 
-  // 步骤3: 查状态转移表，获取新状态
-  // - 当前状态(hrotary->state)作为行索引
-  // - 引脚状态(pinstate)作为列索引
-  // - 使用& 0x0F提取低4位的状态编号(过滤掉高4位的方向事件)
-  hrotary->state = state_table[hrotary->state & 0x0F][pinstate];
-
-  // 步骤4: 返回方向事件(提取高4位)
-  // 0x30 = 0b00110000，用于屏蔽低4位，只保留高4位的事件标志
-  // 返回值可能是:
-  //   - ROTARY_DIR_NONE (0x00): 未完成一个完整周期
-  //   - ROTARY_DIR_CW   (0x10): 顺时针完成一格
-  //   - ROTARY_DIR_CCW  (0x20): 逆时针完成一格
-  return hrotary->state & 0x30;
+  // 步骤3: 查状态转移表并返回方向事件, 见Rotary_ProcessPins()
+  return Rotary_ProcessPins(hrotary, pinstate);
+}
+
+/**
+ * @brief  设置步进模式
+ */
+void Rotary_SetStepMode(Rotary_HandleTypeDef *hrotary, uint8_t mode) {
+  if (mode >= ROTARY_MODE_NUM) {
+    mode = ROTARY_MODE_HALF;
+  }
+  hrotary->table = mode_tables[mode];
+  hrotary->state = R_START;
+}
+
+/**
+ * @brief  设置加速表
+ */
+void Rotary_SetAccel(Rotary_HandleTypeDef *hrotary,
+                     const Rotary_AccelTypeDef *table, uint8_t len) {
+  hrotary->accel = table;
+  hrotary->accel_len = (table != NULL) ? len : 0;
+  hrotary->last_dir = ROTARY_DIR_NONE;
+}
+
+/**
+ * @brief  按旋转速度把一步换算成多步
+ * @note   查表顺序与表项顺序一致，第一个max_interval不小于间隔的表项生效
+ */
+int16_t Rotary_Accelerate(Rotary_HandleTypeDef *hrotary, uint8_t dir,
+                          uint32_t now) {
+  uint32_t dt;
+  int16_t steps = 1;
+
+  if (dir == ROTARY_DIR_NONE) {
+    return 0;
+  }
+
+  // 步骤1: 更新平滑步间隔, 减法对回绕安全
+  dt = now - hrotary->last_time;
+  if (dt > 0x7FFFFFFFU) {
+    dt = 0x7FFFFFFFU; // 防止求平均时溢出
+  }
+  if (dir == hrotary->last_dir) {
+    hrotary->interval = (hrotary->interval + dt) >> 1;
+    // 步骤2: 查加速表
+    for (uint8_t i = 0; i < hrotary->accel_len; i++) {
+      if (hrotary->interval <= hrotary->accel[i].max_interval) {
+        steps = hrotary->accel[i].steps;
+        break;
+      }
+    }
+  } else {
+    hrotary->interval = dt; // 反向或第一步: 不加速, 重新开始平均
+  }
+  hrotary->last_dir = dir;
+  hrotary->last_time = now;
+
+  return (dir == ROTARY_DIR_CW) ? steps : (int16_t)-steps;
+}
+
+/**
+ * @brief  批量处理多个编码器
+ * @note   与Rotary_Process()使用同样的状态表，只是引脚来自端口快照，
+ *         ROTARY_DIR_CW/CCW(0x10/0x20)右移4位正好是2位事件码
+ */
+uint32_t Rotary_ProcessBatch(Rotary_BatchTypeDef *encoders, uint8_t num,
+                             const uint32_t *ports) {
+  uint32_t events = 0;
+
+  if (num > ROTARY_BATCH_MAX) {
+    num = ROTARY_BATCH_MAX;
+  }
+  for (uint8_t i = 0; i < num; i++) {
+    Rotary_BatchTypeDef *enc = &encoders[i];
+    uint8_t pinstate = (uint8_t)((((ports[enc->port_b] >> enc->bit_b) & 1U) << 1) |
+                                 ((ports[enc->port_a] >> enc->bit_a) & 1U));
+
+    const uint8_t (*table)[4] = mode_tables[(enc->mode < ROTARY_MODE_NUM) ? enc->mode : (uint8_t)ROTARY_MODE_HALF];
+
+    enc->state = table[enc->state & 0x0F][pinstate];
+    events |= (uint32_t)((enc->state & 0x30) >> 4) << (2U * i);
+  }
+
+  return events;
 }
 
 /**
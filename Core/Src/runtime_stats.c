@@ -0,0 +1,113 @@
+/**
+******************************************************************************
+* @file           : runtime_stats.c
+* @brief          : 基于DWT周期计数器的运行时统计
+******************************************************************************
+* @attention
+*
+* 这里的configureTimerForRunTimeStats()/getRunTimeCounterValue()是强定义，
+* 覆盖freertos.c中基于TIM4节拍的__weak版本。
+*
+******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "runtime_stats.h"
+#include "dwt.h"
+#include "tlog.h"
+
+/* 私有变量
+ * -----------------------------------------------------------------*/
+
+volatile uint64_t rts_isr_cycles[RTS_ISR_NUM];
+volatile uint32_t rts_isr_count[RTS_ISR_NUM];
+
+static uint32_t rts_last;   // 上次读到的CYCCNT
+static uint32_t rts_high;   // 高32位
+
+// RTStats_Print()上一窗口的起点
+static uint64_t rts_print_start;
+static uint64_t rts_print_isr[RTS_ISR_NUM];
+static uint32_t rts_print_count[RTS_ISR_NUM];
+
+// TLOG的%s只记地址, 名字由tlog_expand.py从ELF读回
+static const char *const rts_isr_name[RTS_ISR_NUM] = {
+    "OTG_FS", "DMA1_S4", "TIM5", "EXTI",
+};
+
+/* 函数实现
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  读取64位周期计数
+ */
+uint64_t RTStats_Cycles64(void) {
+  uint32_t primask = __get_PRIMASK();
+  uint32_t now;
+  uint64_t cycles;
+
+  // 任务和中断都会调用，扩展高位的读-改-写必须原子
+  __disable_irq();
+  now = DWT->CYCCNT;
+  if (now < rts_last) {
+    rts_high++;
+  }
+  rts_last = now;
+  cycles = ((uint64_t)rts_high << 32) | now;
+  __set_PRIMASK(primask);
+
+  return cycles;
+}
+
+/**
+ * @brief  FreeRTOS运行时统计时钟初始化(vTaskStartScheduler中调用)
+ */
+void configureTimerForRunTimeStats(void) {
+  DWT_Init();
+  rts_last = DWT->CYCCNT;
+  rts_print_start = RTStats_Cycles64();
+}
+
+/**
+ * @brief  FreeRTOS运行时统计时钟
+ * @retval 预分频后的周期数(低32位)
+ */
+unsigned long getRunTimeCounterValue(void) {
+  return (unsigned long)(RTStats_Cycles64() >> RTSTATS_PRESCALE_SHIFT);
+}
+
+/**
+ * @brief  按窗口记录各ISR耗时占比, 每个中断一条TLOG
+ */
+void RTStats_Print(void) {
+  uint64_t now = RTStats_Cycles64();
+  uint64_t window = now - rts_print_start;
+  uint64_t isr[RTS_ISR_NUM];
+  uint32_t count[RTS_ISR_NUM];
+  uint32_t primask;
+
+  if (window == 0U) {
+    return;
+  }
+
+  // 64位累计值在中断中更新，关中断拷贝避免读到一半
+  primask = __get_PRIMASK();
+  __disable_irq();
+  for (uint32_t i = 0; i < RTS_ISR_NUM; i++) {
+    isr[i] = rts_isr_cycles[i];
+    count[i] = rts_isr_count[i];
+  }
+  __set_PRIMASK(primask);
+
+  for (uint32_t i = 0; i < RTS_ISR_NUM; i++) {
+    uint64_t d = isr[i] - rts_print_isr[i];
+    uint32_t n = count[i] - rts_print_count[i];
+    uint32_t pct = (uint32_t)((d * 10000U) / window); // 单位0.01%
+
+    TLOG("rtstats: %-7s %u cycles, %u calls, %u.%02u%%", rts_isr_name[i], (uint32_t)d, n,
+         pct / 100U, pct % 100U);
+    rts_print_isr[i] = isr[i];
+    rts_print_count[i] = count[i];
+  }
+  rts_print_start = now;
+}
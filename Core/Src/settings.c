@@ -0,0 +1,206 @@
+/**
+******************************************************************************
+* @file           : settings.c
+* @brief          : 用户设置掉电保存
+******************************************************************************
+* @attention
+*
+* 见settings.h。kvstore.c的Flash接口在这里用HAL实现。
+*
+******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "settings.h"
+#include <string.h>
+#include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "kvstore.h"
+#include "usbd_audio.h"
+#include "tlog.h"
+
+/* 私有宏定义
+ * -----------------------------------------------------------------*/
+
+#define SETTINGS_ADDR_A 0x08008000U   // 扇区2
+#define SETTINGS_ADDR_B 0x0800C000U   // 扇区3
+#define SETTINGS_SECTOR_SIZE 0x4000U
+
+#define SETTINGS_DIRTY_MUTE 0x02U
+
+/* 私有变量
+ * -----------------------------------------------------------------*/
+
+extern USBD_HandleTypeDef hUsbDeviceFS;
+
+static bool Settings_FlashErase(void *ctx, uint8_t sector);
+static bool Settings_FlashProgram(void *ctx, const uint8_t *dst, const void *src, uint32_t len);
+
+static const KV_FlashTypeDef settings_flash = {
+    .sector = {(const uint8_t *)SETTINGS_ADDR_A, (const uint8_t *)SETTINGS_ADDR_B},
+    .sector_size = SETTINGS_SECTOR_SIZE,
+    .erase = Settings_FlashErase,
+    .program = Settings_FlashProgram,
+    .ctx = NULL,
+};
+
+static KV_HandleTypeDef settings_kv;
+static bool settings_ready;
+
+static volatile uint8_t settings_mute;
+static volatile uint8_t settings_dirty;          // SETTINGS_DIRTY_xxx
+static volatile uint32_t settings_changed;       // 最后一次修改的HAL_GetTick()
+static uint32_t settings_busy_tick;              // 最后一次看到USB未配置或在放音
+
+/* 私有函数
+ * -----------------------------------------------------------------*/
+
+/**
+ * @brief  清除上一次操作残留的错误标志, 否则HAL会直接返回错误
+ */
+static void Settings_FlashUnlock(void) {
+  HAL_FLASH_Unlock();
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR |
+                         FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+}
+
+/**
+ * @brief  擦除扇区2或3
+ */
+static bool Settings_FlashErase(void *ctx, uint8_t sector) {
+  FLASH_EraseInitTypeDef erase = {0};
+  uint32_t error;
+  HAL_StatusTypeDef st;
+
+  (void)ctx;
+  erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+  erase.Sector = (sector == 0U) ? FLASH_SECTOR_2 : FLASH_SECTOR_3;
+  erase.NbSectors = 1U;
+  erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+
+  Settings_FlashUnlock();
+  st = HAL_FLASHEx_Erase(&erase, &error);   // 内部会刷新指令/数据缓存
+  HAL_FLASH_Lock();
+  return st == HAL_OK;
+}
+
+/**
+ * @brief  按字编程
+ */
+static bool Settings_FlashProgram(void *ctx, const uint8_t *dst, const void *src, uint32_t len) {
+  HAL_StatusTypeDef st = HAL_OK;
+
+  (void)ctx;
+  Settings_FlashUnlock();
+  for (uint32_t i = 0U; (i < len) && (st == HAL_OK); i += 4U) {
+    uint32_t word;
+    memcpy(&word, (const uint8_t *)src + i, 4U);
+    if (word != 0xFFFFFFFFU) {  // 已擦除的值, 不用编程
+      st = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, (uint32_t)dst + i, word);
+    }
+  }
+  HAL_FLASH_Lock();
+
+  // 数据缓存中可能还有编程前读到的0xFF
+  __HAL_FLASH_DATA_CACHE_DISABLE();
+  __HAL_FLASH_DATA_CACHE_RESET();
+  __HAL_FLASH_DATA_CACHE_ENABLE();
+  return st == HAL_OK;
+}
+
+/**
+ * @brief  标记一项修改
+ */
+static void Settings_Touch(uint8_t dirty) {
+  UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+  settings_dirty |= dirty;
+  settings_changed = HAL_GetTick();
+  taskEXIT_CRITICAL_FROM_ISR(saved);
+}
+
+/* 函数实现
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  从Flash恢复设置
+ */
+void Settings_Init(void) {
+  uint8_t value;
+
+  if (KV_Init(&settings_kv, &settings_flash) != KV_OK) {
+    TLOG("settings: flash init failed");
+    return;
+  }
+  settings_ready = true;
+  if (KV_Get(&settings_kv, SETTINGS_KEY_MUTE, &value, 1U, NULL) == KV_OK) {
+    settings_mute = value;
+  }
+  TLOG("settings: mute %u, sector %u seq %u", settings_mute, settings_kv.active,
+       settings_kv.seq);
+}
+
+/**
+ * @brief  写入到期的修改、在空闲时擦除备用扇区
+ */
+void Settings_Poll(void) {
+  // 擦除只在枚举完成且没有放音时进行: 枚举中停顿会让控制传输超时,
+  // 主机选择了带宽不为0的备用设置即在放音, 切回0后才擦除
+  bool idle = (hUsbDeviceFS.dev_state == USBD_STATE_CONFIGURED) &&
+              (USBD_AUDIO_GetAltSetting(&hUsbDeviceFS) == 0U);
+  uint32_t now = HAL_GetTick();
+  uint8_t dirty;
+  uint8_t value;
+
+  if (!settings_ready) {
+    return;
+  }
+
+  // 步骤1: 修改稳定后取走脏标记, 写失败的放回去下次重试
+  taskENTER_CRITICAL();
+  dirty = settings_dirty;
+  if ((dirty != 0U) && ((now - settings_changed) >= SETTINGS_DELAY_MS)) {
+    settings_dirty = 0U;
+  } else {
+    dirty = 0U;
+  }
+  taskEXIT_CRITICAL();
+
+  if (dirty & SETTINGS_DIRTY_MUTE) {
+    value = settings_mute;
+    if (KV_Set(&settings_kv, SETTINGS_KEY_MUTE, &value, 1U) == KV_OK) {
+      dirty &= (uint8_t)~SETTINGS_DIRTY_MUTE;
+    }
+  }
+  if (dirty != 0U) {
+    taskENTER_CRITICAL();
+    settings_dirty |= dirty;
+    taskEXIT_CRITICAL();
+  }
+
+  // 步骤2: 擦除会让CPU停顿数百毫秒, 只在USB空闲了一段时间后进行;
+  // 刚配置时主机通常紧接着选择备用设置, 不能让它等在擦除后面
+  if (!idle) {
+    settings_busy_tick = now;
+  }
+  if (KV_ErasePending(&settings_kv) && idle &&
+      ((now - settings_busy_tick) >= SETTINGS_ERASE_IDLE_MS)) {
+    KV_StatusTypeDef st = KV_EraseSpare(&settings_kv);
+    TLOG("settings: erase spare %u, %u ms", st, HAL_GetTick() - now);
+  }
+}
+
+/**
+ * @brief  读取静音状态
+ */
+uint8_t Settings_GetMute(void) {
+  return settings_mute;
+}
+
+/**
+ * @brief  修改静音状态
+ */
+void Settings_SetMute(uint8_t mute) {
+  settings_mute = mute;
+  Settings_Touch(SETTINGS_DIRTY_MUTE);
+}
@@ -22,6 +22,11 @@
 #include "stm32f4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "dwt.h"
+#include "telemetry.h"
+#include "runtime_stats.h"
+#include "irq_prof.h"
+#include "trace.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -57,6 +62,9 @@
 /* External variables --------------------------------------------------------*/
 extern PCD_HandleTypeDef hpcd_USB_OTG_FS;
 extern DMA_HandleTypeDef hdma_spi2_tx;
+extern DMA_HandleTypeDef hdma_usart1_rx;
+extern DMA_HandleTypeDef hdma_usart1_tx;
+extern UART_HandleTypeDef huart1;
 extern TIM_HandleTypeDef htim3;
 extern TIM_HandleTypeDef htim5;
 extern TIM_HandleTypeDef htim4;
@@ -163,31 +171,21 @@ void DebugMon_Handler(void)
 /* please refer to the startup file (startup_stm32f4xx.s).                    */
 /******************************************************************************/
 
-/**
-  * @brief This function handles EXTI line0 interrupt.
-  */
-void EXTI0_IRQHandler(void)
-{
-  /* USER CODE BEGIN EXTI0_IRQn 0 */
-
-  /* USER CODE END EXTI0_IRQn 0 */
-  HAL_GPIO_EXTI_IRQHandler(KEY_Pin);
-  /* USER CODE BEGIN EXTI0_IRQn 1 */
-
-  /* USER CODE END EXTI0_IRQn 1 */
-}
-
 /**
   * @brief This function handles EXTI line1 interrupt.
   */
 void EXTI1_IRQHandler(void)
 {
   /* USER CODE BEGIN EXTI1_IRQn 0 */
-
+  uint32_t isr_t0 = DWT_GetCycles();
+  IRQ_PROF_ENTER(RTS_ISR_EXTI, isr_t0, 0U);
+  TRACE_ISR_ENTER(RTS_ISR_EXTI);
   /* USER CODE END EXTI1_IRQn 0 */
   HAL_GPIO_EXTI_IRQHandler(ROTARY_DT_Pin);
   /* USER CODE BEGIN EXTI1_IRQn 1 */
-
+  RTStats_IsrCycles(RTS_ISR_EXTI, DWT_GetCycles() - isr_t0);
+  IRQ_PROF_EXIT(RTS_ISR_EXTI, isr_t0);
+  TRACE_ISR_EXIT(RTS_ISR_EXTI);
   /* USER CODE END EXTI1_IRQn 1 */
 }
 
@@ -197,11 +195,15 @@ void EXTI1_IRQHandler(void)
 void EXTI2_IRQHandler(void)
 {
   /* USER CODE BEGIN EXTI2_IRQn 0 */
-
+  uint32_t isr_t0 = DWT_GetCycles();
+  IRQ_PROF_ENTER(RTS_ISR_EXTI, isr_t0, 0U);
+  TRACE_ISR_ENTER(RTS_ISR_EXTI);
   /* USER CODE END EXTI2_IRQn 0 */
   HAL_GPIO_EXTI_IRQHandler(ROTARY_CLK_Pin);
   /* USER CODE BEGIN EXTI2_IRQn 1 */
-
+  RTStats_IsrCycles(RTS_ISR_EXTI, DWT_GetCycles() - isr_t0);
+  IRQ_PROF_EXIT(RTS_ISR_EXTI, isr_t0);
+  TRACE_ISR_EXIT(RTS_ISR_EXTI);
   /* USER CODE END EXTI2_IRQn 1 */
 }
 
@@ -211,11 +213,17 @@ void EXTI2_IRQHandler(void)
 void DMA1_Stream4_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Stream4_IRQn 0 */
-
+  uint32_t isr_t0 = DWT_GetCycles();
+  IRQ_PROF_ENTER(RTS_ISR_DMA, isr_t0, IrqProf_DmaLatency());
+  TRACE_ISR_ENTER(RTS_ISR_DMA);
   /* USER CODE END DMA1_Stream4_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_spi2_tx);
   /* USER CODE BEGIN DMA1_Stream4_IRQn 1 */
-
+  uint32_t isr_cycles = DWT_GetCycles() - isr_t0;
+  Telemetry_IsrCycles(TLM_ISR_DMA, isr_cycles);
+  RTStats_IsrCycles(RTS_ISR_DMA, isr_cycles);
+  IRQ_PROF_EXIT(RTS_ISR_DMA, isr_t0);
+  TRACE_ISR_EXIT(RTS_ISR_DMA);
   /* USER CODE END DMA1_Stream4_IRQn 1 */
 }
 
@@ -248,17 +256,17 @@ void TIM4_IRQHandler(void)
 }
 
 /**
-  * @brief This function handles EXTI line[15:10] interrupts.
+  * @brief This function handles USART1 global interrupt.
   */
-void EXTI15_10_IRQHandler(void)
+void USART1_IRQHandler(void)
 {
-  /* USER CODE BEGIN EXTI15_10_IRQn 0 */
+  /* USER CODE BEGIN USART1_IRQn 0 */
 
-  /* USER CODE END EXTI15_10_IRQn 0 */
-  HAL_GPIO_EXTI_IRQHandler(ROTARY_SW_Pin);
-  /* USER CODE BEGIN EXTI15_10_IRQn 1 */
+  /* USER CODE END USART1_IRQn 0 */
+  HAL_UART_IRQHandler(&huart1);
+  /* USER CODE BEGIN USART1_IRQn 1 */
 
-  /* USER CODE END EXTI15_10_IRQn 1 */
+  /* USER CODE END USART1_IRQn 1 */
 }
 
 /**
@@ -267,28 +275,68 @@ void EXTI15_10_IRQHandler(void)
 void TIM5_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM5_IRQn 0 */
-
+  uint32_t isr_t0 = DWT_GetCycles();
+  IRQ_PROF_ENTER(RTS_ISR_TIM5, isr_t0, IrqProf_Tim5Latency());
+  TRACE_ISR_ENTER(RTS_ISR_TIM5);
   /* USER CODE END TIM5_IRQn 0 */
   HAL_TIM_IRQHandler(&htim5);
   /* USER CODE BEGIN TIM5_IRQn 1 */
-
+  uint32_t isr_cycles = DWT_GetCycles() - isr_t0;
+  Telemetry_IsrCycles(TLM_ISR_TIM5, isr_cycles);
+  RTStats_IsrCycles(RTS_ISR_TIM5, isr_cycles);
+  IRQ_PROF_EXIT(RTS_ISR_TIM5, isr_t0);
+  TRACE_ISR_EXIT(RTS_ISR_TIM5);
   /* USER CODE END TIM5_IRQn 1 */
 }
 
+/**
+  * @brief This function handles DMA2 stream2 global interrupt.
+  */
+void DMA2_Stream2_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA2_Stream2_IRQn 0 */
+
+  /* USER CODE END DMA2_Stream2_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart1_rx);
+  /* USER CODE BEGIN DMA2_Stream2_IRQn 1 */
+
+  /* USER CODE END DMA2_Stream2_IRQn 1 */
+}
+
 /**
   * @brief This function handles USB On The Go FS global interrupt.
   */
 void OTG_FS_IRQHandler(void)
 {
   /* USER CODE BEGIN OTG_FS_IRQn 0 */
-
+  uint32_t isr_t0 = DWT_GetCycles();
+  IRQ_PROF_ENTER(RTS_ISR_OTG_FS, isr_t0, 0U);
+  TRACE_ISR_ENTER(RTS_ISR_OTG_FS);
   /* USER CODE END OTG_FS_IRQn 0 */
   HAL_PCD_IRQHandler(&hpcd_USB_OTG_FS);
   /* USER CODE BEGIN OTG_FS_IRQn 1 */
-
+  uint32_t isr_cycles = DWT_GetCycles() - isr_t0;
+  Telemetry_IsrCycles(TLM_ISR_USB, isr_cycles);
+  RTStats_IsrCycles(RTS_ISR_OTG_FS, isr_cycles);
+  IRQ_PROF_EXIT(RTS_ISR_OTG_FS, isr_t0);
+  TRACE_ISR_EXIT(RTS_ISR_OTG_FS);
   /* USER CODE END OTG_FS_IRQn 1 */
 }
 
+/**
+  * @brief This function handles DMA2 stream7 global interrupt.
+  */
+void DMA2_Stream7_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA2_Stream7_IRQn 0 */
+
+  /* USER CODE END DMA2_Stream7_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart1_tx);
+  /* USER CODE BEGIN DMA2_Stream7_IRQn 1 */
+
+  /* USER CODE END DMA2_Stream7_IRQn 1 */
+}
+
 /* USER CODE BEGIN 1 */
 
 /* USER CODE END 1 */
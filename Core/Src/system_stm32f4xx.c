@@ -46,6 +46,7 @@
 
 
 #include "stm32f4xx.h"
+#include "bootprof.h"
 
 #if !defined  (HSE_VALUE) 
   #define HSE_VALUE    ((uint32_t)25000000) /*!< Default value of the External oscillator in Hz */
@@ -93,6 +94,17 @@
      remap of boot address selected */
 /* #define USER_VECT_TAB_ADDRESS */
 
+/*!< Define VECT_TAB_SRAM_COPY (project defines) to run from a copy of the
+     Flash vector table placed at the start of SRAM. SystemInit copies
+     __Vectors into the RW_IRAM_VTOR region reserved by STM32F411CEU6.sct
+     before the scatter-loading, so the copy is never zero-initialized.
+     The scatter file only reserves that region when -DVECT_TAB_SRAM_COPY is
+     also on its #! preprocessor line. */
+#if defined(VECT_TAB_SRAM_COPY)
+#define USER_VECT_TAB_ADDRESS
+#define VECT_TAB_SRAM
+#endif /* VECT_TAB_SRAM_COPY */
+
 #if defined(USER_VECT_TAB_ADDRESS)
 /*!< Uncomment the following line if you need to relocate your vector Table
      in Sram else user remap will be done in Flash. */
@@ -149,6 +161,11 @@ const uint8_t APBPrescTable[8]  = {0, 0, 0, 0, 1, 2, 3, 4};
   static void SystemInit_ExtMemCtl(void); 
 #endif /* DATA_IN_ExtSRAM || DATA_IN_ExtSDRAM */
 
+#if defined(VECT_TAB_SRAM_COPY)
+extern const uint32_t __Vectors[];
+extern const uint32_t __Vectors_Size[];
+#endif /* VECT_TAB_SRAM_COPY */
+
 /**
   * @}
   */
@@ -176,9 +193,28 @@ void SystemInit(void)
 #endif /* DATA_IN_ExtSRAM || DATA_IN_ExtSDRAM */
 
   /* Configure the Vector Table location -------------------------------------*/
+#if defined(VECT_TAB_SRAM_COPY)
+  {
+    const uint32_t *src = __Vectors;
+    uint32_t *dst = (uint32_t *)(VECT_TAB_BASE_ADDRESS | VECT_TAB_OFFSET);
+    uint32_t n = (uint32_t)__Vectors_Size / 4U;
+
+    while (n-- > 0U)
+    {
+      *dst++ = *src++;
+    }
+    __DSB();
+  }
+#endif /* VECT_TAB_SRAM_COPY */
 #if defined(USER_VECT_TAB_ADDRESS)
   SCB->VTOR = VECT_TAB_BASE_ADDRESS | VECT_TAB_OFFSET; /* Vector Table Relocation in Internal SRAM */
 #endif /* USER_VECT_TAB_ADDRESS */
+
+#if BOOTPROF_ENABLE
+  /* Before __main: the UNINIT array still holds the previous boot, write
+     unconditionally instead of BootProf_Mark() */
+  bootprof_cycles[BOOT_MS_SYSINIT] = DWT->CYCCNT;
+#endif /* BOOTPROF_ENABLE */
 }
 
 /**
@@ -0,0 +1,307 @@
+/**
+******************************************************************************
+* @file           : telemetry.c
+* @brief          : USB厂商接口遥测记录与参数写入
+******************************************************************************
+* @attention
+*
+* 数据来源:
+*   - 缓冲水位: USB写指针与I2S DMA实际播放位置(NDTR)之差，精确到字节
+*   - 时钟漂移: 水位在1秒窗口内的变化量换算成ppm，再做1/4指数平滑。
+*               水位只会因主机与I2S时钟不一致而持续变化
+*   - CPU占用: FreeRTOS空闲任务运行时间占比
+*   - ISR耗时: 中断入口/出口处DWT周期数之差，每条记录取本周期最大值后清零
+*   - HID延迟: usbd_hid.c在报告入队和主机取走(DataIn)时打的DWT时间戳之差
+*
+* 记录只在调用Telemetry_Poll()的任务中产生(单生产者)，同时写入厂商接口和
+* USART1；OUT命令在USB或串口中断中处理，ACK由中断登记、任务发出。
+*
+******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "telemetry.h"
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "i2s.h"
+#include "dwt.h"
+#include "usbd_audio.h"
+#include "usbd_vendor_if.h"
+#include "usbd_hid.h"
+#include "uartlink.h"
+
+/* 私有宏定义
+ * -----------------------------------------------------------------*/
+
+#define TLM_PERIOD_DEFAULT 100U   // 默认上报周期(ms)
+#define TLM_PERIOD_MIN 10U
+#define TLM_PERIOD_MAX 10000U
+#define TLM_DRIFT_WINDOW 1000U    // 漂移计算窗口(ms)
+
+/* 私有变量
+ * -----------------------------------------------------------------*/
+
+extern USBD_HandleTypeDef hUsbDeviceFS;
+extern unsigned long getRunTimeCounterValue(void);
+
+volatile uint32_t tlm_isr_max[TLM_ISR_NUM];
+
+static volatile uint32_t tlm_period = TLM_PERIOD_DEFAULT;
+static volatile uint8_t tlm_enable = 1U;
+
+// 中断登记的ACK，任务发送后清除
+static volatile uint8_t tlm_ack_pending;
+static volatile uint8_t tlm_ack_param;
+static volatile uint8_t tlm_ack_status;
+static volatile uint32_t tlm_ack_value;
+static volatile uint32_t tlm_baud_pending;   // 应答发出后再切换, 0=无
+
+static uint16_t tlm_seq;
+static uint32_t tlm_last_tick;
+
+static uint32_t tlm_last_idle;
+static uint32_t tlm_last_total;
+
+static uint32_t tlm_drift_tick;
+static int32_t tlm_drift_fill = -1;
+static int32_t tlm_drift_ppm;
+
+/* 私有函数
+ * -----------------------------------------------------------------*/
+
+/**
+ * @brief  一条记录写入厂商接口和串口, 各自缓冲满时丢弃
+ */
+static void Telemetry_Output(const void *rec, uint32_t len) {
+  (void)VENDOR_Transmit_FS((const uint8_t *)rec, len);
+  (void)UartLink_Send(rec, len);
+}
+
+/**
+ * @brief  音频缓冲中待播放的字节数
+ * @retval 字节数, 0xFFFF表示没有在播放
+ */
+static uint16_t Telemetry_BufferFill(void) {
+  uint32_t wr = USBD_AUDIO_GetWritePtr(&hUsbDeviceFS);
+  uint32_t play;
+
+  if (wr == 0xFFFFFFFFU) {
+    return 0xFFFFU;
+  }
+  // DMA以半字为单位循环发送整个缓冲, NDTR为本轮剩余半字数
+  play = AUDIO_TOTAL_BUF_SIZE - (hi2s2.hdmatx->Instance->NDTR * 2U);
+  return (uint16_t)((wr + AUDIO_TOTAL_BUF_SIZE - play) % AUDIO_TOTAL_BUF_SIZE);
+}
+
+/**
+ * @brief  更新时钟漂移估计
+ * @param  fill: 当前水位
+ * @param  now: 当前tick
+ */
+static void Telemetry_UpdateDrift(uint16_t fill, uint32_t now) {
+  if (fill == 0xFFFFU) {
+    tlm_drift_fill = -1;
+    tlm_drift_ppm = 0;
+    return;
+  }
+  if (tlm_drift_fill < 0) {
+    tlm_drift_fill = fill;
+    tlm_drift_tick = now;
+    return;
+  }
+  if ((now - tlm_drift_tick) >= TLM_DRIFT_WINDOW) {
+    // 水位增加 = 主机送来的数据多于I2S消耗的数据
+    int32_t delta = (int32_t)fill - tlm_drift_fill;
+    int32_t ppm = (int32_t)(((int64_t)delta * 1000000) /
+                            ((int64_t)(now - tlm_drift_tick) * AUDIO_OUT_PACKET));
+    tlm_drift_ppm += (ppm - tlm_drift_ppm) / 4;
+    tlm_drift_fill = fill;
+    tlm_drift_tick = now;
+  }
+}
+
+/**
+ * @brief  计算上次调用以来的CPU占用
+ * @retval 单位0.01%
+ */
+static uint16_t Telemetry_CpuLoad(void) {
+  uint32_t idle = ulTaskGetIdleRunTimeCounter();
+  uint32_t total = (uint32_t)getRunTimeCounterValue();
+  uint32_t d_idle = idle - tlm_last_idle;
+  uint32_t d_total = total - tlm_last_total;
+
+  tlm_last_idle = idle;
+  tlm_last_total = total;
+  if ((d_total == 0U) || (d_idle > d_total)) {
+    return 0U;
+  }
+  return (uint16_t)(10000U - (d_idle * 10000U) / d_total);
+}
+
+/**
+ * @brief  发送一条状态记录
+ * @param  now: 当前tick
+ */
+static void Telemetry_SendStatus(uint32_t now) {
+  Telemetry_StatusTypeDef rec;
+  uint16_t fill = Telemetry_BufferFill();
+
+  Telemetry_UpdateDrift(fill, now);
+
+  rec.sync = TLM_SYNC;
+  rec.type = TLM_REC_STATUS;
+  rec.seq = tlm_seq++;
+  rec.tick_ms = now;
+  rec.buf_fill = fill;
+  rec.drift_ppm = (int16_t)((tlm_drift_ppm > 32767) ? 32767
+                            : (tlm_drift_ppm < -32768) ? -32768 : tlm_drift_ppm);
+  rec.cpu_load = Telemetry_CpuLoad();
+  rec.dropped = (uint16_t)VENDOR_GetDropped_FS();
+  for (uint32_t i = 0; i < TLM_ISR_NUM; i++) {
+    // 读后清零不是原子的，清零前刚写入的最大值会丢失一个周期，可以接受
+    rec.isr_max[i] = tlm_isr_max[i];
+    tlm_isr_max[i] = 0U;
+  }
+  rec.heap_free = (uint32_t)xPortGetFreeHeapSize();
+
+  Telemetry_Output(&rec, sizeof(rec));
+}
+
+/**
+ * @brief  发送一条HID延迟记录
+ * @param  now: 当前tick
+ */
+static void Telemetry_SendHid(uint32_t now) {
+  Telemetry_HidTypeDef rec;
+  USBD_HID_LatencyTypeDef lat;
+
+  // 拷贝与清零之间的DataIn中断会丢掉一个样本，可以接受
+  USBD_HID_GetLatency(&lat, 1U);
+
+  rec.sync = TLM_SYNC;
+  rec.type = TLM_REC_HID;
+  rec.seq = tlm_seq++;
+  rec.tick_ms = now;
+  rec.reports = lat.reports;
+  rec.overflows = lat.overflows;
+  rec.lat_last = lat.last;
+  rec.lat_max = lat.max;
+  rec.lat_avg = (lat.reports != 0U) ? (uint32_t)(lat.sum / lat.reports) : 0U;
+  rec.reserved = 0U;
+
+  Telemetry_Output(&rec, sizeof(rec));
+}
+
+/**
+ * @brief  发送中断中登记的ACK
+ * @param  now: 当前tick
+ */
+static void Telemetry_SendAck(uint32_t now) {
+  Telemetry_AckTypeDef rec;
+  uint32_t baud;
+
+  memset(&rec, 0, sizeof(rec));
+  rec.sync = TLM_SYNC;
+  rec.type = TLM_REC_ACK;
+  rec.seq = tlm_seq++;
+  rec.tick_ms = now;
+
+  // OTG_FS和USART1中断都会登记ACK, 取字段和清标志必须一次完成
+  taskENTER_CRITICAL();
+  rec.param = tlm_ack_param;
+  rec.status = tlm_ack_status;
+  rec.value = tlm_ack_value;
+  tlm_ack_pending = 0U;
+  baud = tlm_baud_pending;
+  tlm_baud_pending = 0U;
+  taskEXIT_CRITICAL();
+
+  Telemetry_Output(&rec, sizeof(rec));
+
+  // 应答已以旧波特率排队, 发完后uartlink再切换
+  if (baud != 0U) {
+    UartLink_SetBaud(baud);
+  }
+}
+
+/* 函数实现
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  初始化遥测模块
+ */
+void Telemetry_Init(void) {
+  DWT_Init();
+  tlm_last_tick = HAL_GetTick();
+}
+
+/**
+ * @brief  遥测轮询
+ */
+void Telemetry_Poll(void) {
+  uint32_t now = HAL_GetTick();
+
+  if (tlm_ack_pending) {
+    Telemetry_SendAck(now);
+  }
+  if (tlm_enable && ((now - tlm_last_tick) >= tlm_period)) {
+    tlm_last_tick = now;
+    Telemetry_SendStatus(now);
+    Telemetry_SendHid(now);
+  }
+}
+
+/**
+ * @brief  处理参数读写命令
+ */
+void Telemetry_Command(const uint8_t *buf, uint32_t len) {
+  for (uint32_t i = 0; (i + 6U) <= len; i += 6U) {
+    uint8_t param = buf[i + 1U];
+    uint32_t value = (uint32_t)buf[i + 2U] | ((uint32_t)buf[i + 3U] << 8) |
+                     ((uint32_t)buf[i + 4U] << 16) | ((uint32_t)buf[i + 5U] << 24);
+    uint8_t status = TLM_ACK_OK;
+    bool set = (buf[i] == TLM_CMD_SYNC);
+
+    if (!set && (buf[i] != TLM_CMD_GET)) {
+      break;
+    }
+    switch (param) {
+    case TLM_PARAM_PERIOD:
+      if (set && ((value < TLM_PERIOD_MIN) || (value > TLM_PERIOD_MAX))) {
+        status = TLM_ACK_BAD_VALUE;
+      } else if (set) {
+        tlm_period = value;
+      }
+      value = tlm_period;
+      break;
+    case TLM_PARAM_ENABLE:
+      if (set && (value > 1U)) {
+        status = TLM_ACK_BAD_VALUE;
+      } else if (set) {
+        tlm_enable = (uint8_t)value;
+      }
+      value = tlm_enable;
+      break;
+    case TLM_PARAM_UART_BAUD:
+      if (set && !UartLink_BaudValid(value)) {
+        status = TLM_ACK_BAD_VALUE;
+        value = UartLink_GetBaud();
+      } else if (set) {
+        tlm_baud_pending = value;   // 应答里是切换后的值
+      } else {
+        value = UartLink_GetBaud();
+      }
+      break;
+    default:
+      status = TLM_ACK_BAD_ID;
+      break;
+    }
+
+    // 只保留最后一条命令的应答
+    tlm_ack_param = param;
+    tlm_ack_status = status;
+    tlm_ack_value = value;
+    tlm_ack_pending = 1U;
+  }
+}
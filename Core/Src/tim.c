@@ -21,7 +21,7 @@
 #include "tim.h"
 
 /* USER CODE BEGIN 0 */
-
+#include "bootprof.h"
 /* USER CODE END 0 */
 
 TIM_HandleTypeDef htim3;
@@ -63,7 +63,7 @@ void MX_TIM3_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN TIM3_Init 2 */
-
+  BootProf_Mark(BOOT_MS_TIM3);
   /* USER CODE END TIM3_Init 2 */
 
 }
@@ -103,7 +103,7 @@ void MX_TIM5_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN TIM5_Init 2 */
-
+  BootProf_Mark(BOOT_MS_TIM5);
   /* USER CODE END TIM5_Init 2 */
 
 }
@@ -0,0 +1,133 @@
+/**
+******************************************************************************
+* @file           : tlog.c
+* @brief          : 令牌化延迟日志(每个上下文一个RTT通道)
+******************************************************************************
+* @attention
+*
+* 只在TLOG_ENABLE=1时编译，见tlog.h。
+*
+******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "tlog.h"
+
+#if TLOG_ENABLE
+
+#include "stm32f4xx.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "dwt.h"
+#include "SEGGER_RTT.h"
+
+/* 私有定义
+ * -----------------------------------------------------------------*/
+
+typedef enum {
+  TLOG_CTX_USB = 0,   // OTG_FS_IRQHandler
+  TLOG_CTX_DMA,       // DMA1_Stream4_IRQHandler
+  TLOG_CTX_ISR,       // 其余优先级5的中断
+  TLOG_CTX_TASK,      // 第一个任务通道(main)
+  TLOG_CTX_NUM = TLOG_CTX_TASK + TLOG_TASK_CTX
+} TLog_CtxTypeDef;
+
+#define TLOG_IPSR(irq) ((uint32_t)(irq) + 16U)   // IRQn对应的异常号
+
+/* 私有变量
+ * -----------------------------------------------------------------*/
+
+static uint8_t tlog_buffer[TLOG_CTX_NUM][TLOG_BUFFER_SIZE];
+
+static int8_t tlog_chan[TLOG_CTX_NUM] = {[0 ... TLOG_CTX_NUM - 1] = -1};   // RTT通道号, -1=未分配
+static TaskHandle_t tlog_owner[TLOG_TASK_CTX];       // 任务通道所属任务, main为NULL
+static volatile uint32_t tlog_tasks;                 // 已分配的任务通道数
+
+static const char *const tlog_isr_name[TLOG_CTX_TASK] = {
+    "TLog USB", "TLog DMA", "TLog ISR",
+};
+
+/* 私有函数
+ * -----------------------------------------------------------------*/
+
+/**
+ * @brief  当前任务的通道, 第一次调用时分配
+ * @retval RTT通道号, -1=通道已用完
+ */
+static int TLog_TaskChannel(void) {
+  TaskHandle_t self = NULL;
+  uint32_t primask;
+  uint32_t n;
+  int chan = -1;
+
+  if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED) {
+    self = xTaskGetCurrentTaskHandle();
+  }
+  n = tlog_tasks;
+  for (uint32_t i = 0; i < n; i++) {
+    if (tlog_owner[i] == self) {
+      return tlog_chan[TLOG_CTX_TASK + i];
+    }
+  }
+
+  // 第一次记录: 分配通道. 调度器启动前taskENTER_CRITICAL退出时不会开中断,
+  // 这里直接关中断
+  primask = __get_PRIMASK();
+  __disable_irq();
+  n = tlog_tasks;
+  if (n < TLOG_TASK_CTX) {
+    chan = SEGGER_RTT_AllocUpBuffer((self != NULL) ? pcTaskGetName(self) : "TLog main",
+                                    tlog_buffer[TLOG_CTX_TASK + n], TLOG_BUFFER_SIZE,
+                                    SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+    if (chan >= 0) {
+      tlog_owner[n] = self;
+      tlog_chan[TLOG_CTX_TASK + n] = (int8_t)chan;
+      tlog_tasks = n + 1U;
+    }
+  }
+  __set_PRIMASK(primask);
+
+  return chan;
+}
+
+/* 函数实现
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  分配中断上下文的RTT日志通道
+ */
+void TLog_Init(void) {
+  DWT_Init();
+  for (uint32_t i = 0; i < TLOG_CTX_TASK; i++) {
+    tlog_chan[i] = (int8_t)SEGGER_RTT_AllocUpBuffer(tlog_isr_name[i], tlog_buffer[i],
+                                                   TLOG_BUFFER_SIZE,
+                                                   SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+  }
+}
+
+/**
+ * @brief  填入时间戳并写入当前上下文的通道
+ */
+void TLog_Write(uint32_t *rec, uint32_t len) {
+  uint32_t ipsr = __get_IPSR();
+  int chan;
+
+  if (ipsr == 0U) {
+    chan = TLog_TaskChannel();
+  } else if (ipsr == TLOG_IPSR(OTG_FS_IRQn)) {
+    chan = tlog_chan[TLOG_CTX_USB];
+  } else if (ipsr == TLOG_IPSR(DMA1_Stream4_IRQn)) {
+    chan = tlog_chan[TLOG_CTX_DMA];
+  } else {
+    chan = tlog_chan[TLOG_CTX_ISR];
+  }
+  if (chan < 0) {
+    return;
+  }
+
+  rec[1] = DWT_GetCycles();
+  // 本通道只有当前上下文写入, 无需加锁; 跳过模式整条写入或整条丢弃
+  (void)SEGGER_RTT_WriteSkipNoLock((unsigned)chan, rec, len);
+}
+
+#endif /* TLOG_ENABLE */
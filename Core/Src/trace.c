@@ -0,0 +1,80 @@
+/**
+******************************************************************************
+* @file           : trace.c
+* @brief          : FreeRTOS二进制事件跟踪(RTT通道1)
+******************************************************************************
+* @attention
+*
+* 只在TRACE_ENABLE=1时编译，见trace.h。
+*
+******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "trace.h"
+
+#if TRACE_ENABLE
+
+#include <string.h>
+#include "stm32f4xx.h"
+#include "FreeRTOS.h"
+#include "dwt.h"
+#include "SEGGER_RTT.h"
+#include "ramfunc.h"
+
+/* 私有变量
+ * -----------------------------------------------------------------*/
+
+static uint8_t trace_buffer[TRACE_BUFFER_SIZE];
+
+/* 函数实现
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  配置RTT跟踪通道并写入TRC_START
+ */
+void Trace_Init(void) {
+  uint32_t rec[3];
+
+  DWT_Init();
+  (void)SEGGER_RTT_ConfigUpBuffer(TRACE_RTT_CHANNEL, "Trace", trace_buffer,
+                                  sizeof(trace_buffer), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+  rec[0] = TRC_START;
+  rec[1] = DWT->CYCCNT;
+  rec[2] = SystemCoreClock;
+  (void)SEGGER_RTT_WriteSkipNoLock(TRACE_RTT_CHANNEL, rec, sizeof(rec));
+}
+
+/**
+ * @brief  写入一条8字节事件
+ * @note   TRACE_ISR_xxx在SRAM中的ISR里调用, 所以也放入SRAM
+ */
+RAMFUNC void Trace_Event(uint8_t type, uint8_t id, uint16_t arg) {
+  uint32_t rec[2];
+  uint32_t mask;
+
+  rec[0] = (uint32_t)type | ((uint32_t)id << 8) | ((uint32_t)arg << 16);
+  mask = portSET_INTERRUPT_MASK_FROM_ISR();
+  rec[1] = DWT->CYCCNT;
+  (void)SEGGER_RTT_WriteSkipNoLock(TRACE_RTT_CHANNEL, rec, sizeof(rec));
+  portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/**
+ * @brief  写入任务创建事件(附任务名)
+ */
+void Trace_TaskCreate(uint32_t num, const char *name) {
+  uint32_t rec[2 + (configMAX_TASK_NAME_LEN + 3U) / 4U];
+  uint32_t mask;
+
+  memset(rec, 0, sizeof(rec));
+  rec[0] = TRC_TASK_CREATE | ((num & 0xFFU) << 8);
+  strncpy((char *)&rec[2], name, configMAX_TASK_NAME_LEN);
+  // 名字区固定configMAX_TASK_NAME_LEN字节, 主机按此长度解析
+  mask = portSET_INTERRUPT_MASK_FROM_ISR();
+  rec[1] = DWT->CYCCNT;
+  (void)SEGGER_RTT_WriteSkipNoLock(TRACE_RTT_CHANNEL, rec, 8U + configMAX_TASK_NAME_LEN);
+  portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+#endif /* TRACE_ENABLE */
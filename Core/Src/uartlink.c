@@ -0,0 +1,347 @@
+/**
+******************************************************************************
+* @file           : uartlink.c
+* @brief          : USART1 DMA诊断串口(COBS帧)
+******************************************************************************
+* @attention
+*
+* 见uartlink.h。发送环形缓冲: head只由发送任务修改，tail和tx_inflight
+* 只由发送完成中断修改(任务在临界区中启动DMA时除外)。
+*
+******************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "uartlink.h"
+#include <string.h>
+#include "usart.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "telemetry.h"
+#include "tlog.h"
+
+/* 私有宏定义
+ * -----------------------------------------------------------------*/
+
+// 负载 + CRC, COBS开销1字节(负载不超过254字节), 加分隔符
+#define UARTLINK_FRAME_MAX (UARTLINK_MAX_PAYLOAD + 2U + 1U + 1U)
+
+/* 私有变量
+ * -----------------------------------------------------------------*/
+
+static uint8_t uartlink_tx[UARTLINK_TX_SIZE];
+static volatile uint32_t uartlink_tx_head;
+static volatile uint32_t uartlink_tx_tail;
+static volatile uint32_t uartlink_tx_inflight;   // DMA正在发送的字节数, 0=空闲
+static volatile uint32_t uartlink_tx_dropped;    // 缓冲满丢弃的帧数
+
+static uint8_t uartlink_rx[UARTLINK_RX_SIZE];
+static uint32_t uartlink_rx_pos;                 // 已解析到的DMA缓冲位置
+static uint8_t uartlink_frame[UARTLINK_FRAME_MAX];
+static uint32_t uartlink_frame_len;
+static bool uartlink_frame_overrun;              // 帧过长, 丢弃到下一个分隔符
+static volatile uint32_t uartlink_rx_bad;        // COBS或CRC错误的帧数
+static volatile uint32_t uartlink_errors;        // 噪声/帧错误/溢出次数
+
+static uint32_t uartlink_baud_pending;           // 0=无
+
+/* 私有函数
+ * -----------------------------------------------------------------*/
+
+/**
+ * @brief  CRC-16/CCITT-FALSE, 逐位计算, 帧很短不需要查表
+ */
+static uint16_t UartLink_Crc16(const uint8_t *data, uint32_t len) {
+  uint16_t crc = 0xFFFFU;
+
+  while (len--) {
+    crc ^= (uint16_t)(*data++) << 8;
+    for (uint8_t i = 0; i < 8U; i++) {
+      crc = (crc & 0x8000U) ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+/**
+ * @brief  COBS编码
+ * @retval 编码后长度(不含分隔符)
+ */
+static uint32_t UartLink_CobsEncode(const uint8_t *src, uint32_t len, uint8_t *dst) {
+  uint32_t code_pos = 0U;
+  uint32_t out = 1U;
+  uint8_t code = 1U;
+
+  for (uint32_t i = 0U; i < len; i++) {
+    if (src[i] == 0U) {
+      dst[code_pos] = code;
+      code_pos = out++;
+      code = 1U;
+    } else {
+      dst[out++] = src[i];
+      if (++code == 0xFFU) {
+        dst[code_pos] = code;
+        code_pos = out++;
+        code = 1U;
+      }
+    }
+  }
+  dst[code_pos] = code;
+  return out;
+}
+
+/**
+ * @brief  COBS解码, 可原地解码
+ * @retval 解码后长度, 0表示格式错误
+ */
+static uint32_t UartLink_CobsDecode(const uint8_t *src, uint32_t len, uint8_t *dst) {
+  uint32_t i = 0U;
+  uint32_t out = 0U;
+
+  while (i < len) {
+    uint8_t code = src[i++];
+    if (code == 0U) {
+      return 0U;
+    }
+    for (uint8_t j = 1U; j < code; j++) {
+      if (i >= len) {
+        return 0U;
+      }
+      dst[out++] = src[i++];
+    }
+    if ((code != 0xFFU) && (i < len)) {
+      dst[out++] = 0U;
+    }
+  }
+  return out;
+}
+
+/**
+ * @brief  DMA空闲时发送缓冲中下一段连续数据
+ * @note   在发送完成中断中调用, 或在任务中于临界区内调用
+ */
+static void UartLink_TxStart(void) {
+  uint32_t tail = uartlink_tx_tail;
+  uint32_t start = tail & (UARTLINK_TX_SIZE - 1U);
+  uint32_t n = uartlink_tx_head - tail;
+
+  if ((uartlink_tx_inflight != 0U) || (n == 0U)) {
+    return;
+  }
+  if (n > (UARTLINK_TX_SIZE - start)) {
+    n = UARTLINK_TX_SIZE - start;  // 回绕处分两次发送
+  }
+  uartlink_tx_inflight = n;
+  if (HAL_UART_Transmit_DMA(&huart1, &uartlink_tx[start], (uint16_t)n) != HAL_OK) {
+    uartlink_tx_inflight = 0U;
+  }
+}
+
+/**
+ * @brief  启动循环DMA接收, 只在半满/满/空闲时中断
+ */
+static void UartLink_StartRx(void) {
+  uartlink_rx_pos = 0U;
+  uartlink_frame_len = 0U;
+  uartlink_frame_overrun = false;
+  (void)HAL_UARTEx_ReceiveToIdle_DMA(&huart1, uartlink_rx, UARTLINK_RX_SIZE);
+}
+
+/**
+ * @brief  处理一个完整的帧
+ */
+static void UartLink_RxFrame(void) {
+  uint32_t n = UartLink_CobsDecode(uartlink_frame, uartlink_frame_len, uartlink_frame);
+  UBaseType_t saved;
+
+  if ((n < 3U) || (UartLink_Crc16(uartlink_frame, n - 2U) !=
+                   (uint16_t)(uartlink_frame[n - 2U] | (uartlink_frame[n - 1U] << 8)))) {
+    uartlink_rx_bad++;
+    return;
+  }
+  // 屏蔽OTG_FS中断, 两个接口的命令不会交错登记ACK
+  saved = taskENTER_CRITICAL_FROM_ISR();
+  Telemetry_Command(uartlink_frame, n - 2U);
+  taskEXIT_CRITICAL_FROM_ISR(saved);
+}
+
+/**
+ * @brief  解析DMA缓冲中新收到的字节
+ * @param  pos: DMA写到的位置
+ */
+static void UartLink_RxUpTo(uint32_t pos) {
+  while (uartlink_rx_pos != pos) {
+    uint8_t b = uartlink_rx[uartlink_rx_pos];
+
+    uartlink_rx_pos = (uartlink_rx_pos + 1U) % UARTLINK_RX_SIZE;
+    if (b == 0U) {
+      if (!uartlink_frame_overrun && (uartlink_frame_len != 0U)) {
+        UartLink_RxFrame();
+      }
+      uartlink_frame_len = 0U;
+      uartlink_frame_overrun = false;
+    } else if (uartlink_frame_len < sizeof(uartlink_frame)) {
+      uartlink_frame[uartlink_frame_len++] = b;
+    } else {
+      uartlink_frame_overrun = true;
+    }
+  }
+}
+
+/**
+ * @brief  按波特率配置过采样并重新初始化串口
+ * @note   HAL_UART_Abort/Init的超时靠HAL_GetTick(), 临界区的BASEPRI会连
+ *         TIM4时基一起屏蔽, 所以只在NVIC里关掉USART1和它的两个DMA中断
+ */
+static void UartLink_ApplyBaud(uint32_t baud) {
+  static const IRQn_Type irqs[] = {USART1_IRQn, DMA2_Stream2_IRQn, DMA2_Stream7_IRQn};
+
+  for (uint32_t i = 0U; i < (sizeof(irqs) / sizeof(irqs[0])); i++) {
+    HAL_NVIC_DisableIRQ(irqs[i]);
+  }
+  (void)HAL_UART_Abort(&huart1);
+  huart1.Init.BaudRate = baud;
+  huart1.Init.OverSampling = (baud > (HAL_RCC_GetPCLK2Freq() / 16U)) ? UART_OVERSAMPLING_8
+                                                                     : UART_OVERSAMPLING_16;
+  if (HAL_UART_Init(&huart1) != HAL_OK) {
+    uartlink_errors++;
+  }
+  // 中止前挂起的中断属于旧的传输, 丢掉
+  for (uint32_t i = 0U; i < (sizeof(irqs) / sizeof(irqs[0])); i++) {
+    HAL_NVIC_ClearPendingIRQ(irqs[i]);
+    HAL_NVIC_EnableIRQ(irqs[i]);
+  }
+
+  // 接收状态与错误回调共享
+  taskENTER_CRITICAL();
+  UartLink_StartRx();
+  taskEXIT_CRITICAL();
+}
+
+/* 函数实现
+ * -------------------------------------------------------------------*/
+
+/**
+ * @brief  设置默认波特率并启动DMA接收
+ */
+void UartLink_Init(void) {
+  UartLink_ApplyBaud(UARTLINK_BAUD);
+}
+
+/**
+ * @brief  执行挂起的波特率切换
+ */
+void UartLink_Poll(void) {
+  uint32_t baud = uartlink_baud_pending;
+
+  // 等应答和之前的帧都以旧波特率发完
+  if ((baud != 0U) && (uartlink_tx_inflight == 0U) &&
+      (uartlink_tx_head == uartlink_tx_tail)) {
+    UartLink_ApplyBaud(baud);
+    uartlink_baud_pending = 0U;
+    TLOG("uartlink: %u baud, dropped %u bad %u errors %u", baud, uartlink_tx_dropped,
+         uartlink_rx_bad, uartlink_errors);
+  }
+}
+
+/**
+ * @brief  编码并发送一帧
+ */
+bool UartLink_Send(const void *payload, uint32_t len) {
+  uint8_t raw[UARTLINK_MAX_PAYLOAD + 2U];
+  uint8_t frame[UARTLINK_FRAME_MAX];
+  uint32_t head = uartlink_tx_head;
+  uint32_t start = head & (UARTLINK_TX_SIZE - 1U);
+  uint32_t n;
+  uint32_t first;
+  uint16_t crc;
+
+  if (len > UARTLINK_MAX_PAYLOAD) {
+    return false;
+  }
+  memcpy(raw, payload, len);
+  crc = UartLink_Crc16(raw, len);
+  raw[len] = (uint8_t)crc;
+  raw[len + 1U] = (uint8_t)(crc >> 8);
+  n = UartLink_CobsEncode(raw, len + 2U, frame);
+  frame[n++] = 0U;
+
+  if ((uartlink_baud_pending != 0U) ||
+      (n > (UARTLINK_TX_SIZE - (head - uartlink_tx_tail)))) {
+    uartlink_tx_dropped++;
+    return false;
+  }
+  first = (n < (UARTLINK_TX_SIZE - start)) ? n : (UARTLINK_TX_SIZE - start);
+  memcpy(&uartlink_tx[start], frame, first);
+  memcpy(uartlink_tx, &frame[first], n - first);
+  __DMB();  // 数据写完再发布head
+  uartlink_tx_head = head + n;
+
+  taskENTER_CRITICAL();
+  UartLink_TxStart();
+  taskEXIT_CRITICAL();
+  return true;
+}
+
+/**
+ * @brief  波特率是否可用
+ */
+bool UartLink_BaudValid(uint32_t baud) {
+  return (baud >= UARTLINK_BAUD_MIN) && (baud <= (HAL_RCC_GetPCLK2Freq() / 8U));
+}
+
+/**
+ * @brief  请求切换波特率
+ */
+void UartLink_SetBaud(uint32_t baud) {
+  if (UartLink_BaudValid(baud) && (baud != huart1.Init.BaudRate)) {
+    uartlink_baud_pending = baud;
+  }
+}
+
+/**
+ * @brief  当前波特率
+ */
+uint32_t UartLink_GetBaud(void) {
+  return huart1.Init.BaudRate;
+}
+
+/**
+ * @brief  DMA半满/满或线路空闲
+ * @param  Size: DMA在本轮缓冲中写到的位置
+ */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
+  if (huart->Instance == USART1) {
+    UartLink_RxUpTo(Size % UARTLINK_RX_SIZE);
+  }
+}
+
+/**
+ * @brief  一段发送完成, 接着发送下一段
+ */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+  if (huart->Instance == USART1) {
+    uartlink_tx_tail += uartlink_tx_inflight;
+    uartlink_tx_inflight = 0U;
+    UartLink_TxStart();
+  }
+}
+
+/**
+ * @brief  串口错误: HAL已停止DMA接收, 重新启动
+ */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
+  if (huart->Instance != USART1) {
+    return;
+  }
+  uartlink_errors++;
+  if (huart->RxState == HAL_UART_STATE_READY) {
+    UartLink_StartRx();
+  }
+  if ((huart->gState == HAL_UART_STATE_READY) && (uartlink_tx_inflight != 0U)) {
+    // 发送DMA出错, 丢掉这一段
+    uartlink_tx_tail += uartlink_tx_inflight;
+    uartlink_tx_inflight = 0U;
+    UartLink_TxStart();
+  }
+}
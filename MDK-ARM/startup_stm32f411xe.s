@@ -174,6 +174,19 @@ Reset_Handler    PROC
         IMPORT  SystemInit
         IMPORT  __main
 
+                 ; Start the DWT cycle counter from 0 for the boot profiler
+                 ; (bootprof.h): DEMCR.TRCENA, CYCCNT = 0, CTRL.CYCCNTENA
+                 LDR     R0, =0xE000EDFC
+                 LDR     R1, [R0]
+                 ORR     R1, R1, #0x01000000
+                 STR     R1, [R0]
+                 LDR     R0, =0xE0001000
+                 MOVS    R1, #0
+                 STR     R1, [R0, #4]
+                 LDR     R1, [R0]
+                 ORR     R1, R1, #1
+                 STR     R1, [R0]
+
                  LDR     R0, =SystemInit
                  BLX     R0
                  LDR     R0, =__main
@@ -61,7 +61,6 @@ extern "C" {
 #define AUDIO_OUT_EP                                  0x01U
 #endif /* AUDIO_OUT_EP */
 
-#define USB_AUDIO_CONFIG_DESC_SIZ                     0x6DU
 #define AUDIO_INTERFACE_DESC_SIZE                     0x09U
 #define USB_AUDIO_DESC_SIZ                            0x09U
 #define AUDIO_STANDARD_ENDPOINT_DESC_SIZE             0x09U
@@ -114,6 +113,89 @@ extern "C" {
 /* Total size of the audio transfer buffer */
 #define AUDIO_TOTAL_BUF_SIZE                          ((uint16_t)(AUDIO_OUT_PACKET * AUDIO_OUT_PACKET_NUM))
 
+/* Descriptor builder
+   Each AUDIO_DESC_xxx macro expands to the bytes of one descriptor, its
+   length is the matching _SIZE/_LEN define. wTotalLength of the
+   configuration and of the AC header are sums of these lengths, and
+   usbd_audio.c checks at compile time that the array has the same size,
+   so adding or removing a descriptor cannot leave a stale length behind.
+   Multi-byte fields are little endian, wrapped by AUDIO_DESC_U16. */
+#define AUDIO_DESC_U16(v)                             (uint8_t)((v) & 0xFFU), (uint8_t)(((v) >> 8) & 0xFFU)
+
+#define AUDIO_SAMPLE_FREQ(frq) \
+  (uint8_t)(frq), (uint8_t)(((frq) >> 8)), (uint8_t)(((frq) >> 16))
+
+#define AUDIO_PACKET_SZE(frq) \
+  (uint8_t)((((frq) * 2U * 2U) / 1000U) & 0xFFU), (uint8_t)(((((frq) * 2U * 2U) / 1000U) >> 8) & 0xFFU)
+
+#define AUDIO_FEATURE_UNIT_DESC_SIZE                  0x09U   /* one channel, 1 byte controls */
+#define AUDIO_FORMAT_TYPE_I_DESC_LEN(nfreq)           (0x08U + (3U * (nfreq)))
+
+/* Standard interface, AudioControl or AudioStreaming */
+#define AUDIO_DESC_IF(ifnum, alt, neps, subclass) \
+  AUDIO_INTERFACE_DESC_SIZE, USB_DESC_TYPE_INTERFACE, (ifnum), (alt), (neps), \
+  USB_DEVICE_CLASS_AUDIO, (subclass), AUDIO_PROTOCOL_UNDEFINED, 0x00
+
+/* Class-specific AC header, one streaming interface in the collection */
+#define AUDIO_DESC_AC_HEADER(total, asif) \
+  AUDIO_INTERFACE_DESC_SIZE, AUDIO_INTERFACE_DESCRIPTOR_TYPE, AUDIO_CONTROL_HEADER, \
+  AUDIO_DESC_U16(0x0100U), AUDIO_DESC_U16(total), 0x01, (asif)
+
+#define AUDIO_DESC_INPUT_TERMINAL(id, type, nch, chcfg) \
+  AUDIO_INPUT_TERMINAL_DESC_SIZE, AUDIO_INTERFACE_DESCRIPTOR_TYPE, AUDIO_CONTROL_INPUT_TERMINAL, \
+  (id), AUDIO_DESC_U16(type), 0x00, (nch), AUDIO_DESC_U16(chcfg), 0x00, 0x00
+
+#define AUDIO_DESC_FEATURE_UNIT(id, src, ctrl_master, ctrl_ch1) \
+  AUDIO_FEATURE_UNIT_DESC_SIZE, AUDIO_INTERFACE_DESCRIPTOR_TYPE, AUDIO_CONTROL_FEATURE_UNIT, \
+  (id), (src), 0x01, (uint8_t)(ctrl_master), (uint8_t)(ctrl_ch1), 0x00
+
+#define AUDIO_DESC_OUTPUT_TERMINAL(id, type, src) \
+  AUDIO_OUTPUT_TERMINAL_DESC_SIZE, AUDIO_INTERFACE_DESCRIPTOR_TYPE, AUDIO_CONTROL_OUTPUT_TERMINAL, \
+  (id), AUDIO_DESC_U16(type), 0x00, (src), 0x00
+
+#define AUDIO_DESC_AS_GENERAL(link, delay, format) \
+  AUDIO_STREAMING_INTERFACE_DESC_SIZE, AUDIO_INTERFACE_DESCRIPTOR_TYPE, AUDIO_STREAMING_GENERAL, \
+  (link), (delay), AUDIO_DESC_U16(format)
+
+/* Type I format header, follow it with nfreq AUDIO_SAMPLE_FREQ() entries */
+#define AUDIO_DESC_FORMAT_I(nch, subframe, bits, nfreq) \
+  AUDIO_FORMAT_TYPE_I_DESC_LEN(nfreq), AUDIO_INTERFACE_DESCRIPTOR_TYPE, AUDIO_STREAMING_FORMAT_TYPE, \
+  AUDIO_FORMAT_TYPE_I, (nch), (subframe), (bits), (nfreq)
+
+#define AUDIO_DESC_ISO_EP(epadd, mps, interval) \
+  AUDIO_STANDARD_ENDPOINT_DESC_SIZE, USB_DESC_TYPE_ENDPOINT, (epadd), USBD_EP_TYPE_ISOC, \
+  AUDIO_DESC_U16(mps), (interval), 0x00, 0x00
+
+#define AUDIO_DESC_ISO_EP_GENERAL() \
+  AUDIO_STREAMING_ENDPOINT_DESC_SIZE, AUDIO_ENDPOINT_DESCRIPTOR_TYPE, AUDIO_ENDPOINT_GENERAL, \
+  0x00, 0x00, AUDIO_DESC_U16(0x0000U)
+
+/* Speaker function: USB streaming -> feature unit (mute) -> speaker, one
+   stereo 16 bit rate on an isochronous OUT endpoint. Interfaces acif and
+   asif (alt 0 zero bandwidth, alt 1 operational). */
+#define AUDIO_SPEAKER_AC_LEN          (AUDIO_INTERFACE_DESC_SIZE + AUDIO_INPUT_TERMINAL_DESC_SIZE + \
+                                       AUDIO_FEATURE_UNIT_DESC_SIZE + AUDIO_OUTPUT_TERMINAL_DESC_SIZE)
+
+#define AUDIO_SPEAKER_DESC_LEN        (AUDIO_INTERFACE_DESC_SIZE + AUDIO_SPEAKER_AC_LEN + \
+                                       (2U * AUDIO_INTERFACE_DESC_SIZE) + AUDIO_STREAMING_INTERFACE_DESC_SIZE + \
+                                       AUDIO_FORMAT_TYPE_I_DESC_LEN(1U) + AUDIO_STANDARD_ENDPOINT_DESC_SIZE + \
+                                       AUDIO_STREAMING_ENDPOINT_DESC_SIZE)
+
+#define AUDIO_DESC_SPEAKER(acif, asif, epadd, freq) \
+  AUDIO_DESC_IF((acif), 0x00, 0x00, AUDIO_SUBCLASS_AUDIOCONTROL), \
+  AUDIO_DESC_AC_HEADER(AUDIO_SPEAKER_AC_LEN, (asif)), \
+  AUDIO_DESC_INPUT_TERMINAL(0x01, 0x0101U, 0x01, 0x0000U), \
+  AUDIO_DESC_FEATURE_UNIT(AUDIO_OUT_STREAMING_CTRL, 0x01, AUDIO_CONTROL_MUTE, 0x00), \
+  AUDIO_DESC_OUTPUT_TERMINAL(0x03, 0x0301U, AUDIO_OUT_STREAMING_CTRL), \
+  AUDIO_DESC_IF((asif), 0x00, 0x00, AUDIO_SUBCLASS_AUDIOSTREAMING), \
+  AUDIO_DESC_IF((asif), 0x01, 0x01, AUDIO_SUBCLASS_AUDIOSTREAMING), \
+  AUDIO_DESC_AS_GENERAL(0x01, 0x01, 0x0001U), \
+  AUDIO_DESC_FORMAT_I(0x02, 0x02, 16, 0x01), AUDIO_SAMPLE_FREQ(freq), \
+  AUDIO_DESC_ISO_EP((epadd), ((freq) * 2U * 2U) / 1000U, AUDIO_FS_BINTERVAL), \
+  AUDIO_DESC_ISO_EP_GENERAL()
+
+#define USB_AUDIO_CONFIG_DESC_SIZ     (USB_CONF_DESC_SIZE + AUDIO_SPEAKER_DESC_LEN)
+
 /* Audio Commands enumeration */
 typedef enum
 {
@@ -149,12 +231,13 @@ typedef struct
 
 typedef struct
 {
+  uint8_t buffer[AUDIO_TOTAL_BUF_SIZE];     /* First member: inherits the allocator alignment (DMA burst) */
   uint32_t alt_setting;
-  uint8_t buffer[AUDIO_TOTAL_BUF_SIZE];
   AUDIO_OffsetTypeDef offset;
   uint8_t rd_enable;
   uint16_t rd_ptr;
   uint16_t wr_ptr;
+  uint8_t mute;                             /* Feature unit mute, what GET_CUR reports */
   USBD_AUDIO_ControlTypeDef control;
 } USBD_AUDIO_HandleTypeDef;
 
@@ -309,6 +392,10 @@ uint8_t USBD_AUDIO_RegisterInterface(USBD_HandleTypeDef *pdev,
                                      USBD_AUDIO_ItfTypeDef *fops);
 
 void USBD_AUDIO_Sync(USBD_HandleTypeDef *pdev, AUDIO_OffsetTypeDef offset);
+uint32_t USBD_AUDIO_SyncSize(uint16_t rd_ptr, uint16_t wr_ptr);
+uint32_t USBD_AUDIO_GetWritePtr(USBD_HandleTypeDef *pdev);
+uint32_t USBD_AUDIO_GetAltSetting(USBD_HandleTypeDef *pdev);
+void USBD_AUDIO_SetMute(USBD_HandleTypeDef *pdev, uint8_t mute);
 
 #ifdef USE_USBD_COMPOSITE
 uint32_t USBD_AUDIO_GetEpPcktSze(USBD_HandleTypeDef *pdev, uint8_t If, uint8_t Ep);
@@ -0,0 +1,135 @@
+/**
+  ******************************************************************************
+  * @file    usbd_composite_builder.h
+  * @brief   Header for the usbd_composite_builder.c file
+  ******************************************************************************
+  * @attention
+  *
+  * Slim composite builder for this device: it only knows the classes the
+  * firmware actually registers (AUDIO speaker, the VENDOR bulk interface and
+  * the HID Consumer Control interface).
+  * The API follows the one expected by usbd_core.c/usbd_ctlreq.c when
+  * USE_USBD_COMPOSITE is defined.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_CMPSIT_H
+#define __USBD_CMPSIT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include  "usbd_ioreq.h"
+
+#if USBD_CMPSIT_ACTIVATE_AUDIO == 1U
+#include  "usbd_audio.h"
+#endif /* USBD_CMPSIT_ACTIVATE_AUDIO */
+
+#if USBD_CMPSIT_ACTIVATE_VENDOR == 1U
+#include  "usbd_vendor.h"
+#endif /* USBD_CMPSIT_ACTIVATE_VENDOR */
+
+#if USBD_CMPSIT_ACTIVATE_HID == 1U
+#include  "usbd_hid.h"
+#endif /* USBD_CMPSIT_ACTIVATE_HID */
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_CMPSIT
+  * @brief This file is the header file for usbd_composite_builder.c file
+  * @{
+  */
+
+
+/** @defgroup USBD_CMPSIT_Exported_Defines
+  * @{
+  */
+/* Size of the buffer holding the generated configuration descriptor */
+#ifndef USBD_CMPST_MAX_CONFDESC_SZ
+#define USBD_CMPST_MAX_CONFDESC_SZ                    256U
+#endif /* USBD_CMPST_MAX_CONFDESC_SZ */
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_CMPSIT_Exported_TypesDefinitions
+  * @{
+  */
+typedef struct
+{
+  uint8_t   bLength;
+  uint8_t   bDescriptorType;
+  uint8_t   bFirstInterface;
+  uint8_t   bInterfaceCount;
+  uint8_t   bFunctionClass;
+  uint8_t   bFunctionSubClass;
+  uint8_t   bFunctionProtocol;
+  uint8_t   iFunction;
+} __PACKED USBD_IadDescTypeDef;
+
+typedef struct
+{
+  uint8_t   bLength;
+  uint8_t   bDescriptorType;
+  uint8_t   bInterfaceNumber;
+  uint8_t   bAlternateSetting;
+  uint8_t   bNumEndpoints;
+  uint8_t   bInterfaceClass;
+  uint8_t   bInterfaceSubClass;
+  uint8_t   bInterfaceProtocol;
+  uint8_t   iInterface;
+} __PACKED USBD_IfDescTypeDef;
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_CMPSIT_Exported_Variables
+  * @{
+  */
+extern USBD_ClassTypeDef  USBD_CMPSIT;
+/**
+  * @}
+  */
+
+/** @defgroup USB_CORE_Exported_Functions
+  * @{
+  */
+uint8_t  USBD_CMPSIT_AddClass(USBD_HandleTypeDef *pdev,
+                              USBD_ClassTypeDef *pclass,
+                              USBD_CompositeClassTypeDef class,
+                              uint8_t cfgidx);
+
+uint32_t USBD_CMPSIT_SetClassID(USBD_HandleTypeDef *pdev,
+                                USBD_CompositeClassTypeDef Class,
+                                uint32_t Instance);
+
+uint32_t USBD_CMPSIT_GetClassID(USBD_HandleTypeDef *pdev,
+                                USBD_CompositeClassTypeDef Class,
+                                uint32_t Instance);
+
+uint8_t  USBD_CMPST_ClearConfDesc(USBD_HandleTypeDef *pdev);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __USBD_CMPSIT_H */
@@ -0,0 +1,509 @@
+/**
+  ******************************************************************************
+  * @file    usbd_composite_builder.c
+  * @brief   This file provides all the composite builder functions.
+  ******************************************************************************
+  * @attention
+  *
+  * The configuration descriptor is assembled at run time while the classes
+  * are registered with USBD_RegisterClassComposite():
+  *
+  *  - the first class writes the 9 byte configuration header,
+  *  - each class appends its interface/endpoint descriptors, numbering its
+  *    interfaces after the ones already in use and taking the endpoint
+  *    addresses from the EpAdd array given at registration,
+  *  - the class table (pdev->tclasslist) is filled with the interfaces and
+  *    endpoints of the class, which is what USBD_CoreFindIF/USBD_CoreFindEP
+  *    use to route requests and endpoint events to the right class,
+  *  - wTotalLength and bNumInterfaces are patched after every class.
+  *
+  * Multi-interface functions (AUDIO) are grouped with an Interface
+  * Association Descriptor, the device descriptor must then announce the
+  * Miscellaneous/Common/IAD class triple (see usbd_desc.c).
+  *
+  * Only a Full Speed descriptor is built, the OTG_FS core cannot run at
+  * High Speed.
+  *
+  ******************************************************************************
+  */
+
+#ifdef USE_USBD_COMPOSITE
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_composite_builder.h"
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+
+/** @defgroup CMPSIT_CORE
+  * @brief composite builder module
+  * @{
+  */
+
+/** @defgroup CMPSIT_CORE_Private_Macros
+  * @{
+  */
+#define __USBD_CMPSIT_SET_IF(ifnum, alt, eps, class, subclass, protocol) \
+  do { \
+    USBD_IfDescTypeDef *pIfDesc = (USBD_IfDescTypeDef *)((uint32_t)pConf + *Sze); \
+    pIfDesc->bLength = (uint8_t)sizeof(USBD_IfDescTypeDef); \
+    pIfDesc->bDescriptorType = USB_DESC_TYPE_INTERFACE; \
+    pIfDesc->bInterfaceNumber = (ifnum); \
+    pIfDesc->bAlternateSetting = (alt); \
+    pIfDesc->bNumEndpoints = (eps); \
+    pIfDesc->bInterfaceClass = (class); \
+    pIfDesc->bInterfaceSubClass = (subclass); \
+    pIfDesc->bInterfaceProtocol = (protocol); \
+    pIfDesc->iInterface = 0U; \
+    *Sze += (uint32_t)sizeof(USBD_IfDescTypeDef); \
+  } while (0)
+
+#define __USBD_CMPSIT_SET_EP(epadd, eptype, epsize, binterval) \
+  do { \
+    USBD_EpDescTypeDef *pEpDesc = (USBD_EpDescTypeDef *)((uint32_t)pConf + *Sze); \
+    pEpDesc->bLength = (uint8_t)sizeof(USBD_EpDescTypeDef); \
+    pEpDesc->bDescriptorType = USB_DESC_TYPE_ENDPOINT; \
+    pEpDesc->bEndpointAddress = (epadd); \
+    pEpDesc->bmAttributes = (eptype); \
+    pEpDesc->wMaxPacketSize = (uint16_t)(epsize); \
+    pEpDesc->bInterval = (binterval); \
+    *Sze += (uint32_t)sizeof(USBD_EpDescTypeDef); \
+  } while (0)
+/**
+  * @}
+  */
+
+
+/** @defgroup CMPSIT_CORE_Private_FunctionPrototypes
+  * @{
+  */
+static uint8_t *USBD_CMPSIT_GetFSCfgDesc(uint16_t *length);
+static uint8_t *USBD_CMPSIT_GetDeviceQualifierDescriptor(uint16_t *length);
+
+static uint8_t USBD_CMPSIT_FindFreeIFNbr(USBD_HandleTypeDef *pdev);
+static void USBD_CMPSIT_AddConfDesc(uint32_t Conf, __IO uint32_t *pSze);
+static void USBD_CMPSIT_AssignEp(USBD_HandleTypeDef *pdev, uint8_t Add, uint8_t Type, uint32_t Sze);
+static void USBD_CMPSIT_Put(uint32_t pConf, __IO uint32_t *Sze, const uint8_t *pbuf, uint32_t len);
+
+#if USBD_CMPSIT_ACTIVATE_AUDIO == 1U
+static void USBD_CMPSIT_AUDIODesc(USBD_HandleTypeDef *pdev, uint32_t pConf, __IO uint32_t *Sze);
+#endif /* USBD_CMPSIT_ACTIVATE_AUDIO */
+
+#if USBD_CMPSIT_ACTIVATE_VENDOR == 1U
+static void USBD_CMPSIT_VENDORDesc(USBD_HandleTypeDef *pdev, uint32_t pConf, __IO uint32_t *Sze);
+#endif /* USBD_CMPSIT_ACTIVATE_VENDOR */
+
+#if USBD_CMPSIT_ACTIVATE_HID == 1U
+static void USBD_CMPSIT_HIDDesc(USBD_HandleTypeDef *pdev, uint32_t pConf, __IO uint32_t *Sze);
+#endif /* USBD_CMPSIT_ACTIVATE_HID */
+/**
+  * @}
+  */
+
+
+/** @defgroup CMPSIT_CORE_Private_Variables
+  * @{
+  */
+/* This structure is used only for the Configuration descriptors and Device Qualifier */
+USBD_ClassTypeDef  USBD_CMPSIT =
+{
+  NULL, /* Init, */
+  NULL, /* DeInit, */
+  NULL, /* Setup, */
+  NULL, /* EP0_TxSent, */
+  NULL, /* EP0_RxReady, */
+  NULL, /* DataIn, */
+  NULL, /* DataOut, */
+  NULL, /* SOF,  */
+  NULL,
+  NULL,
+  USBD_CMPSIT_GetFSCfgDesc, /* Full Speed only device */
+  USBD_CMPSIT_GetFSCfgDesc,
+  USBD_CMPSIT_GetFSCfgDesc,
+  USBD_CMPSIT_GetDeviceQualifierDescriptor,
+#if (USBD_SUPPORT_USER_STRING_DESC == 1U)
+  NULL,
+#endif /* USBD_SUPPORT_USER_STRING_DESC */
+};
+
+/* The generated Configuration Descriptor and its current size */
+__ALIGN_BEGIN static uint8_t USBD_CMPSIT_FSCfgDesc[USBD_CMPST_MAX_CONFDESC_SZ]  __ALIGN_END;
+static uint32_t CurrFSConfDescSz = 0U;
+
+/* USB Standard Device Descriptor */
+__ALIGN_BEGIN static uint8_t USBD_CMPSIT_DeviceQualifierDesc[USB_LEN_DEV_QUALIFIER_DESC] __ALIGN_END =
+{
+  USB_LEN_DEV_QUALIFIER_DESC,
+  USB_DESC_TYPE_DEVICE_QUALIFIER,
+  0x00,
+  0x02,
+  0xEF,                                 /* Miscellaneous (IAD) */
+  0x02,
+  0x01,
+  0x40,
+  0x01,
+  0x00,
+};
+/**
+  * @}
+  */
+
+
+/** @defgroup CMPSIT_CORE_Private_Functions
+  * @{
+  */
+
+/**
+  * @brief  USBD_CMPSIT_AddClass
+  *         Register a class in the class table and append its descriptors
+  * @param  pdev: device instance
+  * @param  pclass: class handle
+  * @param  class: type of the class
+  * @param  cfgidx: configuration index (only one configuration is supported)
+  * @retval status
+  */
+uint8_t  USBD_CMPSIT_AddClass(USBD_HandleTypeDef *pdev,
+                              USBD_ClassTypeDef *pclass,
+                              USBD_CompositeClassTypeDef class,
+                              uint8_t cfgidx)
+{
+  UNUSED(pclass);
+  UNUSED(cfgidx);
+
+  if ((pdev->classId == 0U) || (CurrFSConfDescSz == 0U))
+  {
+    USBD_CMPSIT_AddConfDesc((uint32_t)USBD_CMPSIT_FSCfgDesc, &CurrFSConfDescSz);
+  }
+
+  pdev->tclasslist[pdev->classId].ClassType = class;
+  pdev->tclasslist[pdev->classId].ClassId = pdev->classId;
+  pdev->tclasslist[pdev->classId].Active = 1U;
+  pdev->tclasslist[pdev->classId].NumEps = 0U;
+  pdev->tclasslist[pdev->classId].NumIf = 0U;
+
+  switch (class)
+  {
+#if USBD_CMPSIT_ACTIVATE_AUDIO == 1U
+    case CLASS_TYPE_AUDIO:
+      USBD_CMPSIT_AUDIODesc(pdev, (uint32_t)USBD_CMPSIT_FSCfgDesc, &CurrFSConfDescSz);
+      break;
+#endif /* USBD_CMPSIT_ACTIVATE_AUDIO */
+
+#if USBD_CMPSIT_ACTIVATE_VENDOR == 1U
+    case CLASS_TYPE_VENDOR:
+      USBD_CMPSIT_VENDORDesc(pdev, (uint32_t)USBD_CMPSIT_FSCfgDesc, &CurrFSConfDescSz);
+      break;
+#endif /* USBD_CMPSIT_ACTIVATE_VENDOR */
+
+#if USBD_CMPSIT_ACTIVATE_HID == 1U
+    case CLASS_TYPE_HID:
+      USBD_CMPSIT_HIDDesc(pdev, (uint32_t)USBD_CMPSIT_FSCfgDesc, &CurrFSConfDescSz);
+      break;
+#endif /* USBD_CMPSIT_ACTIVATE_HID */
+
+    default:
+      pdev->tclasslist[pdev->classId].Active = 0U;
+      return (uint8_t)USBD_FAIL;
+  }
+
+  /* Update wTotalLength and bNumInterfaces of the configuration header */
+  ((USBD_ConfigDescTypeDef *)(void *)USBD_CMPSIT_FSCfgDesc)->wTotalLength = (uint16_t)CurrFSConfDescSz;
+  ((USBD_ConfigDescTypeDef *)(void *)USBD_CMPSIT_FSCfgDesc)->bNumInterfaces = USBD_CMPSIT_FindFreeIFNbr(pdev);
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_CMPSIT_SetClassID
+  *         Select the class instance before calling its RegisterInterface
+  * @param  pdev: device instance
+  * @param  Class: type of the class
+  * @param  Instance: instance of this type (0 for the first one)
+  * @retval index of the class in the table, 0xFF if not found
+  */
+uint32_t USBD_CMPSIT_SetClassID(USBD_HandleTypeDef *pdev, USBD_CompositeClassTypeDef Class, uint32_t Instance)
+{
+  uint32_t idx = USBD_CMPSIT_GetClassID(pdev, Class, Instance);
+
+  if (idx != 0xFFU)
+  {
+    pdev->classId = idx;
+  }
+
+  return idx;
+}
+
+/**
+  * @brief  USBD_CMPSIT_GetClassID
+  *         Find a class instance in the class table
+  * @param  pdev: device instance
+  * @param  Class: type of the class
+  * @param  Instance: instance of this type (0 for the first one)
+  * @retval index of the class in the table, 0xFF if not found
+  */
+uint32_t USBD_CMPSIT_GetClassID(USBD_HandleTypeDef *pdev, USBD_CompositeClassTypeDef Class, uint32_t Instance)
+{
+  uint32_t inst = 0U;
+
+  for (uint32_t idx = 0U; idx < pdev->NumClasses; idx++)
+  {
+    if ((pdev->tclasslist[idx].ClassType == Class) &&
+        (pdev->tclasslist[idx].Active == 1U))
+    {
+      if (inst == Instance)
+      {
+        return idx;
+      }
+      inst++;
+    }
+  }
+
+  return 0xFFU;
+}
+
+/**
+  * @brief  USBD_CMPST_ClearConfDesc
+  *         Reset the generated configuration descriptor
+  * @param  pdev: device instance (reserved for future use)
+  * @retval status
+  */
+uint8_t  USBD_CMPST_ClearConfDesc(USBD_HandleTypeDef *pdev)
+{
+  UNUSED(pdev);
+
+  CurrFSConfDescSz = 0U;
+  (void)USBD_memset(USBD_CMPSIT_FSCfgDesc, 0, sizeof(USBD_CMPSIT_FSCfgDesc));
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_CMPSIT_GetFSCfgDesc
+  *         return configuration descriptor for both FS and HS modes
+  * @param  length : pointer data length
+  * @retval pointer to descriptor buffer
+  */
+static uint8_t *USBD_CMPSIT_GetFSCfgDesc(uint16_t *length)
+{
+  *length = (uint16_t)CurrFSConfDescSz;
+
+  return USBD_CMPSIT_FSCfgDesc;
+}
+
+/**
+  * @brief  USBD_CMPSIT_GetDeviceQualifierDescriptor
+  *         return Device Qualifier descriptor
+  * @param  length : pointer data length
+  * @retval pointer to descriptor buffer
+  */
+static uint8_t *USBD_CMPSIT_GetDeviceQualifierDescriptor(uint16_t *length)
+{
+  *length = (uint16_t)(sizeof(USBD_CMPSIT_DeviceQualifierDesc));
+
+  return USBD_CMPSIT_DeviceQualifierDesc;
+}
+
+/**
+  * @brief  USBD_CMPSIT_FindFreeIFNbr
+  *         Number of interfaces used by the classes registered so far, which
+  *         is also the number of the next free interface
+  * @param  pdev: device instance
+  * @retval interface number
+  */
+static uint8_t USBD_CMPSIT_FindFreeIFNbr(USBD_HandleTypeDef *pdev)
+{
+  uint32_t idx = 0U;
+
+  for (uint32_t i = 0U; i <= pdev->classId; i++)
+  {
+    idx += pdev->tclasslist[i].NumIf;
+  }
+
+  return (uint8_t)idx;
+}
+
+/**
+  * @brief  USBD_CMPSIT_AddConfDesc
+  *         Write the configuration header
+  * @param  Conf: configuration descriptor buffer
+  * @param  pSze: current size of the descriptor
+  * @retval none
+  */
+static void USBD_CMPSIT_AddConfDesc(uint32_t Conf, __IO uint32_t *pSze)
+{
+  USBD_ConfigDescTypeDef *ptr = (USBD_ConfigDescTypeDef *)Conf;
+
+  ptr->bLength = (uint8_t)sizeof(USBD_ConfigDescTypeDef);
+  ptr->bDescriptorType = USB_DESC_TYPE_CONFIGURATION;
+  ptr->wTotalLength = 0U;
+  ptr->bNumInterfaces = 0U;
+  ptr->bConfigurationValue = 1U;
+  ptr->iConfiguration = 0U;
+#if (USBD_SELF_POWERED == 1U)
+  ptr->bmAttributes = 0xC0U;
+#else
+  ptr->bmAttributes = 0x80U;
+#endif /* USBD_SELF_POWERED */
+  ptr->bMaxPower = USBD_MAX_POWER;
+
+  *pSze = (uint32_t)sizeof(USBD_ConfigDescTypeDef);
+}
+
+/**
+  * @brief  USBD_CMPSIT_AssignEp
+  *         Add an endpoint to the table of the class being registered
+  * @param  pdev: device instance
+  * @param  Add: endpoint address
+  * @param  Type: endpoint type
+  * @param  Sze: endpoint max packet size
+  * @retval none
+  */
+static void USBD_CMPSIT_AssignEp(USBD_HandleTypeDef *pdev, uint8_t Add, uint8_t Type, uint32_t Sze)
+{
+  uint32_t idx = pdev->tclasslist[pdev->classId].NumEps;
+
+  if (idx < USBD_MAX_CLASS_ENDPOINTS)
+  {
+    pdev->tclasslist[pdev->classId].Eps[idx].add = Add;
+    pdev->tclasslist[pdev->classId].Eps[idx].type = Type;
+    pdev->tclasslist[pdev->classId].Eps[idx].size = (uint8_t)Sze;
+    pdev->tclasslist[pdev->classId].Eps[idx].is_used = 1U;
+    pdev->tclasslist[pdev->classId].NumEps++;
+  }
+}
+
+/**
+  * @brief  USBD_CMPSIT_Put
+  *         Append raw class specific descriptor bytes
+  * @param  pConf: configuration descriptor buffer
+  * @param  Sze: current size of the descriptor
+  * @param  pbuf: bytes to append
+  * @param  len: number of bytes
+  * @retval none
+  */
+static void USBD_CMPSIT_Put(uint32_t pConf, __IO uint32_t *Sze, const uint8_t *pbuf, uint32_t len)
+{
+  if ((*Sze + len) <= USBD_CMPST_MAX_CONFDESC_SZ)
+  {
+    (void)USBD_memcpy((uint8_t *)(pConf + *Sze), pbuf, len);
+    *Sze += len;
+  }
+}
+
+#if USBD_CMPSIT_ACTIVATE_AUDIO == 1U
+/**
+  * @brief  USBD_CMPSIT_AUDIODesc
+  *         Speaker function: IAD followed by the AudioControl and
+  *         AudioStreaming interfaces from AUDIO_DESC_SPEAKER()
+  * @param  pdev: device instance
+  * @param  pConf: configuration descriptor buffer
+  * @param  Sze: current size of the descriptor
+  * @retval none
+  */
+static void USBD_CMPSIT_AUDIODesc(USBD_HandleTypeDef *pdev, uint32_t pConf, __IO uint32_t *Sze)
+{
+  USBD_IadDescTypeDef *pIadDesc;
+  uint8_t ifnum = USBD_CMPSIT_FindFreeIFNbr(pdev);
+  uint8_t epadd = pdev->tclasslist[pdev->classId].EpAdd[0];
+  uint32_t mps = USBD_AUDIO_GetEpPcktSze(pdev, 0U, 0U);
+
+  /* Same descriptors as the single class configuration in usbd_audio.c */
+  const uint8_t speaker_desc[] =
+  {
+    AUDIO_DESC_SPEAKER(ifnum, (uint8_t)(ifnum + 1U), epadd, USBD_AUDIO_FREQ),
+  };
+
+  pdev->tclasslist[pdev->classId].NumIf = 2U;
+  pdev->tclasslist[pdev->classId].Ifs[0] = ifnum;
+  pdev->tclasslist[pdev->classId].Ifs[1] = (uint8_t)(ifnum + 1U);
+  pdev->tclasslist[pdev->classId].CurrPcktSze = mps;
+  USBD_CMPSIT_AssignEp(pdev, epadd, USBD_EP_TYPE_ISOC, mps);
+
+  pIadDesc = (USBD_IadDescTypeDef *)(pConf + *Sze);
+  pIadDesc->bLength = (uint8_t)sizeof(USBD_IadDescTypeDef);
+  pIadDesc->bDescriptorType = USB_DESC_TYPE_IAD;
+  pIadDesc->bFirstInterface = ifnum;
+  pIadDesc->bInterfaceCount = 2U;
+  pIadDesc->bFunctionClass = USB_DEVICE_CLASS_AUDIO;
+  pIadDesc->bFunctionSubClass = AUDIO_SUBCLASS_AUDIOCONTROL;
+  pIadDesc->bFunctionProtocol = AUDIO_PROTOCOL_UNDEFINED;
+  pIadDesc->iFunction = 0U;
+  *Sze += (uint32_t)sizeof(USBD_IadDescTypeDef);
+
+  USBD_CMPSIT_Put(pConf, Sze, speaker_desc, sizeof(speaker_desc));
+}
+#endif /* USBD_CMPSIT_ACTIVATE_AUDIO */
+
+#if USBD_CMPSIT_ACTIVATE_VENDOR == 1U
+/**
+  * @brief  USBD_CMPSIT_VENDORDesc
+  *         Vendor function: one interface, bulk IN (EpAdd[0]) and bulk OUT (EpAdd[1])
+  * @param  pdev: device instance
+  * @param  pConf: configuration descriptor buffer
+  * @param  Sze: current size of the descriptor
+  * @retval none
+  */
+static void USBD_CMPSIT_VENDORDesc(USBD_HandleTypeDef *pdev, uint32_t pConf, __IO uint32_t *Sze)
+{
+  uint8_t ifnum = USBD_CMPSIT_FindFreeIFNbr(pdev);
+  uint8_t in_ep = pdev->tclasslist[pdev->classId].EpAdd[0];
+  uint8_t out_ep = pdev->tclasslist[pdev->classId].EpAdd[1];
+
+  pdev->tclasslist[pdev->classId].NumIf = 1U;
+  pdev->tclasslist[pdev->classId].Ifs[0] = ifnum;
+  pdev->tclasslist[pdev->classId].CurrPcktSze = VENDOR_DATA_FS_MAX_PACKET_SIZE;
+  USBD_CMPSIT_AssignEp(pdev, in_ep, USBD_EP_TYPE_BULK, VENDOR_DATA_FS_MAX_PACKET_SIZE);
+  USBD_CMPSIT_AssignEp(pdev, out_ep, USBD_EP_TYPE_BULK, VENDOR_DATA_FS_MAX_PACKET_SIZE);
+
+  __USBD_CMPSIT_SET_IF(ifnum, 0U, 2U, USB_VENDOR_CLASS, USB_VENDOR_SUBCLASS, USB_VENDOR_PROTOCOL);
+  __USBD_CMPSIT_SET_EP(in_ep, USBD_EP_TYPE_BULK, VENDOR_DATA_FS_MAX_PACKET_SIZE, 0U);
+  __USBD_CMPSIT_SET_EP(out_ep, USBD_EP_TYPE_BULK, VENDOR_DATA_FS_MAX_PACKET_SIZE, 0U);
+}
+#endif /* USBD_CMPSIT_ACTIVATE_VENDOR */
+
+#if USBD_CMPSIT_ACTIVATE_HID == 1U
+/**
+  * @brief  USBD_CMPSIT_HIDDesc
+  *         Consumer Control function: one interface, HID descriptor and one
+  *         interrupt IN endpoint (EpAdd[0]) polled every frame
+  * @param  pdev: device instance
+  * @param  pConf: configuration descriptor buffer
+  * @param  Sze: current size of the descriptor
+  * @retval none
+  */
+static void USBD_CMPSIT_HIDDesc(USBD_HandleTypeDef *pdev, uint32_t pConf, __IO uint32_t *Sze)
+{
+  uint8_t ifnum = USBD_CMPSIT_FindFreeIFNbr(pdev);
+  uint8_t in_ep = pdev->tclasslist[pdev->classId].EpAdd[0];
+  uint16_t len;
+  uint8_t *phid = USBD_HID_GetHIDDesc(&len);
+
+  pdev->tclasslist[pdev->classId].NumIf = 1U;
+  pdev->tclasslist[pdev->classId].Ifs[0] = ifnum;
+  pdev->tclasslist[pdev->classId].CurrPcktSze = HID_EPIN_SIZE;
+  USBD_CMPSIT_AssignEp(pdev, in_ep, USBD_EP_TYPE_INTR, HID_EPIN_SIZE);
+
+  /* No boot interface, no protocol */
+  __USBD_CMPSIT_SET_IF(ifnum, 0U, 1U, 0x03U, 0x00U, 0x00U);
+  USBD_CMPSIT_Put(pConf, Sze, phid, len);
+  __USBD_CMPSIT_SET_EP(in_ep, USBD_EP_TYPE_INTR, HID_EPIN_SIZE, HID_FS_BINTERVAL);
+}
+#endif /* USBD_CMPSIT_ACTIVATE_HID */
+
+/**
+  * @}
+  */
+
+
+/**
+  * @}
+  */
+
+
+/**
+  * @}
+  */
+
+#endif /* USE_USBD_COMPOSITE */
@@ -0,0 +1,159 @@
+/**
+  ******************************************************************************
+  * @file    usbd_hid.h
+  * @brief   header file for the usbd_hid.c file.
+  ******************************************************************************
+  * @attention
+  *
+  * HID Consumer Control function (media keys) with one interrupt IN endpoint
+  * polled every frame. Only used inside the composite device, its interface
+  * descriptor is generated by usbd_composite_builder.c.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USB_HID_H
+#define __USB_HID_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include  "usbd_ioreq.h"
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_HID
+  * @brief This file is the Header file for usbd_hid.c
+  * @{
+  */
+
+
+/** @defgroup USBD_HID_Exported_Defines
+  * @{
+  */
+#ifndef HID_EPIN_ADDR
+#define HID_EPIN_ADDR                                 0x83U
+#endif /* HID_EPIN_ADDR */
+
+#define HID_EPIN_SIZE                                 0x01U
+
+#ifndef HID_FS_BINTERVAL
+#define HID_FS_BINTERVAL                              0x01U
+#endif /* HID_FS_BINTERVAL */
+
+/* Reports waiting for the IN endpoint, power of two. Each click takes two
+   (press + release), so this holds HID_REPORT_QUEUE_SIZE / 2 detents */
+#ifndef HID_REPORT_QUEUE_SIZE
+#define HID_REPORT_QUEUE_SIZE                         32U
+#endif /* HID_REPORT_QUEUE_SIZE */
+
+/* Time stamp source for the latency statistics, in timer ticks */
+#ifndef USBD_HID_TIMESTAMP
+#define USBD_HID_TIMESTAMP()                          0U
+#endif /* USBD_HID_TIMESTAMP */
+
+#define USB_HID_DESC_SIZ                              9U
+#define HID_CC_REPORT_DESC_SIZE                       27U
+
+#define HID_DESCRIPTOR_TYPE                           0x21U
+#define HID_REPORT_DESC                               0x22U
+
+#define HID_REQ_SET_PROTOCOL                          0x0BU
+#define HID_REQ_GET_PROTOCOL                          0x03U
+
+#define HID_REQ_SET_IDLE                              0x0AU
+#define HID_REQ_GET_IDLE                              0x02U
+
+#define HID_REQ_SET_REPORT                            0x09U
+#define HID_REQ_GET_REPORT                            0x01U
+
+/* Consumer Control report bits */
+#define HID_CC_VOLUME_UP                              0x01U
+#define HID_CC_VOLUME_DOWN                            0x02U
+#define HID_CC_MUTE                                   0x04U
+#define HID_CC_PLAY_PAUSE                             0x08U
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_HID_Exported_TypesDefinitions
+  * @{
+  */
+typedef enum
+{
+  USBD_HID_IDLE = 0,
+  USBD_HID_BUSY,
+} USBD_HID_StateTypeDef;
+
+typedef struct
+{
+  uint8_t report;
+  uint32_t stamp;       /* USBD_HID_TIMESTAMP() when queued */
+} USBD_HID_ReportTypeDef;
+
+typedef struct
+{
+  uint32_t Protocol;
+  uint32_t IdleState;
+  uint32_t AltSetting;
+  USBD_HID_StateTypeDef state;
+  uint8_t tx_report;
+  uint32_t tx_stamp;
+  USBD_HID_ReportTypeDef queue[HID_REPORT_QUEUE_SIZE];
+  uint32_t head;
+  uint32_t tail;
+} USBD_HID_HandleTypeDef;
+
+/* Queue-to-host latency of the reports, in USBD_HID_TIMESTAMP() ticks */
+typedef struct
+{
+  uint32_t reports;     /* reports delivered */
+  uint32_t overflows;   /* reports refused because the queue was full */
+  uint32_t last;
+  uint32_t max;
+  uint64_t sum;         /* for the mean: sum / reports */
+} USBD_HID_LatencyTypeDef;
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_HID_Exported_Variables
+  * @{
+  */
+
+extern USBD_ClassTypeDef USBD_HID;
+#define USBD_HID_CLASS &USBD_HID
+/**
+  * @}
+  */
+
+/** @defgroup USB_CORE_Exported_Functions
+  * @{
+  */
+uint8_t USBD_HID_SendKey(USBD_HandleTypeDef *pdev, uint8_t keys);
+void USBD_HID_GetLatency(USBD_HID_LatencyTypeDef *stats, uint8_t reset);
+uint8_t *USBD_HID_GetHIDDesc(uint16_t *length);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __USB_HID_H */
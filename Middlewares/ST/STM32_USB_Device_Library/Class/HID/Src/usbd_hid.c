@@ -0,0 +1,482 @@
+/**
+  ******************************************************************************
+  * @file    usbd_hid.c
+  * @brief   This file provides the HID core functions for a Consumer Control
+  *          (media key) interface inside a composite device.
+  *
+  *          ===================================================================
+  *                                HID Class Description
+  *          ===================================================================
+  *           - One interrupt IN endpoint, 1 byte report, polled every frame
+  *             (bInterval 1): Volume Up, Volume Down, Mute, Play/Pause.
+  *           - Reports are queued in a FIFO and sent one per frame, so a fast
+  *             turn of the knob loses nothing as long as the FIFO has room.
+  *             Overflows are counted.
+  *           - Every report is time stamped when queued and the delay until
+  *             the host fetched it (DataIn) is kept as latency statistics.
+  *
+  *           USBD_HID_SendKey() shares the FIFO with the DataIn callback
+  *           without a lock: it must be called from an interrupt of the same
+  *           priority as OTG_FS, or with the OTG_FS interrupt masked. In this
+  *           project the only caller is the input task (input.c), inside
+  *           taskENTER_CRITICAL(): OTG_FS sits at
+  *           configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, so BASEPRI masks it.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_hid.h"
+#include "usbd_ctlreq.h"
+
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+
+/** @defgroup USBD_HID
+  * @brief usbd core module
+  * @{
+  */
+
+/** @defgroup USBD_HID_Private_FunctionPrototypes
+  * @{
+  */
+static uint8_t USBD_HID_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_HID_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_HID_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+static uint8_t USBD_HID_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static void USBD_HID_Send(USBD_HandleTypeDef *pdev, USBD_HID_HandleTypeDef *hhid);
+/**
+  * @}
+  */
+
+/** @defgroup USBD_HID_Private_Variables
+  * @{
+  */
+
+USBD_ClassTypeDef USBD_HID =
+{
+  USBD_HID_Init,
+  USBD_HID_DeInit,
+  USBD_HID_Setup,
+  NULL,                 /* EP0_TxSent */
+  NULL,                 /* EP0_RxReady */
+  USBD_HID_DataIn,
+  NULL,                 /* DataOut */
+  NULL,                 /* SOF */
+  NULL,
+  NULL,
+  NULL,                 /* Descriptors come from the composite builder */
+  NULL,
+  NULL,
+  NULL,
+};
+
+/* USB HID device descriptor */
+__ALIGN_BEGIN static uint8_t USBD_HID_Desc[USB_HID_DESC_SIZ] __ALIGN_END =
+{
+  0x09,                                               /* bLength: HID Descriptor size */
+  HID_DESCRIPTOR_TYPE,                                /* bDescriptorType: HID */
+  0x11,                                               /* bcdHID: HID Class Spec release number */
+  0x01,
+  0x00,                                               /* bCountryCode: Hardware target country */
+  0x01,                                               /* bNumDescriptors */
+  HID_REPORT_DESC,                                    /* bDescriptorType */
+  HID_CC_REPORT_DESC_SIZE,                            /* wItemLength: Total length of Report descriptor */
+  0x00,
+};
+
+/* Consumer Control, one bit per usage, 4 bits padding */
+__ALIGN_BEGIN static uint8_t HID_CC_ReportDesc[HID_CC_REPORT_DESC_SIZE] __ALIGN_END =
+{
+  0x05, 0x0C,                                         /* Usage Page (Consumer) */
+  0x09, 0x01,                                         /* Usage (Consumer Control) */
+  0xA1, 0x01,                                         /* Collection (Application) */
+  0x15, 0x00,                                         /*   Logical Minimum (0) */
+  0x25, 0x01,                                         /*   Logical Maximum (1) */
+  0x75, 0x01,                                         /*   Report Size (1) */
+  0x95, 0x04,                                         /*   Report Count (4) */
+  0x09, 0xE9,                                         /*   Usage (Volume Increment) */
+  0x09, 0xEA,                                         /*   Usage (Volume Decrement) */
+  0x09, 0xE2,                                         /*   Usage (Mute) */
+  0x09, 0xCD,                                         /*   Usage (Play/Pause) */
+  0x81, 0x02,                                         /*   Input (Data, Var, Abs) */
+  0x81, 0x03,                                         /*   Input (Const) padding */
+  0xC0                                                /* End Collection */
+};
+
+static uint8_t HIDInEpAdd = HID_EPIN_ADDR;
+
+static USBD_HID_LatencyTypeDef HIDLatency;
+/**
+  * @}
+  */
+
+/** @defgroup USBD_HID_Private_Functions
+  * @{
+  */
+
+/**
+  * @brief  USBD_HID_Init
+  *         Initialize the HID interface
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+static uint8_t USBD_HID_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  UNUSED(cfgidx);
+  USBD_HID_HandleTypeDef *hhid;
+
+  hhid = (USBD_HID_HandleTypeDef *)USBD_malloc(sizeof(USBD_HID_HandleTypeDef));
+
+  if (hhid == NULL)
+  {
+    pdev->pClassDataCmsit[pdev->classId] = NULL;
+    return (uint8_t)USBD_EMEM;
+  }
+
+  hhid->Protocol = 1U;
+  hhid->IdleState = 0U;
+  hhid->AltSetting = 0U;
+  hhid->state = USBD_HID_IDLE;
+  hhid->head = 0U;
+  hhid->tail = 0U;
+
+  pdev->pClassDataCmsit[pdev->classId] = (void *)hhid;
+  pdev->pClassData = pdev->pClassDataCmsit[pdev->classId];
+
+#ifdef USE_USBD_COMPOSITE
+  /* Get the Endpoints addresses allocated for this class instance */
+  HIDInEpAdd = USBD_CoreGetEPAdd(pdev, USBD_EP_IN, USBD_EP_TYPE_INTR, (uint8_t)pdev->classId);
+#endif /* USE_USBD_COMPOSITE */
+
+  pdev->ep_in[HIDInEpAdd & 0xFU].bInterval = HID_FS_BINTERVAL;
+
+  (void)USBD_LL_OpenEP(pdev, HIDInEpAdd, USBD_EP_TYPE_INTR, HID_EPIN_SIZE);
+  pdev->ep_in[HIDInEpAdd & 0xFU].is_used = 1U;
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_DeInit
+  *         DeInitialize the HID layer
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+static uint8_t USBD_HID_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  UNUSED(cfgidx);
+
+#ifdef USE_USBD_COMPOSITE
+  HIDInEpAdd = USBD_CoreGetEPAdd(pdev, USBD_EP_IN, USBD_EP_TYPE_INTR, (uint8_t)pdev->classId);
+#endif /* USE_USBD_COMPOSITE */
+
+  (void)USBD_LL_CloseEP(pdev, HIDInEpAdd);
+  pdev->ep_in[HIDInEpAdd & 0xFU].is_used = 0U;
+  pdev->ep_in[HIDInEpAdd & 0xFU].bInterval = 0U;
+
+  if (pdev->pClassDataCmsit[pdev->classId] != NULL)
+  {
+    (void)USBD_free(pdev->pClassDataCmsit[pdev->classId]);
+    pdev->pClassDataCmsit[pdev->classId] = NULL;
+    pdev->pClassData = NULL;
+  }
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_Setup
+  *         Handle the HID specific requests
+  * @param  pdev: instance
+  * @param  req: usb requests
+  * @retval status
+  */
+static uint8_t USBD_HID_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+  USBD_HID_HandleTypeDef *hhid = (USBD_HID_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+  USBD_StatusTypeDef ret = USBD_OK;
+  uint16_t len;
+  uint8_t *pbuf;
+  uint16_t status_info = 0U;
+
+  if (hhid == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  switch (req->bmRequest & USB_REQ_TYPE_MASK)
+  {
+    case USB_REQ_TYPE_CLASS :
+      switch (req->bRequest)
+      {
+        case HID_REQ_SET_PROTOCOL:
+          hhid->Protocol = (uint8_t)(req->wValue);
+          break;
+
+        case HID_REQ_GET_PROTOCOL:
+          (void)USBD_CtlSendData(pdev, (uint8_t *)&hhid->Protocol, 1U);
+          break;
+
+        case HID_REQ_SET_IDLE:
+          hhid->IdleState = (uint8_t)(req->wValue >> 8);
+          break;
+
+        case HID_REQ_GET_IDLE:
+          (void)USBD_CtlSendData(pdev, (uint8_t *)&hhid->IdleState, 1U);
+          break;
+
+        default:
+          USBD_CtlError(pdev, req);
+          ret = USBD_FAIL;
+          break;
+      }
+      break;
+
+    case USB_REQ_TYPE_STANDARD:
+      switch (req->bRequest)
+      {
+        case USB_REQ_GET_STATUS:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            (void)USBD_CtlSendData(pdev, (uint8_t *)&status_info, 2U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_GET_DESCRIPTOR:
+          if ((req->wValue >> 8) == HID_REPORT_DESC)
+          {
+            len = MIN(HID_CC_REPORT_DESC_SIZE, req->wLength);
+            pbuf = HID_CC_ReportDesc;
+          }
+          else if ((req->wValue >> 8) == HID_DESCRIPTOR_TYPE)
+          {
+            pbuf = USBD_HID_Desc;
+            len = MIN(USB_HID_DESC_SIZ, req->wLength);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+            break;
+          }
+          (void)USBD_CtlSendData(pdev, pbuf, len);
+          break;
+
+        case USB_REQ_GET_INTERFACE :
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            (void)USBD_CtlSendData(pdev, (uint8_t *)&hhid->AltSetting, 1U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_SET_INTERFACE:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            hhid->AltSetting = (uint8_t)(req->wValue);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_CLEAR_FEATURE:
+          break;
+
+        default:
+          USBD_CtlError(pdev, req);
+          ret = USBD_FAIL;
+          break;
+      }
+      break;
+
+    default:
+      USBD_CtlError(pdev, req);
+      ret = USBD_FAIL;
+      break;
+  }
+
+  return (uint8_t)ret;
+}
+
+/**
+  * @brief  USBD_HID_Send
+  *         Move the oldest queued report to the endpoint if it is idle
+  * @param  pdev: device instance
+  * @param  hhid: HID handle
+  * @retval None
+  */
+static void USBD_HID_Send(USBD_HandleTypeDef *pdev, USBD_HID_HandleTypeDef *hhid)
+{
+  USBD_HID_ReportTypeDef *rep;
+
+  if ((hhid->state != USBD_HID_IDLE) || (hhid->head == hhid->tail))
+  {
+    return;
+  }
+
+  rep = &hhid->queue[hhid->tail & (HID_REPORT_QUEUE_SIZE - 1U)];
+  hhid->tx_report = rep->report;
+  hhid->tx_stamp = rep->stamp;
+  hhid->tail++;
+
+  hhid->state = USBD_HID_BUSY;
+  (void)USBD_LL_Transmit(pdev, HIDInEpAdd, &hhid->tx_report, HID_EPIN_SIZE);
+}
+
+/**
+  * @brief  USBD_HID_DataIn
+  *         Report fetched by the host: account its latency, send the next one
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+static uint8_t USBD_HID_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  USBD_HID_HandleTypeDef *hhid;
+  uint32_t lat;
+
+  UNUSED(epnum);
+
+  hhid = (USBD_HID_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+
+  if (hhid == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  lat = (uint32_t)USBD_HID_TIMESTAMP() - hhid->tx_stamp;
+  HIDLatency.reports++;
+  HIDLatency.last = lat;
+  HIDLatency.sum += lat;
+  if (lat > HIDLatency.max)
+  {
+    HIDLatency.max = lat;
+  }
+
+  hhid->state = USBD_HID_IDLE;
+  USBD_HID_Send(pdev, hhid);
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_HID_Exported_Functions
+  * @{
+  */
+
+/**
+  * @brief  USBD_HID_SendKey
+  *         Queue a key click: one report with the keys pressed followed by an
+  *         empty report (release). Sent immediately if the endpoint is idle.
+  *         Call with OTG_FS masked or at its priority, see the file header.
+  * @param  pdev: device instance
+  * @param  keys: HID_CC_xxx bits
+  * @retval USBD_OK if queued, USBD_BUSY if the queue was full (click lost)
+  */
+uint8_t USBD_HID_SendKey(USBD_HandleTypeDef *pdev, uint8_t keys)
+{
+  USBD_HID_HandleTypeDef *hhid = NULL;
+  uint32_t stamp;
+
+  /* Look the class up by pointer, pdev->classId is only valid inside the
+     core dispatch */
+  for (uint32_t i = 0U; i < pdev->NumClasses; i++)
+  {
+    if (pdev->pClass[i] == &USBD_HID)
+    {
+      hhid = (USBD_HID_HandleTypeDef *)pdev->pClassDataCmsit[i];
+      break;
+    }
+  }
+
+  if ((hhid == NULL) || (pdev->dev_state != USBD_STATE_CONFIGURED))
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  if ((HID_REPORT_QUEUE_SIZE - (hhid->head - hhid->tail)) < 2U)
+  {
+    HIDLatency.overflows++;
+    return (uint8_t)USBD_BUSY;
+  }
+
+  stamp = (uint32_t)USBD_HID_TIMESTAMP();
+  hhid->queue[hhid->head & (HID_REPORT_QUEUE_SIZE - 1U)].report = keys;
+  hhid->queue[hhid->head & (HID_REPORT_QUEUE_SIZE - 1U)].stamp = stamp;
+  hhid->head++;
+  hhid->queue[hhid->head & (HID_REPORT_QUEUE_SIZE - 1U)].report = 0U;
+  hhid->queue[hhid->head & (HID_REPORT_QUEUE_SIZE - 1U)].stamp = stamp;
+  hhid->head++;
+
+  USBD_HID_Send(pdev, hhid);
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_GetLatency
+  *         Copy the latency statistics
+  * @param  stats: destination
+  * @param  reset: clear the statistics after the copy
+  * @retval None
+  */
+void USBD_HID_GetLatency(USBD_HID_LatencyTypeDef *stats, uint8_t reset)
+{
+  *stats = HIDLatency;
+
+  if (reset != 0U)
+  {
+    HIDLatency.reports = 0U;
+    HIDLatency.overflows = 0U;
+    HIDLatency.last = 0U;
+    HIDLatency.max = 0U;
+    HIDLatency.sum = 0U;
+  }
+}
+
+/**
+  * @brief  USBD_HID_GetHIDDesc
+  *         return the HID descriptor, used by the composite builder
+  * @param  length : pointer data length
+  * @retval pointer to descriptor buffer
+  */
+uint8_t *USBD_HID_GetHIDDesc(uint16_t *length)
+{
+  *length = (uint16_t)sizeof(USBD_HID_Desc);
+  return USBD_HID_Desc;
+}
+/**
+  * @}
+  */
+
+
+/**
+  * @}
+  */
+
+
+/**
+  * @}
+  */
@@ -0,0 +1,116 @@
+/**
+  ******************************************************************************
+  * @file    usbd_vendor.h
+  * @brief   header file for the usbd_vendor.c file.
+  ******************************************************************************
+  * @attention
+  *
+  * Vendor specific (class 0xFF) interface with one bulk IN and one bulk OUT
+  * endpoint. It carries no audio data: the IN pipe streams telemetry records
+  * produced by the application, the OUT pipe receives parameter writes.
+  *
+  * The class only exists inside a composite device (USE_USBD_COMPOSITE), its
+  * interface descriptor is generated by usbd_composite_builder.c.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_VENDOR_H
+#define __USBD_VENDOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include  "usbd_ioreq.h"
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_VENDOR
+  * @brief This file is the Header file for usbd_vendor.c
+  * @{
+  */
+
+
+/** @defgroup USBD_VENDOR_Exported_Defines
+  * @{
+  */
+#ifndef VENDOR_IN_EP
+#define VENDOR_IN_EP                                  0x82U
+#endif /* VENDOR_IN_EP */
+
+#ifndef VENDOR_OUT_EP
+#define VENDOR_OUT_EP                                 0x02U
+#endif /* VENDOR_OUT_EP */
+
+#define VENDOR_DATA_FS_MAX_PACKET_SIZE                64U
+
+#define USB_VENDOR_CLASS                              0xFFU
+#define USB_VENDOR_SUBCLASS                           0x00U
+#define USB_VENDOR_PROTOCOL                           0x00U
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_VENDOR_Exported_TypesDefinitions
+  * @{
+  */
+typedef struct
+{
+  uint8_t rx_buffer[VENDOR_DATA_FS_MAX_PACKET_SIZE];
+  uint8_t tx_buffer[VENDOR_DATA_FS_MAX_PACKET_SIZE];
+  __IO uint8_t tx_busy;
+} USBD_VENDOR_HandleTypeDef;
+
+typedef struct
+{
+  int8_t (*Init)(void);
+  int8_t (*DeInit)(void);
+  /* Bulk OUT packet received, pbuf is reused after the call returns */
+  int8_t (*Receive)(uint8_t *pbuf, uint32_t len);
+  /* Fill pbuf (up to len bytes) with the next IN packet, return its size */
+  uint16_t (*TxReady)(uint8_t *pbuf, uint16_t len);
+} USBD_VENDOR_ItfTypeDef;
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_VENDOR_Exported_Variables
+  * @{
+  */
+
+extern USBD_ClassTypeDef USBD_VENDOR;
+#define USBD_VENDOR_CLASS &USBD_VENDOR
+/**
+  * @}
+  */
+
+/** @defgroup USB_CORE_Exported_Functions
+  * @{
+  */
+uint8_t USBD_VENDOR_RegisterInterface(USBD_HandleTypeDef *pdev,
+                                      USBD_VENDOR_ItfTypeDef *fops);
+uint8_t USBD_VENDOR_Kick(USBD_HandleTypeDef *pdev);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __USBD_VENDOR_H */
@@ -0,0 +1,373 @@
+/**
+  ******************************************************************************
+  * @file    usbd_vendor.c
+  * @brief   This file provides the high layer firmware functions to manage a
+  *          vendor specific bulk interface inside a composite device.
+  *
+  *          ===================================================================
+  *                                VENDOR Class Description
+  *          ===================================================================
+  *           - One bulk IN endpoint, pulled from the application: each time
+  *             the endpoint is free the TxReady callback fills the next packet.
+  *           - One bulk OUT endpoint, every packet is handed to the Receive
+  *             callback and the endpoint is re-armed immediately.
+  *           - No class specific requests, the interface has no alternate
+  *             settings.
+  *
+  *           USBD_VENDOR_Kick() is called outside of the core dispatch, where
+  *           pdev->classId belongs to whatever class was served last, so it
+  *           finds its own class slot by the class pointer.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_vendor.h"
+#include "usbd_ctlreq.h"
+
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+
+/** @defgroup USBD_VENDOR
+  * @brief usbd vendor module
+  * @{
+  */
+
+/** @defgroup USBD_VENDOR_Private_FunctionPrototypes
+  * @{
+  */
+static uint8_t USBD_VENDOR_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_VENDOR_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_VENDOR_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+static uint8_t USBD_VENDOR_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t USBD_VENDOR_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
+/**
+  * @}
+  */
+
+/** @defgroup USBD_VENDOR_Private_Variables
+  * @{
+  */
+
+USBD_ClassTypeDef USBD_VENDOR =
+{
+  USBD_VENDOR_Init,
+  USBD_VENDOR_DeInit,
+  USBD_VENDOR_Setup,
+  NULL,                 /* EP0_TxSent */
+  NULL,                 /* EP0_RxReady */
+  USBD_VENDOR_DataIn,
+  USBD_VENDOR_DataOut,
+  NULL,                 /* SOF */
+  NULL,
+  NULL,
+  NULL,                 /* Descriptors come from the composite builder */
+  NULL,
+  NULL,
+  NULL,
+};
+
+static uint8_t VENDORInEpAdd  = VENDOR_IN_EP;
+static uint8_t VENDOROutEpAdd = VENDOR_OUT_EP;
+/**
+  * @}
+  */
+
+/** @defgroup USBD_VENDOR_Private_Functions
+  * @{
+  */
+
+/**
+  * @brief  USBD_VENDOR_Init
+  *         Initialize the VENDOR interface
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+static uint8_t USBD_VENDOR_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  UNUSED(cfgidx);
+  USBD_VENDOR_HandleTypeDef *hvendor;
+
+  hvendor = (USBD_VENDOR_HandleTypeDef *)USBD_malloc(sizeof(USBD_VENDOR_HandleTypeDef));
+
+  if (hvendor == NULL)
+  {
+    pdev->pClassDataCmsit[pdev->classId] = NULL;
+    return (uint8_t)USBD_EMEM;
+  }
+
+  hvendor->tx_busy = 0U;
+  pdev->pClassDataCmsit[pdev->classId] = (void *)hvendor;
+  pdev->pClassData = pdev->pClassDataCmsit[pdev->classId];
+
+#ifdef USE_USBD_COMPOSITE
+  /* Get the Endpoints addresses allocated for this class instance */
+  VENDORInEpAdd  = USBD_CoreGetEPAdd(pdev, USBD_EP_IN, USBD_EP_TYPE_BULK, (uint8_t)pdev->classId);
+  VENDOROutEpAdd = USBD_CoreGetEPAdd(pdev, USBD_EP_OUT, USBD_EP_TYPE_BULK, (uint8_t)pdev->classId);
+#endif /* USE_USBD_COMPOSITE */
+
+  (void)USBD_LL_OpenEP(pdev, VENDORInEpAdd, USBD_EP_TYPE_BULK, VENDOR_DATA_FS_MAX_PACKET_SIZE);
+  pdev->ep_in[VENDORInEpAdd & 0xFU].is_used = 1U;
+
+  (void)USBD_LL_OpenEP(pdev, VENDOROutEpAdd, USBD_EP_TYPE_BULK, VENDOR_DATA_FS_MAX_PACKET_SIZE);
+  pdev->ep_out[VENDOROutEpAdd & 0xFU].is_used = 1U;
+
+  if (((USBD_VENDOR_ItfTypeDef *)pdev->pUserData[pdev->classId])->Init() != 0)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  (void)USBD_LL_PrepareReceive(pdev, VENDOROutEpAdd, hvendor->rx_buffer,
+                               VENDOR_DATA_FS_MAX_PACKET_SIZE);
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_VENDOR_DeInit
+  *         DeInitialize the VENDOR layer
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+static uint8_t USBD_VENDOR_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  UNUSED(cfgidx);
+
+#ifdef USE_USBD_COMPOSITE
+  VENDORInEpAdd  = USBD_CoreGetEPAdd(pdev, USBD_EP_IN, USBD_EP_TYPE_BULK, (uint8_t)pdev->classId);
+  VENDOROutEpAdd = USBD_CoreGetEPAdd(pdev, USBD_EP_OUT, USBD_EP_TYPE_BULK, (uint8_t)pdev->classId);
+#endif /* USE_USBD_COMPOSITE */
+
+  (void)USBD_LL_CloseEP(pdev, VENDORInEpAdd);
+  pdev->ep_in[VENDORInEpAdd & 0xFU].is_used = 0U;
+
+  (void)USBD_LL_CloseEP(pdev, VENDOROutEpAdd);
+  pdev->ep_out[VENDOROutEpAdd & 0xFU].is_used = 0U;
+
+  if (pdev->pClassDataCmsit[pdev->classId] != NULL)
+  {
+    ((USBD_VENDOR_ItfTypeDef *)pdev->pUserData[pdev->classId])->DeInit();
+    (void)USBD_free(pdev->pClassDataCmsit[pdev->classId]);
+    pdev->pClassDataCmsit[pdev->classId] = NULL;
+    pdev->pClassData = NULL;
+  }
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_VENDOR_Setup
+  *         Handle the standard interface requests, there are no class requests
+  * @param  pdev: instance
+  * @param  req: usb requests
+  * @retval status
+  */
+static uint8_t USBD_VENDOR_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+  uint8_t ifalt = 0U;
+  uint16_t status_info = 0U;
+  USBD_StatusTypeDef ret = USBD_OK;
+
+  switch (req->bmRequest & USB_REQ_TYPE_MASK)
+  {
+    case USB_REQ_TYPE_STANDARD:
+      switch (req->bRequest)
+      {
+        case USB_REQ_GET_STATUS:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            (void)USBD_CtlSendData(pdev, (uint8_t *)&status_info, 2U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_GET_INTERFACE:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            (void)USBD_CtlSendData(pdev, &ifalt, 1U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_SET_INTERFACE:
+          if (pdev->dev_state != USBD_STATE_CONFIGURED)
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_CLEAR_FEATURE:
+          break;
+
+        default:
+          USBD_CtlError(pdev, req);
+          ret = USBD_FAIL;
+          break;
+      }
+      break;
+
+    default:
+      USBD_CtlError(pdev, req);
+      ret = USBD_FAIL;
+      break;
+  }
+
+  return (uint8_t)ret;
+}
+
+/**
+  * @brief  USBD_VENDOR_DataIn
+  *         IN packet sent, queue the next one if the application has data
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+static uint8_t USBD_VENDOR_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  USBD_VENDOR_HandleTypeDef *hvendor;
+
+  UNUSED(epnum);
+
+  hvendor = (USBD_VENDOR_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+
+  if (hvendor == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  hvendor->tx_busy = 0U;
+
+  return USBD_VENDOR_Kick(pdev);
+}
+
+/**
+  * @brief  USBD_VENDOR_DataOut
+  *         OUT packet received, pass it up and re-arm the endpoint
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+static uint8_t USBD_VENDOR_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  USBD_VENDOR_HandleTypeDef *hvendor;
+
+  hvendor = (USBD_VENDOR_HandleTypeDef *)pdev->pClassDataCmsit[pdev->classId];
+
+  if (hvendor == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  ((USBD_VENDOR_ItfTypeDef *)pdev->pUserData[pdev->classId])->Receive(hvendor->rx_buffer,
+                                                                     USBD_LL_GetRxDataSize(pdev, epnum));
+
+  (void)USBD_LL_PrepareReceive(pdev, epnum, hvendor->rx_buffer,
+                               VENDOR_DATA_FS_MAX_PACKET_SIZE);
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_VENDOR_Exported_Functions
+  * @{
+  */
+
+/**
+  * @brief  USBD_VENDOR_RegisterInterface
+  * @param  pdev: device instance
+  * @param  fops: VENDOR interface callback
+  * @retval status
+  */
+uint8_t USBD_VENDOR_RegisterInterface(USBD_HandleTypeDef *pdev,
+                                      USBD_VENDOR_ItfTypeDef *fops)
+{
+  if (fops == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  pdev->pUserData[pdev->classId] = fops;
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_VENDOR_Kick
+  *         Start an IN transfer if the endpoint is idle and TxReady has data.
+  *         Called from the DataIn callback and by the application after it
+  *         queued data. The application must mask the OTG_FS interrupt around
+  *         the call, tx_busy is shared with the DataIn callback.
+  * @param  pdev: device instance
+  * @retval USBD_OK if a packet was queued or nothing had to be done,
+  *         USBD_BUSY while the previous packet is in flight
+  */
+uint8_t USBD_VENDOR_Kick(USBD_HandleTypeDef *pdev)
+{
+  USBD_VENDOR_HandleTypeDef *hvendor = NULL;
+  USBD_VENDOR_ItfTypeDef *itf = NULL;
+  uint16_t len;
+
+  /* Look the class up by pointer, pdev->classId is only valid inside the
+     core dispatch */
+  for (uint32_t i = 0U; i < pdev->NumClasses; i++)
+  {
+    if (pdev->pClass[i] == &USBD_VENDOR)
+    {
+      hvendor = (USBD_VENDOR_HandleTypeDef *)pdev->pClassDataCmsit[i];
+      itf = (USBD_VENDOR_ItfTypeDef *)pdev->pUserData[i];
+      break;
+    }
+  }
+
+  if ((hvendor == NULL) || (pdev->dev_state != USBD_STATE_CONFIGURED))
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  if (hvendor->tx_busy != 0U)
+  {
+    return (uint8_t)USBD_BUSY;
+  }
+
+  len = itf->TxReady(hvendor->tx_buffer, VENDOR_DATA_FS_MAX_PACKET_SIZE);
+
+  if (len != 0U)
+  {
+    hvendor->tx_busy = 1U;
+    pdev->ep_in[VENDORInEpAdd & 0xFU].total_length = len;
+    (void)USBD_LL_Transmit(pdev, VENDORInEpAdd, hvendor->tx_buffer, len);
+  }
+
+  return (uint8_t)USBD_OK;
+}
+/**
+  * @}
+  */
+
+
+/**
+  * @}
+  */
+
+
+/**
+  * @}
+  */
@@ -330,6 +330,7 @@ typedef enum
   CLASS_TYPE_VIDEO   = 10,
   CLASS_TYPE_PRINTER = 11,
   CLASS_TYPE_CCID    = 12,
+  CLASS_TYPE_VENDOR  = 13,
 } USBD_CompositeClassTypeDef;
 
 
@@ -0,0 +1,160 @@
+/*
+ * N independent Rotary_Process() calls vs one Rotary_ProcessBatch().
+ *
+ * The encoders sit on two simulated GPIO ports. Rotary_Process reads each
+ * phase through a Rotary_ReadPinFunc that tests one bit of the port, the
+ * way the HAL_GPIO_ReadPin based callbacks in main.c do. The batch decoder
+ * gets the two port snapshots. Every encoder random-walks through legal
+ * Gray transitions, and both decoders must report the same events before
+ * anything is timed.
+ */
+#include "test.h"
+#include "rotary.h"
+
+#define FRAMES   4096U
+#define ROUNDS   200U
+
+typedef struct {
+  const volatile uint32_t *port;
+  uint32_t mask;
+} Pin;
+
+static volatile uint32_t gpio[2];        /* the "IDR" registers */
+static uint32_t frames[FRAMES][2];
+
+static Pin pins[ROTARY_BATCH_MAX][2];
+static Rotary_HandleTypeDef single[ROTARY_BATCH_MAX];
+static Rotary_BatchTypeDef batch[ROTARY_BATCH_MAX];
+
+static volatile uint32_t sink;
+static uint32_t rng = 42U;
+
+static uint32_t rnd(void)
+{
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+static bool read_pin(void *user_data)
+{
+  const Pin *p = (const Pin *)user_data;
+  return (*p->port & p->mask) != 0U;
+}
+
+/* encoder i: A on bit 2i, B on bit 2i+1; even encoders on port 0, odd on 1 */
+static void setup(uint32_t n)
+{
+  for (uint32_t i = 0U; i < n; i++) {
+    uint8_t port = (uint8_t)(i & 1U);
+    uint8_t bit = (uint8_t)(2U * (i >> 1));
+    uint8_t mode = (uint8_t)(i % ROTARY_MODE_NUM);
+
+    pins[i][0].port = &gpio[port];
+    pins[i][0].mask = 1UL << bit;
+    pins[i][1].port = &gpio[port];
+    pins[i][1].mask = 1UL << (bit + 1U);
+    Rotary_Init(&single[i], read_pin, &pins[i][0], read_pin, &pins[i][1]);
+    Rotary_SetStepMode(&single[i], mode);
+
+    batch[i].port_a = port;
+    batch[i].bit_a = bit;
+    batch[i].port_b = port;
+    batch[i].bit_b = (uint8_t)(bit + 1U);
+    batch[i].mode = mode;
+    batch[i].state = 0U;
+  }
+}
+
+/* every encoder moves one Gray step with probability 1/4 per frame */
+static void make_frames(void)
+{
+  static const uint8_t cw_seq[4] = {3U, 1U, 0U, 2U};
+  uint8_t phase[ROTARY_BATCH_MAX] = {0};
+
+  for (uint32_t f = 0U; f < FRAMES; f++) {
+    uint32_t p[2] = {0U, 0U};
+
+    for (uint32_t i = 0U; i < ROTARY_BATCH_MAX; i++) {
+      uint32_t r = rnd();
+      if ((r & 3U) == 0U) {
+        phase[i] = (uint8_t)((phase[i] + (((r >> 2) & 1U) ? 1U : 3U)) & 3U);
+      }
+      p[i & 1U] |= (uint32_t)cw_seq[phase[i]] << (2U * (i >> 1));
+    }
+    frames[f][0] = p[0];
+    frames[f][1] = p[1];
+  }
+}
+
+static uint32_t run_single(uint32_t n, uint32_t f)
+{
+  uint32_t events = 0U;
+
+  gpio[0] = frames[f][0];
+  gpio[1] = frames[f][1];
+  for (uint32_t i = 0U; i < n; i++) {
+    uint8_t dir = Rotary_Process(&single[i]);
+    if (dir == ROTARY_DIR_CW) {
+      events |= ROTARY_BATCH_CW(i);
+    } else if (dir == ROTARY_DIR_CCW) {
+      events |= ROTARY_BATCH_CCW(i);
+    }
+  }
+  return events;
+}
+
+static uint32_t run_batch(uint32_t n, uint32_t f)
+{
+  uint32_t ports[2];
+
+  gpio[0] = frames[f][0];
+  gpio[1] = frames[f][1];
+  ports[0] = gpio[0];
+  ports[1] = gpio[1];
+  return Rotary_ProcessBatch(batch, (uint8_t)n, ports);
+}
+
+int main(void)
+{
+  static const uint32_t counts[] = {1U, 2U, 4U, 8U, 16U};
+
+  make_frames();
+  printf("rotary decode per 1 ms frame (%u frames x %u rounds):\n", FRAMES, ROUNDS);
+  printf("  encoders  Rotary_Process x N   batch        ratio\n");
+  for (uint32_t c = 0U; c < sizeof(counts) / sizeof(counts[0]); c++) {
+    uint32_t n = counts[c];
+    uint32_t nevents = 0U;
+    double t0, t1, t2;
+
+    /* same events from both, frame by frame */
+    setup(n);
+    for (uint32_t f = 0U; f < FRAMES; f++) {
+      uint32_t a = run_single(n, f);
+      uint32_t b = run_batch(n, f);
+      CHECK_MSG(a == b, "%u encoders, frame %u: 0x%08x vs 0x%08x", n, f, a, b);
+      nevents += (a != 0U);
+    }
+    CHECK(nevents > 0U);
+
+    setup(n);
+    t0 = test_now_ns();
+    for (uint32_t r = 0U; r < ROUNDS; r++) {
+      for (uint32_t f = 0U; f < FRAMES; f++) {
+        sink ^= run_single(n, f);
+      }
+    }
+    t1 = test_now_ns();
+    for (uint32_t r = 0U; r < ROUNDS; r++) {
+      for (uint32_t f = 0U; f < FRAMES; f++) {
+        sink ^= run_batch(n, f);
+      }
+    }
+    t2 = test_now_ns();
+
+    printf("  %8u  %8.1f ns/frame  %8.1f ns/frame  %5.2fx\n", n,
+           (t1 - t0) / (FRAMES * ROUNDS), (t2 - t1) / (FRAMES * ROUNDS), (t1 - t0) / (t2 - t1));
+  }
+  return test_summary("bench_rotary_batch");
+}
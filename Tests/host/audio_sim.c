@@ -0,0 +1,383 @@
+/*
+ * Packet-level simulation of the USB speaker path, see audio_sim.h.
+ */
+#include <string.h>
+
+#include "audio_sim.h"
+#include "usbd_ll_host.h"
+#include "usbd_audio_if.h"
+#include "settings.h"
+#ifdef USE_USBD_COMPOSITE
+#include "usb_device.h"
+#endif
+
+#define FRAME_NS      1000000ULL
+#define AS_INTERFACE  1U
+
+#ifdef USE_USBD_COMPOSITE
+extern USBD_HandleTypeDef hUsbDeviceFS;       /* usb_device.c */
+#else
+USBD_HandleTypeDef hUsbDeviceFS;
+#endif
+
+static AudioSim_ConfigTypeDef sim_cfg;
+static AudioSim_StatsTypeDef sim_stats;
+static double sim_frame_ns;           /* I2S stereo frame period */
+static double sim_next_frame;         /* time of the next stereo frame */
+static uint64_t sim_next_ms;          /* next occupancy sample */
+static uint32_t sim_seq;              /* last stereo frame number sent */
+static uint32_t sim_played;           /* last stereo frame number played, 0 = none */
+static uint8_t sim_packet[1024];
+
+/* main.c ------------------------------------------------------------------ */
+
+void HAL_I2S_TxHalfCpltCallback(I2S_HandleTypeDef *hi2s)
+{
+  if (hi2s == &hi2s2)
+  {
+    HalfTransfer_CallBack_FS();
+  }
+}
+
+void HAL_I2S_TxCpltCallback(I2S_HandleTypeDef *hi2s)
+{
+  if (hi2s == &hi2s2)
+  {
+    TransferComplete_CallBack_FS();
+  }
+}
+
+void AudioDMA_Stop(void)
+{
+  HAL_I2S_DMAStop(&hi2s2);
+}
+
+void AudioDMA_Pause(void)
+{
+  HAL_I2S_DMAPause(&hi2s2);
+}
+
+void AudioDMA_Resume(void)
+{
+  HAL_I2S_DMAResume(&hi2s2);
+}
+
+void AudioCard_Play(uint16_t *buff, uint16_t size)
+{
+  HAL_I2S_Transmit_DMA(&hi2s2, buff, size);
+}
+
+void AudioCard_Resync(uint16_t *buff, uint16_t size)
+{
+  if (size != AUDIO_TOTAL_BUF_SIZE / 2U)
+  {
+    sim_stats.resyncs++;
+  }
+  if (hi2s2.TxXferSize == size)
+  {
+    return;
+  }
+  HAL_I2S_DMAStop(&hi2s2);
+  HAL_I2S_Transmit_DMA(&hi2s2, buff, size);
+}
+
+/* simulation -------------------------------------------------------------- */
+
+static uint32_t sim_rng = 1U;
+
+static uint32_t sim_rand(void)
+{
+  sim_rng ^= sim_rng << 13;
+  sim_rng ^= sim_rng >> 17;
+  sim_rng ^= sim_rng << 5;
+  return sim_rng;
+}
+
+USBD_AUDIO_HandleTypeDef *AudioSim_Class(void)
+{
+  return (USBD_AUDIO_HandleTypeDef *)hUsbDeviceFS.pClassDataCmsit[0];
+}
+
+const AudioSim_StatsTypeDef *AudioSim_Stats(void)
+{
+  return &sim_stats;
+}
+
+double AudioSim_Occupancy(void)
+{
+  USBD_AUDIO_HandleTypeDef *haudio = AudioSim_Class();
+  uint32_t rd;
+
+  if ((haudio == NULL) || (I2S_Host_Running() == 0))
+  {
+    return -1.0;
+  }
+  rd = (uint32_t)((uint8_t *)hi2s2.pTxBuffPtr - haudio->buffer) + I2S_Host_Pos() * 2U;
+  return (double)((haudio->wr_ptr + AUDIO_TOTAL_BUF_SIZE - rd % AUDIO_TOTAL_BUF_SIZE) %
+                  AUDIO_TOTAL_BUF_SIZE) / AUDIO_OUT_PACKET;
+}
+
+void AudioSim_Reset(const AudioSim_ConfigTypeDef *cfg)
+{
+  sim_cfg = *cfg;
+  memset(&sim_stats, 0, sizeof(sim_stats));
+  sim_stats.occ_min_ms = 1e9;
+  sim_stats.occ_max_ms = -1e9;
+  sim_frame_ns = 1e9 / ((double)USBD_AUDIO_FREQ * (1.0 + cfg->ppm * 1e-6));
+  sim_next_frame = sim_frame_ns;
+  sim_next_ms = FRAME_NS;
+  sim_seq = 0U;
+  sim_played = 0U;
+
+  USBD_Host_Reset();
+  I2S_Host_Reset();
+  memset(&hUsbDeviceFS, 0, sizeof(hUsbDeviceFS));
+
+  if (sim_cfg.csv != NULL)
+  {
+    fprintf(sim_cfg.csv, "t_ms,occupancy_ms,wr_ptr,dma_pos,overruns,underruns,resyncs\n");
+  }
+}
+
+void AudioSim_Begin(const AudioSim_ConfigTypeDef *cfg)
+{
+  AudioSim_Reset(cfg);
+  Settings_Init();
+#ifdef USE_USBD_COMPOSITE
+  MX_USB_DEVICE_Init();
+#else
+  USBD_Init(&hUsbDeviceFS, (USBD_DescriptorsTypeDef *)&USBD_Host_Desc, DEVICE_FS);
+  USBD_RegisterClass(&hUsbDeviceFS, &USBD_AUDIO);
+  USBD_AUDIO_RegisterInterface(&hUsbDeviceFS, &USBD_AUDIO_fops_FS);
+  USBD_Start(&hUsbDeviceFS);
+#endif
+  USBD_Host_Enumerate(&hUsbDeviceFS);
+  USBD_Host_Control(&hUsbDeviceFS, 0x01U, USB_REQ_SET_INTERFACE, 1U, AS_INTERFACE, 0U, NULL);
+}
+
+static void sim_play_frame(void)
+{
+  uint16_t l, r;
+  uint32_t seq;
+
+  if ((I2S_Host_Next(&l) == 0) || (I2S_Host_Next(&r) == 0))
+  {
+    return;
+  }
+  seq = (uint32_t)l | ((uint32_t)r << 16);
+  sim_stats.frames_played++;
+
+  if ((sim_played != 0U) && (seq != sim_played + 1U))
+  {
+    if (seq > sim_played + 1U)
+    {
+      sim_stats.overruns++;
+    }
+    else
+    {
+      sim_stats.underruns++;
+    }
+    if (sim_stats.first_glitch_ns == 0U)
+    {
+      sim_stats.first_glitch_ns = (uint64_t)sim_next_frame;
+    }
+  }
+  sim_played = seq;
+}
+
+static void sim_sample(uint64_t t_ns)
+{
+  double occ = AudioSim_Occupancy();
+
+  if (occ >= 0.0)
+  {
+    if (occ < sim_stats.occ_min_ms)
+    {
+      sim_stats.occ_min_ms = occ;
+    }
+    if (occ > sim_stats.occ_max_ms)
+    {
+      sim_stats.occ_max_ms = occ;
+    }
+    sim_stats.occ_sum_ms += occ;
+    sim_stats.occ_samples++;
+  }
+  if (sim_cfg.csv != NULL)
+  {
+    USBD_AUDIO_HandleTypeDef *haudio = AudioSim_Class();
+
+    fprintf(sim_cfg.csv, "%llu,%.3f,%u,%u,%u,%u,%u\n", (unsigned long long)(t_ns / FRAME_NS), occ,
+            (haudio != NULL) ? haudio->wr_ptr : 0U, I2S_Host_Pos() * 2U, sim_stats.overruns,
+            sim_stats.underruns, sim_stats.resyncs);
+  }
+}
+
+void AudioSim_AdvanceTo(uint64_t t_ns)
+{
+  while (1)
+  {
+    uint64_t frame = (uint64_t)sim_next_frame;
+
+    if ((frame > t_ns) && (sim_next_ms > t_ns))
+    {
+      break;
+    }
+    if (frame <= sim_next_ms)
+    {
+      sim_play_frame();
+      sim_next_frame += sim_frame_ns;
+    }
+    else
+    {
+      sim_sample(sim_next_ms);
+      sim_next_ms += FRAME_NS;
+    }
+  }
+  sim_stats.t_ns = t_ns;
+}
+
+uint64_t AudioSim_NextDmaEvent(void)
+{
+  uint32_t pos = I2S_Host_Pos();
+  uint32_t edge = (pos < hi2s2.TxXferSize / 2U) ? hi2s2.TxXferSize / 2U : hi2s2.TxXferSize;
+  uint32_t frames = (edge - pos + 1U) / 2U;
+
+  if (I2S_Host_Running() == 0)
+  {
+    return UINT64_MAX;
+  }
+  return (uint64_t)(sim_next_frame + (double)(frames - 1U) * sim_frame_ns);
+}
+
+void AudioSim_RunToDmaEvent(void)
+{
+  uint64_t t = AudioSim_NextDmaEvent();
+
+  if (t == UINT64_MAX)
+  {
+    return;
+  }
+  AudioSim_AdvanceTo(t);
+  /* the estimate and the summed frame times may round apart by a ns */
+  while ((I2S_Host_Running() != 0) && (I2S_Host_Pos() != 0U) &&
+         (I2S_Host_Pos() != hi2s2.TxXferSize / 2U))
+  {
+    AudioSim_AdvanceTo((uint64_t)sim_next_frame);
+  }
+}
+
+int AudioSim_Packet(uint64_t t_ns, uint32_t len)
+{
+  USBD_AUDIO_HandleTypeDef *haudio = AudioSim_Class();
+  USBD_HostEpTypeDef *ep = USBD_Host_Ep(AUDIO_OUT_EP);
+  uint32_t room;
+  uint32_t frames;
+
+  AudioSim_AdvanceTo(t_ns);
+  if ((haudio == NULL) || (ep->armed == 0U))
+  {
+    sim_stats.naks++;
+    return -1;
+  }
+
+  /* the class arms AUDIO_OUT_PACKET bytes at wr_ptr whatever room is left in
+     the ring; on the board a longer packet would run past the buffer */
+  room = AUDIO_TOTAL_BUF_SIZE - haudio->wr_ptr;
+  if (room > ep->len)
+  {
+    room = ep->len;
+  }
+  if (len > sizeof(sim_packet))
+  {
+    len = sizeof(sim_packet);
+  }
+  if (len > room)
+  {
+    len = room;
+    sim_stats.clipped++;
+  }
+
+  frames = len / 4U;
+  memset(sim_packet, 0, len);
+  for (uint32_t i = 0U; i < frames; i++)
+  {
+    uint32_t seq = ++sim_seq;
+
+    sim_packet[4U * i + 0U] = (uint8_t)seq;
+    sim_packet[4U * i + 1U] = (uint8_t)(seq >> 8);
+    sim_packet[4U * i + 2U] = (uint8_t)(seq >> 16);
+    sim_packet[4U * i + 3U] = (uint8_t)(seq >> 24);
+  }
+  USBD_Host_Out(&hUsbDeviceFS, AUDIO_OUT_EP, sim_packet, len);
+  sim_stats.packets++;
+  return (int)len;
+}
+
+int AudioSim_Control(uint64_t t_ns, uint8_t bmRequest, uint8_t bRequest, uint16_t wValue,
+                     uint16_t wIndex, uint16_t wLength, uint8_t *data)
+{
+  AudioSim_AdvanceTo(t_ns);
+  return USBD_Host_Control(&hUsbDeviceFS, bmRequest, bRequest, wValue, wIndex, wLength, data);
+}
+
+void AudioSim_RunHost(const AudioSim_HostTypeDef *host)
+{
+  uint32_t frames = (uint32_t)(host->seconds * 1000.0);
+  uint32_t packet = (host->packet != 0U) ? host->packet : AUDIO_OUT_PACKET;
+  uint32_t jitter = (host->jitter_us > 499U) ? 499U : host->jitter_us;
+  uint32_t held = 0U;
+
+  sim_rng = (host->seed != 0U) ? host->seed : 1U;
+  for (uint32_t k = 1U; k <= frames; k++)
+  {
+    uint64_t t = (uint64_t)k * FRAME_NS;
+
+    if ((host->burst_every_ms != 0U) && (host->burst_len != 0U) &&
+        ((k % host->burst_every_ms) < host->burst_len))
+    {
+      held++;
+      continue;
+    }
+    /* the backlog goes out back to back, 10 us apart, ahead of this frame */
+    for (uint32_t i = 0U; i < held; i++)
+    {
+      (void)AudioSim_Packet(t + (uint64_t)i * 10000U, packet);
+    }
+    t += (uint64_t)held * 10000U;
+    held = 0U;
+
+    if ((host->drop > 0.0) && ((double)(sim_rand() % 1000000U) < host->drop * 1e6))
+    {
+      continue;
+    }
+    if (jitter != 0U)
+    {
+      t = t + 1000ULL * (sim_rand() % (2U * jitter + 1U)) - 1000ULL * jitter;
+    }
+    (void)AudioSim_Packet(t, packet);
+  }
+  AudioSim_AdvanceTo((uint64_t)(frames + 1U) * FRAME_NS);
+}
+
+void AudioSim_Report(FILE *f)
+{
+  const AudioSim_StatsTypeDef *s = &sim_stats;
+  const I2S_HostStatsTypeDef *i2s = I2S_Host_Stats();
+
+  fprintf(f, "  %.3f s, %u packets (%u NAK, %u clipped), %llu frames played\n",
+          (double)s->t_ns / 1e9, s->packets, s->naks, s->clipped,
+          (unsigned long long)s->frames_played);
+  if (s->occ_samples != 0U)
+  {
+    fprintf(f, "  occupancy %.2f / %.2f / %.2f ms (min/avg/max of %u)\n", s->occ_min_ms,
+            s->occ_sum_ms / s->occ_samples, s->occ_max_ms, AUDIO_OUT_PACKET_NUM);
+  }
+  fprintf(f, "  glitches: %u overrun, %u underrun", s->overruns, s->underruns);
+  if (s->first_glitch_ns != 0U)
+  {
+    fprintf(f, ", first at %.3f s", (double)s->first_glitch_ns / 1e9);
+  }
+  fprintf(f, "\n  DMA: %u start, %u refused (HAL_BUSY), %u drift corrections asked, "
+          "%u pause, %u resume\n", i2s->starts, i2s->busy, s->resyncs, i2s->pauses,
+          i2s->resumes);
+}
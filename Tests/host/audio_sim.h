@@ -0,0 +1,94 @@
+/*
+ * Packet-level simulation of the USB speaker path.
+ *
+ * The unmodified USB core, usbd_audio.c and USB_DEVICE/App/usbd_audio_if.c
+ * run against usbd_ll_host (the PCD) and i2s_host (I2S2 + circular DMA).
+ * The main.c glue between the two (AudioCard_Play/Resync, AudioDMA_*, the
+ * HAL_I2S_Tx*Callback dispatch) is repeated here as it is on the board.
+ *
+ * Time is in nanoseconds. The USB frame clock is the reference; the I2S
+ * sample clock runs ppm away from it. Every stereo frame the host sends
+ * carries a running number (left = low half, right = high half), so each
+ * frame the DMA plays can be checked for continuity: a jump ahead means the
+ * writer overtook the read head, a jump back means the read head passed the
+ * writer and replayed stale data.
+ */
+#ifndef AUDIO_SIM_H
+#define AUDIO_SIM_H
+
+#include <stdio.h>
+
+#include "usbd_audio.h"
+#include "i2s_host.h"
+
+typedef struct
+{
+  double ppm;                 /* I2S sample clock error against the USB frame clock */
+  FILE *csv;                  /* per-ms timeline, NULL for none */
+} AudioSim_ConfigTypeDef;
+
+typedef struct
+{
+  uint64_t t_ns;              /* simulated time reached */
+  uint32_t packets;           /* OUT packets the class took */
+  uint32_t naks;              /* OUT packets sent while the endpoint was not armed */
+  uint32_t clipped;           /* packets cut at the ring end or the endpoint size */
+  uint64_t frames_played;     /* stereo frames the DMA sent */
+  uint32_t overruns;          /* played data jumped ahead */
+  uint32_t underruns;         /* played data went back */
+  uint64_t first_glitch_ns;   /* 0 while there was none */
+  double occ_min_ms;          /* buffered audio ahead of the read head, sampled each ms */
+  double occ_max_ms;
+  double occ_sum_ms;
+  uint32_t occ_samples;
+  uint32_t resyncs;           /* AUDIO_CMD_PLAY with a drift-corrected size */
+} AudioSim_StatsTypeDef;
+
+/* A synthetic host: one packet per 1 ms frame, with timing faults */
+typedef struct
+{
+  double seconds;
+  uint32_t packet;            /* bytes per packet, AUDIO_OUT_PACKET when 0 */
+  uint32_t jitter_us;         /* delivery offset, uniform +-jitter, at most 499 */
+  double drop;                /* probability that a frame's packet is lost */
+  uint32_t burst_every_ms;    /* every N ms the host stalls ... */
+  uint32_t burst_len;         /* ... for this many frames, then sends the backlog */
+  uint32_t seed;
+} AudioSim_HostTypeDef;
+
+/* Reset everything, enumerate, select alternate setting 1 at t = 0 */
+void AudioSim_Begin(const AudioSim_ConfigTypeDef *cfg);
+
+/* Only the reset part of AudioSim_Begin(), for a caller that brings the
+   device up and enumerates it itself (the RTOS simulation) */
+void AudioSim_Reset(const AudioSim_ConfigTypeDef *cfg);
+
+/* Run the I2S clock up to t_ns */
+void AudioSim_AdvanceTo(uint64_t t_ns);
+
+/* Time of the next half or full transfer interrupt of the I2S DMA,
+   UINT64_MAX while it is stopped */
+uint64_t AudioSim_NextDmaEvent(void);
+
+/* Run the I2S clock through the frame that raises that interrupt */
+void AudioSim_RunToDmaEvent(void);
+
+/* An isochronous OUT packet of len bytes at t_ns; -1 when it was NAKed */
+int AudioSim_Packet(uint64_t t_ns, uint32_t len);
+
+/* A control transfer at t_ns, see USBD_Host_Control() */
+int AudioSim_Control(uint64_t t_ns, uint8_t bmRequest, uint8_t bRequest, uint16_t wValue,
+                     uint16_t wIndex, uint16_t wLength, uint8_t *data);
+
+/* Drive a synthetic host from frame 1 for host->seconds */
+void AudioSim_RunHost(const AudioSim_HostTypeDef *host);
+
+const AudioSim_StatsTypeDef *AudioSim_Stats(void);
+USBD_AUDIO_HandleTypeDef *AudioSim_Class(void);
+
+/* Buffered audio ahead of the read head in ms, -1 while the DMA is stopped */
+double AudioSim_Occupancy(void);
+
+void AudioSim_Report(FILE *f);
+
+#endif /* AUDIO_SIM_H */
@@ -0,0 +1,98 @@
+/*
+ * Host stand-in for the HAL flash driver, see flash_host.h.
+ */
+#include <string.h>
+
+#include "flash_host.h"
+
+#define FLASH_HOST_BASE     0x08000000U
+#define FLASH_HOST_SECTORS  8U
+#define WORD_NS             16000ULL
+
+/* RM0383 table 4: 4 x 16 KB, 64 KB, 3 x 128 KB */
+static const struct
+{
+  uint32_t offset;
+  uint32_t size;
+  uint64_t erase_ns;
+} flash_sector[FLASH_HOST_SECTORS] =
+{
+  {0x00000U, 0x04000U, 250000000ULL}, {0x04000U, 0x04000U, 250000000ULL},
+  {0x08000U, 0x04000U, 250000000ULL}, {0x0C000U, 0x04000U, 250000000ULL},
+  {0x10000U, 0x10000U, 550000000ULL}, {0x20000U, 0x20000U, 1000000000ULL},
+  {0x40000U, 0x20000U, 1000000000ULL}, {0x60000U, 0x20000U, 1000000000ULL},
+};
+
+static FLASH_HostStatsTypeDef flash_stats;
+static uint8_t flash_locked = 1U;
+static void (*flash_stall)(uint64_t ns);
+
+static void flash_spend(uint64_t ns)
+{
+  if (flash_stall != NULL)
+  {
+    flash_stall(ns);
+  }
+}
+
+void FLASH_Host_Reset(void (*stall)(uint64_t ns))
+{
+  memset(&flash_stats, 0, sizeof(flash_stats));
+  flash_locked = 1U;
+  flash_stall = stall;
+}
+
+const FLASH_HostStatsTypeDef *FLASH_Host_Stats(void)
+{
+  return &flash_stats;
+}
+
+/* HAL_FLASH* -------------------------------------------------------------- */
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+  flash_locked = 0U;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+  flash_locked = 1U;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+  uint32_t *word = (uint32_t *)(uintptr_t)Address;
+
+  if ((flash_locked != 0U) || (TypeProgram != FLASH_TYPEPROGRAM_WORD) ||
+      (Address < FLASH_HOST_BASE) || (Address + 4U > FLASH_HOST_BASE + 0x80000U) ||
+      ((Address & 3U) != 0U))
+  {
+    flash_stats.errors++;
+    return HAL_ERROR;
+  }
+  flash_spend(WORD_NS);
+  *word &= (uint32_t)Data;
+  flash_stats.programs++;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *SectorError)
+{
+  *SectorError = 0xFFFFFFFFU;
+  if ((flash_locked != 0U) || (pEraseInit->TypeErase != FLASH_TYPEERASE_SECTORS) ||
+      (pEraseInit->Sector + pEraseInit->NbSectors > FLASH_HOST_SECTORS))
+  {
+    flash_stats.errors++;
+    return HAL_ERROR;
+  }
+  for (uint32_t s = pEraseInit->Sector; s < pEraseInit->Sector + pEraseInit->NbSectors; s++)
+  {
+    flash_spend(flash_sector[s].erase_ns);
+    memset((void *)(uintptr_t)(FLASH_HOST_BASE + flash_sector[s].offset), 0xFF,
+           flash_sector[s].size);
+    flash_stats.erases++;
+  }
+  return HAL_OK;
+}
@@ -0,0 +1,28 @@
+/*
+ * Host stand-in for the HAL flash driver (stm32f4xx_hal_flash*.c).
+ *
+ * Works on the flash the RTOS simulation maps at 0x08000000, with the
+ * rules of the real array: an erase sets a sector to 0xFF, programming
+ * can only clear bits, nothing is written while the control register is
+ * locked. The CPU stalls for the typical times of the STM32F411 data
+ * sheet (x32 parallelism): 16 us per word, 250 ms per 16 KB sector, 550 ms
+ * per 64 KB and 1 s per 128 KB sector.
+ */
+#ifndef FLASH_HOST_H
+#define FLASH_HOST_H
+
+#include "stm32f4xx_hal.h"
+
+typedef struct
+{
+  uint32_t erases;            /* sectors */
+  uint32_t programs;          /* words */
+  uint32_t errors;            /* calls refused: locked, outside the array */
+} FLASH_HostStatsTypeDef;
+
+/* Unlocked state and statistics back to reset; stall(ns) spends the time */
+void FLASH_Host_Reset(void (*stall)(uint64_t ns));
+
+const FLASH_HostStatsTypeDef *FLASH_Host_Stats(void);
+
+#endif /* FLASH_HOST_H */
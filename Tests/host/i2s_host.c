@@ -0,0 +1,120 @@
+/*
+ * Host stand-in for I2S2 and its TX DMA stream, see i2s_host.h.
+ */
+#include <string.h>
+
+#include "i2s_host.h"
+
+I2S_HandleTypeDef hi2s2;
+
+/* the stream only carries NDTR, which telemetry.c and irq_prof.c read */
+static DMA_Stream_TypeDef i2s_stream;
+static DMA_HandleTypeDef i2s_dma = { .Instance = &i2s_stream };
+
+static I2S_HostStatsTypeDef i2s_stats;
+static uint32_t i2s_pos;
+static uint8_t i2s_paused;
+
+void I2S_Host_Reset(void)
+{
+  memset(&hi2s2, 0, sizeof(hi2s2));
+  hi2s2.State = HAL_I2S_STATE_READY;
+  hi2s2.hdmatx = &i2s_dma;
+  i2s_stream.NDTR = 0U;
+  memset(&i2s_stats, 0, sizeof(i2s_stats));
+  i2s_pos = 0U;
+  i2s_paused = 0U;
+}
+
+int I2S_Host_Next(uint16_t *halfword)
+{
+  if ((hi2s2.State != HAL_I2S_STATE_BUSY_TX) || (i2s_paused != 0U))
+  {
+    return 0;
+  }
+
+  *halfword = hi2s2.pTxBuffPtr[i2s_pos++];
+  i2s_stream.NDTR = hi2s2.TxXferSize - i2s_pos;
+
+  /* DMA_CIRCULAR: HT at half, TC at the end, then the same buffer again */
+  if (i2s_pos == hi2s2.TxXferSize / 2U)
+  {
+    HAL_I2S_TxHalfCpltCallback(&hi2s2);
+  }
+  else if (i2s_pos == hi2s2.TxXferSize)
+  {
+    i2s_pos = 0U;
+    i2s_stream.NDTR = hi2s2.TxXferSize;
+    HAL_I2S_TxCpltCallback(&hi2s2);
+  }
+  return 1;
+}
+
+uint32_t I2S_Host_Pos(void)
+{
+  return i2s_pos;
+}
+
+int I2S_Host_Running(void)
+{
+  return (hi2s2.State == HAL_I2S_STATE_BUSY_TX) && (i2s_paused == 0U);
+}
+
+const I2S_HostStatsTypeDef *I2S_Host_Stats(void)
+{
+  return &i2s_stats;
+}
+
+/* HAL_I2S_* --------------------------------------------------------------- */
+
+HAL_StatusTypeDef HAL_I2S_Transmit_DMA(I2S_HandleTypeDef *hi2s, uint16_t *pData, uint16_t Size)
+{
+  if ((pData == NULL) || (Size == 0U))
+  {
+    return HAL_ERROR;
+  }
+  if (hi2s->State != HAL_I2S_STATE_READY)
+  {
+    i2s_stats.busy++;
+    return HAL_BUSY;
+  }
+
+  /* 16-bit data: Size is in halfwords */
+  hi2s->State = HAL_I2S_STATE_BUSY_TX;
+  hi2s->pTxBuffPtr = pData;
+  hi2s->TxXferSize = Size;
+  hi2s->TxXferCount = Size;
+  i2s_stream.NDTR = Size;
+  i2s_pos = 0U;
+  i2s_paused = 0U;
+  i2s_stats.starts++;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2S_DMAPause(I2S_HandleTypeDef *hi2s)
+{
+  if (hi2s->State == HAL_I2S_STATE_BUSY_TX)
+  {
+    i2s_paused = 1U;
+  }
+  i2s_stats.pauses++;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2S_DMAResume(I2S_HandleTypeDef *hi2s)
+{
+  if (hi2s->State == HAL_I2S_STATE_BUSY_TX)
+  {
+    i2s_paused = 0U;
+  }
+  i2s_stats.resumes++;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2S_DMAStop(I2S_HandleTypeDef *hi2s)
+{
+  hi2s->State = HAL_I2S_STATE_READY;
+  i2s_paused = 0U;
+  i2s_stats.stops++;
+  return HAL_OK;
+}
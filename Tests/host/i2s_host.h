@@ -0,0 +1,39 @@
+/*
+ * Host stand-in for I2S2 and its TX DMA stream (Core/Src/i2s.c).
+ *
+ * The HAL_I2S_* calls the firmware makes keep the HAL's state rules: a
+ * transfer is started only from READY, and the circular DMA never returns
+ * to READY by itself, so a second HAL_I2S_Transmit_DMA() gets HAL_BUSY as it
+ * does on the board. The sample clock is the caller's: every
+ * I2S_Host_Next() moves the DMA on by one halfword and raises the half and
+ * full transfer callbacks at the same points the DMA interrupt would.
+ */
+#ifndef I2S_HOST_H
+#define I2S_HOST_H
+
+#include "stm32f4xx_hal.h"
+
+typedef struct
+{
+  uint32_t starts;            /* HAL_I2S_Transmit_DMA() accepted */
+  uint32_t busy;              /* HAL_I2S_Transmit_DMA() refused with HAL_BUSY */
+  uint32_t pauses;
+  uint32_t resumes;
+  uint32_t stops;
+} I2S_HostStatsTypeDef;
+
+extern I2S_HandleTypeDef hi2s2;
+
+/* Back to reset state: stopped, not paused, statistics cleared */
+void I2S_Host_Reset(void);
+
+/* Send one halfword; 0 while stopped or paused (the line carries nothing) */
+int I2S_Host_Next(uint16_t *halfword);
+
+/* Halfword index in the running transfer, and whether one is running */
+uint32_t I2S_Host_Pos(void);
+int I2S_Host_Running(void);
+
+const I2S_HostStatsTypeDef *I2S_Host_Stats(void);
+
+#endif /* I2S_HOST_H */
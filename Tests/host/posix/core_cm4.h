@@ -0,0 +1,49 @@
+/*
+ * Host stand-in for the Cortex-M4 intrinsics, in front of the real core_cm4.h.
+ *
+ * stm32f411xe.h includes "core_cm4.h" through the include path, so this
+ * file is found first. It takes in the compiler header core_cm4.h would
+ * include, then shadows the CMSIS intrinsics the simulated firmware calls
+ * by macros of the same name that read the CPU state of the POSIX port
+ * (portmacro.h) instead of running ARM instructions. The inline functions
+ * of core_cm4.h and everything after it only see the macros; the ARM
+ * versions stay unused. The core registers themselves (DWT, SysTick, SCB,
+ * ...) stay where CMSIS puts them; the simulator maps RAM at those
+ * addresses.
+ */
+#ifndef HOST_CORE_CM4_H
+#define HOST_CORE_CM4_H
+
+#include <stdint.h>
+#include "cmsis_compiler.h"
+
+#undef __NOP
+#undef __WFI
+#undef __WFE
+#undef __SEV
+
+extern volatile uint32_t ulPortIPSR;
+extern volatile uint32_t ulPortPRIMASK;
+extern uint32_t STACK$$Limit[];   /* the simulator's MSP region, as armlink names it */
+
+/* one thread holds the CPU at a time (port.c): a compiler barrier is enough */
+#define __DMB()         __asm volatile ("" ::: "memory")
+#define __DSB()         __asm volatile ("" ::: "memory")
+#define __ISB()         __asm volatile ("" ::: "memory")
+#define __NOP()         ((void)0)
+#define __WFI()         ((void)0)
+#define __WFE()         ((void)0)
+#define __SEV()         ((void)0)
+#define __CLZ(x)        ((uint8_t)(((x) == 0U) ? 32U : (uint32_t)__builtin_clz(x)))
+#define __get_IPSR()    (ulPortIPSR)
+#define __get_PRIMASK() (ulPortPRIMASK)
+#define __set_PRIMASK(x) ((void)(ulPortPRIMASK = (x)))
+#define __get_MSP()     ((uint32_t)(uintptr_t)STACK$$Limit)
+#define __get_BASEPRI() (0U)
+#define __set_BASEPRI(x) ((void)(x))
+#define __disable_irq() ((void)(ulPortPRIMASK = 1U))
+#define __enable_irq()  ((void)(ulPortPRIMASK = 0U))
+
+#include_next "core_cm4.h"
+
+#endif /* HOST_CORE_CM4_H */
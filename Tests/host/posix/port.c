@@ -0,0 +1,333 @@
+/*
+ * FreeRTOS port for the host simulation.
+ *
+ * Every task is a pthread, but only one thread holds the CPU at a time:
+ * a context switch wakes the thread vTaskSwitchContext() chose and puts
+ * the current one to sleep. Task code therefore runs unmodified and never
+ * concurrently, and a run is repeatable to the last switch.
+ *
+ * There are no timer signals. The idle task is never given a thread: when
+ * it is chosen, the CPU goes back to the thread that called
+ * vTaskStartScheduler(), which asks the simulator (vPortSimInit()) to let
+ * time pass up to the next interrupt and run it. Interrupt handlers run
+ * on that thread between vPortInterruptEnter()/Exit(); a yield they ask
+ * for is taken when they return. Task code itself takes no simulated time
+ * unless the simulator is asked to spend some inside it, in which case
+ * the interrupts that come due run on the task's thread and
+ * vPortPreemptionPoint() takes the switch they asked for.
+ *
+ * The Thread_t of a task lives at the top of the stack the kernel
+ * allocated for it; the pthread has its own stack, so the FreeRTOS stack
+ * figures only show that region.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef configIDLE_TASK_NAME
+#define configIDLE_TASK_NAME "IDLE"   /* as in tasks.c */
+#endif
+
+/* a task that holds the CPU this long in wall time is stuck */
+#define PORT_WATCHDOG_S  5
+
+typedef struct
+{
+  pthread_t thread;
+  pthread_cond_t cond;
+  int go;                       /* set by the thread handing over the CPU */
+  TaskFunction_t code;
+  void *params;
+  uint64_t ready_ns;            /* UINT64_MAX while not waiting for the CPU */
+  PortTaskStats_t stats;
+} Thread_t;
+
+volatile uint32_t ulPortIPSR;
+volatile uint32_t ulPortPRIMASK;
+
+static pthread_mutex_t port_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t port_cpu_cond = PTHREAD_COND_INITIALIZER;
+static int port_cpu_go;                 /* the idle CPU (scheduler thread) may run */
+static UBaseType_t port_nesting;        /* critical nesting of the running thread */
+static volatile int port_yield_pending;
+static uint32_t port_saved_ipsr;
+static BaseType_t (*port_idle)(void);
+static uint64_t (*port_now_ns)(void);
+
+static uint64_t prvNow(void)
+{
+  return (port_now_ns != NULL) ? port_now_ns() : 0U;
+}
+
+/* The thread that runs a task, NULL for the idle task (the scheduler thread) */
+static Thread_t *prvThreadOf(void *xTask)
+{
+  /* by name: xTaskGetIdleTaskHandle() asserts before the scheduler starts */
+  if ((xTask == NULL) || (strcmp(pcTaskGetName((TaskHandle_t)xTask), configIDLE_TASK_NAME) == 0))
+  {
+    return NULL;
+  }
+  /* pxTopOfStack is the first member of the TCB and stays just below the Thread_t */
+  return (Thread_t *)(*(StackType_t **)xTask + 1);
+}
+
+/* Hand the CPU to t (NULL: the scheduler thread); port_lock held */
+static void prvGive(Thread_t *t)
+{
+  if (t == NULL)
+  {
+    port_cpu_go = 1;
+    pthread_cond_signal(&port_cpu_cond);
+    return;
+  }
+  t->stats.runs++;
+  if (t->ready_ns != UINT64_MAX)
+  {
+    uint64_t latency = prvNow() - t->ready_ns;
+
+    t->stats.wakes++;
+    t->stats.latency_sum_ns += latency;
+    if (latency > t->stats.latency_max_ns)
+    {
+      t->stats.latency_max_ns = latency;
+    }
+    t->ready_ns = UINT64_MAX;
+  }
+  t->go = 1;
+  pthread_cond_signal(&t->cond);
+}
+
+/* Sleep until the CPU is handed back to t; port_lock held */
+static void prvTake(Thread_t *t)
+{
+  pthread_cond_t *cond = (t != NULL) ? &t->cond : &port_cpu_cond;
+  int *go = (t != NULL) ? &t->go : &port_cpu_go;
+
+  while (*go == 0)
+  {
+    if (t != NULL)
+    {
+      pthread_cond_wait(cond, &port_lock);
+    }
+    else
+    {
+      struct timespec until;
+
+      clock_gettime(CLOCK_REALTIME, &until);
+      until.tv_sec += PORT_WATCHDOG_S;
+      if ((pthread_cond_timedwait(cond, &port_lock, &until) == ETIMEDOUT) && (*go == 0))
+      {
+        fprintf(stderr, "port: task '%s' has not blocked for %d s\n",
+                pcTaskGetName(NULL), PORT_WATCHDOG_S);
+        abort();
+      }
+    }
+  }
+  *go = 0;
+}
+
+/* After vTaskSwitchContext(): run the chosen task, sleep until self is chosen again */
+static void prvSwitch(Thread_t *self)
+{
+  Thread_t *next = prvThreadOf(xTaskGetCurrentTaskHandle());
+  UBaseType_t nesting = port_nesting;
+
+  if (next == self)
+  {
+    return;
+  }
+  pthread_mutex_lock(&port_lock);
+  prvGive(next);
+  prvTake(self);
+  pthread_mutex_unlock(&port_lock);
+  port_nesting = nesting;
+}
+
+static void *prvThreadStart(void *arg)
+{
+  Thread_t *t = (Thread_t *)arg;
+
+  pthread_mutex_lock(&port_lock);
+  prvTake(t);
+  pthread_mutex_unlock(&port_lock);
+  port_nesting = 0U;
+
+  t->code(t->params);
+
+  /* task functions do not return; if one does, it is gone for good */
+  vTaskDelete(NULL);
+  return NULL;
+}
+
+/* Kernel interface -------------------------------------------------------- */
+
+StackType_t *pxPortInitialiseStack(StackType_t *pxTopOfStack, TaskFunction_t pxCode,
+                                   void *pvParameters)
+{
+  /* pxTopOfStack is 8-byte aligned, so is the Thread_t right below it */
+  Thread_t *t = (Thread_t *)pxTopOfStack - 1;
+  pthread_attr_t attr;
+
+  t->code = pxCode;
+  t->params = pvParameters;
+  t->go = 0;
+  t->ready_ns = UINT64_MAX;
+  t->stats = (PortTaskStats_t){0};
+  pthread_cond_init(&t->cond, NULL);
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  if (pthread_create(&t->thread, &attr, prvThreadStart, t) != 0)
+  {
+    perror("port: pthread_create");
+    abort();
+  }
+  pthread_attr_destroy(&attr);
+  return (StackType_t *)t - 1;
+}
+
+BaseType_t xPortStartScheduler(void)
+{
+  ulPortPRIMASK = 0U;
+  for (;;)
+  {
+    Thread_t *t = prvThreadOf(xTaskGetCurrentTaskHandle());
+
+    if (t != NULL)
+    {
+      pthread_mutex_lock(&port_lock);
+      prvGive(t);
+      prvTake(NULL);
+      pthread_mutex_unlock(&port_lock);
+      port_nesting = 0U;
+    }
+
+    /* nothing is ready: the CPU sleeps until the next interrupt */
+    if ((port_idle == NULL) || (port_idle() == pdFALSE))
+    {
+      break;
+    }
+    if (port_yield_pending != 0)
+    {
+      port_yield_pending = 0;
+      vTaskSwitchContext();
+    }
+  }
+  return pdFALSE;
+}
+
+void vPortEndScheduler(void)
+{
+}
+
+void vPortYield(void)
+{
+  Thread_t *self = prvThreadOf(xTaskGetCurrentTaskHandle());
+
+  if (ulPortIPSR != 0U)
+  {
+    port_yield_pending = 1;
+    return;
+  }
+  port_yield_pending = 0;
+  vTaskSwitchContext();
+  prvSwitch(self);
+}
+
+void vPortYieldFromISR(void)
+{
+  port_yield_pending = 1;
+}
+
+void vPortEnterCritical(void)
+{
+  port_nesting++;
+}
+
+void vPortExitCritical(void)
+{
+  port_nesting--;
+}
+
+void vPortDisableInterrupts(void)
+{
+  ulPortPRIMASK = 1U;
+}
+
+void vPortEnableInterrupts(void)
+{
+  ulPortPRIMASK = 0U;
+}
+
+uint32_t ulPortSetInterruptMask(void)
+{
+  return 0U;
+}
+
+void vPortClearInterruptMask(uint32_t ulMask)
+{
+  (void)ulMask;
+}
+
+void xPortSysTickHandler(void)
+{
+  if (xTaskIncrementTick() != pdFALSE)
+  {
+    vPortYieldFromISR();
+  }
+}
+
+/* Simulator interface ------------------------------------------------------ */
+
+void vPortSimInit(BaseType_t (*idle)(void), uint64_t (*now_ns)(void))
+{
+  port_idle = idle;
+  port_now_ns = now_ns;
+}
+
+void vPortInterruptEnter(uint32_t ulIrq)
+{
+  port_saved_ipsr = ulPortIPSR;
+  ulPortIPSR = ulIrq;
+}
+
+void vPortInterruptExit(void)
+{
+  ulPortIPSR = port_saved_ipsr;
+}
+
+void vPortPreemptionPoint(void)
+{
+  if ((port_yield_pending != 0) && (port_nesting == 0U) && (ulPortIPSR == 0U) &&
+      (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING))
+  {
+    vPortYield();
+  }
+}
+
+UBaseType_t uxPortCriticalNesting(void)
+{
+  return port_nesting;
+}
+
+const PortTaskStats_t *pxPortTaskStats(void *xTask)
+{
+  Thread_t *t = prvThreadOf(xTask);
+
+  return (t != NULL) ? &t->stats : NULL;
+}
+
+void vPortTaskReady(void *xTask)
+{
+  Thread_t *t = prvThreadOf(xTask);
+
+  if ((t != NULL) && (t->ready_ns == UINT64_MAX) && (xTask != (void *)xTaskGetCurrentTaskHandle()))
+  {
+    t->ready_ns = prvNow();
+  }
+}
@@ -0,0 +1,106 @@
+/*
+ * FreeRTOS port for the host simulation, see port.c.
+ *
+ * Takes the place of portable/RVDS/ARM_CM4F/portmacro.h. Types keep the
+ * target's widths where the kernel exposes them (ticks, stack words), so
+ * queue, stack and heap figures come out close to the board's.
+ */
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#include <stdint.h>
+
+#define portCHAR        char
+#define portFLOAT       float
+#define portDOUBLE      double
+#define portLONG        long
+#define portSHORT       short
+#define portSTACK_TYPE  uint32_t
+#define portBASE_TYPE   long
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define portMAX_DELAY               ((TickType_t)0xffffffffUL)
+#define portTICK_TYPE_IS_ATOMIC     1
+#define portPOINTER_SIZE_TYPE       uintptr_t
+
+#define portSTACK_GROWTH            (-1)
+#define portTICK_PERIOD_MS          ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portBYTE_ALIGNMENT          8
+#define portNOP()
+
+/* Scheduling: a yield hands the CPU over at once; from an interrupt it is
+   taken when the interrupt returns, as the PendSV would */
+void vPortYield(void);
+void vPortYieldFromISR(void);
+
+#define portYIELD()                 vPortYield()
+#define portEND_SWITCHING_ISR(x)    do { if ((x) != pdFALSE) { vPortYieldFromISR(); } } while (0)
+#define portYIELD_FROM_ISR(x)       portEND_SWITCHING_ISR(x)
+
+/* Critical sections only count: nothing else runs while a task does */
+void vPortEnterCritical(void);
+void vPortExitCritical(void);
+void vPortDisableInterrupts(void);
+void vPortEnableInterrupts(void);
+uint32_t ulPortSetInterruptMask(void);
+void vPortClearInterruptMask(uint32_t ulMask);
+
+#define portDISABLE_INTERRUPTS()                vPortDisableInterrupts()
+#define portENABLE_INTERRUPTS()                 vPortEnableInterrupts()
+#define portENTER_CRITICAL()                    vPortEnterCritical()
+#define portEXIT_CRITICAL()                     vPortExitCritical()
+#define portSET_INTERRUPT_MASK_FROM_ISR()       ulPortSetInterruptMask()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)    vPortClearInterruptMask(x)
+
+#define portTASK_FUNCTION_PROTO(vFunction, pvParameters) void vFunction(void *pvParameters)
+#define portTASK_FUNCTION(vFunction, pvParameters) void vFunction(void *pvParameters)
+
+/* SysTick_Handler() in cmsis_os2.c calls this once per tick */
+void xPortSysTickHandler(void);
+
+/* The simulated CPU ----------------------------------------------------------
+ *
+ * IPSR and PRIMASK as __get_IPSR()/__get_PRIMASK() report them (see
+ * core_cm4.h next to this file): nonzero IPSR is interrupt context.
+ */
+extern volatile uint32_t ulPortIPSR;
+extern volatile uint32_t ulPortPRIMASK;
+
+/* Run an interrupt handler body between these two */
+void vPortInterruptEnter(uint32_t ulIrq);
+void vPortInterruptExit(void);
+
+/*
+ * The simulator's side of the CPU. idle runs whenever no task is ready:
+ * it lets simulated time pass up to the next interrupt, runs it and
+ * returns pdTRUE, or pdFALSE to leave vTaskStartScheduler(). now_ns gives
+ * simulated time for the latency figures.
+ */
+void vPortSimInit(BaseType_t (*idle)(void), uint64_t (*now_ns)(void));
+
+/* In a task, after interrupts were run inside it: switch if one asked to */
+void vPortPreemptionPoint(void);
+
+/* Nesting of the running task's critical sections */
+UBaseType_t uxPortCriticalNesting(void);
+
+typedef struct
+{
+  uint32_t runs;              /* times the task was given the CPU */
+  uint32_t wakes;             /* ... of those, after it was made ready */
+  uint64_t latency_sum_ns;    /* made ready to running */
+  uint64_t latency_max_ns;
+} PortTaskStats_t;
+
+/* Per-task scheduling figures; NULL for the idle task */
+const PortTaskStats_t *pxPortTaskStats(void *xTask);
+
+/* A task entered the ready list: start of its wake-up latency */
+void vPortTaskReady(void *xTask);
+#define traceMOVED_TASK_TO_READY_STATE(pxTCB) vPortTaskReady(pxTCB)
+
+#endif /* PORTMACRO_H */
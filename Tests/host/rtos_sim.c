@@ -0,0 +1,724 @@
+/*
+ * The firmware's task set on the POSIX port of FreeRTOS, see rtos_sim.h.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "rtos_sim.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "cmsis_os.h"
+#include "SEGGER_RTT.h"
+#include "trace.h"
+#include "tlog.h"
+#include "health.h"
+#include "input.h"
+#include "settings.h"
+#include "bootprof.h"
+#include "rotary.h"
+#include "runtime_stats.h"
+#include "usb_device.h"
+#include "usbd_vendor.h"
+#include "usbd_hid.h"
+#include "audio_sim.h"
+#include "usbd_ll_host.h"
+#include "flash_host.h"
+#include "uart_host.h"
+#include "tim.h"
+
+#define AS_INTERFACE        1U
+/* full-speed bulk: at most 19 packets of 64 bytes per frame */
+#define BULK_PER_FRAME      19U
+/* an input change that raises no interrupt: exception 0, thread mode */
+#define SIM_NO_IRQ          ((IRQn_Type)-16)
+/* HSE crystal start-up, DS10314 tSU(HSE) typical */
+#define RTOS_SIM_HSE_NS     (2U * RTOS_SIM_MS)
+
+void MX_FREERTOS_Init(void);
+void SysTick_Handler(void);                 /* cmsis_os2.c */
+extern USBD_HandleTypeDef hUsbDeviceFS;     /* usb_device.c */
+
+typedef struct
+{
+  uint64_t t;
+  uint64_t seq;
+  uint64_t period;            /* 0 for a single event */
+  IRQn_Type irq;
+  RtosSim_HandlerTypeDef fn;
+  void *arg;
+} Event_t;
+
+typedef struct
+{
+  GPIO_TypeDef *port;
+  uint16_t pin;
+  GPIO_PinState level;
+} Pin_t;
+
+typedef struct
+{
+  uint8_t setup[8];
+  uint8_t data[64];
+} Control_t;
+
+/* The parts of the address space the firmware touches directly */
+static const struct
+{
+  uintptr_t base;
+  size_t size;
+} sim_region[] =
+{
+  {0x08000000U, 0x80000U},    /* flash: settings sectors 2 and 3 */
+  {0x1FFF7000U, 0x1000U},     /* system memory: unique ID, usbd_desc.c */
+  {0x40000000U, 0x80000U},    /* APB1, APB2, AHB1 peripherals */
+  {0xE0000000U, 0x100000U},   /* private peripheral bus: DWT, SysTick, NVIC, SCB */
+};
+
+static RtosSim_ConfigTypeDef sim_cfg;
+static RtosSim_StatsTypeDef sim_stats;
+static uint64_t sim_now;
+static uint64_t sim_end;
+static Event_t *sim_ev;               /* binary heap on (t, seq) */
+static uint32_t sim_ev_num;
+static uint32_t sim_ev_max;
+static uint64_t sim_ev_seq;
+static uint8_t sim_streaming;         /* the host selected the streaming alternate setting */
+static uint64_t sim_clock_ns;         /* when the core clock last changed ... */
+static uint32_t sim_clock_cycles;     /* ... and CYCCNT then */
+static uint32_t sim_clock_mhz;
+static uint32_t sim_enc_pos;          /* quarter position after the turns scheduled so far */
+static uint32_t sim_enc_pins;
+
+/* system_stm32f4xx.c, main.c --------------------------------------------- */
+
+uint32_t SystemCoreClock = 96000000U;
+volatile long long FreeRTOSRunTimeTicks;
+Rotary_HandleTypeDef hrotary;
+
+/* the MSP region health.c paints, with the names armlink gives it */
+uint32_t STACK$$Base[256];
+__asm__(".globl STACK$$Limit\n.set STACK$$Limit, STACK$$Base + 1024");
+
+static const Rotary_AccelTypeDef rotary_accel[] = {
+  {4000U, 8U},
+  {10000U, 4U},
+  {25000U, 2U},
+};
+
+void Error_Handler(void)
+{
+  fprintf(stderr, "rtos_sim: Error_Handler at %.3f ms\n", (double)sim_now / 1e6);
+  abort();
+}
+
+static bool read_rotary_a(void *data)
+{
+  (void)data;
+  return HAL_GPIO_ReadPin(ROTARY_CLK_GPIO_Port, ROTARY_CLK_Pin) == GPIO_PIN_SET;
+}
+
+static bool read_rotary_b(void *data)
+{
+  (void)data;
+  return HAL_GPIO_ReadPin(ROTARY_DT_GPIO_Port, ROTARY_DT_Pin) == GPIO_PIN_SET;
+}
+
+static void Rotary_Update(void)
+{
+  uint32_t idr = ROTARY_CLK_GPIO_Port->IDR;
+  uint8_t pins = (uint8_t)((((idr & ROTARY_DT_Pin) != 0U) << 1) | ((idr & ROTARY_CLK_Pin) != 0U));
+  uint8_t result = Rotary_ProcessPins(&hrotary, pins);
+  int16_t steps;
+
+  if (result == ROTARY_DIR_NONE)
+  {
+    return;
+  }
+  steps = Rotary_Accelerate(&hrotary, result, RTStats_Micros());
+  if (steps > 0)
+  {
+    Input_PostFromISR(INPUT_EVT_ROTARY_CW, 0U, (uint16_t)steps);
+  }
+  else
+  {
+    Input_PostFromISR(INPUT_EVT_ROTARY_CCW, 0U, (uint16_t)-steps);
+  }
+}
+
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+  if ((GPIO_Pin == ROTARY_DT_Pin) || (GPIO_Pin == ROTARY_CLK_Pin))
+  {
+    Rotary_Update();
+  }
+}
+
+/* interrupt handlers ------------------------------------------------------ */
+
+static void sim_tim4(void *arg)
+{
+  (void)arg;
+  FreeRTOSRunTimeTicks++;
+  HAL_IncTick();
+}
+
+static void sim_tim5(void *arg)
+{
+  static uint16_t led_counter = 0;
+
+  (void)arg;
+  led_counter++;
+  if (led_counter >= 500)
+  {
+    led_counter = 0;
+    HAL_GPIO_TogglePin(LED_GPIO_Port, LED_Pin);
+  }
+  Input_Tick();
+}
+
+static void sim_systick(void *arg)
+{
+  (void)arg;
+  SysTick_Handler();
+}
+
+static void sim_dma(void *arg)
+{
+  (void)arg;
+  AudioSim_RunToDmaEvent();
+}
+
+static void sim_pin(void *arg)
+{
+  Pin_t *p = (Pin_t *)arg;
+  uint32_t before = p->port->IDR;
+
+  if (p->level == GPIO_PIN_SET)
+  {
+    p->port->IDR |= p->pin;
+  }
+  else
+  {
+    p->port->IDR &= ~(uint32_t)p->pin;
+  }
+  /* EXTI1/2 trigger on both edges of the encoder pins, MX_GPIO_Init() */
+  if ((p->port == ROTARY_CLK_GPIO_Port) && ((p->pin & (ROTARY_CLK_Pin | ROTARY_DT_Pin)) != 0U) &&
+      (before != p->port->IDR))
+  {
+    EXTI->PR |= p->pin;
+    HAL_GPIO_EXTI_IRQHandler(p->pin);
+    EXTI->PR &= ~(uint32_t)p->pin;
+  }
+  free(p);
+}
+
+/* The host's side of one 1 ms frame */
+static void sim_usb_frame(void *arg)
+{
+  uint8_t buf[64];
+  int n;
+
+  (void)arg;
+  if (sim_streaming != 0U)
+  {
+    (void)AudioSim_Packet(sim_now, AUDIO_OUT_PACKET);
+  }
+  for (uint32_t i = 0U; i < BULK_PER_FRAME; i++)
+  {
+    n = USBD_Host_In(&hUsbDeviceFS, VENDOR_IN_EP, buf, sizeof(buf));
+    if (n <= 0)
+    {
+      break;
+    }
+    sim_stats.vendor_bytes += (uint32_t)n;
+  }
+  n = USBD_Host_In(&hUsbDeviceFS, HID_EPIN_ADDR, buf, sizeof(buf));
+  if (n > 0)
+  {
+    if (sim_stats.hid_reports < RTOS_SIM_HID_LOG)
+    {
+      sim_stats.hid[sim_stats.hid_reports].t_ns = sim_now;
+      sim_stats.hid[sim_stats.hid_reports].keys = buf[0];
+    }
+    sim_stats.hid_reports++;
+  }
+}
+
+static void sim_control(void *arg)
+{
+  Control_t *c = (Control_t *)arg;
+  uint16_t wValue = (uint16_t)(c->setup[2] | (c->setup[3] << 8));
+  uint16_t wIndex = (uint16_t)(c->setup[4] | (c->setup[5] << 8));
+  uint16_t wLength = (uint16_t)(c->setup[6] | (c->setup[7] << 8));
+
+  if (AudioSim_Control(sim_now, c->setup[0], c->setup[1], wValue, wIndex, wLength, c->data) >= 0)
+  {
+    if ((c->setup[0] == 0x01U) && (c->setup[1] == USB_REQ_SET_INTERFACE) && (wIndex == AS_INTERFACE))
+    {
+      sim_streaming = (wValue != 0U) ? 1U : 0U;
+    }
+  }
+  free(c);
+}
+
+static void sim_every(uint64_t t_ns, IRQn_Type irq, RtosSim_HandlerTypeDef fn, uint64_t period);
+
+static void sim_enumerate(void *arg)
+{
+  (void)arg;
+  USBD_Host_Enumerate(&hUsbDeviceFS);
+  if (hUsbDeviceFS.dev_state == USBD_STATE_CONFIGURED)
+  {
+    sim_stats.enumerated_ns = sim_now;
+  }
+  sim_every(sim_now + RTOS_SIM_MS, OTG_FS_IRQn, sim_usb_frame, RTOS_SIM_MS);
+  if (sim_cfg.no_stream == 0U)
+  {
+    RtosSim_Control(sim_now, 0x01U, USB_REQ_SET_INTERFACE, 1U, AS_INTERFACE, 0U, NULL);
+  }
+}
+
+/* timeline ---------------------------------------------------------------- */
+
+static int sim_before(const Event_t *a, const Event_t *b)
+{
+  return (a->t < b->t) || ((a->t == b->t) && (a->seq < b->seq));
+}
+
+static void sim_push(Event_t e)
+{
+  uint32_t i;
+
+  if (sim_ev_num == sim_ev_max)
+  {
+    sim_ev_max = (sim_ev_max != 0U) ? 2U * sim_ev_max : 64U;
+    sim_ev = realloc(sim_ev, sim_ev_max * sizeof(*sim_ev));
+    if (sim_ev == NULL)
+    {
+      abort();
+    }
+  }
+  e.seq = sim_ev_seq++;
+  i = sim_ev_num++;
+  while ((i > 0U) && sim_before(&e, &sim_ev[(i - 1U) / 2U]))
+  {
+    sim_ev[i] = sim_ev[(i - 1U) / 2U];
+    i = (i - 1U) / 2U;
+  }
+  sim_ev[i] = e;
+}
+
+static Event_t sim_pop(void)
+{
+  Event_t top = sim_ev[0];
+  Event_t last = sim_ev[--sim_ev_num];
+  uint32_t i = 0U;
+
+  for (;;)
+  {
+    uint32_t c = 2U * i + 1U;
+
+    if (c >= sim_ev_num)
+    {
+      break;
+    }
+    if ((c + 1U < sim_ev_num) && sim_before(&sim_ev[c + 1U], &sim_ev[c]))
+    {
+      c++;
+    }
+    if (!sim_before(&sim_ev[c], &last))
+    {
+      break;
+    }
+    sim_ev[i] = sim_ev[c];
+    i = c;
+  }
+  sim_ev[i] = last;
+  return top;
+}
+
+static void sim_every(uint64_t t_ns, IRQn_Type irq, RtosSim_HandlerTypeDef fn, uint64_t period)
+{
+  Event_t e = {t_ns, 0U, period, irq, fn, NULL};
+
+  sim_push(e);
+}
+
+static void sim_set_now(uint64_t t_ns)
+{
+  sim_now = t_ns;
+  DWT->CYCCNT = sim_clock_cycles + (uint32_t)((t_ns - sim_clock_ns) * sim_clock_mhz / 1000U);
+}
+
+static void sim_set_clock(uint32_t hz)
+{
+  sim_clock_ns = sim_now;
+  sim_clock_cycles = DWT->CYCCNT;
+  sim_clock_mhz = hz / 1000000U;
+}
+
+static void sim_drain_rtt(void)
+{
+  char buf[256];
+
+  for (unsigned ch = 0U; ch < (unsigned)_SEGGER_RTT.MaxNumUpBuffers; ch++)
+  {
+    FILE *f = (ch == 0U) ? sim_cfg.console : (ch == TRACE_RTT_CHANNEL) ? sim_cfg.trace : NULL;
+    unsigned n;
+
+    while ((n = SEGGER_RTT_ReadUpBufferNoLock(ch, buf, sizeof(buf))) != 0U)
+    {
+      if (f != NULL)
+      {
+        fwrite(buf, 1U, n, f);
+      }
+    }
+  }
+}
+
+/* Run the next interrupt due by limit; 0 when there is none */
+static int sim_dispatch(uint64_t limit)
+{
+  uint64_t dma = AudioSim_NextDmaEvent();
+  RtosSim_IrqStatsTypeDef *st;
+  Event_t e;
+
+  /* the DMA first on a tie: whatever runs after it may advance the audio clock */
+  if ((sim_ev_num != 0U) && (sim_ev[0].t < dma))
+  {
+    if (sim_ev[0].t > limit)
+    {
+      return 0;
+    }
+    e = sim_pop();
+  }
+  else
+  {
+    if (dma > limit)
+    {
+      return 0;
+    }
+    e = (Event_t){dma, 0U, 0U, DMA1_Stream4_IRQn, sim_dma, NULL};
+  }
+  if (e.t > sim_now)
+  {
+    sim_set_now(e.t);
+  }
+
+  st = &sim_stats.irq[16 + e.irq];
+  if (e.irq != SIM_NO_IRQ)
+  {
+    st->count++;
+    if (sim_now - e.t > st->late_max_ns)
+    {
+      st->late_max_ns = sim_now - e.t;
+    }
+  }
+  /* a periodic interrupt that came due again while pending is taken once */
+  if (e.period != 0U)
+  {
+    uint64_t missed = (sim_now - e.t) / e.period;
+
+    st->coalesced += (uint32_t)missed;
+    e.t += (missed + 1U) * e.period;
+    sim_push(e);
+  }
+
+  vPortInterruptEnter((uint32_t)(16 + e.irq));
+  e.fn(e.arg);
+  vPortInterruptExit();
+  sim_drain_rtt();
+  return 1;
+}
+
+/* The port's idle CPU: let time pass up to the next interrupt */
+static BaseType_t sim_idle(void)
+{
+  if (sim_dispatch(sim_end) != 0)
+  {
+    return pdTRUE;
+  }
+  sim_set_now(sim_end);
+  return pdFALSE;
+}
+
+static uint64_t sim_now_ns(void)
+{
+  return sim_now;
+}
+
+/* interface --------------------------------------------------------------- */
+
+void RtosSim_Init(const RtosSim_ConfigTypeDef *cfg)
+{
+  static const uint32_t uid[3] = {0x00470031U, 0x31345106U, 0x38363830U};
+
+  for (uint32_t i = 0U; i < sizeof(sim_region) / sizeof(sim_region[0]); i++)
+  {
+    void *p = mmap((void *)sim_region[i].base, sim_region[i].size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+    if (p != (void *)sim_region[i].base)
+    {
+      perror("rtos_sim: mmap");
+      exit(1);
+    }
+  }
+  memset((void *)sim_region[0].base, 0xFF, sim_region[0].size);
+  memcpy((void *)UID_BASE, uid, sizeof(uid));
+  /* Reset_Handler starts the cycle counter, DWT_Init() finds it running */
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  sim_cfg = *cfg;
+  memset(&sim_stats, 0, sizeof(sim_stats));
+  sim_ev_num = 0U;
+  sim_streaming = 0U;
+  sim_enc_pos = 0U;
+  sim_enc_pins = ROTARY_CLK_Pin | ROTARY_DT_Pin;
+  sim_now = 0U;
+  DWT->CYCCNT = 0U;
+  sim_set_clock(HSI_VALUE);
+  FLASH_Host_Reset(RtosSim_Stall);
+  vPortSimInit(sim_idle, sim_now_ns);
+}
+
+void RtosSim_At(uint64_t t_ns, IRQn_Type irq, RtosSim_HandlerTypeDef fn, void *arg)
+{
+  Event_t e = {t_ns, 0U, 0U, irq, fn, arg};
+
+  sim_push(e);
+}
+
+void RtosSim_Pin(uint64_t t_ns, GPIO_TypeDef *port, uint16_t pin, GPIO_PinState level)
+{
+  Pin_t *p = malloc(sizeof(*p));
+  IRQn_Type irq = SIM_NO_IRQ;
+
+  p->port = port;
+  p->pin = pin;
+  p->level = level;
+  if ((port == ROTARY_CLK_GPIO_Port) && (pin == ROTARY_DT_Pin))
+  {
+    irq = EXTI1_IRQn;
+  }
+  else if ((port == ROTARY_CLK_GPIO_Port) && (pin == ROTARY_CLK_Pin))
+  {
+    irq = EXTI2_IRQn;
+  }
+  RtosSim_At(t_ns, irq, sim_pin, p);
+}
+
+void RtosSim_Turn(uint64_t t_ns, int32_t quarters, uint64_t interval_ns)
+{
+  /* from rest (both phases high) CW is DT low, CLK low, DT high, CLK high */
+  static const uint16_t cw_pin[4] = {ROTARY_DT_Pin, ROTARY_CLK_Pin, ROTARY_DT_Pin, ROTARY_CLK_Pin};
+  int32_t dir = (quarters < 0) ? -1 : 1;
+
+  for (int32_t i = 0; i != quarters; i += dir)
+  {
+    /* the pin that changes going CW from pos, or back into pos going CCW */
+    uint16_t pin = cw_pin[(dir > 0) ? sim_enc_pos : (sim_enc_pos + 3U) & 3U];
+
+    sim_enc_pos = (uint32_t)((int32_t)sim_enc_pos + dir) & 3U;
+    sim_enc_pins ^= pin;
+    RtosSim_Pin(t_ns, ROTARY_CLK_GPIO_Port, pin,
+                ((sim_enc_pins & pin) != 0U) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    t_ns += interval_ns;
+  }
+}
+
+void RtosSim_Control(uint64_t t_ns, uint8_t bmRequest, uint8_t bRequest, uint16_t wValue,
+                     uint16_t wIndex, uint16_t wLength, const uint8_t *data)
+{
+  Control_t *c = calloc(1U, sizeof(*c));
+  uint8_t setup[8] =
+  {
+    bmRequest, bRequest, LOBYTE(wValue), HIBYTE(wValue),
+    LOBYTE(wIndex), HIBYTE(wIndex), LOBYTE(wLength), HIBYTE(wLength)
+  };
+
+  memcpy(c->setup, setup, sizeof(setup));
+  if ((data != NULL) && ((bmRequest & 0x80U) == 0U))
+  {
+    memcpy(c->data, data, (wLength < sizeof(c->data)) ? wLength : sizeof(c->data));
+  }
+  RtosSim_At(t_ns, OTG_FS_IRQn, sim_control, c);
+}
+
+/* the peripherals StartDefaultTask() brings up ------------------------------ */
+
+TIM_HandleTypeDef htim5;
+
+void MX_TIM5_Init(void)
+{
+  htim5.Instance = TIM5;
+  BootProf_Mark(BOOT_MS_TIM5);
+}
+
+void MX_USART1_UART_Init(void)
+{
+  UART_Host_Init(sim_cfg.uart);
+  BootProf_Mark(BOOT_MS_USART1);
+}
+
+void MX_TIM3_Init(void)
+{
+  BootProf_Mark(BOOT_MS_TIM3);
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim)
+{
+  if (htim->Instance != TIM5)
+  {
+    return HAL_ERROR;
+  }
+  sim_every(sim_now + RTOS_SIM_MS, TIM5_IRQn, sim_tim5, RTOS_SIM_MS);
+  return HAL_OK;
+}
+
+void RtosSim_Run(uint64_t t_ns)
+{
+  AudioSim_ConfigTypeDef audio = {sim_cfg.ppm, NULL};
+
+  sim_end = t_ns;
+  AudioSim_Reset(&audio);
+
+  /* main(), from reset on the HSI */
+  BootProf_Init();
+  BootProf_Mark(BOOT_MS_HAL);
+  /* SystemClock_Config(): waits for the HSE, then runs from the PLL; the
+     HAL time base is TIM4 (stm32f4xx_hal_timebase_tim.c) from then on */
+  sim_set_now(sim_now + RTOS_SIM_HSE_NS);
+  sim_set_clock(SystemCoreClock);
+  sim_every(sim_now + RTOS_SIM_MS, TIM4_IRQn, sim_tim4, RTOS_SIM_MS);
+  BootProf_Mark(BOOT_MS_CLOCK);
+  SEGGER_RTT_Init();
+  Trace_Init();
+  Health_Init();
+  TLog_Init();
+  Settings_Init();
+  MX_USB_DEVICE_Init();
+  RtosSim_At(sim_now + RTOS_SIM_CONNECT_NS, OTG_FS_IRQn, sim_enumerate, NULL);
+  Rotary_Init(&hrotary, read_rotary_a, NULL, read_rotary_b, NULL);
+  Rotary_SetAccel(&hrotary, rotary_accel, sizeof(rotary_accel) / sizeof(rotary_accel[0]));
+  /* MX_GPIO_Init(): every input is pulled up */
+  KEY_GPIO_Port->IDR |= KEY_Pin;
+  ROTARY_CLK_GPIO_Port->IDR |= ROTARY_CLK_Pin | ROTARY_DT_Pin | ROTARY_SW_Pin;
+  /* MX_DMA_Init(), MX_I2S2_Init(): audio_sim, below */
+  BootProf_Mark(BOOT_MS_GPIO_DMA);
+  BootProf_Mark(BOOT_MS_I2S2);
+  BootProf_Mark(BOOT_MS_APP);
+  osKernelInitialize();
+  MX_FREERTOS_Init();
+  /* xPortStartScheduler() starts SysTick */
+  sim_every(sim_now + RTOS_SIM_MS, SysTick_IRQn, sim_systick, RTOS_SIM_MS);
+  osKernelStart();
+
+  /* vTaskStartScheduler() returns once sim_idle() reached the end */
+  sim_drain_rtt();
+  sim_stats.t_ns = sim_now;
+}
+
+uint64_t RtosSim_Now(void)
+{
+  return sim_now;
+}
+
+void RtosSim_Stall(uint64_t ns)
+{
+  sim_set_now(sim_now + ns);
+  sim_stats.stalled_ns += ns;
+  if (ns > sim_stats.stall_max_ns)
+  {
+    sim_stats.stall_max_ns = ns;
+  }
+  /* what came due meanwhile runs now, unless it is masked */
+  if ((ulPortIPSR != 0U) || (ulPortPRIMASK != 0U) || (uxPortCriticalNesting() != 0U))
+  {
+    return;
+  }
+  while (sim_dispatch(sim_now) != 0)
+  {
+  }
+  vPortPreemptionPoint();
+}
+
+const RtosSim_StatsTypeDef *RtosSim_Stats(void)
+{
+  return &sim_stats;
+}
+
+const PortTaskStats_t *RtosSim_Task(const char *name)
+{
+  TaskStatus_t task[8];
+  UBaseType_t n = uxTaskGetSystemState(task, sizeof(task) / sizeof(task[0]), NULL);
+
+  for (UBaseType_t i = 0U; i < n; i++)
+  {
+    if (strcmp(task[i].pcTaskName, name) == 0)
+    {
+      return pxPortTaskStats(task[i].xHandle);
+    }
+  }
+  return NULL;
+}
+
+/* report ------------------------------------------------------------------ */
+
+static const char *sim_irq_name(int exc)
+{
+  switch (exc - 16)
+  {
+    case SysTick_IRQn:        return "SysTick";
+    case TIM4_IRQn:           return "TIM4";
+    case TIM5_IRQn:           return "TIM5";
+    case OTG_FS_IRQn:         return "OTG_FS";
+    case DMA1_Stream4_IRQn:   return "DMA1_S4";
+    case DMA2_Stream7_IRQn:   return "DMA2_S7";
+    case EXTI1_IRQn:          return "EXTI1";
+    case EXTI2_IRQn:          return "EXTI2";
+    default:                  return "?";
+  }
+}
+
+void RtosSim_Report(FILE *f)
+{
+  const RtosSim_StatsTypeDef *s = &sim_stats;
+  TaskStatus_t task[8];
+  UBaseType_t n = uxTaskGetSystemState(task, sizeof(task) / sizeof(task[0]), NULL);
+
+  fprintf(f, "  %.3f s, enumerated at %.3f ms, CPU stalled %.3f ms (longest %.3f ms)\n",
+          (double)s->t_ns / 1e9, (double)s->enumerated_ns / 1e6, (double)s->stalled_ns / 1e6,
+          (double)s->stall_max_ns / 1e6);
+  fprintf(f, "  interrupt    count  coalesced  late max (us)\n");
+  for (int exc = 0; exc < (int)(sizeof(s->irq) / sizeof(s->irq[0])); exc++)
+  {
+    if (s->irq[exc].count != 0U)
+    {
+      fprintf(f, "  %-8s %9u  %9u  %13.1f\n", sim_irq_name(exc), s->irq[exc].count,
+              s->irq[exc].coalesced, (double)s->irq[exc].late_max_ns / 1e3);
+    }
+  }
+  fprintf(f, "  task         prio   runs  wakes  latency avg / max (us)\n");
+  for (UBaseType_t i = 0U; i < n; i++)
+  {
+    const PortTaskStats_t *t = pxPortTaskStats(task[i].xHandle);
+
+    if (t == NULL)
+    {
+      continue;
+    }
+    fprintf(f, "  %-12s %4lu %6u %6u  %10.1f / %.1f\n", task[i].pcTaskName,
+            (unsigned long)task[i].uxCurrentPriority, t->runs, t->wakes,
+            (t->wakes != 0U) ? (double)t->latency_sum_ns / t->wakes / 1e3 : 0.0,
+            (double)t->latency_max_ns / 1e3);
+  }
+  fprintf(f, "  heap: %u of %u bytes free, %u at least\n", (unsigned)xPortGetFreeHeapSize(),
+          (unsigned)configTOTAL_HEAP_SIZE, (unsigned)xPortGetMinimumEverFreeHeapSize());
+  fprintf(f, "  USB: %u vendor bytes, %u HID reports; USART1: %u bytes; flash: %u erases, "
+          "%u words\n", s->vendor_bytes, s->hid_reports, UART_Host_Stats()->bytes,
+          FLASH_Host_Stats()->erases, FLASH_Host_Stats()->programs);
+  AudioSim_Report(f);
+}
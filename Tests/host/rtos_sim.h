@@ -0,0 +1,109 @@
+/*
+ * The firmware's task set on the POSIX port of FreeRTOS (host/posix).
+ *
+ * The unmodified kernel, CMSIS-RTOS2 layer, freertos.c and the modules
+ * its tasks call (input, settings + kvstore, telemetry, uartlink, health,
+ * ...) run on a simulated STM32F411. RAM is mapped at the addresses of
+ * the flash, the peripherals and the Cortex-M core registers, so register
+ * reads and writes, the settings sectors and the UID work as they are;
+ * host/flash_host.c and host/uart_host.c stand in for the HAL drivers whose
+ * hardware side matters, the USB side is the composite device of
+ * usb_device.c against usbd_ll_host and the audio path is audio_sim.
+ *
+ * Time is virtual and in nanoseconds. Interrupts are events on a single
+ * timeline: SysTick, TIM4 (HAL tick) and TIM5 every millisecond, the I2S
+ * DMA half/full transfers, one USB frame per millisecond once the host
+ * has enumerated (the audio OUT packet, the vendor and HID IN endpoints),
+ * the USART1 TX DMA completion and whatever pin changes the caller
+ * schedules. Task code takes no time: a task runs from the moment it is
+ * made ready until it blocks, unless the CPU is stalled inside it
+ * (RtosSim_Stall(), e.g. by a flash erase). Scheduling latency is then the
+ * time a task waits behind higher priority tasks, critical sections and
+ * stalls, and the same inputs always give the same run.
+ *
+ * FreeRTOS cannot be restarted: RtosSim_Run() is called once per process.
+ */
+#ifndef RTOS_SIM_H
+#define RTOS_SIM_H
+
+#include <stdio.h>
+
+#include "main.h"
+#include "FreeRTOS.h"
+
+#define RTOS_SIM_MS             1000000ULL
+/* the host resets the bus this long after the D+ pull-up (USB 2.0 7.1.7.3) */
+#define RTOS_SIM_CONNECT_NS     (100ULL * RTOS_SIM_MS)
+#define RTOS_SIM_HID_LOG        64U
+
+typedef void (*RtosSim_HandlerTypeDef)(void *arg);
+
+typedef struct
+{
+  double ppm;                 /* I2S sample clock error, see audio_sim.h */
+  uint8_t no_stream;          /* the host enumerates but sends no audio */
+  FILE *console;              /* RTT channel 0 (SEGGER_RTT_printf), NULL to drop */
+  FILE *trace;                /* RTT channel 1 (trace.h, TRACE_ENABLE=1), NULL to drop */
+  FILE *uart;                 /* what USART1 sends, NULL to drop */
+} RtosSim_ConfigTypeDef;
+
+typedef struct
+{
+  uint32_t count;
+  uint32_t coalesced;         /* periodic interrupts that came due again while pending */
+  uint64_t late_max_ns;       /* held off by a stall or a masked section */
+} RtosSim_IrqStatsTypeDef;
+
+typedef struct
+{
+  uint64_t t_ns;
+  uint8_t keys;               /* HID_CC_xxx, 0 for the release report */
+} RtosSim_HidReportTypeDef;
+
+typedef struct
+{
+  uint64_t t_ns;              /* simulated time reached */
+  uint64_t enumerated_ns;     /* SET_CONFIGURATION, 0 while not enumerated */
+  uint64_t stalled_ns;        /* CPU stalls in total */
+  uint64_t stall_max_ns;
+  uint32_t vendor_bytes;      /* read from the vendor bulk IN endpoint */
+  uint32_t hid_reports;       /* read from the HID interrupt IN endpoint */
+  RtosSim_HidReportTypeDef hid[RTOS_SIM_HID_LOG];   /* the first ones */
+  RtosSim_IrqStatsTypeDef irq[16 + 128];            /* by exception number */
+} RtosSim_StatsTypeDef;
+
+/* Map the MCU address space and reset the simulation */
+void RtosSim_Init(const RtosSim_ConfigTypeDef *cfg);
+
+/* Run fn(arg) as interrupt irq at t_ns (in the past: as soon as possible) */
+void RtosSim_At(uint64_t t_ns, IRQn_Type irq, RtosSim_HandlerTypeDef fn, void *arg);
+
+/* Drive an input pin at t_ns; the encoder pins raise their EXTI line */
+void RtosSim_Pin(uint64_t t_ns, GPIO_TypeDef *port, uint16_t pin, GPIO_PinState level);
+
+/* Turn the encoder by quarter steps (CW positive), one every interval_ns
+   from t_ns; the default half-step mode reports every second one */
+void RtosSim_Turn(uint64_t t_ns, int32_t quarters, uint64_t interval_ns);
+
+/* A control transfer from the host at t_ns, see USBD_Host_Control();
+   the data stage of an OUT request (up to 64 bytes) is copied */
+void RtosSim_Control(uint64_t t_ns, uint8_t bmRequest, uint8_t bRequest, uint16_t wValue,
+                     uint16_t wIndex, uint16_t wLength, const uint8_t *data);
+
+/* Boot as main() does, start the scheduler and run until t_ns */
+void RtosSim_Run(uint64_t t_ns);
+
+uint64_t RtosSim_Now(void);
+
+/* The CPU stops for ns; interrupts that come due meanwhile run after it */
+void RtosSim_Stall(uint64_t ns);
+
+const RtosSim_StatsTypeDef *RtosSim_Stats(void);
+
+/* Scheduling figures of a task by name (host/posix/portmacro.h), NULL if none */
+const PortTaskStats_t *RtosSim_Task(const char *name);
+
+/* Interrupts, tasks, heap and the audio path */
+void RtosSim_Report(FILE *f);
+
+#endif /* RTOS_SIM_H */
@@ -0,0 +1,29 @@
+/*
+ * Host stand-in for Core/Src/settings.c: RAM only, nothing is kept.
+ *
+ * Settings_Init() goes back to the defaults, as a first power-up with
+ * blank sectors would. The RTOS simulation links the real settings.c
+ * against host/flash_host.c instead.
+ */
+#include "settings.h"
+
+static uint8_t host_mute;
+
+void Settings_Init(void)
+{
+  host_mute = 0U;
+}
+
+void Settings_Poll(void)
+{
+}
+
+uint8_t Settings_GetMute(void)
+{
+  return host_mute;
+}
+
+void Settings_SetMute(uint8_t mute)
+{
+  host_mute = mute;
+}
@@ -0,0 +1,129 @@
+/*
+ * Host stand-in for USART1 and its DMA streams, see uart_host.h.
+ */
+#include <string.h>
+
+#include "uart_host.h"
+#include "rtos_sim.h"
+
+UART_HandleTypeDef huart1;
+
+static UART_HostStatsTypeDef uart_stats;
+static FILE *uart_tx_file;
+static uint32_t uart_tx_gen;          /* a completion of an aborted transfer is stale */
+static uint8_t *uart_rx_buf;
+static uint16_t uart_rx_size;
+static uint16_t uart_rx_pos;
+
+static void uart_tx_done(void *arg)
+{
+  if ((uint32_t)(uintptr_t)arg != uart_tx_gen)
+  {
+    return;
+  }
+  huart1.gState = HAL_UART_STATE_READY;
+  HAL_UART_TxCpltCallback(&huart1);
+}
+
+void UART_Host_Init(FILE *tx)
+{
+  memset(&huart1, 0, sizeof(huart1));
+  memset(&uart_stats, 0, sizeof(uart_stats));
+  huart1.Instance = USART1;
+  huart1.Init.BaudRate = 115200;
+  huart1.Init.WordLength = UART_WORDLENGTH_8B;
+  huart1.Init.StopBits = UART_STOPBITS_1;
+  huart1.Init.Parity = UART_PARITY_NONE;
+  huart1.Init.Mode = UART_MODE_TX_RX;
+  huart1.Init.OverSampling = UART_OVERSAMPLING_16;
+  huart1.gState = HAL_UART_STATE_READY;
+  huart1.RxState = HAL_UART_STATE_READY;
+  uart_tx_file = tx;
+  uart_tx_gen = 0U;
+  uart_rx_buf = NULL;
+}
+
+void UART_Host_Receive(const uint8_t *data, uint32_t len)
+{
+  if ((uart_rx_buf == NULL) || (huart1.RxState != HAL_UART_STATE_BUSY_RX))
+  {
+    return;
+  }
+  for (uint32_t i = 0U; i < len; i++)
+  {
+    uart_rx_buf[uart_rx_pos] = data[i];
+    uart_rx_pos = (uint16_t)((uart_rx_pos + 1U) % uart_rx_size);
+  }
+  uart_stats.rx_bytes += len;
+  HAL_UARTEx_RxEventCallback(&huart1, uart_rx_pos);
+}
+
+const UART_HostStatsTypeDef *UART_Host_Stats(void)
+{
+  return &uart_stats;
+}
+
+/* HAL_UART_* -------------------------------------------------------------- */
+
+uint32_t HAL_RCC_GetPCLK2Freq(void)
+{
+  /* APB2 undivided, SystemClock_Config() */
+  return SystemCoreClock;
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+  huart->gState = HAL_UART_STATE_READY;
+  huart->RxState = HAL_UART_STATE_READY;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Abort(UART_HandleTypeDef *huart)
+{
+  uart_tx_gen++;
+  huart->gState = HAL_UART_STATE_READY;
+  huart->RxState = HAL_UART_STATE_READY;
+  uart_stats.aborts++;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData,
+                                        uint16_t Size)
+{
+  uint64_t ns;
+
+  if (huart->gState != HAL_UART_STATE_READY)
+  {
+    uart_stats.busy++;
+    return HAL_BUSY;
+  }
+  if ((pData == NULL) || (Size == 0U))
+  {
+    return HAL_ERROR;
+  }
+  huart->gState = HAL_UART_STATE_BUSY_TX;
+  uart_stats.transfers++;
+  uart_stats.bytes += Size;
+  if (uart_tx_file != NULL)
+  {
+    fwrite(pData, 1U, Size, uart_tx_file);
+  }
+  ns = (uint64_t)Size * 10U * 1000000000ULL / huart->Init.BaudRate;
+  RtosSim_At(RtosSim_Now() + ns, DMA2_Stream7_IRQn, uart_tx_done, (void *)(uintptr_t)uart_tx_gen);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData,
+                                               uint16_t Size)
+{
+  if (huart->RxState != HAL_UART_STATE_READY)
+  {
+    return HAL_BUSY;
+  }
+  huart->RxState = HAL_UART_STATE_BUSY_RX;
+  huart->ReceptionType = HAL_UART_RECEPTION_TOIDLE;
+  uart_rx_buf = pData;
+  uart_rx_size = Size;
+  uart_rx_pos = 0U;
+  return HAL_OK;
+}
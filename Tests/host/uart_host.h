@@ -0,0 +1,34 @@
+/*
+ * Host stand-in for USART1 and its DMA streams (Core/Src/usart.c).
+ *
+ * HAL_UART_Transmit_DMA() takes the line for 10 bit times per byte at the
+ * configured baud rate and completes in the DMA2 stream 7 interrupt of
+ * the RTOS simulation, so uartlink.c sees the transmit complete callback
+ * when the board would. Reception goes into the buffer given to
+ * HAL_UARTEx_ReceiveToIdle_DMA() and ends with the idle line event.
+ */
+#ifndef UART_HOST_H
+#define UART_HOST_H
+
+#include <stdio.h>
+
+#include "usart.h"
+
+typedef struct
+{
+  uint32_t transfers;         /* HAL_UART_Transmit_DMA() accepted */
+  uint32_t busy;              /* ... refused with HAL_BUSY */
+  uint32_t bytes;             /* sent on the line */
+  uint32_t aborts;
+  uint32_t rx_bytes;
+} UART_HostStatsTypeDef;
+
+/* MX_USART1_UART_Init(); every byte sent goes to tx as well, NULL for none */
+void UART_Host_Init(FILE *tx);
+
+/* Bytes arriving from the other end, then the line goes idle; interrupt context */
+void UART_Host_Receive(const uint8_t *data, uint32_t len);
+
+const UART_HostStatsTypeDef *UART_Host_Stats(void);
+
+#endif /* UART_HOST_H */
@@ -0,0 +1,330 @@
+/*
+ * Host stand-in for USB_DEVICE/Target/usbd_conf.c, see usbd_ll_host.h.
+ */
+#include <string.h>
+
+#include "usbd_ll_host.h"
+
+#define HOST_HEAP_SIZE  16384U
+
+static USBD_HostEpTypeDef host_ep[32];
+static uint8_t host_heap[HOST_HEAP_SIZE] __attribute__((aligned(16)));
+static uint32_t host_heap_used;
+static uint32_t host_heap_failures;
+
+static uint8_t host_dev_desc[USB_LEN_DEV_DESC] =
+{
+  0x12, USB_DESC_TYPE_DEVICE, 0x00, 0x02, 0x00, 0x00, 0x00, USB_MAX_EP0_SIZE,
+  0x83, 0x04, 0x40, 0x57, 0x00, 0x02, 0x01, 0x02, 0x03, 0x01
+};
+
+static uint8_t *host_get_dev_desc(USBD_SpeedTypeDef speed, uint16_t *length)
+{
+  (void)speed;
+  *length = sizeof(host_dev_desc);
+  return host_dev_desc;
+}
+
+const USBD_DescriptorsTypeDef USBD_Host_Desc =
+{
+  .GetDeviceDescriptor = host_get_dev_desc,
+};
+
+USBD_HostEpTypeDef *USBD_Host_Ep(uint8_t ep_addr)
+{
+  return &host_ep[(ep_addr & 0x0FU) | (((ep_addr & 0x80U) != 0U) ? 0x10U : 0U)];
+}
+
+void USBD_Host_Reset(void)
+{
+  memset(host_ep, 0, sizeof(host_ep));
+  host_heap_used = 0U;
+  host_heap_failures = 0U;
+}
+
+void USBD_Host_Enumerate(USBD_HandleTypeDef *pdev)
+{
+  USBD_LL_SetSpeed(pdev, USBD_SPEED_FULL);
+  USBD_LL_Reset(pdev);
+  USBD_Host_Control(pdev, 0x00U, USB_REQ_SET_ADDRESS, 1U, 0U, 0U, NULL);
+  USBD_Host_Control(pdev, 0x00U, USB_REQ_SET_CONFIGURATION, 1U, 0U, 0U, NULL);
+}
+
+int USBD_Host_Control(USBD_HandleTypeDef *pdev, uint8_t bmRequest, uint8_t bRequest,
+                      uint16_t wValue, uint16_t wIndex, uint16_t wLength, uint8_t *data)
+{
+  USBD_HostEpTypeDef *in = USBD_Host_Ep(0x80U);
+  USBD_HostEpTypeDef *out = USBD_Host_Ep(0x00U);
+  uint8_t setup[8] =
+  {
+    bmRequest, bRequest, LOBYTE(wValue), HIBYTE(wValue),
+    LOBYTE(wIndex), HIBYTE(wIndex), LOBYTE(wLength), HIBYTE(wLength)
+  };
+  uint32_t moved = 0U;
+
+  in->stalled = 0U;
+  out->stalled = 0U;
+  in->armed = 0U;
+  out->armed = 0U;
+  USBD_LL_SetupStage(pdev, setup);
+  if ((in->stalled != 0U) && (out->stalled != 0U))
+  {
+    /* USBD_CtlError() */
+    return -1;
+  }
+
+  if ((bmRequest & 0x80U) != 0U)
+  {
+    /* data IN packets until the device stops sending, then status OUT */
+    while (in->armed != 0U)
+    {
+      /* the core hands over the whole remainder, the PCD sends one packet */
+      uint32_t n = (in->len > USB_MAX_EP0_SIZE) ? USB_MAX_EP0_SIZE : in->len;
+
+      if ((data != NULL) && (moved + n <= wLength))
+      {
+        memcpy(&data[moved], in->buf, n);
+      }
+      moved += n;
+      in->armed = 0U;
+      USBD_LL_DataInStage(pdev, 0U, in->buf);
+      if (n < USB_MAX_EP0_SIZE)
+      {
+        break;
+      }
+    }
+    /* the core stalls EP0 IN after the last packet, against extra IN tokens */
+    out->armed = 0U;
+    USBD_LL_DataOutStage(pdev, 0U, NULL);
+  }
+  else
+  {
+    /* data OUT packets into whatever the device armed, then status IN */
+    while ((moved < wLength) && (out->armed != 0U) && (out->stalled == 0U))
+    {
+      uint32_t n = wLength - moved;
+
+      if (n > USB_MAX_EP0_SIZE)
+      {
+        n = USB_MAX_EP0_SIZE;
+      }
+      if ((out->buf != NULL) && (data != NULL))
+      {
+        memcpy(out->buf, &data[moved], n);
+      }
+      moved += n;
+      out->rx_size = n;
+      out->armed = 0U;
+      USBD_LL_DataOutStage(pdev, 0U, out->buf);
+    }
+    if ((in->stalled != 0U) || (out->stalled != 0U) || (moved < wLength))
+    {
+      return -1;
+    }
+    if (in->armed != 0U)
+    {
+      in->armed = 0U;
+      USBD_LL_DataInStage(pdev, 0U, NULL);
+    }
+  }
+
+  return (int)moved;
+}
+
+int USBD_Host_Out(USBD_HandleTypeDef *pdev, uint8_t ep_addr, const uint8_t *data, uint32_t len)
+{
+  USBD_HostEpTypeDef *ep = USBD_Host_Ep(ep_addr);
+
+  if ((ep->open == 0U) || (ep->armed == 0U) || (ep->stalled != 0U))
+  {
+    return -1;
+  }
+  if (len > ep->len)
+  {
+    len = ep->len;
+  }
+  memcpy(ep->buf, data, len);
+  ep->rx_size = len;
+  ep->armed = 0U;
+  USBD_LL_DataOutStage(pdev, ep_addr & 0x7FU, ep->buf);
+  return (int)len;
+}
+
+int USBD_Host_In(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t *data, uint32_t max)
+{
+  USBD_HostEpTypeDef *ep = USBD_Host_Ep(ep_addr | 0x80U);
+  uint32_t n = ep->len;
+
+  if ((ep->open == 0U) || (ep->armed == 0U))
+  {
+    return -1;
+  }
+  if (n > max)
+  {
+    n = max;
+  }
+  if ((data != NULL) && (ep->buf != NULL))
+  {
+    memcpy(data, ep->buf, n);
+  }
+  ep->armed = 0U;
+  USBD_LL_DataInStage(pdev, ep_addr & 0x7FU, ep->buf);
+  return (int)n;
+}
+
+uint32_t USBD_Host_HeapUsed(void)
+{
+  return host_heap_used;
+}
+
+/* USBD_LL_* --------------------------------------------------------------- */
+
+USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
+{
+  (void)pdev;
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_DeInit(USBD_HandleTypeDef *pdev)
+{
+  (void)pdev;
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_Start(USBD_HandleTypeDef *pdev)
+{
+  (void)pdev;
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_Stop(USBD_HandleTypeDef *pdev)
+{
+  (void)pdev;
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_OpenEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr,
+                                  uint8_t ep_type, uint16_t ep_mps)
+{
+  USBD_HostEpTypeDef *ep = USBD_Host_Ep(ep_addr);
+
+  (void)pdev;
+  ep->open = 1U;
+  ep->type = ep_type;
+  ep->mps = ep_mps;
+  ep->stalled = 0U;
+  ep->armed = 0U;
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_CloseEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  USBD_HostEpTypeDef *ep = USBD_Host_Ep(ep_addr);
+
+  (void)pdev;
+  ep->open = 0U;
+  ep->armed = 0U;
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_FlushEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  (void)pdev;
+  USBD_Host_Ep(ep_addr)->armed = 0U;
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_StallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  (void)pdev;
+  USBD_Host_Ep(ep_addr)->stalled = 1U;
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_ClearStallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  (void)pdev;
+  USBD_Host_Ep(ep_addr)->stalled = 0U;
+  return USBD_OK;
+}
+
+uint8_t USBD_LL_IsStallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  (void)pdev;
+  return USBD_Host_Ep(ep_addr)->stalled;
+}
+
+USBD_StatusTypeDef USBD_LL_SetUSBAddress(USBD_HandleTypeDef *pdev, uint8_t dev_addr)
+{
+  (void)pdev;
+  (void)dev_addr;
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_Transmit(USBD_HandleTypeDef *pdev, uint8_t ep_addr,
+                                    uint8_t *pbuf, uint32_t size)
+{
+  USBD_HostEpTypeDef *ep = USBD_Host_Ep(ep_addr | 0x80U);
+
+  (void)pdev;
+  ep->buf = pbuf;
+  ep->len = size;
+  ep->armed = 1U;
+  ep->transfers++;
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_PrepareReceive(USBD_HandleTypeDef *pdev, uint8_t ep_addr,
+                                          uint8_t *pbuf, uint32_t size)
+{
+  USBD_HostEpTypeDef *ep = USBD_Host_Ep(ep_addr & 0x7FU);
+
+  (void)pdev;
+  ep->buf = pbuf;
+  ep->len = size;
+  ep->armed = 1U;
+  ep->transfers++;
+  return USBD_OK;
+}
+
+uint32_t USBD_LL_GetRxDataSize(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  (void)pdev;
+  return USBD_Host_Ep(ep_addr & 0x7FU)->rx_size;
+}
+
+void USBD_LL_Delay(uint32_t Delay)
+{
+  (void)Delay;
+}
+
+/* Bump allocator in place of the block pool, enough for the class handles */
+void *USBD_static_malloc(uint32_t size)
+{
+  void *p;
+
+  size = (size + 15U) & ~15U;
+  if (host_heap_used + size > HOST_HEAP_SIZE)
+  {
+    host_heap_failures++;
+    return NULL;
+  }
+  p = &host_heap[host_heap_used];
+  host_heap_used += size;
+  memset(p, 0, size);
+  return p;
+}
+
+void USBD_static_free(void *p)
+{
+  (void)p;
+}
+
+/* nothing is freed, so the high-water mark is what is in use */
+void USBD_static_pool_stats(USBD_PoolStatsTypeDef *stats)
+{
+  stats->size = HOST_HEAP_SIZE;
+  stats->used = host_heap_used;
+  stats->high_water = host_heap_used;
+  stats->failures = host_heap_failures;
+}
@@ -0,0 +1,53 @@
+/*
+ * Host stand-in for USB_DEVICE/Target/usbd_conf.c.
+ *
+ * Implements the USBD_LL_* layer the ST device library calls and records
+ * what the classes ask of the controller, so the unmodified core and class
+ * sources run on the build machine. The USBD_Host_* calls play the part of
+ * the PCD interrupt handler: they feed setup packets and endpoint data into
+ * the core the way HAL_PCD_*Callback would.
+ */
+#ifndef USBD_LL_HOST_H
+#define USBD_LL_HOST_H
+
+#include "usbd_core.h"
+
+typedef struct
+{
+  uint8_t  open;
+  uint8_t  type;
+  uint16_t mps;
+  uint8_t  stalled;
+  uint8_t  armed;             /* IN: Transmit pending, OUT: PrepareReceive pending */
+  uint8_t *buf;
+  uint32_t len;
+  uint32_t rx_size;           /* what USBD_LL_GetRxDataSize() reports */
+  uint32_t transfers;         /* Transmit/PrepareReceive calls so far */
+} USBD_HostEpTypeDef;
+
+extern const USBD_DescriptorsTypeDef USBD_Host_Desc;
+
+/* ep_addr with the direction bit, e.g. 0x01 or 0x81 */
+USBD_HostEpTypeDef *USBD_Host_Ep(uint8_t ep_addr);
+
+/* Forget every endpoint and heap allocation; call before USBD_Init() */
+void USBD_Host_Reset(void);
+
+/* Bus reset, SET_ADDRESS and SET_CONFIGURATION(1) */
+void USBD_Host_Enumerate(USBD_HandleTypeDef *pdev);
+
+/* One complete control transfer. For IN requests data receives the reply;
+   returns the number of bytes moved, or -1 when the device stalled. */
+int USBD_Host_Control(USBD_HandleTypeDef *pdev, uint8_t bmRequest, uint8_t bRequest,
+                      uint16_t wValue, uint16_t wIndex, uint16_t wLength, uint8_t *data);
+
+/* Deliver an OUT packet; -1 when the endpoint was not armed (NAK/drop) */
+int USBD_Host_Out(USBD_HandleTypeDef *pdev, uint8_t ep_addr, const uint8_t *data, uint32_t len);
+
+/* Complete a pending IN transfer; returns its length, -1 when none */
+int USBD_Host_In(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t *data, uint32_t max);
+
+/* Bytes currently taken from the USBD_static_malloc() arena */
+uint32_t USBD_Host_HeapUsed(void);
+
+#endif /* USBD_LL_HOST_H */
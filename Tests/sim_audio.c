@@ -0,0 +1,181 @@
+/*
+ * USB speaker simulation from the command line, see host/audio_sim.h.
+ *
+ *   build/sim_audio [-t s] [-p ppm] [-j us] [-d prob] [-b every_ms:len]
+ *                   [-n bytes] [-s seed] [-c timeline.csv]
+ *   build/sim_audio -r events|- [-p ppm] [-c timeline.csv]
+ *
+ *   -t  simulated time in seconds (10)
+ *   -p  I2S clock error against the USB frame clock in ppm (0; the board's
+ *       PLLI2S gives 48.007 kHz, +146 ppm)
+ *   -j  packet delivery jitter, uniform +-us (0)
+ *   -d  probability that a frame's packet is lost (0)
+ *   -b  every N ms the host stalls for len frames, then sends the backlog
+ *   -n  bytes per packet (AUDIO_OUT_PACKET)
+ *   -c  write the per-ms occupancy timeline as CSV
+ *   -r  replay a recorded host instead of the synthetic one
+ *
+ * The replay input has one host action per line, times in microseconds
+ * from the start of the recording (Tools/usbmon_replay.py writes it):
+ *
+ *   <t_us> out <len>                                   isochronous OUT packet
+ *   <t_us> ctrl <bm> <bReq> <wValue> <wIndex> <wLength> [data bytes]
+ *
+ * numbers in C syntax (0x.. for hex). Lines starting with # are skipped.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "audio_sim.h"
+
+/* the simulation starts at 0 with enumeration; the recording 1 ms later */
+#define REPLAY_START_NS  1000000ULL
+
+static int replay(FILE *in)
+{
+  char line[512];
+  unsigned lineno = 0U;
+  uint64_t t_ns = REPLAY_START_NS;
+
+  while (fgets(line, sizeof(line), in) != NULL)
+  {
+    unsigned long long t_us;
+    char kind[8];
+    int used = 0;
+
+    lineno++;
+    if ((line[0] == '#') || (line[0] == '\n'))
+    {
+      continue;
+    }
+    if (sscanf(line, "%llu %7s %n", &t_us, kind, &used) < 2)
+    {
+      fprintf(stderr, "line %u: cannot parse\n", lineno);
+      return 1;
+    }
+    t_ns = REPLAY_START_NS + t_us * 1000ULL;
+
+    if (strcmp(kind, "out") == 0)
+    {
+      (void)AudioSim_Packet(t_ns, (uint32_t)strtoul(&line[used], NULL, 0));
+    }
+    else if (strcmp(kind, "ctrl") == 0)
+    {
+      unsigned long f[5];
+      uint8_t data[64] = {0};
+      char *p = &line[used];
+      int ret;
+
+      for (uint32_t i = 0U; i < 5U; i++)
+      {
+        f[i] = strtoul(p, &p, 0);
+      }
+      for (uint32_t i = 0U; i < sizeof(data); i++)
+      {
+        char *q;
+        unsigned long b = strtoul(p, &q, 0);
+
+        if (q == p)
+        {
+          break;
+        }
+        data[i] = (uint8_t)b;
+        p = q;
+      }
+      ret = AudioSim_Control(t_ns, (uint8_t)f[0], (uint8_t)f[1], (uint16_t)f[2], (uint16_t)f[3],
+                             (uint16_t)((f[4] > sizeof(data)) ? sizeof(data) : f[4]), data);
+      printf("%12.3f ms  ctrl %02lx %02lx %04lx %04lx %lu -> %s\n", (double)t_us / 1000.0,
+             f[0], f[1], f[2], f[3], f[4], (ret < 0) ? "STALL" : "ok");
+    }
+    else
+    {
+      fprintf(stderr, "line %u: unknown event '%s'\n", lineno, kind);
+      return 1;
+    }
+  }
+  AudioSim_AdvanceTo(t_ns + 1000000ULL);
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  AudioSim_ConfigTypeDef cfg = {0};
+  AudioSim_HostTypeDef host = {0};
+  const char *csv = NULL;
+  const char *events = NULL;
+  int opt;
+
+  host.seconds = 10.0;
+  while ((opt = getopt(argc, argv, "t:p:j:d:b:n:s:c:r:")) != -1)
+  {
+    switch (opt)
+    {
+      case 't': host.seconds = atof(optarg); break;
+      case 'p': cfg.ppm = atof(optarg); break;
+      case 'j': host.jitter_us = (uint32_t)atoi(optarg); break;
+      case 'd': host.drop = atof(optarg); break;
+      case 'b':
+        if (sscanf(optarg, "%u:%u", &host.burst_every_ms, &host.burst_len) != 2)
+        {
+          fprintf(stderr, "-b wants every_ms:len\n");
+          return 2;
+        }
+        break;
+      case 'n': host.packet = (uint32_t)atoi(optarg); break;
+      case 's': host.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'c': csv = optarg; break;
+      case 'r': events = optarg; break;
+      default:
+        fprintf(stderr, "usage: %s [-t s] [-p ppm] [-j us] [-d prob] [-b every_ms:len] "
+                "[-n bytes] [-s seed] [-c csv] [-r events|-]\n", argv[0]);
+        return 2;
+    }
+  }
+
+  if (csv != NULL)
+  {
+    cfg.csv = fopen(csv, "w");
+    if (cfg.csv == NULL)
+    {
+      perror(csv);
+      return 1;
+    }
+  }
+
+  AudioSim_Begin(&cfg);
+  if (events != NULL)
+  {
+    FILE *in = (strcmp(events, "-") == 0) ? stdin : fopen(events, "r");
+    int ret;
+
+    if (in == NULL)
+    {
+      perror(events);
+      return 1;
+    }
+    ret = replay(in);
+    if (in != stdin)
+    {
+      fclose(in);
+    }
+    if (ret != 0)
+    {
+      return ret;
+    }
+    printf("sim_audio: replay of %s, %.0f ppm\n", events, cfg.ppm);
+  }
+  else
+  {
+    AudioSim_RunHost(&host);
+    printf("sim_audio: %.0f ppm, jitter +-%u us, drop %.4f, burst %u:%u\n", cfg.ppm,
+           host.jitter_us, host.drop, host.burst_every_ms, host.burst_len);
+  }
+  AudioSim_Report(stdout);
+
+  if (cfg.csv != NULL)
+  {
+    fclose(cfg.csv);
+  }
+  return 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * The firmware's task set on the POSIX port of FreeRTOS, see host/rtos_sim.h.
+ *
+ *   build/sim_rtos [-t s] [-p ppm] [-n] [-k ms]... [-e ms:quarters]...
+ *                  [-o console.txt] [-T trace.bin] [-u uart.bin]
+ *
+ *   -t  simulated time in seconds (5)
+ *   -p  I2S clock error against the USB frame clock in ppm (0)
+ *   -n  the host enumerates but does not stream audio
+ *   -k  press KEY (mute) at ms for 100 ms
+ *   -e  turn the encoder at ms by quarter steps, 1 ms apart (CW positive)
+ *   -o  RTT channel 0 (the firmware's console) to a file, - for stdout
+ *   -T  RTT channel 1 (trace.h records) to a file
+ *   -u  what USART1 sends to a file
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "rtos_sim.h"
+
+#define KEY_PRESS_NS  (100ULL * RTOS_SIM_MS)
+
+static FILE *open_out(const char *path)
+{
+  FILE *f;
+
+  if (strcmp(path, "-") == 0)
+  {
+    return stdout;
+  }
+  f = fopen(path, "wb");
+  if (f == NULL)
+  {
+    perror(path);
+    exit(1);
+  }
+  return f;
+}
+
+int main(int argc, char **argv)
+{
+  RtosSim_ConfigTypeDef cfg = {0};
+  const RtosSim_StatsTypeDef *s = RtosSim_Stats();
+  double seconds = 5.0;
+  int opt;
+
+  /* inputs are scheduled after RtosSim_Init(), so collect them first */
+  double key_ms[16];
+  uint32_t keys = 0U;
+  double enc_ms[16];
+  int32_t enc_quarters[16];
+  uint32_t turns = 0U;
+
+  while ((opt = getopt(argc, argv, "t:p:nk:e:o:T:u:")) != -1)
+  {
+    switch (opt)
+    {
+      case 't': seconds = atof(optarg); break;
+      case 'p': cfg.ppm = atof(optarg); break;
+      case 'n': cfg.no_stream = 1U; break;
+      case 'k':
+        if (keys < sizeof(key_ms) / sizeof(key_ms[0]))
+        {
+          key_ms[keys++] = atof(optarg);
+        }
+        break;
+      case 'e':
+        if ((turns < sizeof(enc_ms) / sizeof(enc_ms[0])) &&
+            (sscanf(optarg, "%lf:%d", &enc_ms[turns], &enc_quarters[turns]) == 2))
+        {
+          turns++;
+          break;
+        }
+        fprintf(stderr, "-e wants ms:quarters\n");
+        return 2;
+      case 'o': cfg.console = open_out(optarg); break;
+      case 'T': cfg.trace = open_out(optarg); break;
+      case 'u': cfg.uart = open_out(optarg); break;
+      default:
+        fprintf(stderr, "usage: %s [-t s] [-p ppm] [-n] [-k ms]... [-e ms:quarters]... "
+                "[-o console] [-T trace] [-u uart]\n", argv[0]);
+        return 2;
+    }
+  }
+
+  RtosSim_Init(&cfg);
+  for (uint32_t i = 0U; i < keys; i++)
+  {
+    uint64_t t = (uint64_t)(key_ms[i] * 1e6);
+
+    RtosSim_Pin(t, KEY_GPIO_Port, KEY_Pin, GPIO_PIN_RESET);
+    RtosSim_Pin(t + KEY_PRESS_NS, KEY_GPIO_Port, KEY_Pin, GPIO_PIN_SET);
+  }
+  for (uint32_t i = 0U; i < turns; i++)
+  {
+    RtosSim_Turn((uint64_t)(enc_ms[i] * 1e6), enc_quarters[i], RTOS_SIM_MS);
+  }
+  RtosSim_Run((uint64_t)(seconds * 1e9));
+
+  printf("sim_rtos: %.0f ppm%s\n", cfg.ppm, (cfg.no_stream != 0U) ? ", no stream" : "");
+  RtosSim_Report(stdout);
+  for (uint32_t i = 0U; (i < s->hid_reports) && (i < RTOS_SIM_HID_LOG); i++)
+  {
+    printf("  HID %10.3f ms  %02x\n", (double)s->hid[i].t_ns / 1e6, s->hid[i].keys);
+  }
+  fflush(NULL);
+  /* the task threads are still blocked inside the kernel */
+  _exit(0);
+}
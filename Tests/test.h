@@ -0,0 +1,63 @@
+/*
+ * Minimal check macros for the host tests.
+ *
+ * A failed CHECK prints the location and carries on, so one run reports
+ * every broken case; main() returns test_summary() as the exit code.
+ */
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+#include <time.h>
+
+static int test_checks;
+static int test_failed;
+
+#define CHECK(cond)                                                         \
+  do {                                                                      \
+    test_checks++;                                                          \
+    if (!(cond)) {                                                          \
+      test_failed++;                                                        \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);       \
+    }                                                                       \
+  } while (0)
+
+#define CHECK_EQ(a, b)                                                      \
+  do {                                                                      \
+    long long a_ = (long long)(a), b_ = (long long)(b);                     \
+    test_checks++;                                                          \
+    if (a_ != b_) {                                                         \
+      test_failed++;                                                        \
+      printf("%s:%d: %s == %s failed: %lld != %lld\n",                      \
+             __FILE__, __LINE__, #a, #b, a_, b_);                           \
+    }                                                                       \
+  } while (0)
+
+/* CHECK with a printf-style context line, for table and replay driven tests */
+#define CHECK_MSG(cond, ...)                                                \
+  do {                                                                      \
+    test_checks++;                                                          \
+    if (!(cond)) {                                                          \
+      test_failed++;                                                        \
+      printf("%s:%d: CHECK(%s) failed: ", __FILE__, __LINE__, #cond);       \
+      printf(__VA_ARGS__);                                                  \
+      printf("\n");                                                         \
+    }                                                                       \
+  } while (0)
+
+static inline int test_summary(const char *name)
+{
+  printf("%s: %d checks, %d failed\n", name, test_checks, test_failed);
+  return test_failed != 0;
+}
+
+/* Monotonic nanoseconds for the benchmarks */
+static inline double test_now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+#endif /* TEST_H */
@@ -0,0 +1,175 @@
+/*
+ * USB speaker path under a virtual host and DMA, see host/audio_sim.h.
+ *
+ * These pin down what the buffering does today, so a change to it shows up
+ * as a changed number here rather than on the bench. Each case prints the
+ * full report; the checks cover the parts that must not move.
+ */
+#include "test.h"
+#include "audio_sim.h"
+
+static void run(const char *name, double ppm, const AudioSim_HostTypeDef *host)
+{
+  AudioSim_ConfigTypeDef cfg = {ppm, NULL};
+
+  printf("%s\n", name);
+  AudioSim_Begin(&cfg);
+  AudioSim_RunHost(host);
+  AudioSim_Report(stdout);
+}
+
+/* a perfect host and clock: the stream starts after one lap and never breaks */
+static void test_clean(void)
+{
+  AudioSim_HostTypeDef host = {.seconds = 10.0};
+  const AudioSim_StatsTypeDef *s = AudioSim_Stats();
+
+  run("clean, 0 ppm", 0.0, &host);
+  CHECK_EQ(s->packets, 10000);
+  CHECK_EQ(s->naks, 0);
+  CHECK_EQ(s->clipped, 0);
+  CHECK_EQ(s->overruns + s->underruns, 0);
+  CHECK_EQ(I2S_Host_Stats()->starts, 1);
+  /* START at the first wrap, 80 ms in; from then on 79 ms sit ahead of the read head */
+  CHECK(s->frames_played >= (10000 - AUDIO_OUT_PACKET_NUM - 1) * 48ULL);
+  CHECK(s->occ_min_ms >= AUDIO_OUT_PACKET_NUM - 2);
+  CHECK(s->occ_max_ms <= AUDIO_OUT_PACKET_NUM);
+}
+
+/*
+ * The board's PLLI2S runs 146 ppm fast. The read head pulls away from the
+ * writer by 0.15 ms per second, so the ring drains but nothing breaks in a
+ * minute, and the pointers never get close enough to ask for a correction:
+ * the AUDIO_CMD_PLAY on every full-transfer callback leaves the DMA alone.
+ */
+static void test_board_clock(void)
+{
+  AudioSim_HostTypeDef host = {.seconds = 60.0};
+  const AudioSim_StatsTypeDef *s = AudioSim_Stats();
+
+  run("board clock, +146 ppm", 146.0, &host);
+  CHECK_EQ(s->overruns + s->underruns, 0);
+  CHECK(s->occ_min_ms < s->occ_max_ms - 8.0);
+  CHECK_EQ(I2S_Host_Stats()->starts, 1);
+  CHECK_EQ(I2S_Host_Stats()->busy, 0);
+}
+
+/*
+ * START comes with the packet that completes the first lap, and the DMA
+ * reaches each packet's slot just as the next lap's packet lands there:
+ * the writer trails the read head by less than a stereo frame. A slow I2S
+ * clock lets it overtake after 20.8 us / 146 ppm = 0.14 s. From then on
+ * USBD_AUDIO_Sync asks for a lap two stereo frames off every few laps, and
+ * AudioCard_Resync() restarts the DMA with it and back: the ring stays full,
+ * but it is held right at the point where the two heads cross.
+ */
+static void test_slow_clock(void)
+{
+  AudioSim_HostTypeDef host = {.seconds = 30.0};
+  const AudioSim_StatsTypeDef *s = AudioSim_Stats();
+
+  run("slow clock, -146 ppm", -146.0, &host);
+  CHECK(s->overruns > 0U);
+  CHECK(s->first_glitch_ns < 10000000000ULL);
+  CHECK(s->resyncs > 0U);
+  CHECK_EQ(I2S_Host_Stats()->busy, 0);
+  CHECK_EQ(I2S_Host_Stats()->starts, 1U + 2U * s->resyncs);
+  CHECK(s->occ_min_ms >= AUDIO_OUT_PACKET_NUM - 2);
+}
+
+/* every lost packet costs exactly one packet of depth, and no continuity */
+static void test_drops(void)
+{
+  AudioSim_HostTypeDef host = {.seconds = 10.0, .drop = 0.002, .seed = 3U};
+  const AudioSim_StatsTypeDef *s = AudioSim_Stats();
+  double lost;
+
+  run("0.2% packet loss, 0 ppm", 0.0, &host);
+  lost = 10000.0 - s->packets;
+  CHECK(lost > 5.0);
+  CHECK_EQ(s->overruns + s->underruns, 0);
+  CHECK(s->occ_min_ms <= AUDIO_OUT_PACKET_NUM - lost);
+}
+
+/* a stalled host that catches up fills the gap it left */
+static void test_bursts(void)
+{
+  AudioSim_HostTypeDef host = {.seconds = 10.0, .burst_every_ms = 500U, .burst_len = 20U};
+  const AudioSim_StatsTypeDef *s = AudioSim_Stats();
+
+  run("20 ms host stall every 500 ms, 0 ppm", 0.0, &host);
+  CHECK_EQ(s->naks, 0);
+  CHECK_EQ(s->overruns + s->underruns, 0);
+  CHECK(s->occ_min_ms < AUDIO_OUT_PACKET_NUM - 19);
+}
+
+/* delivery jitter: for the same reason any packet that comes in early
+   overtakes the read head */
+static void test_jitter(void)
+{
+  AudioSim_HostTypeDef host = {.seconds = 10.0, .jitter_us = 300U, .seed = 7U};
+  const AudioSim_StatsTypeDef *s = AudioSim_Stats();
+
+  run("+-300 us delivery jitter, 0 ppm", 0.0, &host);
+  CHECK_EQ(s->packets, 10000);
+  printf("  -> %u glitches in 10 s\n", s->overruns + s->underruns);
+}
+
+/*
+ * The feature unit's mute: SET_CUR pauses the DMA and GET_CUR reads it
+ * back; unmuting resumes. Mute stops the line, not the stream, so packets
+ * keep coming in.
+ */
+static void test_mute(void)
+{
+  AudioSim_HostTypeDef host = {.seconds = 1.0};
+  const uint16_t mute_ctl = (uint16_t)(AUDIO_OUT_STREAMING_CTRL << 8);
+  uint64_t t = 1000U * 1000000ULL;
+  uint8_t on = 1U;
+  uint8_t off = 0U;
+  uint8_t cur = 0xFFU;
+
+  run("mute, 0 ppm", 0.0, &host);
+  CHECK(I2S_Host_Running());
+  CHECK_EQ(AudioSim_Control(t, 0xA1U, AUDIO_REQ_GET_CUR, 0x0100U, mute_ctl, 1U, &cur), 1);
+  CHECK_EQ(cur, 0);
+
+  CHECK_EQ(AudioSim_Control(t + 1000000U, 0x21U, AUDIO_REQ_SET_CUR, 0x0100U, mute_ctl, 1U, &on),
+           1);
+  CHECK_EQ(I2S_Host_Stats()->pauses, 1);
+  CHECK_EQ(AudioSim_Control(t + 2000000U, 0xA1U, AUDIO_REQ_GET_CUR, 0x0100U, mute_ctl, 1U, &cur),
+           1);
+  CHECK_EQ(cur, 1);
+  CHECK(AudioSim_Packet(t + 3000000U, AUDIO_OUT_PACKET) >= 0);
+
+  CHECK_EQ(AudioSim_Control(t + 4000000U, 0x21U, AUDIO_REQ_SET_CUR, 0x0100U, mute_ctl, 1U, &off),
+           1);
+  CHECK_EQ(I2S_Host_Stats()->resumes, 1);
+  CHECK_EQ(AudioSim_Control(t + 5000000U, 0xA1U, AUDIO_REQ_GET_CUR, 0x0100U, mute_ctl, 1U, &cur),
+           1);
+  CHECK_EQ(cur, 0);
+}
+
+/* the drift correction rule on its own */
+static void test_sync_size(void)
+{
+  const uint32_t half = AUDIO_TOTAL_BUF_SIZE / 2U;
+
+  CHECK_EQ(USBD_AUDIO_SyncSize(half, 0U), half);
+  CHECK_EQ(USBD_AUDIO_SyncSize(1000U, 1000U - AUDIO_OUT_PACKET + 4U), half + 4U);
+  CHECK_EQ(USBD_AUDIO_SyncSize(1000U, 1000U + 4U), half - 4U);
+  CHECK_EQ(USBD_AUDIO_SyncSize(0U, AUDIO_TOTAL_BUF_SIZE - 4U), half + 4U);
+}
+
+int main(void)
+{
+  test_clean();
+  test_board_clock();
+  test_slow_clock();
+  test_drops();
+  test_bursts();
+  test_jitter();
+  test_mute();
+  test_sync_size();
+  return test_summary("audio");
+}
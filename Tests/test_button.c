@@ -0,0 +1,170 @@
+/*
+ * Button debouncer and gesture replay (Core/Src/button.c).
+ *
+ * Each file in data/button is a waveform as a logic analyzer exports it:
+ * "t_us level" edges of the pull-up input (1 = released), "end ms" and the
+ * expected gestures "expect EVENT from_ms to_ms" in order. The line is
+ * sampled every 1 ms like TIM5 does and every event Button_Process reports
+ * must match the next expectation, inside its window. Events of one tick
+ * are taken in the order input.c queues them.
+ */
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "button.h"
+
+#define DATA_DIR   "data/button/"
+#define MAX_EDGES  2048
+#define MAX_EXPECT 32
+
+typedef struct {
+  uint8_t bit;
+  const char *name;
+} EventName;
+
+/* input_evt_map order */
+static const EventName event_names[] = {
+  {BUTTON_EVT_PRESS, "PRESS"},
+  {BUTTON_EVT_DOUBLE, "DOUBLE"},
+  {BUTTON_EVT_LONG, "LONG"},
+  {BUTTON_EVT_REPEAT, "REPEAT"},
+  {BUTTON_EVT_RELEASE, "RELEASE"},
+};
+
+typedef struct {
+  char name[16];
+  uint32_t from_ms;
+  uint32_t to_ms;
+} Expect;
+
+typedef struct {
+  uint32_t t_us[MAX_EDGES];
+  uint8_t level[MAX_EDGES];
+  uint32_t n;
+  uint32_t end_ms;
+  Expect expect[MAX_EXPECT];
+  uint32_t nexpect;
+
+  /* replay state */
+  uint32_t now_us;
+  uint32_t cursor;
+  bool line;
+} Wave;
+
+static Wave wave;
+
+static bool wave_read(void *user_data)
+{
+  Wave *w = (Wave *)user_data;
+
+  while ((w->cursor < w->n) && (w->t_us[w->cursor] <= w->now_us)) {
+    w->line = w->level[w->cursor++] != 0U;
+  }
+  return w->line;
+}
+
+static int wave_load(Wave *w, const char *path)
+{
+  FILE *f = fopen(path, "r");
+  char line[128];
+
+  if (f == NULL) {
+    return -1;
+  }
+  memset(w, 0, sizeof(*w));
+  w->line = true;
+  while (fgets(line, sizeof(line), f) != NULL) {
+    unsigned a, b;
+    char name[16];
+
+    if ((line[0] == '#') || (line[0] == '\n')) {
+      continue;
+    }
+    if (sscanf(line, "end %u", &a) == 1) {
+      w->end_ms = a;
+    } else if (sscanf(line, "expect %15s %u %u", name, &a, &b) == 3) {
+      if (w->nexpect < MAX_EXPECT) {
+        Expect *e = &w->expect[w->nexpect++];
+        strcpy(e->name, name);
+        e->from_ms = a;
+        e->to_ms = b;
+      }
+    } else if ((sscanf(line, "%u %u", &a, &b) == 2) && (w->n < MAX_EDGES)) {
+      w->t_us[w->n] = a;
+      w->level[w->n] = (uint8_t)b;
+      w->n++;
+    }
+  }
+  fclose(f);
+  return 0;
+}
+
+static void replay(const char *file)
+{
+  char path[256];
+  Button_HandleTypeDef btn;
+  uint32_t next = 0U;
+
+  snprintf(path, sizeof(path), DATA_DIR "%s", file);
+  CHECK_MSG(wave_load(&wave, path) == 0, "%s: cannot read", path);
+  CHECK_MSG(wave.end_ms != 0U, "%s: no end line", file);
+
+  Button_Init(&btn, wave_read, &wave, false);
+  for (uint32_t ms = 0U; ms <= wave.end_ms; ms++) {
+    uint8_t events;
+
+    wave.now_us = ms * 1000U;
+    events = Button_Process(&btn);
+    for (uint32_t i = 0U; i < sizeof(event_names) / sizeof(event_names[0]); i++) {
+      const Expect *e = &wave.expect[next];
+
+      if ((events & event_names[i].bit) == 0U) {
+        continue;
+      }
+      if (next >= wave.nexpect) {
+        CHECK_MSG(0, "%s: unexpected %s at %u ms", file, event_names[i].name, ms);
+        continue;
+      }
+      CHECK_MSG(strcmp(e->name, event_names[i].name) == 0,
+                "%s: %s at %u ms, expected %s", file, event_names[i].name, ms, e->name);
+      CHECK_MSG((ms >= e->from_ms) && (ms <= e->to_ms),
+                "%s: %s at %u ms, expected %u..%u ms", file, e->name, ms, e->from_ms, e->to_ms);
+      next++;
+    }
+  }
+  CHECK_MSG(next == wave.nexpect, "%s: %u of %u events seen", file, next, wave.nexpect);
+}
+
+static int name_cmp(const void *a, const void *b)
+{
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+int main(void)
+{
+  DIR *d = opendir(DATA_DIR);
+  struct dirent *de;
+  char *files[64];
+  uint32_t n = 0U;
+
+  CHECK_MSG(d != NULL, "run from Tests/, %s not found", DATA_DIR);
+  while ((d != NULL) && ((de = readdir(d)) != NULL) && (n < 64U)) {
+    size_t len = strlen(de->d_name);
+    if ((len > 4U) && (strcmp(&de->d_name[len - 4U], ".txt") == 0)) {
+      files[n++] = strdup(de->d_name);
+    }
+  }
+  if (d != NULL) {
+    closedir(d);
+  }
+  CHECK(n > 0U);
+  qsort(files, n, sizeof(files[0]), name_cmp);
+  for (uint32_t i = 0U; i < n; i++) {
+    replay(files[i]);
+    free(files[i]);
+  }
+  printf("button: %u waveforms\n", n);
+  return test_summary("button");
+}
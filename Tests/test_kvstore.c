@@ -0,0 +1,232 @@
+/*
+ * Log-structured key-value store (Core/Src/kvstore.c) on two RAM sectors.
+ *
+ * The flash model only clears bits, one 32-bit word at a time, like the
+ * F411 programs with PSIZE x32. It can fail one program call part way
+ * (a write error: the call returns false, later calls work) or cut the
+ * power at a word (nothing after it is written). After either, a fresh
+ * KV_Init() over the same sectors must read back every value that was
+ * acknowledged, and for the write that was cut, the old or the new value.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "kvstore.h"
+
+#define SECTOR_SIZE 1024U
+#define KEYS        4U
+#define RANDOM_OPS  20000U
+#define CUT_WRITES  60U
+
+static uint8_t sectors[2][SECTOR_SIZE];
+static uint32_t erases[2];
+static int32_t power_words = -1;   /* words left before the power goes, -1: no cut */
+static int32_t fail_words = -1;    /* words the next program call writes before it fails */
+static uint32_t misaligned;        /* program calls the F411 would refuse */
+
+static bool flash_erase(void *ctx, uint8_t sector)
+{
+  (void)ctx;
+  if (power_words == 0) {
+    return false;
+  }
+  memset(sectors[sector], 0xFF, SECTOR_SIZE);
+  erases[sector]++;
+  return true;
+}
+
+static bool flash_program(void *ctx, const uint8_t *dst, const void *src, uint32_t len)
+{
+  const uint8_t *s = src;
+  uint8_t *d = (uint8_t *)dst;
+
+  (void)ctx;
+  misaligned += (((uintptr_t)dst & 3U) != 0U) || ((len & 3U) != 0U);
+  for (uint32_t i = 0U; i < len; i += 4U) {
+    if ((power_words == 0) || (fail_words == 0)) {
+      fail_words = -1;
+      return false;
+    }
+    if (power_words > 0) {
+      power_words--;
+    }
+    if (fail_words > 0) {
+      fail_words--;
+    }
+    for (uint32_t k = 0U; k < 4U; k++) {
+      d[i + k] &= s[i + k];
+    }
+  }
+  return true;
+}
+
+static const KV_FlashTypeDef flash = {
+  {sectors[0], sectors[1]}, SECTOR_SIZE, flash_erase, flash_program, NULL,
+};
+
+static void format(KV_HandleTypeDef *hkv)
+{
+  /* not blank and no valid header, as flash that held something else */
+  memset(sectors, 0x5A, sizeof(sectors));
+  memset(erases, 0, sizeof(erases));
+  power_words = -1;
+  fail_words = -1;
+  CHECK_EQ(KV_Init(hkv, &flash), KV_OK);
+}
+
+static uint32_t get(KV_HandleTypeDef *hkv, uint16_t key)
+{
+  uint32_t value = 0U;
+
+  (void)KV_Get(hkv, key, &value, sizeof(value), NULL);
+  return value;
+}
+
+/*
+ * Random keys, values and lengths; whenever the store asks for an erase the
+ * spare sector is erased as settings.c would. About one write in seven
+ * starts over from KV_Init() and reads every key back against the model.
+ */
+static void test_random(void)
+{
+  KV_HandleTypeDef hkv;
+  uint32_t model[KEYS + 1U] = {0};
+  uint32_t model_len[KEYS + 1U] = {0};
+  uint32_t busy = 0U;
+  uint32_t bad = 0U;
+
+  format(&hkv);
+  srand(1);
+  for (uint32_t i = 0U; i < RANDOM_OPS; i++) {
+    uint16_t key = (uint16_t)(1 + rand() % KEYS);
+    uint32_t value = (uint32_t)rand();
+    uint32_t len = 1U + (uint32_t)rand() % 4U;
+    KV_StatusTypeDef st = KV_Set(&hkv, key, &value, len);
+
+    if (st == KV_BUSY) {
+      busy++;
+      CHECK(KV_ErasePending(&hkv));
+      CHECK_EQ(KV_EraseSpare(&hkv), KV_OK);
+      st = KV_Set(&hkv, key, &value, len);
+    }
+    CHECK_EQ(st, KV_OK);
+    model[key] = value;
+    model_len[key] = len;
+
+    if (rand() % 7 == 0) {
+      CHECK_EQ(KV_Init(&hkv, &flash), KV_OK);
+      for (uint16_t k = 1U; k <= KEYS; k++) {
+        uint32_t got = 0U;
+        uint32_t got_len = 0U;
+        KV_StatusTypeDef found = KV_Get(&hkv, k, &got, sizeof(got), &got_len);
+
+        if (model_len[k] == 0U) {
+          bad += found != KV_NOT_FOUND;
+        } else {
+          bad += (found != KV_OK) || (got_len != model_len[k]) ||
+                 (memcmp(&got, &model[k], got_len) != 0);
+        }
+      }
+    }
+  }
+  printf("  %u writes, %u busy, %u + %u erases\n", RANDOM_OPS, busy, erases[0], erases[1]);
+  CHECK_EQ(bad, 0);
+  CHECK(busy > 0U);
+  /* the two sectors take turns */
+  CHECK(erases[0] > 0U);
+  CHECK(erases[1] > 0U);
+  CHECK(abs((int)erases[0] - (int)erases[1]) <= 1);
+}
+
+/*
+ * Cut the power at every word of CUT_WRITES writes, compaction included,
+ * then boot again: acknowledged values survive, the cut one is either.
+ */
+static void test_power_loss(void)
+{
+  KV_HandleTypeDef hkv;
+  uint32_t lost = 0U;
+
+  format(&hkv);
+  for (int32_t cut = 0; cut < 400; cut++) {
+    uint32_t before[KEYS + 1U];
+    uint16_t cut_key = 0U;
+    uint32_t cut_value = 0U;
+    uint32_t value = 0xC0DE0000U + (uint32_t)cut;
+
+    CHECK_EQ(KV_Init(&hkv, &flash), KV_OK);
+    for (uint16_t k = 1U; k <= KEYS; k++) {
+      before[k] = get(&hkv, k);
+    }
+    if (KV_ErasePending(&hkv)) {
+      CHECK_EQ(KV_EraseSpare(&hkv), KV_OK);
+    }
+
+    power_words = cut;
+    for (uint32_t n = 0U; n < CUT_WRITES; n++, value++) {
+      uint16_t key = (uint16_t)(1U + n % KEYS);
+
+      if (KV_Set(&hkv, key, &value, sizeof(value)) != KV_OK) {
+        cut_key = key;
+        cut_value = value;
+        break;
+      }
+      before[key] = value;
+    }
+    power_words = -1;
+
+    CHECK_EQ(KV_Init(&hkv, &flash), KV_OK);
+    for (uint16_t k = 1U; k <= KEYS; k++) {
+      uint32_t got = get(&hkv, k);
+
+      if ((got != before[k]) && !((k == cut_key) && (got == cut_value))) {
+        lost++;
+        printf("  cut at word %d: key %u is %08x, want %08x\n", cut, k, got, before[k]);
+      }
+    }
+  }
+  CHECK_EQ(lost, 0);
+}
+
+/*
+ * A program error part way through a record: KV_Set() reports it, the
+ * half-written slot is killed and skipped, and the next write goes after
+ * it in the same sector and reads back after a reboot.
+ */
+static void test_write_error(void)
+{
+  KV_HandleTypeDef hkv;
+  uint32_t a = 0x11111111U;
+  uint32_t b = 0x22222222U;
+  uint32_t c = 0x33333333U;
+  uint32_t off;
+
+  for (int32_t words = 0; words < 3; words++) {
+    format(&hkv);
+    CHECK_EQ(KV_Set(&hkv, 1U, &a, sizeof(a)), KV_OK);
+    off = hkv.write_off;
+
+    fail_words = words;
+    CHECK_EQ(KV_Set(&hkv, 2U, &b, sizeof(b)), KV_ERROR);
+    CHECK_EQ(fail_words, -1);
+    /* past the dead record, not over it */
+    CHECK_EQ(hkv.write_off, off + 12U);
+
+    CHECK_EQ(KV_Set(&hkv, 2U, &c, sizeof(c)), KV_OK);
+    CHECK_EQ(KV_Init(&hkv, &flash), KV_OK);
+    CHECK_EQ(get(&hkv, 1U), a);
+    CHECK_EQ(get(&hkv, 2U), c);
+    CHECK_EQ(hkv.write_off, off + 24U);
+    CHECK_EQ(erases[0] + erases[1], 1);
+  }
+}
+
+int main(void)
+{
+  test_random();
+  test_power_loss();
+  test_write_error();
+  CHECK_EQ(misaligned, 0);
+  return test_summary("kvstore");
+}
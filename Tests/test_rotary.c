@@ -0,0 +1,343 @@
+/*
+ * Rotary_Process() in every step mode: exhaustive Gray-code walks, every
+ * state/input pair, contact bounce, noise spikes, and ns per call.
+ *
+ * The expectation comes from the shaft position, not from the tables. A
+ * walk is a sequence of +-1 quarter steps from rest (both phases high, the
+ * pull-ups). A mode emits an event when the position reaches a detent
+ * other than the one it last reported: every position for QUARTER, every
+ * other one (00 and 11) for HALF, every fourth (11) for FULL.
+ */
+#include <stdlib.h>
+
+#include "test.h"
+#include "rotary.h"
+
+#define WALK_LEN   14U         /* 2^14 walks per mode */
+#define BENCH_N    20000000U
+
+/* pin state (bit1=B, bit0=A) at quarter position p, CW from rest 11 */
+static const uint8_t gray[4] = {3U, 1U, 0U, 2U};
+static const uint8_t detent_every[ROTARY_MODE_NUM] = {2U, 4U, 1U};
+static const char *const mode_name[ROTARY_MODE_NUM] = {"half", "full", "quarter"};
+
+static uint8_t pins;
+
+static bool read_a(void *user_data)
+{
+  (void)user_data;
+  return (pins & 1U) != 0U;
+}
+
+static bool read_b(void *user_data)
+{
+  (void)user_data;
+  return (pins & 2U) != 0U;
+}
+
+static uint8_t at(int32_t pos)
+{
+  return gray[(uint32_t)pos & 3U];
+}
+
+static int32_t gray_pos(uint8_t p)
+{
+  int32_t i = 0;
+
+  while (gray[i] != p) {
+    i++;
+  }
+  return i;
+}
+
+typedef struct {
+  Rotary_HandleTypeDef h;
+  int32_t pos;
+  int32_t detent;
+  uint32_t want_cw, want_ccw;
+  uint32_t got_cw, got_ccw;
+  uint32_t wrong;            /* event where the position model has none */
+} Run;
+
+static void run_start(Run *r, uint8_t mode)
+{
+  Rotary_Init(&r->h, read_a, NULL, read_b, NULL);
+  Rotary_SetStepMode(&r->h, mode);
+  r->pos = 0;
+  r->detent = 0;
+  r->want_cw = r->want_ccw = r->got_cw = r->got_ccw = r->wrong = 0U;
+  pins = at(0);
+  (void)Rotary_Process(&r->h);
+}
+
+/* one sample at shaft position pos; returns the decoder's event */
+static uint8_t run_sample(Run *r, uint8_t mode, int32_t pos)
+{
+  int32_t every = detent_every[mode];
+  uint8_t want = ROTARY_DIR_NONE;
+  uint8_t got;
+
+  r->pos = pos;
+  if (((pos % every) == 0) && (pos != r->detent)) {
+    want = (pos > r->detent) ? ROTARY_DIR_CW : ROTARY_DIR_CCW;
+    r->detent = pos;
+  }
+  pins = at(pos);
+  got = Rotary_Process(&r->h);
+
+  r->want_cw += (want == ROTARY_DIR_CW);
+  r->want_ccw += (want == ROTARY_DIR_CCW);
+  r->got_cw += (got == ROTARY_DIR_CW);
+  r->got_ccw += (got == ROTARY_DIR_CCW);
+  r->wrong += (got != want);
+  return got;
+}
+
+/* every sequence of WALK_LEN quarter steps, each sampled once */
+static void test_exhaustive_walks(void)
+{
+  for (uint8_t m = 0U; m < ROTARY_MODE_NUM; m++) {
+    uint32_t bad = 0U, events = 0U;
+
+    for (uint32_t w = 0U; w < (1UL << WALK_LEN); w++) {
+      Run r;
+      int32_t pos = 0;
+
+      run_start(&r, m);
+      for (uint32_t s = 0U; s < WALK_LEN; s++) {
+        pos += ((w >> s) & 1U) ? 1 : -1;
+        (void)run_sample(&r, m, pos);
+      }
+      events += r.got_cw + r.got_ccw;
+      if (r.wrong != 0U) {
+        if (bad++ < 3U) {
+          CHECK_MSG(0, "%s: walk 0x%04x: %u wrong samples, cw %u/%u ccw %u/%u", mode_name[m], w,
+                    r.wrong, r.got_cw, r.want_cw, r.got_ccw, r.want_ccw);
+        }
+      }
+    }
+    CHECK_MSG(bad == 0U, "%s: %u of %u walks wrong", mode_name[m], bad, 1U << WALK_LEN);
+    printf("  %-7s %u walks of %u steps, %u events, %u wrong\n", mode_name[m], 1U << WALK_LEN,
+           WALK_LEN, events, bad);
+  }
+}
+
+/*
+ * Every state reachable from rest against every input. A Gray step
+ * emits at most the event in its own direction, a skipped state (both
+ * phases changed, direction unknown) and a repeated state emit nothing.
+ */
+static void test_all_transitions(void)
+{
+  for (uint8_t m = 0U; m < ROTARY_MODE_NUM; m++) {
+    uint8_t seen[16][4] = {{0}};
+    uint8_t queue[64][2];
+    uint32_t head = 0U, tail = 0U, pairs = 0U;
+    Rotary_HandleTypeDef h;
+
+    /* the first sample sees the encoder at rest */
+    Rotary_Init(&h, NULL, NULL, NULL, NULL);
+    Rotary_SetStepMode(&h, m);
+    (void)Rotary_ProcessPins(&h, at(0));
+    queue[tail][0] = h.state & 0x0FU;
+    queue[tail][1] = 3U;
+    tail++;
+    seen[h.state & 0x0FU][3] = 1U;
+
+    while (head < tail) {
+      uint8_t state = queue[head][0];
+      uint8_t last = queue[head][1];
+      head++;
+
+      for (uint8_t in = 0U; in < 4U; in++) {
+        uint8_t d = (uint8_t)((in ^ last) == 3U ? 2U : ((in == last) ? 0U : 1U));
+        uint8_t ev;
+
+        h.state = state;
+        ev = Rotary_ProcessPins(&h, in);
+        pairs++;
+
+        if (d == 1U) {
+          uint8_t dir = (in == at(gray_pos(last) + 1)) ? ROTARY_DIR_CW : ROTARY_DIR_CCW;
+          CHECK_MSG((ev == ROTARY_DIR_NONE) || (ev == dir),
+                    "%s: state %u pins %u->%u gave 0x%02x", mode_name[m], state, last, in, ev);
+        } else {
+          CHECK_MSG(ev == ROTARY_DIR_NONE, "%s: state %u pins %u->%u (%s) gave 0x%02x",
+                    mode_name[m], state, last, in, (d == 0U) ? "repeat" : "skip", ev);
+        }
+        CHECK_MSG((h.state & 0x0FU) < 16U, "%s: state %u out of range", mode_name[m], h.state);
+        if (seen[h.state & 0x0FU][in] == 0U) {
+          seen[h.state & 0x0FU][in] = 1U;
+          queue[tail][0] = h.state & 0x0FU;
+          queue[tail][1] = in;
+          tail++;
+        }
+      }
+    }
+    printf("  %-7s %u reachable (state, pins) pairs, %u transitions\n", mode_name[m], tail, pairs);
+  }
+}
+
+/*
+ * Contact bounce: the phase that changes on a step chatters between the old
+ * and new level for a few samples before it settles. HALF and FULL must
+ * report exactly the detents of the clean walk; QUARTER follows every
+ * chatter edge by design, so only its net count is checked.
+ */
+static void test_bounce(void)
+{
+  for (uint8_t m = 0U; m < ROTARY_MODE_NUM; m++) {
+    uint32_t bad = 0U;
+
+    srand(7U + m);
+    for (uint32_t trial = 0U; trial < 20000U; trial++) {
+      Run r, clean;
+      int32_t pos = 0;
+      int32_t dir = (trial & 1U) ? 1 : -1;
+      uint32_t steps = 4U + (uint32_t)(rand() % 40);
+
+      run_start(&r, m);
+      run_start(&clean, m);
+      for (uint32_t s = 0U; s < steps; s++) {
+        int32_t next;
+        uint32_t chatter = (uint32_t)(rand() % 6);
+
+        /* mostly one direction, sometimes a step back */
+        next = pos + (((rand() % 8) == 0) ? -dir : dir);
+        for (uint32_t c = 0U; c < chatter; c++) {
+          (void)run_sample(&r, m, next);
+          (void)run_sample(&r, m, pos);
+        }
+        (void)run_sample(&r, m, next);
+        (void)run_sample(&clean, m, next);
+        pos = next;
+      }
+
+      if (m == ROTARY_MODE_QUARTER) {
+        bad += ((int32_t)(r.got_cw - r.got_ccw) != (int32_t)(clean.got_cw - clean.got_ccw));
+      } else {
+        bad += (r.got_cw != clean.want_cw) || (r.got_ccw != clean.want_ccw) || (r.wrong != 0U);
+      }
+    }
+    CHECK_MSG(bad == 0U, "%s: %u of 20000 bounced walks differ from the clean walk", mode_name[m],
+              bad);
+  }
+}
+
+/*
+ * Noise: single-sample spikes on a steady spin. A spike on one phase (one
+ * wire) can cost a detent, the decoder resyncs at the next rest position,
+ * but must never add one or report the wrong direction. A spike to any
+ * state can also land two steps away; the tables resync as if at rest, so
+ * HALF can then take the next real step for a reversal. That case is only
+ * reported. QUARTER has no rest positions and is left out.
+ */
+static void test_noise(void)
+{
+  static const char *const kind_name[2] = {"one phase", "any state"};
+
+  for (uint8_t m = ROTARY_MODE_HALF; m <= ROTARY_MODE_FULL; m++) {
+    for (uint32_t kind = 0U; kind < 2U; kind++) {
+      uint32_t want = 0U, got = 0U, reverse = 0U;
+
+      srand(99U + m);
+      for (uint32_t trial = 0U; trial < 2000U; trial++) {
+        Run r;
+        int32_t dir = (trial & 1U) ? 1 : -1;
+        int32_t pos = 0;
+
+        run_start(&r, m);
+        for (uint32_t s = 0U; s < 200U; s++) {
+          uint8_t ev;
+
+          if ((rand() % 10) == 0) {
+            pins = (kind == 0U) ? (uint8_t)(at(pos) ^ (1U << (rand() & 1))) : (uint8_t)(rand() & 3);
+            ev = Rotary_Process(&r.h);
+            reverse += (ev == ((dir > 0) ? ROTARY_DIR_CCW : ROTARY_DIR_CW));
+            got += (ev != ROTARY_DIR_NONE);
+          }
+          pos += dir;
+          ev = run_sample(&r, m, pos);
+          reverse += (ev == ((dir > 0) ? ROTARY_DIR_CCW : ROTARY_DIR_CW));
+          got += (ev != ROTARY_DIR_NONE);
+        }
+        want += r.want_cw + r.want_ccw;
+      }
+      if (kind == 0U) {
+        CHECK_MSG(reverse == 0U, "%s: %u reverse events under noise", mode_name[m], reverse);
+        CHECK_MSG(got <= want, "%s: %u events for %u detents under noise", mode_name[m], got,
+                  want);
+      }
+      printf("  %-7s %-11s spikes: %u of %u detents reported (%.1f%%), %u reversed\n",
+             mode_name[m], kind_name[kind], got, want, 100.0 * got / want, reverse);
+    }
+  }
+}
+
+/* random pin states: the decoder must only ever return NONE/CW/CCW */
+static void test_random(void)
+{
+  for (uint8_t m = 0U; m < ROTARY_MODE_NUM; m++) {
+    Rotary_HandleTypeDef h;
+    uint32_t bad = 0U;
+
+    Rotary_Init(&h, read_a, NULL, read_b, NULL);
+    Rotary_SetStepMode(&h, m);
+    srand(5U);
+    for (uint32_t i = 0U; i < 1000000U; i++) {
+      uint8_t ev;
+
+      pins = (uint8_t)(rand() & 3);
+      ev = Rotary_Process(&h);
+      bad += (ev != ROTARY_DIR_NONE) && (ev != ROTARY_DIR_CW) && (ev != ROTARY_DIR_CCW);
+    }
+    CHECK_MSG(bad == 0U, "%s: %u invalid results", mode_name[m], bad);
+  }
+}
+
+static volatile uint32_t sink;
+
+static void bench(void)
+{
+  static uint8_t seq[4096];
+
+  srand(3U);
+  for (uint32_t i = 0U, pos = 0U; i < sizeof(seq); i++) {
+    pos += ((rand() & 3) == 0) ? 3U : 1U;
+    seq[i] = at((int32_t)pos);
+  }
+
+  printf("  ns/call        Rotary_Process  Rotary_ProcessPins\n");
+  for (uint8_t m = 0U; m < ROTARY_MODE_NUM; m++) {
+    Rotary_HandleTypeDef h;
+    uint32_t acc = 0U;
+    double t0, t1, t2;
+
+    Rotary_Init(&h, read_a, NULL, read_b, NULL);
+    Rotary_SetStepMode(&h, m);
+    t0 = test_now_ns();
+    for (uint32_t i = 0U; i < BENCH_N; i++) {
+      pins = seq[i & (sizeof(seq) - 1U)];
+      acc += Rotary_Process(&h);
+    }
+    t1 = test_now_ns();
+    for (uint32_t i = 0U; i < BENCH_N; i++) {
+      acc += Rotary_ProcessPins(&h, seq[i & (sizeof(seq) - 1U)]);
+    }
+    t2 = test_now_ns();
+    sink = acc;
+    printf("  %-7s        %8.2f        %8.2f\n", mode_name[m], (t1 - t0) / BENCH_N,
+           (t2 - t1) / BENCH_N);
+  }
+}
+
+int main(void)
+{
+  test_exhaustive_walks();
+  test_all_transitions();
+  test_bounce();
+  test_noise();
+  test_random();
+  bench();
+  return test_summary("rotary");
+}
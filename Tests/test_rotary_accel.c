@@ -0,0 +1,218 @@
+/*
+ * Rotary_Accelerate() against synthetic spin profiles.
+ *
+ * Time comes from the firmware's RTStats_Micros() (runtime_stats.h) on top
+ * of a simulated 64-bit cycle counter at 96 MHz, so the wrap cases run
+ * through the same conversion Rotary_Update uses.
+ */
+#include <stdlib.h>
+
+#include "test.h"
+#include "rotary.h"
+#include "runtime_stats.h"
+
+#define HCLK_HZ 96000000U
+
+uint32_t SystemCoreClock = HCLK_HZ;
+
+static uint64_t sim_cycles;
+
+uint64_t RTStats_Cycles64(void)
+{
+  return sim_cycles;
+}
+
+/* main.c rotary_accel */
+static const Rotary_AccelTypeDef accel[] = {
+  {4000U, 8U},
+  {10000U, 4U},
+  {25000U, 2U},
+};
+
+static Rotary_HandleTypeDef h;
+
+static void reset(uint64_t cycles)
+{
+  Rotary_Init(&h, NULL, NULL, NULL, NULL);
+  Rotary_SetAccel(&h, accel, sizeof(accel) / sizeof(accel[0]));
+  sim_cycles = cycles;
+}
+
+/* advance by us microseconds, then report one detent */
+static int16_t step(uint8_t dir, uint32_t us)
+{
+  sim_cycles += (uint64_t)us * (HCLK_HZ / 1000000U);
+  return Rotary_Accelerate(&h, dir, RTStats_Micros());
+}
+
+/* the expected steady-state output for a constant interval */
+static int16_t band(uint32_t us)
+{
+  for (uint32_t i = 0U; i < sizeof(accel) / sizeof(accel[0]); i++) {
+    if (us <= accel[i].max_interval) {
+      return accel[i].steps;
+    }
+  }
+  return 1;
+}
+
+/* constant spins: |steps| never decreases and settles on the table value */
+static void test_constant_spin(void)
+{
+  static const uint32_t intervals[] = {1000U, 3000U, 4000U, 4001U, 8000U, 10000U,
+                                       20000U, 25000U, 25001U, 60000U, 500000U};
+
+  for (uint32_t i = 0U; i < sizeof(intervals) / sizeof(intervals[0]); i++) {
+    int16_t prev = 0;
+    int16_t s = 0;
+
+    reset(1000000ULL * 96U);
+    for (uint32_t n = 0U; n < 40U; n++) {
+      s = step(ROTARY_DIR_CW, intervals[i]);
+      CHECK_MSG(s >= prev, "%u us: step %u gave %d after %d", intervals[i], n, s, prev);
+      prev = s;
+    }
+    CHECK_MSG(s == band(intervals[i]), "%u us: settled at %d, expected %d", intervals[i], s,
+              band(intervals[i]));
+
+    reset(1000000ULL * 96U);
+    for (uint32_t n = 0U; n < 40U; n++) {
+      s = step(ROTARY_DIR_CCW, intervals[i]);
+    }
+    CHECK_MSG(s == -band(intervals[i]), "%u us CCW: settled at %d", intervals[i], s);
+  }
+}
+
+/* the first detent and the first one after a reversal are single steps */
+static void test_first_and_reversal(void)
+{
+  reset(0U);
+  CHECK_EQ(step(ROTARY_DIR_CW, 2000U), 1);
+  for (uint32_t n = 0U; n < 30U; n++) {
+    (void)step(ROTARY_DIR_CW, 2000U);
+  }
+  CHECK_EQ(step(ROTARY_DIR_CW, 2000U), 8);
+  CHECK_EQ(step(ROTARY_DIR_CCW, 2000U), -1);
+  CHECK_EQ(step(ROTARY_DIR_CW, 2000U), 1);
+
+  /* no event leaves the state alone: the interval restarted at 2000 us on
+     the reversal, the next detent 4000 us later averages to 3000 us */
+  CHECK_EQ(step(ROTARY_DIR_NONE, 2000U), 0);
+  CHECK_EQ(step(ROTARY_DIR_CW, 2000U), 8);
+}
+
+/* slowing down drops out of acceleration on the first slow detent */
+static void test_slow_down(void)
+{
+  reset(0U);
+  for (uint32_t n = 0U; n < 30U; n++) {
+    (void)step(ROTARY_DIR_CW, 2500U);
+  }
+  CHECK_EQ(step(ROTARY_DIR_CW, 2500U), 8);
+  CHECK_EQ(step(ROTARY_DIR_CW, 100000U), 1);
+  CHECK_EQ(step(ROTARY_DIR_CW, 200000U), 1);
+}
+
+/* a single quick pair of detents must not jump to the top of the table */
+static void test_smoothing(void)
+{
+  int16_t s;
+
+  reset(0U);
+  (void)step(ROTARY_DIR_CW, 300000U);
+  (void)step(ROTARY_DIR_CW, 300000U);
+  s = step(ROTARY_DIR_CW, 1000U);
+  CHECK_MSG(s == 1, "one fast detent after slow ones gave %d", s);
+}
+
+/* a fast sweep covers a 0..100 volume range in a fraction of the detents */
+static void test_sweep(void)
+{
+  int32_t total = 0;
+  uint32_t detents = 0U;
+
+  reset(0U);
+  while (total < 100) {
+    total += step(ROTARY_DIR_CW, 3000U);
+    detents++;
+  }
+  printf("  0..100 at 3 ms/detent: %u detents\n", detents);
+  CHECK(detents <= 30U);
+
+  total = 0;
+  detents = 0U;
+  reset(0U);
+  while (total < 100) {
+    total += step(ROTARY_DIR_CW, 150000U);
+    detents++;
+  }
+  CHECK_EQ(detents, 100);
+}
+
+/*
+ * Wrap cases: a fast spin across the 32-bit CYCCNT wrap (every 44.7 s) and
+ * across the wrap of the 32-bit microsecond count (every 71.6 min).
+ * Acceleration must continue unchanged through both.
+ */
+static void test_wrap(void)
+{
+  static const struct {
+    const char *name;
+    uint64_t start;
+  } cases[] = {
+    {"CYCCNT wrap", (1ULL << 32) - 50000ULL * 96U},
+    {"5th CYCCNT wrap", 5ULL * (1ULL << 32) - 50000ULL * 96U},
+    {"us counter wrap", (1ULL << 32) * 96U - 50000ULL * 96U},
+  };
+
+  for (uint32_t i = 0U; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    int16_t s;
+
+    reset(cases[i].start - 100000ULL * 96U);
+    for (uint32_t n = 0U; n < 30U; n++) {
+      (void)step(ROTARY_DIR_CW, 3000U);
+    }
+    /* 30 more detents at 3 ms run through the wrap point */
+    for (uint32_t n = 0U; n < 30U; n++) {
+      s = step(ROTARY_DIR_CW, 3000U);
+      CHECK_MSG(s == 8, "%s: detent %u gave %d", cases[i].name, n, s);
+    }
+  }
+
+  /* the conversion it replaced: CYCCNT / 96 jumps back at the 44.7 s wrap */
+  {
+    uint64_t c = (1ULL << 32) - 1000ULL * 96U;
+    uint32_t before = (uint32_t)c / 96U;
+    uint32_t after = (uint32_t)(c + 3000ULL * 96U) / 96U;
+    sim_cycles = c;
+    uint32_t m0 = RTStats_Micros();
+    sim_cycles = c + 3000ULL * 96U;
+    uint32_t m1 = RTStats_Micros();
+
+    CHECK(after - before != 3000U);
+    CHECK_EQ(m1 - m0, 3000U);
+  }
+}
+
+/* without a table every detent is one step */
+static void test_no_table(void)
+{
+  Rotary_Init(&h, NULL, NULL, NULL, NULL);
+  sim_cycles = 0U;
+  for (uint32_t n = 0U; n < 20U; n++) {
+    CHECK_EQ(step(ROTARY_DIR_CW, 1000U), 1);
+  }
+  CHECK_EQ(step(ROTARY_DIR_CCW, 1000U), -1);
+}
+
+int main(void)
+{
+  test_constant_spin();
+  test_first_and_reversal();
+  test_slow_down();
+  test_smoothing();
+  test_sweep();
+  test_wrap();
+  test_no_table();
+  return test_summary("rotary_accel");
+}
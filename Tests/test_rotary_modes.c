@@ -0,0 +1,332 @@
+/*
+ * Quadrature replay against both decode paths of main.c.
+ *
+ * A virtual encoder produces timed A/B edges (optionally with contact
+ * bounce). They are fed to Rotary_ProcessPins() the two ways the firmware
+ * can run it:
+ *
+ *   interrupt  every edge sets the EXTI pending bit of its line; the handler
+ *              starts after an entry latency, clears the bit, reads both
+ *              pins from IDR and advances the state machine. Edges while a
+ *              bit is already pending coalesce, as in hardware.
+ *   polling    TIM5 reads both pins every 1 ms (ROTARY_POLL=1).
+ *
+ * Every decoded step is matched with the edge that completed it to check
+ * the count, the direction and the timestamp error, and the number of
+ * handler runs is reported as the interrupt load.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+#include "rotary.h"
+
+#define NS_PER_US        1000ULL
+#define NS_PER_MS        1000000ULL
+#define MAX_EDGES        200000
+#define MAX_STEPS        50000
+
+/* EXTI handler timing at 96 MHz: entry + HAL dispatch before the IDR read,
+   then the rest of Rotary_Update. Other ISRs of equal or higher priority
+   (OTG_FS) can add up to ISR_BLOCK_NS before the handler starts. */
+#define ISR_ENTRY_NS     600ULL
+#define ISR_READ_NS      400ULL
+#define ISR_BODY_NS      1500ULL
+#define ISR_BLOCK_NS     15000ULL
+
+/* pinstate (B<<1 | A) sequence of a clockwise turn from the 11 rest state */
+static const uint8_t cw_seq[4] = {3U, 1U, 0U, 2U};
+
+typedef struct {
+  uint64_t t;
+  uint8_t pins;        /* state after the edge */
+} Edge;
+
+typedef struct {
+  uint64_t t;
+  uint8_t dir;
+} Step;
+
+static Edge edges[MAX_EDGES];
+static uint32_t nedges;
+static Step truth[MAX_STEPS];   /* edges that complete a half-step */
+static uint32_t ntruth;
+
+static uint32_t rng = 40U;
+
+static uint32_t rnd(uint32_t n)
+{
+  rng = rng * 1103515245U + 12345U;
+  return (rng >> 8) % n;
+}
+
+static void add_edge(uint64_t t, uint8_t pins)
+{
+  if (nedges < MAX_EDGES) {
+    edges[nedges].t = t;
+    edges[nedges].pins = pins;
+    nedges++;
+  }
+}
+
+/*
+ * Turn by `steps` half-steps (negative = CCW), one Gray transition every
+ * period_ns(i). bounce_ns > 0 makes the changing contact chatter for up to
+ * that long before it settles.
+ */
+static uint64_t turn(uint64_t t, int32_t steps, uint64_t (*period_ns)(uint32_t),
+                     uint64_t bounce_ns, uint32_t *phase)
+{
+  uint32_t transitions = (uint32_t)abs(steps) * 2U;
+  int dir = (steps > 0) ? 1 : 3;     /* +1 or -1 modulo 4 */
+
+  for (uint32_t i = 0U; i < transitions; i++) {
+    uint8_t from = cw_seq[*phase];
+    uint8_t to;
+
+    *phase = (*phase + (uint32_t)dir) & 3U;
+    to = cw_seq[*phase];
+    t += period_ns(i);
+    if (bounce_ns > 0U) {
+      uint64_t b = t;
+      uint32_t n = 1U + rnd(6U) * 2U;    /* odd count of toggles ends at `to` */
+
+      for (uint32_t k = 0U; (k < n) && (b < t + bounce_ns); k++) {
+        add_edge(b, (k & 1U) ? from : to);
+        b += 5U * NS_PER_US + rnd(40U) * NS_PER_US;
+      }
+      add_edge(b, to);
+      if ((*phase & 1U) == 0U) {
+        truth[ntruth].t = b;
+        truth[ntruth].dir = (steps > 0) ? ROTARY_DIR_CW : ROTARY_DIR_CCW;
+        ntruth++;
+      }
+      t = b;
+    } else {
+      add_edge(t, to);
+      if ((*phase & 1U) == 0U) {
+        truth[ntruth].t = t;
+        truth[ntruth].dir = (steps > 0) ? ROTARY_DIR_CW : ROTARY_DIR_CCW;
+        ntruth++;
+      }
+    }
+  }
+  return t;
+}
+
+/* pin state at time t; calls must be in increasing t */
+typedef struct {
+  uint32_t i;
+  uint8_t pins;
+} Cursor;
+
+static uint8_t pins_at(Cursor *c, uint64_t t)
+{
+  while ((c->i < nedges) && (edges[c->i].t <= t)) {
+    c->pins = edges[c->i++].pins;
+  }
+  return c->pins;
+}
+
+typedef struct {
+  uint32_t steps;
+  uint32_t wrong_dir;
+  uint32_t runs;          /* handler runs or polls */
+  uint64_t max_err_ns;    /* decoded step time - completing edge time */
+  Step out[MAX_STEPS];
+} Result;
+
+static void record(Result *r, uint8_t dir, uint64_t t)
+{
+  if (dir == ROTARY_DIR_NONE) {
+    return;
+  }
+  if (r->steps < MAX_STEPS) {
+    r->out[r->steps].t = t;
+    r->out[r->steps].dir = dir;
+  }
+  r->steps++;
+}
+
+static void score(Result *r)
+{
+  for (uint32_t i = 0U; (i < r->steps) && (i < ntruth); i++) {
+    if (r->out[i].dir != truth[i].dir) {
+      r->wrong_dir++;
+    }
+    if ((r->out[i].t >= truth[i].t) && (r->out[i].t - truth[i].t > r->max_err_ns)) {
+      r->max_err_ns = r->out[i].t - truth[i].t;
+    }
+  }
+}
+
+static void run_interrupt(Result *r)
+{
+  Rotary_HandleTypeDef h;
+  Cursor edge = {0U, 3U};
+  Cursor read = {0U, 3U};
+  uint64_t pending_since[2] = {0U, 0U};
+  uint8_t pending = 0U;          /* bit0: EXTI2 (CLK/A), bit1: EXTI1 (DT/B) */
+  uint64_t t_free = 0U;
+  uint64_t t_block = 0U;         /* drawn when a line becomes pending */
+
+  memset(r, 0, sizeof(*r));
+  Rotary_Init(&h, NULL, NULL, NULL, NULL);
+  for (;;) {
+    uint64_t t_start = UINT64_MAX;
+    uint8_t line;
+
+    if (pending != 0U) {
+      uint64_t since = UINT64_MAX;
+      for (line = 0U; line < 2U; line++) {
+        if ((pending & (1U << line)) && (pending_since[line] < since)) {
+          since = pending_since[line];
+        }
+      }
+      t_start = since + ISR_ENTRY_NS + t_block;
+      if (t_start < t_free) {
+        t_start = t_free;
+      }
+    }
+    if ((edge.i < nedges) && (edges[edge.i].t <= t_start)) {
+      uint8_t before = edge.pins;
+      uint8_t changed = before ^ pins_at(&edge, edges[edge.i].t);
+
+      if ((changed != 0U) && (pending == 0U)) {
+        t_block = (rnd(8U) == 0U) ? rnd(ISR_BLOCK_NS) : 0U;
+      }
+      for (line = 0U; line < 2U; line++) {
+        if ((changed & (1U << line)) && !(pending & (1U << line))) {
+          pending |= (uint8_t)(1U << line);
+          pending_since[line] = edges[edge.i - 1U].t;
+        }
+      }
+      continue;
+    }
+    if (t_start == UINT64_MAX) {
+      break;
+    }
+    /* EXTI1 (B) has the lower vector number and is taken first */
+    line = (pending & 2U) ? 1U : 0U;
+    pending &= (uint8_t)~(1U << line);
+    record(r, Rotary_ProcessPins(&h, pins_at(&read, t_start + ISR_READ_NS)), t_start + ISR_READ_NS);
+    r->runs++;
+    t_free = t_start + ISR_BODY_NS;
+  }
+  score(r);
+}
+
+static void run_polling(Result *r, uint64_t end)
+{
+  Rotary_HandleTypeDef h;
+  Cursor read = {0U, 3U};
+  uint64_t phase = rnd(1000U) * NS_PER_US;
+
+  memset(r, 0, sizeof(*r));
+  Rotary_Init(&h, NULL, NULL, NULL, NULL);
+  for (uint64_t t = phase; t <= end; t += NS_PER_MS) {
+    record(r, Rotary_ProcessPins(&h, pins_at(&read, t)), t);
+    r->runs++;
+  }
+  score(r);
+}
+
+static Result res_irq, res_poll;
+
+static uint64_t g_period;
+static uint64_t const_period(uint32_t i)
+{
+  (void)i;
+  return g_period;
+}
+
+/* flick: accelerates from 20 to 2000 half-steps/s and back over 400 transitions */
+static uint64_t flick_period(uint32_t i)
+{
+  uint32_t x = (i < 200U) ? i : 399U - i;
+  uint64_t rate = 20U + (uint64_t)x * 10U;     /* half-steps/s */
+  return 1000000000ULL / (rate * 2U);
+}
+
+static void scenario(const char *name, uint64_t end, int expect_poll_exact, uint64_t bounce)
+{
+  run_interrupt(&res_irq);
+  run_polling(&res_poll, end);
+
+  /* the latency column is only meaningful when every step was decoded */
+  printf("  %-28s %5u steps | irq %5u runs %5u late %5.1f us | poll %5u runs %5u late %6.1f us\n",
+         name, ntruth, res_irq.steps, res_irq.runs,
+         (res_irq.steps == ntruth) ? res_irq.max_err_ns / 1000.0 : -1.0,
+         res_poll.steps, res_poll.runs,
+         (res_poll.steps == ntruth) ? res_poll.max_err_ns / 1000.0 : -1.0);
+
+  /* the interrupt path must see every step, in the right direction, promptly */
+  CHECK_MSG(res_irq.steps == ntruth, "%s: irq decoded %u of %u", name, res_irq.steps, ntruth);
+  CHECK_MSG(res_irq.wrong_dir == 0U, "%s: irq %u wrong directions", name, res_irq.wrong_dir);
+  CHECK_MSG(res_irq.max_err_ns <= ISR_ENTRY_NS + ISR_BLOCK_NS + ISR_READ_NS + ISR_BODY_NS + bounce,
+            "%s: irq timestamp %llu ns late", name, (unsigned long long)res_irq.max_err_ns);
+  if (expect_poll_exact) {
+    CHECK_MSG(res_poll.steps == ntruth, "%s: poll decoded %u of %u", name, res_poll.steps, ntruth);
+    CHECK_MSG(res_poll.wrong_dir == 0U, "%s: poll %u wrong directions", name, res_poll.wrong_dir);
+    CHECK_MSG(res_poll.max_err_ns <= NS_PER_MS + bounce, "%s: poll timestamp %llu ns late",
+              name, (unsigned long long)res_poll.max_err_ns);
+  }
+}
+
+static void reset(void)
+{
+  nedges = 0U;
+  ntruth = 0U;
+}
+
+int main(void)
+{
+  /* half-steps/s; polling is only expected to keep up while every Gray
+     state lasts longer than its 1 ms period */
+  static const struct {
+    uint32_t rate;
+    int poll_exact;
+  } speeds[] = {{10U, 1}, {50U, 1}, {200U, 1}, {400U, 1}, {1000U, 0}, {2000U, 0}, {4000U, 0}};
+  char name[64];
+  uint32_t phase;
+  uint64_t t;
+
+  printf("rotary decode, interrupt vs 1 ms polling:\n");
+  for (uint32_t i = 0U; i < sizeof(speeds) / sizeof(speeds[0]); i++) {
+    reset();
+    phase = 0U;
+    g_period = 1000000000ULL / ((uint64_t)speeds[i].rate * 2U);
+    t = turn(0U, 200, const_period, 0U, &phase);
+    t = turn(t + 50U * NS_PER_MS, -200, const_period, 0U, &phase);
+    snprintf(name, sizeof(name), "%u steps/s CW+CCW", speeds[i].rate);
+    scenario(name, t + 10U * NS_PER_MS, speeds[i].poll_exact, 0U);
+  }
+
+  /* chattering contacts: up to 300 us of bounce per edge */
+  for (uint32_t rate = 20U; rate <= 400U; rate *= 20U) {
+    reset();
+    phase = 0U;
+    g_period = 1000000000ULL / ((uint64_t)rate * 2U);
+    t = turn(0U, 100, const_period, 300U * NS_PER_US, &phase);
+    t = turn(t + 50U * NS_PER_MS, -100, const_period, 300U * NS_PER_US, &phase);
+    snprintf(name, sizeof(name), "%u steps/s, 300 us bounce", rate);
+    scenario(name, t + 10U * NS_PER_MS, 1, 300U * NS_PER_US);
+  }
+
+  /* fast flicks both ways with reversals in between */
+  reset();
+  phase = 0U;
+  t = 0U;
+  for (int k = 0; k < 6; k++) {
+    t = turn(t + 20U * NS_PER_MS, (k & 1) ? -200 : 200, flick_period, 0U, &phase);
+  }
+  scenario("flick 20..2000..20 steps/s", t + 10U * NS_PER_MS, 0, 0U);
+
+  /* idle: no edges, so no interrupts; polling still runs 1000 times a second */
+  reset();
+  scenario("idle 1 s", NS_PER_MS * 1000U, 1, 0U);
+  CHECK_EQ(res_irq.runs, 0);
+  CHECK(res_poll.runs >= 999U);
+
+  return test_summary("rotary_modes");
+}
@@ -0,0 +1,140 @@
+/*
+ * Per-handle step modes against the decoder they replaced.
+ *
+ * Before the step mode moved into the handle, rotary.c was built with one
+ * state table, picked by ROTARY_HALF_STEP. Those two tables are kept here
+ * verbatim as the reference. Random pin streams (legal steps, skipped
+ * states and plain noise) go through the reference and through
+ * Rotary_Process, Rotary_ProcessPins and Rotary_ProcessBatch, and every
+ * output must be identical. The quarter-step mode has no predecessor. It is
+ * checked against the Gray-code position difference instead.
+ */
+#include <stdlib.h>
+
+#include "test.h"
+#include "rotary.h"
+
+#define SAMPLES 1000000U
+
+/* rotary.c before per-handle modes, -DROTARY_HALF_STEP */
+static const uint8_t old_half[6][4] = {
+    {0x3, 0x2, 0x1, 0x0},
+    {0x3 | ROTARY_DIR_CCW, 0x0, 0x1, 0x0},
+    {0x3 | ROTARY_DIR_CW, 0x2, 0x0, 0x0},
+    {0x3, 0x5, 0x4, 0x0},
+    {0x3, 0x3, 0x4, 0x0 | ROTARY_DIR_CW},
+    {0x3, 0x5, 0x3, 0x0 | ROTARY_DIR_CCW},
+};
+
+/* rotary.c before per-handle modes, without ROTARY_HALF_STEP */
+static const uint8_t old_full[7][4] = {
+    {0x0, 0x2, 0x4, 0x0},
+    {0x3, 0x0, 0x1, 0x0 | ROTARY_DIR_CW},
+    {0x3, 0x2, 0x0, 0x0},
+    {0x3, 0x2, 0x1, 0x0},
+    {0x6, 0x0, 0x4, 0x0},
+    {0x6, 0x5, 0x0, 0x0 | ROTARY_DIR_CCW},
+    {0x6, 0x5, 0x4, 0x0},
+};
+
+static uint8_t pins;
+
+static bool read_a(void *user_data)
+{
+  (void)user_data;
+  return (pins & 1U) != 0U;
+}
+
+static bool read_b(void *user_data)
+{
+  (void)user_data;
+  return (pins & 2U) != 0U;
+}
+
+/* quarter step: one event per Gray step, nothing for a skipped state */
+static uint8_t quarter_ref(uint8_t *last, uint8_t now)
+{
+  static const uint8_t pos[4] = {2U, 1U, 3U, 0U}; /* CW: 11 01 00 10, as HALF/FULL */
+  uint8_t d = (uint8_t)((pos[now] - pos[*last]) & 3U);
+
+  *last = now;
+  return (d == 1U) ? ROTARY_DIR_CW : (d == 3U) ? ROTARY_DIR_CCW : ROTARY_DIR_NONE;
+}
+
+/* three kinds of input: mostly legal steps, any next state, or a random mix */
+static uint8_t next_pins(uint32_t kind, uint8_t cur)
+{
+  static const uint8_t cw[4] = {2U, 0U, 3U, 1U}; /* successor of 00 01 10 11 */
+  static const uint8_t ccw[4] = {1U, 3U, 0U, 2U};
+  uint32_t r = (uint32_t)rand();
+
+  switch (kind) {
+  case 0U:
+    return ((r & 7U) == 0U) ? cur : ((r & 8U) ? cw[cur] : ccw[cur]);
+  case 1U:
+    return (uint8_t)(r & 3U);
+  default:
+    return ((r & 3U) != 0U) ? ((r & 4U) ? cw[cur] : ccw[cur]) : (uint8_t)((r >> 3) & 3U);
+  }
+}
+
+static void compare(uint32_t kind, unsigned seed)
+{
+  Rotary_HandleTypeDef h[ROTARY_MODE_NUM];
+  Rotary_HandleTypeDef p[ROTARY_MODE_NUM];
+  Rotary_BatchTypeDef b[ROTARY_MODE_NUM];
+  uint8_t oh = 0U, of = 0U, oq = 0U;
+  uint32_t events = 0U, mismatches = 0U;
+
+  srand(seed);
+  for (uint8_t m = 0U; m < ROTARY_MODE_NUM; m++) {
+    Rotary_Init(&h[m], read_a, NULL, read_b, NULL);
+    Rotary_Init(&p[m], NULL, NULL, NULL, NULL);
+    Rotary_SetStepMode(&h[m], m);
+    Rotary_SetStepMode(&p[m], m);
+    b[m] = (Rotary_BatchTypeDef){0U, 0U, 0U, 1U, m, 0U};
+  }
+
+  pins = 0U;
+  for (uint32_t i = 0U; i < SAMPLES; i++) {
+    uint8_t ref[ROTARY_MODE_NUM];
+    uint32_t port;
+    uint32_t batch;
+
+    pins = next_pins(kind, pins);
+    port = pins;
+
+    oh = old_half[oh & 0x0FU][pins];
+    of = old_full[of & 0x0FU][pins];
+    ref[ROTARY_MODE_HALF] = oh & 0x30U;
+    ref[ROTARY_MODE_FULL] = of & 0x30U;
+    ref[ROTARY_MODE_QUARTER] = quarter_ref(&oq, pins);
+
+    batch = Rotary_ProcessBatch(b, ROTARY_MODE_NUM, &port);
+    for (uint8_t m = 0U; m < ROTARY_MODE_NUM; m++) {
+      uint8_t a = Rotary_Process(&h[m]);
+      uint8_t c = Rotary_ProcessPins(&p[m], pins);
+      uint8_t d = (uint8_t)(((batch >> (2U * m)) & 3U) << 4);
+
+      if ((a != ref[m]) || (c != ref[m]) || (d != ref[m])) {
+        if (mismatches++ < 5U) {
+          CHECK_MSG(0, "input %u mode %u sample %u: ref 0x%02x process 0x%02x pins 0x%02x "
+                    "batch 0x%02x", kind, m, i, ref[m], a, c, d);
+        }
+      }
+      events += (ref[m] != ROTARY_DIR_NONE);
+    }
+  }
+  CHECK_MSG(mismatches == 0U, "input %u: %u mismatches", kind, mismatches);
+  CHECK(events > SAMPLES / 10U);
+  printf("  input %u: %u samples x %u modes, %u events, %u mismatches\n", kind, SAMPLES,
+         ROTARY_MODE_NUM, events, mismatches);
+}
+
+int main(void)
+{
+  for (uint32_t kind = 0U; kind < 3U; kind++) {
+    compare(kind, 1234U + kind);
+  }
+  return test_summary("rotary_tables");
+}
@@ -0,0 +1,385 @@
+/*
+ * The firmware's task set on the POSIX port of FreeRTOS, see host/rtos_sim.h.
+ *
+ * FreeRTOS runs once per process, so every case boots in a child that
+ * sends its figures back through a pipe; the checks run here. A child that
+ * hangs (configASSERT() spins) is killed by alarm().
+ */
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "test.h"
+#include "rtos_sim.h"
+#include "audio_sim.h"
+#include "uart_host.h"
+#include "flash_host.h"
+#include "usbd_hid.h"
+#include "kvstore.h"
+#include "settings.h"
+
+#define MS           RTOS_SIM_MS
+#define CHILD_S      20U
+
+/* settings.c's sectors 2 and 3 in the simulated flash */
+#define SETTINGS_A   0x08008000U
+#define SETTINGS_B   0x0800C000U
+#define SETTINGS_SZ  0x4000U
+/* what the settings sectors hold at power-up */
+#define FLASH_BLANK  0U
+#define FLASH_MUTED  1U            /* mute saved before the last power-down */
+#define FLASH_USED   2U            /* neither sector formatted: KV_Init() erases */
+#define FLASH_DIRTY  3U            /* mute saved, spare sector left unerased */
+
+typedef struct
+{
+  RtosSim_StatsTypeDef rtos;
+  AudioSim_StatsTypeDef audio;
+  PortTaskStats_t input;
+  PortTaskStats_t deflt;
+  uint32_t uart_bytes;
+  uint32_t i2s_pauses;
+  uint32_t flash_words;
+  uint32_t flash_erases;
+  size_t heap_min;
+} Result;
+
+typedef struct
+{
+  const char *name;
+  double seconds;
+  uint8_t no_stream;
+  uint64_t key_ns;             /* KEY pressed for 100 ms, 0 for none */
+  uint64_t turn_ns;            /* the encoder turned ... */
+  int32_t quarters;            /* ... by this many quarter steps, 1 ms apart */
+  uint8_t flash;               /* FLASH_xxx */
+} Case;
+
+/* What an earlier power cycle left: written straight into the mapped flash */
+static bool sector_erase(void *ctx, uint8_t sector)
+{
+  (void)ctx;
+  memset((void *)(uintptr_t)((sector == 0U) ? SETTINGS_A : SETTINGS_B), 0xFF, SETTINGS_SZ);
+  return true;
+}
+
+static bool sector_program(void *ctx, const uint8_t *dst, const void *src, uint32_t len)
+{
+  (void)ctx;
+  for (uint32_t i = 0U; i < len; i++)
+  {
+    ((uint8_t *)dst)[i] &= ((const uint8_t *)src)[i];
+  }
+  return true;
+}
+
+static void save_mute(uint8_t mute)
+{
+  static const KV_FlashTypeDef flash = {
+    {(const uint8_t *)SETTINGS_A, (const uint8_t *)SETTINGS_B}, SETTINGS_SZ,
+    sector_erase, sector_program, NULL,
+  };
+  KV_HandleTypeDef hkv;
+
+  if ((KV_Init(&hkv, &flash) != KV_OK) ||
+      (KV_Set(&hkv, SETTINGS_KEY_MUTE, &mute, 1U) != KV_OK))
+  {
+    _exit(1);
+  }
+}
+
+static void child(const Case *c, int fd)
+{
+  RtosSim_ConfigTypeDef cfg = {0};
+  Result r;
+
+  alarm(CHILD_S);
+  cfg.no_stream = c->no_stream;
+  RtosSim_Init(&cfg);
+  if (c->flash == FLASH_MUTED)
+  {
+    save_mute(1U);
+  }
+  else if (c->flash == FLASH_USED)
+  {
+    memset((void *)(uintptr_t)SETTINGS_A, 0x00, SETTINGS_SZ);
+  }
+  else if (c->flash == FLASH_DIRTY)
+  {
+    save_mute(1U);
+    memset((void *)(uintptr_t)(SETTINGS_B + SETTINGS_SZ / 2U), 0x00, 4U);
+  }
+  if (c->key_ns != 0U)
+  {
+    RtosSim_Pin(c->key_ns, KEY_GPIO_Port, KEY_Pin, GPIO_PIN_RESET);
+    RtosSim_Pin(c->key_ns + 100U * MS, KEY_GPIO_Port, KEY_Pin, GPIO_PIN_SET);
+  }
+  if (c->quarters != 0)
+  {
+    RtosSim_Turn(c->turn_ns, c->quarters, MS);
+  }
+  RtosSim_Run((uint64_t)(c->seconds * 1e9));
+
+  printf("%s\n", c->name);
+  RtosSim_Report(stdout);
+  fflush(stdout);
+  memset(&r, 0, sizeof(r));
+  r.rtos = *RtosSim_Stats();
+  r.audio = *AudioSim_Stats();
+  r.input = *RtosSim_Task("inputTask");
+  r.deflt = *RtosSim_Task("defaultTask");
+  r.uart_bytes = UART_Host_Stats()->bytes;
+  r.i2s_pauses = I2S_Host_Stats()->pauses;
+  r.flash_words = FLASH_Host_Stats()->programs;
+  r.flash_erases = FLASH_Host_Stats()->erases;
+  r.heap_min = xPortGetMinimumEverFreeHeapSize();
+  if (write(fd, &r, sizeof(r)) != (ssize_t)sizeof(r))
+  {
+    _exit(1);
+  }
+  /* the task threads are still blocked inside the kernel */
+  _exit(0);
+}
+
+static int run(const Case *c, Result *r)
+{
+  int fd[2];
+  int status;
+  pid_t pid;
+  ssize_t n;
+
+  fflush(stdout);
+  if (pipe(fd) != 0)
+  {
+    perror("pipe");
+    exit(1);
+  }
+  pid = fork();
+  if (pid == 0)
+  {
+    close(fd[0]);
+    child(c, fd[1]);
+  }
+  close(fd[1]);
+  n = read(fd[0], r, sizeof(*r));
+  close(fd[0]);
+  waitpid(pid, &status, 0);
+  CHECK_MSG(WIFEXITED(status) && (WEXITSTATUS(status) == 0), "%s: child %s %d", c->name,
+            WIFSIGNALED(status) ? "killed by signal" : "exit",
+            WIFSIGNALED(status) ? WTERMSIG(status) : WEXITSTATUS(status));
+  CHECK_MSG(n == (ssize_t)sizeof(*r), "%s: no result", c->name);
+  return n == (ssize_t)sizeof(*r);
+}
+
+/* The first HID report with keys at or after t_ns, -1 for none */
+static int64_t hid_after(const Result *r, uint64_t t_ns, uint8_t keys)
+{
+  for (uint32_t i = 0U; (i < r->rtos.hid_reports) && (i < RTOS_SIM_HID_LOG); i++)
+  {
+    if ((r->rtos.hid[i].t_ns >= t_ns) && (r->rtos.hid[i].keys == keys))
+    {
+      return (int64_t)r->rtos.hid[i].t_ns;
+    }
+  }
+  return -1;
+}
+
+static uint32_t hid_count(const Result *r, uint64_t from_ns, uint64_t to_ns, uint8_t keys)
+{
+  uint32_t n = 0U;
+
+  for (uint32_t i = 0U; (i < r->rtos.hid_reports) && (i < RTOS_SIM_HID_LOG); i++)
+  {
+    n += (r->rtos.hid[i].t_ns >= from_ns) && (r->rtos.hid[i].t_ns < to_ns) &&
+         (r->rtos.hid[i].keys == keys);
+  }
+  return n;
+}
+
+/*
+ * Boot, enumerate and stream for 3 s. The host connects 100 ms after
+ * MX_USB_DEVICE_Init(); the default task feeds the vendor endpoint and
+ * USART1, and nothing in a clean run glitches the audio.
+ */
+static void test_boot_and_stream(void)
+{
+  Case c = {"boot and stream, 3 s", 3.0, 0U, 0U, 0U, 0};
+  Result r;
+
+  if (!run(&c, &r))
+  {
+    return;
+  }
+  CHECK(r.rtos.enumerated_ns >= RTOS_SIM_CONNECT_NS);
+  CHECK(r.rtos.enumerated_ns < RTOS_SIM_CONNECT_NS + 10U * MS);
+  CHECK(r.audio.packets >= 2800U);
+  CHECK_EQ(r.audio.naks, 0);
+  CHECK_EQ(r.audio.overruns + r.audio.underruns, 0);
+  CHECK(r.rtos.irq[16 + DMA1_Stream4_IRQn].count >= 60U);
+  CHECK(r.rtos.irq[16 + SysTick_IRQn].count >= 2990U);
+  /* the default task polls every 10 ms */
+  CHECK(r.deflt.wakes >= 290U);
+  CHECK(r.rtos.vendor_bytes > 0U);
+  CHECK(r.uart_bytes > 0U);
+  CHECK_EQ(r.rtos.hid_reports, 0);
+  CHECK_EQ(r.i2s_pauses, 0);
+  CHECK(r.heap_min > 0U);
+}
+
+/*
+ * Mute saved before the last power-down: AUDIO_Init_FS() takes it from
+ * Settings_GetMute() and the stream starts paused. Nothing new to save.
+ */
+static void test_saved_mute(void)
+{
+  Case c = {"saved mute, 1 s", 1.0, 0U, 0U, 0U, 0, FLASH_MUTED};
+  Result r;
+
+  if (!run(&c, &r))
+  {
+    return;
+  }
+  CHECK(r.audio.packets >= 800U);
+  CHECK_EQ(r.i2s_pauses, 1);
+  CHECK_EQ(r.flash_words, 0);
+}
+
+/*
+ * First power-up over flash that held something else: Settings_Init()
+ * erases a sector (250 ms, CPU stalled) before MX_USB_DEVICE_Init(), so
+ * the D+ pull-up comes after it and the host enumerates as usual.
+ */
+static void test_first_erase(void)
+{
+  Case c = {"first power-up, used flash, 1 s", 1.0, 0U, 0U, 0U, 0, FLASH_USED};
+  Result r;
+
+  if (!run(&c, &r))
+  {
+    return;
+  }
+  CHECK(r.rtos.stall_max_ns >= 250U * MS);
+  CHECK(r.rtos.enumerated_ns >= r.rtos.stall_max_ns + RTOS_SIM_CONNECT_NS);
+  CHECK(r.rtos.enumerated_ns < r.rtos.stall_max_ns + RTOS_SIM_CONNECT_NS + 10U * MS);
+  CHECK(r.audio.packets >= 500U);
+  CHECK_EQ(r.audio.overruns + r.audio.underruns, 0);
+}
+
+/*
+ * Power-up with the spare sector left dirty (power lost before its erase
+ * ran). Settings_Poll() holds the 250 ms erase back until the device has
+ * been configured without the streaming alternate setting for
+ * SETTINGS_ERASE_IDLE_MS, so neither enumeration nor the SET_INTERFACE
+ * that follows waits behind it. With a stream running the erase stays
+ * pending; an idle host gets it a second after enumeration.
+ */
+static void test_dirty_spare(void)
+{
+  Case busy = {"dirty spare sector, streaming, 1 s", 1.0, 0U, 0U, 0U, 0, FLASH_DIRTY};
+  Case idle = {"dirty spare sector, no stream, 2 s", 2.0, 1U, 0U, 0U, 0, FLASH_DIRTY};
+  Result r;
+
+  if (run(&busy, &r))
+  {
+    CHECK(r.rtos.enumerated_ns < RTOS_SIM_CONNECT_NS + 10U * MS);
+    CHECK_EQ(r.flash_erases, 0);
+    CHECK(r.rtos.stall_max_ns < 250U * MS);
+    CHECK_EQ(r.i2s_pauses, 1);
+    CHECK_EQ(r.audio.overruns + r.audio.underruns, 0);
+  }
+  if (run(&idle, &r))
+  {
+    CHECK(r.rtos.enumerated_ns < RTOS_SIM_CONNECT_NS + 10U * MS);
+    CHECK_EQ(r.flash_erases, 1);
+    CHECK(r.rtos.stall_max_ns >= 250U * MS);
+  }
+}
+
+/*
+ * KEY is debounced in TIM5 (Input_Tick), posted to the input task and
+ * sent as a MUTE report that the host reads in the next frame, followed by
+ * the release report.
+ */
+static void test_key_press(void)
+{
+  Case c = {"KEY pressed at 500 ms", 1.0, 0U, 500U * MS, 0U, 0};
+  Result r;
+  int64_t mute;
+
+  if (!run(&c, &r))
+  {
+    return;
+  }
+  mute = hid_after(&r, 500U * MS, HID_CC_MUTE);
+  printf("  MUTE %.3f ms after the press\n", (double)(mute - 500 * (int64_t)MS) / 1e6);
+  CHECK(mute >= 0);
+  CHECK(mute < 500 * (int64_t)MS + 20 * (int64_t)MS);
+  CHECK(hid_after(&r, (uint64_t)mute + 1U, 0x00U) > mute);
+  CHECK(r.input.wakes >= 1U);
+  CHECK_EQ(r.audio.overruns + r.audio.underruns, 0);
+}
+
+/* Encoder edges go through EXTI1/2 and come out as volume reports */
+static void test_encoder(void)
+{
+  Case cw = {"encoder +8 quarter steps at 800 ms", 1.0, 0U, 0U, 800U * MS, 8};
+  Case ccw = {"encoder -8 quarter steps at 800 ms", 1.0, 0U, 0U, 800U * MS, -8};
+  Result r;
+
+  if (run(&cw, &r))
+  {
+    CHECK(r.rtos.irq[16 + EXTI1_IRQn].count == 4U);
+    CHECK(r.rtos.irq[16 + EXTI2_IRQn].count == 4U);
+    CHECK(hid_count(&r, 800U * MS, 900U * MS, HID_CC_VOLUME_UP) >= 1U);
+    CHECK_EQ(hid_count(&r, 0U, 1000U * MS, HID_CC_VOLUME_DOWN), 0);
+  }
+  if (run(&ccw, &r))
+  {
+    CHECK(hid_count(&r, 800U * MS, 900U * MS, HID_CC_VOLUME_DOWN) >= 1U);
+    CHECK_EQ(hid_count(&r, 0U, 1000U * MS, HID_CC_VOLUME_UP), 0);
+  }
+}
+
+/* Enumerated but idle: no packets, the DMA never starts, the keys still work */
+static void test_no_stream(void)
+{
+  Case c = {"no stream, KEY at 500 ms", 1.0, 1U, 500U * MS, 0U, 0};
+  Result r;
+
+  if (!run(&c, &r))
+  {
+    return;
+  }
+  CHECK(r.rtos.enumerated_ns != 0U);
+  CHECK_EQ(r.audio.packets, 0);
+  CHECK_EQ(r.rtos.irq[16 + DMA1_Stream4_IRQn].count, 0);
+  CHECK(hid_after(&r, 500U * MS, HID_CC_MUTE) >= 0);
+}
+
+/* The same inputs give the same run, to the nanosecond */
+static void test_repeatable(void)
+{
+  Case c = {"repeat: KEY at 300 ms, encoder at 600 ms", 1.5, 0U, 300U * MS, 600U * MS, 12};
+  Result a;
+  Result b;
+
+  if (run(&c, &a) && run(&c, &b))
+  {
+    CHECK(memcmp(&a, &b, sizeof(a)) == 0);
+  }
+}
+
+int main(void)
+{
+  test_boot_and_stream();
+  test_saved_mute();
+  test_first_erase();
+  test_dirty_spare();
+  test_key_press();
+  test_encoder();
+  test_no_stream();
+  test_repeatable();
+  return test_summary("rtos");
+}
@@ -0,0 +1,135 @@
+/*
+ * Configuration descriptor byte-compare.
+ *
+ * The speaker descriptor is assembled from the AUDIO_DESC_xxx macros in
+ * usbd_audio.h (single class) and by usbd_composite_builder.c (composite
+ * build). Both must stay byte-identical to the hand-written arrays they
+ * replaced, which are kept here as the reference.
+ */
+#include <string.h>
+
+#include "test.h"
+#include "usbd_ll_host.h"
+#include "usbd_audio.h"
+#ifdef USE_USBD_COMPOSITE
+#include "usbd_composite_builder.h"
+#include "usbd_vendor.h"
+#include "usbd_hid.h"
+#endif
+
+#ifndef USE_USBD_COMPOSITE
+/* USBD_AUDIO_CfgDesc as it was hand-maintained, 0x6D bytes */
+static const uint8_t ref_cfg[] =
+{
+  0x09, 0x02, 0x6d, 0x00, 0x02, 0x01, 0x00, 0xc0, 0x32, 0x09, 0x04, 0x00, 0x00, 0x00, 0x01, 0x01,
+  0x00, 0x00, 0x09, 0x24, 0x01, 0x00, 0x01, 0x27, 0x00, 0x01, 0x01, 0x0c, 0x24, 0x02, 0x01, 0x01,
+  0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x09, 0x24, 0x06, 0x02, 0x01, 0x01, 0x01, 0x00, 0x00,
+  0x09, 0x24, 0x03, 0x03, 0x01, 0x03, 0x00, 0x02, 0x00, 0x09, 0x04, 0x01, 0x00, 0x00, 0x01, 0x02,
+  0x00, 0x00, 0x09, 0x04, 0x01, 0x01, 0x01, 0x01, 0x02, 0x00, 0x00, 0x07, 0x24, 0x01, 0x01, 0x01,
+  0x01, 0x00, 0x0b, 0x24, 0x02, 0x01, 0x02, 0x02, 0x10, 0x01, 0x80, 0xbb, 0x00, 0x09, 0x05, 0x01,
+  0x01, 0xc0, 0x00, 0x01, 0x00, 0x00, 0x07, 0x25, 0x01, 0x00, 0x00, 0x00, 0x00
+};
+#else
+/* Composite configuration before the speaker used the shared macros: IAD +
+   speaker (interfaces 0-1), vendor bulk pair (2), HID media keys (3) */
+static const uint8_t ref_cfg[] =
+{
+  0x09, 0x02, 0xa5, 0x00, 0x04, 0x01, 0x00, 0xc0, 0x32, 0x08, 0x0b, 0x00, 0x02, 0x01, 0x01, 0x00,
+  0x00, 0x09, 0x04, 0x00, 0x00, 0x00, 0x01, 0x01, 0x00, 0x00, 0x09, 0x24, 0x01, 0x00, 0x01, 0x27,
+  0x00, 0x01, 0x01, 0x0c, 0x24, 0x02, 0x01, 0x01, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x09,
+  0x24, 0x06, 0x02, 0x01, 0x01, 0x01, 0x00, 0x00, 0x09, 0x24, 0x03, 0x03, 0x01, 0x03, 0x00, 0x02,
+  0x00, 0x09, 0x04, 0x01, 0x00, 0x00, 0x01, 0x02, 0x00, 0x00, 0x09, 0x04, 0x01, 0x01, 0x01, 0x01,
+  0x02, 0x00, 0x00, 0x07, 0x24, 0x01, 0x01, 0x01, 0x01, 0x00, 0x0b, 0x24, 0x02, 0x01, 0x02, 0x02,
+  0x10, 0x01, 0x80, 0xbb, 0x00, 0x09, 0x05, 0x01, 0x01, 0xc0, 0x00, 0x01, 0x00, 0x00, 0x07, 0x25,
+  0x01, 0x00, 0x00, 0x00, 0x00, 0x09, 0x04, 0x02, 0x00, 0x02, 0xff, 0x00, 0x00, 0x00, 0x07, 0x05,
+  0x82, 0x02, 0x40, 0x00, 0x00, 0x07, 0x05, 0x02, 0x02, 0x40, 0x00, 0x00, 0x09, 0x04, 0x03, 0x00,
+  0x01, 0x03, 0x00, 0x00, 0x00, 0x09, 0x21, 0x11, 0x01, 0x00, 0x01, 0x22, 0x1b, 0x00, 0x07, 0x05,
+  0x83, 0x03, 0x01, 0x00, 0x01
+};
+#endif /* USE_USBD_COMPOSITE */
+
+static void check_cfg(const uint8_t *cfg, uint16_t len)
+{
+  uint16_t i;
+
+  CHECK_EQ(len, sizeof(ref_cfg));
+  CHECK_EQ(cfg[2] | (cfg[3] << 8), sizeof(ref_cfg));
+  for (i = 0U; (i < len) && (i < sizeof(ref_cfg)); i++)
+  {
+    CHECK_MSG(cfg[i] == ref_cfg[i], "byte %u: 0x%02x, expected 0x%02x", i, cfg[i], ref_cfg[i]);
+  }
+}
+
+#ifndef USE_USBD_COMPOSITE
+static void test_single(void)
+{
+  uint16_t len = 0U;
+  uint8_t *cfg = USBD_AUDIO.GetFSConfigDescriptor(&len);
+
+  check_cfg(cfg, len);
+  CHECK_EQ(USB_AUDIO_CONFIG_DESC_SIZ, sizeof(ref_cfg));
+}
+
+static int8_t fops_init(uint32_t freq, uint32_t vol, uint32_t options) { return 0; }
+static int8_t fops_deinit(uint32_t options) { return 0; }
+static int8_t fops_cmd(uint8_t *pbuf, uint32_t size, uint8_t cmd) { return 0; }
+static int8_t fops_ctl(uint8_t cmd) { return 0; }
+static int8_t fops_get_state(void) { return 0; }
+
+static USBD_AUDIO_ItfTypeDef fops =
+{
+  fops_init, fops_deinit, fops_cmd, fops_ctl, fops_ctl, fops_cmd, fops_get_state
+};
+
+/* The same bytes must come back through GET_DESCRIPTOR after enumeration */
+static void test_get_descriptor(void)
+{
+  static USBD_HandleTypeDef dev;
+  uint8_t buf[256];
+  int n;
+
+  USBD_Host_Reset();
+  USBD_Init(&dev, (USBD_DescriptorsTypeDef *)&USBD_Host_Desc, DEVICE_FS);
+  USBD_RegisterClass(&dev, &USBD_AUDIO);
+  USBD_AUDIO_RegisterInterface(&dev, &fops);
+  USBD_Host_Enumerate(&dev);
+  CHECK_EQ(dev.dev_state, USBD_STATE_CONFIGURED);
+
+  n = USBD_Host_Control(&dev, 0x80U, USB_REQ_GET_DESCRIPTOR, USB_DESC_TYPE_CONFIGURATION << 8,
+                        0U, sizeof(buf), buf);
+  CHECK_EQ(n, sizeof(ref_cfg));
+  CHECK(memcmp(buf, ref_cfg, sizeof(ref_cfg)) == 0);
+}
+#else
+static void test_composite(void)
+{
+  static USBD_HandleTypeDef dev;
+  /* endpoint assignment of USB_DEVICE/App/usb_device.c */
+  static uint8_t audio_ep[] = { AUDIO_OUT_EP };
+  static uint8_t vendor_ep[] = { VENDOR_IN_EP, VENDOR_OUT_EP };
+  static uint8_t hid_ep[] = { HID_EPIN_ADDR };
+  uint16_t len = 0U;
+  uint8_t *cfg;
+
+  USBD_Host_Reset();
+  USBD_Init(&dev, (USBD_DescriptorsTypeDef *)&USBD_Host_Desc, DEVICE_FS);
+  CHECK_EQ(USBD_RegisterClassComposite(&dev, USBD_AUDIO_CLASS, CLASS_TYPE_AUDIO, audio_ep), USBD_OK);
+  CHECK_EQ(USBD_RegisterClassComposite(&dev, USBD_VENDOR_CLASS, CLASS_TYPE_VENDOR, vendor_ep), USBD_OK);
+  CHECK_EQ(USBD_RegisterClassComposite(&dev, USBD_HID_CLASS, CLASS_TYPE_HID, hid_ep), USBD_OK);
+
+  cfg = USBD_CMPSIT.GetFSConfigDescriptor(&len);
+  check_cfg(cfg, len);
+}
+#endif /* USE_USBD_COMPOSITE */
+
+int main(void)
+{
+#ifndef USE_USBD_COMPOSITE
+  test_single();
+  test_get_descriptor();
+  return test_summary("usb_desc");
+#else
+  test_composite();
+  return test_summary("usb_desc_composite");
+#endif
+}
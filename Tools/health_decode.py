@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+"""Decode the binary task health snapshots (RTT channel 2).
+
+Record layout: Core/Inc/health.h (little-endian, one snapshot per second).
+Capture the channel with e.g.
+
+    JLinkRTTLogger -Device STM32F411CE -If SWD -Speed 4000 -RTTChannel 2 health.bin
+    health_decode.py health.bin
+
+or pipe a live capture into it with "-" as the file name.
+"""
+import argparse
+import struct
+import sys
+
+SYNC = 0xA5
+REC_SNAPSHOT = 0x01
+REC_NAME = 0x02
+
+HEADER = struct.Struct("<BBBBIIIIIHHHBBIHH")
+TASK = struct.Struct("<BBBBHHI")
+NAME = struct.Struct("<BBBB16s")
+STATES = ["Running", "Ready", "Blocked", "Suspended", "Deleted"]
+WARNINGS = ["task stack", "heap minimum", "heap fragmented", "MSP", "malloc failed",
+            "USB pool allocation failed"]
+CPU_HZ = 96e6
+
+
+def read_exact(f, n):
+    data = f.read(n)
+    if len(data) < n:
+        raise EOFError
+    return data
+
+
+def print_snapshot(hdr, tasks, names):
+    (_, _, ntasks, dropped, tick, run_delta, heap_free, heap_min, heap_largest,
+     heap_blocks, msp_used, msp_size, warn, malloc_failed, cycles, pool_size, pool_high) = hdr
+    print("tick %u  snapshot %.1f us  dropped %u" % (tick, cycles / CPU_HZ * 1e6, dropped))
+    print("  heap free %u (min %u, largest block %u in %u blocks)  malloc failed %u"
+          % (heap_free, heap_min, heap_largest, heap_blocks, malloc_failed))
+    print("  MSP used %u of %u  USB pool high-water %u of %u"
+          % (msp_used, msp_size, pool_high, pool_size))
+    if warn:
+        print("  WARNING: " + ", ".join(w for i, w in enumerate(WARNINGS) if warn & (1 << i)))
+    print("  Task             State      Prio  Stack   Usage")
+    for number, state, prio, base, hwm, _, delta in sorted(tasks):
+        name = names.get(number, "#%u" % number)
+        usage = 100.0 * delta / run_delta if run_delta else 0.0
+        prio_text = "%u" % prio if prio == base else "%u/%u" % (prio, base)
+        print("  %-16s %-10s %-5s %-7u %5.2f%%"
+              % (name, STATES[state] if state < len(STATES) else state,
+                 prio_text, hwm, usage))
+
+
+def decode(f):
+    names = {}
+    while True:
+        try:
+            sync = read_exact(f, 1)[0]
+            if sync != SYNC:
+                continue
+            kind = read_exact(f, 1)[0]
+            if kind == REC_NAME:
+                _, _, number, _, name = NAME.unpack(bytes([sync, kind]) + read_exact(f, NAME.size - 2))
+                names[number] = name.split(b"\0")[0].decode(errors="replace")
+            elif kind == REC_SNAPSHOT:
+                hdr = HEADER.unpack(bytes([sync, kind]) + read_exact(f, HEADER.size - 2))
+                data = read_exact(f, hdr[2] * TASK.size)
+                tasks = [TASK.unpack_from(data, i * TASK.size) for i in range(hdr[2])]
+                print_snapshot(hdr, tasks, names)
+        except EOFError:
+            return
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="raw RTT channel 2 capture, - for stdin")
+    args = parser.parse_args()
+
+    if args.input == "-":
+        decode(sys.stdin.buffer)
+    else:
+        with open(args.input, "rb") as f:
+            decode(f)
+
+
+if __name__ == "__main__":
+    main()
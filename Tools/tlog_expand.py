@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""Expand the tokenized TLOG records into text, merging the per-context channels.
+
+Record layout: Core/Inc/tlog.h. Each record is the address of the format
+string, a DWT timestamp and one 32-bit word per conversion in the format.
+The format strings (and %s arguments) are read back from the firmware ELF.
+
+Every writer context has its own RTT up-channel ("TLog USB", "TLog DMA",
+"TLog ISR", "TLog main" and one per task name; RTT Viewer lists the channel
+numbers). Capture each channel to its own file and pass them all, the
+records are merged by timestamp:
+
+    JLinkRTTLogger -Device STM32F411CE -If SWD -Speed 4000 -RTTChannel 3 usb.bin
+    JLinkRTTLogger -Device STM32F411CE -If SWD -Speed 4000 -RTTChannel 4 dma.bin
+    tlog_expand.py MDK-ARM/STM32F411CEU6/STM32F411CEU6.axf usb.bin dma.bin
+
+Use "-" as the capture name to read a single live stream from stdin. The ELF
+must be the image that produced the capture, otherwise the addresses are wrong.
+"""
+import argparse
+import heapq
+import os
+import re
+import struct
+import sys
+
+SHT_PROGBITS = 1
+SHF_ALLOC = 0x2
+
+CONV = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(?:hh|h|ll|l|z|j|t)?([diouxXcsp%])")
+
+
+class Image:
+    """Loadable sections of a little-endian ELF32 file."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+            sys.exit("%s: not a little-endian ELF32 file" % path)
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            _, kind, flags, addr, offset, size = struct.unpack_from("<IIIIII", data, shoff + i * shentsize)
+            if kind == SHT_PROGBITS and flags & SHF_ALLOC and size:
+                self.sections.append((addr, data[offset:offset + size]))
+
+    def string(self, addr):
+        for base, blob in self.sections:
+            if base <= addr < base + len(blob):
+                end = blob.find(b"\0", addr - base)
+                return blob[addr - base:end if end >= 0 else None].decode(errors="replace")
+        return None
+
+
+def conversions(fmt):
+    return [m for m in CONV.finditer(fmt) if m.group(4) != "%"]
+
+
+def expand(image, fmt, args):
+    """Format with the C conversion rules the target would have used."""
+    values = iter(args)
+
+    def one(m):
+        flags, width, prec, conv = m.groups()
+        if conv == "%":
+            return "%"
+        v = next(values)
+        spec = "%" + flags + width + ("." + prec if prec else "")
+        if conv in "di":
+            return (spec + "d") % (v - (1 << 32) if v & 0x80000000 else v)
+        if conv == "u":
+            return (spec + "d") % v
+        if conv == "c":
+            return (spec + "c") % chr(v & 0xFF)
+        if conv == "p":
+            return (spec + "s") % ("0x%08x" % v)
+        if conv == "s":
+            text = image.string(v)
+            return (spec + "s") % (text if text is not None else "<0x%08x>" % v)
+        return (spec + conv) % v
+
+    return CONV.sub(one, fmt)
+
+
+def records(f):
+    while True:
+        head = f.read(8)
+        if len(head) < 8:
+            return
+        yield struct.unpack("<II", head)
+
+
+def stream(image, f, label, cache):
+    """Yield (cycles, label, text) for one channel, timestamps unwrapped."""
+    last = None
+    high = 0
+    for addr, ts in records(f):
+        if addr not in cache:
+            fmt = image.string(addr)
+            if fmt is None:
+                sys.exit("%s: unknown format address 0x%08x, wrong ELF or lost framing"
+                         % (label, addr))
+            cache[addr] = (fmt, len(conversions(fmt)))
+        fmt, nargs = cache[addr]
+        data = f.read(4 * nargs)
+        if len(data) < 4 * nargs:
+            return
+        # DWT->CYCCNT wraps every 44.7 s at 96 MHz; a channel silent for
+        # longer than that loses one wrap
+        if last is not None and ts < last:
+            high += 1 << 32
+        last = ts
+        yield high + ts, label, expand(image, fmt, struct.unpack("<%dI" % nargs, data))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="firmware image (.axf/.elf)")
+    parser.add_argument("input", nargs="+", help="raw RTT channel captures, - for stdin")
+    parser.add_argument("--clock", type=float, default=96e6, help="DWT clock in Hz")
+    args = parser.parse_args()
+
+    image = Image(args.elf)
+    cache = {}
+    labels = [os.path.splitext(os.path.basename(name))[0] for name in args.input]
+    streams = [stream(image, sys.stdin.buffer if name == "-" else open(name, "rb"), label, cache)
+               for name, label in zip(args.input, labels)]
+    width = max(len(label) for label in labels)
+    for cycles, label, text in heapq.merge(*streams):
+        print("%12.6f  %-*s  %s" % (cycles / args.clock, width, label, text))
+        sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()
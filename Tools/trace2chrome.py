@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Convert the binary FreeRTOS trace (RTT channel 1) to Chrome trace JSON.
+
+Record layout: Core/Inc/trace.h (8 byte little-endian records, DWT timestamps).
+Build the firmware with TRACE_ENABLE=1 and capture the channel from reset,
+e.g. with
+
+    JLinkRTTLogger -Device STM32F411CE -If SWD -Speed 4000 -RTTChannel 1 trace.bin
+    trace2chrome.py trace.bin trace.json
+
+then open trace.json in chrome://tracing or https://ui.perfetto.dev.
+Tasks and ISRs show up as threads, queue and notify events as instants.
+"""
+import argparse
+import json
+import struct
+import sys
+
+HEADER = struct.Struct("<BBHI")
+NAME_LEN = 16                   # configMAX_TASK_NAME_LEN
+
+TRC_START = 0x01
+TRC_TASK_CREATE = 0x02
+TRC_TASK_IN = 0x03
+TRC_TASK_OUT = 0x04
+TRC_ISR_ENTER = 0x05
+TRC_ISR_EXIT = 0x06
+
+INSTANT = {
+    0x07: "queue send",
+    0x08: "queue send failed",
+    0x09: "queue receive",
+    0x0A: "queue receive failed",
+    0x0B: "queue block send",
+    0x0C: "queue block receive",
+    0x0D: "notify",
+    0x0E: "notify take",
+    0x0F: "notify block",
+}
+
+ISR_NAMES = ["OTG_FS", "DMA1_Stream4", "TIM5", "EXTI"]  # RTStats_IsrTypeDef
+ISR_TID = 1000
+PID = 1
+
+
+def records(data):
+    """Yield (type, id, arg, ts, extra) from the raw channel bytes."""
+    pos = 0
+    while pos + HEADER.size <= len(data):
+        kind, ident, arg, ts = HEADER.unpack_from(data, pos)
+        pos += HEADER.size
+        extra = None
+        if kind == TRC_START:
+            (extra,) = struct.unpack_from("<I", data, pos)
+            pos += 4
+        elif kind == TRC_TASK_CREATE:
+            extra = data[pos:pos + NAME_LEN].split(b"\0")[0].decode(errors="replace")
+            pos += NAME_LEN
+        elif kind not in (TRC_TASK_IN, TRC_TASK_OUT, TRC_ISR_ENTER, TRC_ISR_EXIT) \
+                and kind not in INSTANT:
+            sys.exit("bad record type 0x%02x at offset %d" % (kind, pos - HEADER.size))
+        yield kind, ident, arg, ts, extra
+
+
+def convert(data):
+    events = []
+    hz = 96e6
+    last = None
+    high = 0
+
+    for i, name in enumerate(ISR_NAMES):
+        events.append({"ph": "M", "pid": PID, "tid": ISR_TID + i,
+                       "name": "thread_name", "args": {"name": "ISR " + name}})
+
+    for kind, ident, arg, ts, extra in records(data):
+        # DWT->CYCCNT wraps every 44.7 s at 96 MHz
+        if last is not None and ts < last:
+            high += 1 << 32
+        last = ts
+        us = (high + ts) * 1e6 / hz
+
+        if kind == TRC_START:
+            hz = float(extra)
+            high = 0
+            us = ts * 1e6 / hz
+            events.append({"ph": "M", "pid": PID, "name": "process_name",
+                           "args": {"name": "STM32F411 @ %d MHz" % (extra // 1000000)}})
+        elif kind == TRC_TASK_CREATE:
+            events.append({"ph": "M", "pid": PID, "tid": ident,
+                           "name": "thread_name", "args": {"name": extra}})
+        elif kind in (TRC_TASK_IN, TRC_TASK_OUT):
+            events.append({"ph": "B" if kind == TRC_TASK_IN else "E", "pid": PID,
+                           "tid": ident, "ts": us, "name": "running"})
+        elif kind in (TRC_ISR_ENTER, TRC_ISR_EXIT):
+            name = ISR_NAMES[ident] if ident < len(ISR_NAMES) else "ISR %d" % ident
+            events.append({"ph": "B" if kind == TRC_ISR_ENTER else "E", "pid": PID,
+                           "tid": ISR_TID + ident, "ts": us, "name": name})
+        else:
+            # queue events carry no task number and go to tid 0
+            events.append({"ph": "i", "s": "t", "pid": PID, "tid": ident, "ts": us,
+                           "name": INSTANT[kind], "args": {"arg": "0x%04x" % arg}})
+    return events
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="raw RTT channel 1 capture")
+    parser.add_argument("output", help="Chrome trace JSON")
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as f:
+        events = convert(f.read())
+    with open(args.output, "w") as f:
+        json.dump({"traceEvents": events, "displayTimeUnit": "ns"}, f)
+    print("%d events" % len(events))
+
+
+if __name__ == "__main__":
+    main()
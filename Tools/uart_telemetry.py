@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""Read the telemetry stream over USART1 and write parameters.
+
+Frame layout: Core/Inc/uartlink.h. Every frame is COBS(payload | CRC-16)
+followed by 0x00; the payloads are the records and commands of
+Core/Inc/telemetry.h, printed the same way as usb_telemetry.py does.
+
+    uart_telemetry.py --port COM5                     print status records
+    uart_telemetry.py --port /dev/ttyUSB0 --period 50
+    uart_telemetry.py --port COM5 --set-baud 2000000  switch to 2 Mbaud, then read
+    uart_telemetry.py --port COM5 --get 3             read the current baud rate
+
+The link starts at 115200 baud after reset; --baud must match the firmware if
+it was switched before. Needs pyserial (pip install pyserial).
+"""
+import argparse
+import struct
+import sys
+
+import usb_telemetry as tlm
+
+DEFAULT_BAUD = 115200   # UARTLINK_BAUD
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE."""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_pos, code = 0, 1
+    for b in data:
+        if b == 0:
+            out[code_pos] = code
+            code_pos, code = len(out), 1
+            out.append(0)
+        else:
+            out.append(b)
+            code += 1
+            if code == 0xFF:
+                out[code_pos] = code
+                code_pos, code = len(out), 1
+                out.append(0)
+    out[code_pos] = code
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            return None
+        out += data[i:i + code - 1]
+        i += code - 1
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def frame(payload):
+    return cobs_encode(payload + struct.pack("<H", crc16(payload))) + b"\0"
+
+
+class Link:
+    def __init__(self, port):
+        self.port = port
+        self.buf = bytearray()
+        self.bad = 0
+
+    def send(self, payload):
+        self.port.write(frame(payload))
+
+    def payloads(self):
+        """Yield checked payloads; the first partial frame is dropped."""
+        synced = False
+        while True:
+            self.buf += self.port.read(max(1, self.port.in_waiting))
+            while True:
+                end = self.buf.find(b"\0")
+                if end < 0:
+                    break
+                raw, self.buf = bytes(self.buf[:end]), self.buf[end + 1:]
+                if not synced:
+                    synced = True
+                    continue
+                data = cobs_decode(raw)
+                if (data is None or len(data) < 3
+                        or struct.unpack_from("<H", data, len(data) - 2)[0] != crc16(data[:-2])):
+                    self.bad += 1
+                    print("-- bad frame (%d so far)" % self.bad)
+                    continue
+                yield data[:-2]
+
+    def records(self):
+        for data in self.payloads():
+            if len(data) == tlm.RECORD_SIZE and data[0] == tlm.SYNC:
+                yield data
+
+
+def set_baud(link, baud):
+    """Ask for a new baud rate and follow once it is acknowledged."""
+    link.send(tlm.command(tlm.PARAM_UART_BAUD, baud))
+    for rec in link.records():
+        if rec[1] != tlm.REC_ACK:
+            continue
+        _, _, _, _, param, status, _, value = tlm.ACK.unpack_from(rec)
+        if param != tlm.PARAM_UART_BAUD:
+            continue
+        if status != 0:
+            sys.exit("baud %d rejected (%s)" % (baud, tlm.ACK_TEXT.get(status, status)))
+        # the firmware switches after the ACK has left its buffer
+        link.port.flush()
+        link.port.baudrate = value
+        link.buf.clear()
+        print("-- switched to %d baud" % value)
+        return
+
+
+def main():
+    import serial
+
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--port", required=True, help="serial port, e.g. COM5 or /dev/ttyUSB0")
+    ap.add_argument("--baud", type=int, default=DEFAULT_BAUD, help="current link baud rate")
+    ap.add_argument("--set-baud", type=int, help="switch the link to this baud rate first")
+    tlm.add_param_args(ap)
+    args = ap.parse_args()
+
+    link = Link(serial.Serial(args.port, args.baud, timeout=1))
+    if args.set_baud is not None:
+        set_baud(link, args.set_baud)
+    for cmd in tlm.param_commands(args):
+        link.send(cmd)
+    tlm.print_records(link.records())
+
+
+if __name__ == "__main__":
+    main()
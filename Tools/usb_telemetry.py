@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""Read the telemetry stream of the vendor interface and write parameters.
+
+Record layout: Core/Inc/telemetry.h (32 byte little-endian records).
+
+    usb_telemetry.py                     print status records
+    usb_telemetry.py --period 50         set the report period (ms) first
+    usb_telemetry.py --enable 0          stop the reports
+    usb_telemetry.py --get 3             read a parameter (ACK carries the value)
+
+The same records and commands also run over USART1, see uart_telemetry.py.
+
+Needs pyusb (pip install pyusb) and, on Windows, a WinUSB driver bound to
+interface 2 (e.g. with Zadig). The audio and HID interfaces keep the OS driver.
+"""
+import argparse
+import struct
+import sys
+
+VID = 1155          # USBD_VID
+PID = 22336         # USBD_PID_FS
+EP_IN = 0x82        # VENDOR_IN_EP
+EP_OUT = 0x02       # VENDOR_OUT_EP
+
+SYNC = 0xA5
+CMD_SYNC = 0x5A
+CMD_GET = 0x5B
+RECORD_SIZE = 32
+REC_STATUS = 0x01
+REC_ACK = 0x02
+REC_HID = 0x03
+
+PARAM_PERIOD = 0x01
+PARAM_ENABLE = 0x02
+PARAM_UART_BAUD = 0x03
+
+STATUS = struct.Struct("<BBHIHhHH3II")
+ACK = struct.Struct("<BBHIBBHI")
+HID = struct.Struct("<BBHI6I")
+ACK_TEXT = {0: "ok", 1: "bad id", 2: "bad value"}
+CPU_HZ = 96e6
+
+
+def find_interface(dev):
+    for intf in dev.get_active_configuration():
+        if intf.bInterfaceClass == 0xFF:
+            return intf.bInterfaceNumber
+    sys.exit("no vendor interface, is the firmware built with USE_USBD_COMPOSITE?")
+
+
+def command(param, value=0, get=False):
+    return struct.pack("<BBI", CMD_GET if get else CMD_SYNC, param, value)
+
+
+def records(dev):
+    """Yield 32 byte records, resynchronising on the sync byte."""
+    import usb.core
+    buf = bytearray()
+    while True:
+        try:
+            buf += dev.read(EP_IN, 64, timeout=1000)
+        except usb.core.USBTimeoutError:
+            continue
+        while len(buf) >= RECORD_SIZE:
+            if buf[0] != SYNC or buf[1] not in (REC_STATUS, REC_ACK, REC_HID):
+                del buf[0]
+                continue
+            yield bytes(buf[:RECORD_SIZE])
+            del buf[:RECORD_SIZE]
+
+
+def add_param_args(ap):
+    ap.add_argument("--period", type=int, help="report period in ms (10..10000)")
+    ap.add_argument("--enable", type=int, choices=(0, 1), help="start/stop reports")
+    ap.add_argument("--get", type=int, action="append", default=[], metavar="ID",
+                    help="read parameter ID (repeatable)")
+
+
+def param_commands(args):
+    """Commands for the parameter options, in the order they should be sent."""
+    cmds = []
+    if args.period is not None:
+        cmds.append(command(PARAM_PERIOD, args.period))
+    if args.enable is not None:
+        cmds.append(command(PARAM_ENABLE, args.enable))
+    cmds += [command(param, get=True) for param in args.get]
+    return cmds
+
+
+def print_records(recs):
+    last_seq = None
+    for rec in recs:
+        seq = struct.unpack_from("<H", rec, 2)[0]
+        if last_seq is not None and seq != (last_seq + 1) & 0xFFFF:
+            print("-- lost %d record(s)" % ((seq - last_seq - 1) & 0xFFFF))
+        last_seq = seq
+
+        if rec[1] == REC_ACK:
+            _, _, _, tick, param, status, _, value = ACK.unpack_from(rec)
+            print("%10u ack param %d -> %u (%s)" % (tick, param, value, ACK_TEXT.get(status, status)))
+            continue
+
+        if rec[1] == REC_HID:
+            _, _, _, tick, reports, overflows, last, worst, avg, _ = HID.unpack_from(rec)
+            if reports or overflows:
+                print("%10u hid  %u report(s)  latency last %.0f max %.0f avg %.0f us  overflows %u"
+                      % (tick, reports, last / CPU_HZ * 1e6, worst / CPU_HZ * 1e6,
+                         avg / CPU_HZ * 1e6, overflows))
+            continue
+
+        (_, _, _, tick, fill, drift, cpu, dropped,
+         isr_usb, isr_dma, isr_tim5, heap) = STATUS.unpack_from(rec)
+        fill_txt = "  idle" if fill == 0xFFFF else "%6u" % fill
+        print("%10u fill %s B  drift %+6d ppm  cpu %5.1f%%  "
+              "isr usb %5.1f dma %5.1f tim5 %5.1f us  heap %5u  dropped %u"
+              % (tick, fill_txt, drift, cpu / 100.0,
+                 isr_usb / CPU_HZ * 1e6, isr_dma / CPU_HZ * 1e6, isr_tim5 / CPU_HZ * 1e6,
+                 heap, dropped))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    add_param_args(ap)
+    args = ap.parse_args()
+
+    import usb.core
+    import usb.util
+    dev = usb.core.find(idVendor=VID, idProduct=PID)
+    if dev is None:
+        sys.exit("device %04x:%04x not found" % (VID, PID))
+    intf = find_interface(dev)
+    usb.util.claim_interface(dev, intf)
+
+    # one command per packet: only the last command of a packet is acknowledged
+    for cmd in param_commands(args):
+        dev.write(EP_OUT, cmd)
+    print_records(records(dev))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+"""Replay a usbmon capture of the audio stream through the host build of the card.
+
+Takes the isochronous OUT packets and the interface/endpoint control requests
+(SET_INTERFACE, SET_CUR, ...) a real host sent to the card and plays them,
+with their original timing, into Tests/build/sim_audio: the unmodified USB
+core, usbd_audio.c and usbd_audio_if.c running against a virtual PCD and a
+virtual I2S DMA (Tests/host/audio_sim.h). Every other request of the capture
+(enumeration) is left out; the simulation enumerates on its own and selects
+alternate setting 1 before the first packet.
+
+The I2S clock runs --ppm away from the USB frame clock, so host/device clock
+drift, host scheduling jitter, dropped frames and bursts in the capture show
+up in the report as the buffered audio ahead of the read head, and as an
+overrun or underrun whenever the data played is not the next frame the host
+sent. The ring size and sample rate are those of the build.
+
+Capture on the host with either
+
+    cat /sys/kernel/debug/usb/usbmon/1u > audio.mon          (text, 1u format)
+    tshark -i usbmon1 -w audio.pcap                          (pcap, DLT 189/220)
+
+then
+
+    usbmon_replay.py audio.mon --device 5
+    usbmon_replay.py audio.pcap --device 5 --ppm 146 --csv occupancy.csv
+    usbmon_replay.py audio.mon --device 5 --events > audio.ev   (sim input only)
+
+The simulator is built with make -C Tests sim when it is missing.
+"""
+import argparse
+import os
+import struct
+import subprocess
+import sys
+
+REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SIM = os.path.join(REPO, "Tests", "build", "sim_audio")
+
+PCAP_MAGIC = {b"\xd4\xc3\xb2\xa1": "<", b"\xa1\xb2\xc3\xd4": ">"}
+DLT_USB_LINUX = 189
+DLT_USB_LINUX_MMAPPED = 220
+USB_HDR = struct.Struct("<QBBBBHbbqiiII8s")
+USB_HDR_MMAPPED_EXTRA = struct.Struct("<iiII")
+ISO_DESC = struct.Struct("<iIII")
+XFER_ISO = 0
+XFER_CTRL = 2
+
+
+class Event:
+    """One thing the host did, in microseconds from the start of the capture."""
+
+    def __init__(self, ts, kind, value):
+        self.ts = ts
+        self.kind = kind          # "out" (packet length) or "ctrl" (setup fields, data)
+        self.value = value
+
+    def line(self, t0):
+        if self.kind == "out":
+            return "%u out %u" % (self.ts - t0, self.value)
+        fields, data = self.value
+        return "%u ctrl 0x%02x 0x%02x 0x%04x 0x%04x %u%s" % (
+            (self.ts - t0,) + fields + ("".join(" 0x%02x" % b for b in data),))
+
+
+def setup_event(ts, setup, data):
+    """A control request to an interface or endpoint, None for the rest."""
+    fields = struct.unpack("<BBHHH", setup)
+    if (fields[0] & 0x1F) not in (0x01, 0x02):
+        return None
+    return Event(ts, "ctrl", (fields, bytes(data) if not fields[0] & 0x80 else b""))
+
+
+def iso_packets(ts_complete, lengths):
+    """Spread the packets of one completed URB over the 1 ms frames before it."""
+    n = len(lengths)
+    return [Event(ts_complete - (n - 1 - i) * 1000, "out", length)
+            for i, length in enumerate(lengths)]
+
+
+def parse_text(f, device):
+    """usbmon 1u text format (Documentation/usb/usbmon.rst)."""
+    events = []
+    for line in f:
+        words = line.decode(errors="replace").split()
+        if len(words) < 5:
+            continue
+        ts, kind, addr = int(words[1]), words[2], words[3].split(":")
+        if len(addr) < 4 or (device is not None and int(addr[2]) != device):
+            continue
+        if addr[0] == "Co" and kind == "S" and words[4] == "s":
+            setup = bytes(int(w, 16) for w in words[5:7]) + b"".join(
+                struct.pack("<H", int(w, 16)) for w in words[7:10])
+            # OUT data, if captured: length "=" then words of up to 4 bytes
+            data = b""
+            if len(words) > 11 and words[11] == "=":
+                data = bytes.fromhex("".join(words[12:]))
+            ev = setup_event(ts, setup, data)
+            if ev:
+                events.append(ev)
+        elif addr[0] == "Zo" and kind == "C":
+            # status:interval:start_frame, then count and status:offset:length
+            ndesc = int(words[5])
+            lengths = [int(w.split(":")[2]) for w in words[6:6 + ndesc]]
+            events.extend(iso_packets(ts, lengths))
+    return events
+
+
+def parse_pcap(f, device):
+    """Linux usbmon pcap, with (220) or without (189) the iso descriptors."""
+    magic = f.read(4)
+    endian = PCAP_MAGIC.get(magic)
+    if endian is None:
+        raise SystemExit("not a pcap file (pcapng is not supported, convert with editcap -F pcap)")
+    _, _, _, _, _, linktype = struct.unpack(endian + "HHiIII", f.read(20))
+    if linktype not in (DLT_USB_LINUX, DLT_USB_LINUX_MMAPPED):
+        raise SystemExit("link type %u is not a usbmon capture" % linktype)
+
+    events = []
+    while True:
+        rec = f.read(16)
+        if len(rec) < 16:
+            break
+        sec, usec, incl, _ = struct.unpack(endian + "IIII", rec)
+        data = f.read(incl)
+        (_, kind, xfer, epnum, devnum, _, flag_setup, _, _, _, _, length, _,
+         setup) = USB_HDR.unpack_from(data)
+        ts = sec * 1000000 + usec
+        if device is not None and devnum != device:
+            continue
+        pos = USB_HDR.size
+        if linktype == DLT_USB_LINUX_MMAPPED:
+            _, _, _, ndesc = USB_HDR_MMAPPED_EXTRA.unpack_from(data, pos)
+            pos += USB_HDR_MMAPPED_EXTRA.size
+        else:
+            ndesc = struct.unpack_from("<ii", setup)[1]
+
+        if xfer == XFER_CTRL and kind == ord("S") and flag_setup == 0:
+            ev = setup_event(ts, setup, data[pos:])
+            if ev:
+                events.append(ev)
+        elif xfer == XFER_ISO and kind == ord("C") and not (epnum & 0x80) and ndesc > 0:
+            if linktype == DLT_USB_LINUX_MMAPPED:
+                lengths = [ISO_DESC.unpack_from(data, pos + i * ISO_DESC.size)[2]
+                           for i in range(ndesc)]
+            else:
+                lengths = [length // ndesc] * ndesc
+            events.extend(iso_packets(ts, lengths))
+    return events
+
+
+def run_sim(events, ppm, csv_path, sim):
+    """Feed the events to sim_audio -r - and return its exit status."""
+    if not os.path.exists(sim):
+        subprocess.check_call(["make", "-C", os.path.join(REPO, "Tests"), "sim"])
+    cmd = [sim, "-r", "-", "-p", repr(ppm)]
+    if csv_path:
+        cmd += ["-c", csv_path]
+    proc = subprocess.Popen(cmd, stdin=subprocess.PIPE, universal_newlines=True)
+    t0 = events[0].ts
+    proc.communicate("".join(e.line(t0) + "\n" for e in events))
+    return proc.returncode
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", help="usbmon text (1u) or pcap capture, - for text on stdin")
+    parser.add_argument("--device", type=int, help="USB device address of the card (default: all)")
+    parser.add_argument("--ppm", type=float, default=0.0,
+                        help="I2S clock error against the USB frame clock (ppm)")
+    parser.add_argument("--csv", help="write the per-ms occupancy timeline to this file")
+    parser.add_argument("--sim", default=SIM, help="simulator binary (default: %(default)s)")
+    parser.add_argument("--events", action="store_true",
+                        help="print the simulator input instead of running it")
+    args = parser.parse_args()
+
+    if args.capture == "-":
+        events = parse_text(sys.stdin.buffer, args.device)
+    else:
+        with open(args.capture, "rb") as f:
+            is_pcap = f.read(4) in PCAP_MAGIC
+            f.seek(0)
+            events = parse_pcap(f, args.device) if is_pcap else parse_text(f, args.device)
+    if not any(e.kind == "out" for e in events):
+        raise SystemExit("no isochronous OUT packets in the capture")
+    events.sort(key=lambda e: e.ts)
+
+    if args.events:
+        t0 = events[0].ts
+        sys.stdout.writelines(e.line(t0) + "\n" for e in events)
+        return 0
+    return run_sim(events, args.ppm, args.csv, args.sim)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -25,9 +25,15 @@
 #include "usbd_desc.h"
 #include "usbd_audio.h"
 #include "usbd_audio_if.h"
+#ifdef USE_USBD_COMPOSITE
+#include "usbd_composite_builder.h"
+#include "usbd_vendor.h"
+#include "usbd_vendor_if.h"
+#include "usbd_hid.h"
+#endif /* USE_USBD_COMPOSITE */
 
 /* USER CODE BEGIN Includes */
-
+#include "bootprof.h"
 /* USER CODE END Includes */
 
 /* USER CODE BEGIN PV */
@@ -43,6 +49,13 @@
 /* USB Device Core handle declaration. */
 USBD_HandleTypeDef hUsbDeviceFS;
 
+#ifdef USE_USBD_COMPOSITE
+/* Endpoint addresses of each class instance, kept by the core after registration */
+static uint8_t AUDIO_EpAdd_Inst[1] = {AUDIO_OUT_EP};
+static uint8_t VENDOR_EpAdd_Inst[2] = {VENDOR_IN_EP, VENDOR_OUT_EP};
+static uint8_t HID_EpAdd_Inst[1] = {HID_EPIN_ADDR};
+#endif /* USE_USBD_COMPOSITE */
+
 /*
  * -- Insert your variables declaration here --
  */
@@ -72,6 +85,33 @@ void MX_USB_DEVICE_Init(void)
   {
     Error_Handler();
   }
+#ifdef USE_USBD_COMPOSITE
+  /* Interfaces 0-1: speaker, interface 2: vendor telemetry/control,
+     interface 3: HID media keys */
+  if (USBD_RegisterClassComposite(&hUsbDeviceFS, USBD_AUDIO_CLASS, CLASS_TYPE_AUDIO, AUDIO_EpAdd_Inst) != USBD_OK)
+  {
+    Error_Handler();
+  }
+  if (USBD_RegisterClassComposite(&hUsbDeviceFS, USBD_VENDOR_CLASS, CLASS_TYPE_VENDOR, VENDOR_EpAdd_Inst) != USBD_OK)
+  {
+    Error_Handler();
+  }
+  if (USBD_RegisterClassComposite(&hUsbDeviceFS, USBD_HID_CLASS, CLASS_TYPE_HID, HID_EpAdd_Inst) != USBD_OK)
+  {
+    Error_Handler();
+  }
+  /* RegisterInterface stores the fops at pdev->classId, select the instance first */
+  if ((USBD_CMPSIT_SetClassID(&hUsbDeviceFS, CLASS_TYPE_AUDIO, 0) == 0xFFU) ||
+      (USBD_AUDIO_RegisterInterface(&hUsbDeviceFS, &USBD_AUDIO_fops_FS) != USBD_OK))
+  {
+    Error_Handler();
+  }
+  if ((USBD_CMPSIT_SetClassID(&hUsbDeviceFS, CLASS_TYPE_VENDOR, 0) == 0xFFU) ||
+      (USBD_VENDOR_RegisterInterface(&hUsbDeviceFS, &USBD_VENDOR_fops_FS) != USBD_OK))
+  {
+    Error_Handler();
+  }
+#else
   if (USBD_RegisterClass(&hUsbDeviceFS, &USBD_AUDIO) != USBD_OK)
   {
     Error_Handler();
@@ -80,13 +120,14 @@ void MX_USB_DEVICE_Init(void)
   {
     Error_Handler();
   }
+#endif /* USE_USBD_COMPOSITE */
   if (USBD_Start(&hUsbDeviceFS) != USBD_OK)
   {
     Error_Handler();
   }
 
   /* USER CODE BEGIN USB_DEVICE_Init_PostTreatment */
-
+  BootProf_Mark(BOOT_MS_USB);
   /* USER CODE END USB_DEVICE_Init_PostTreatment */
 }
 
@@ -22,7 +22,9 @@
 #include "usbd_audio_if.h"
 
 /* USER CODE BEGIN INCLUDE */
-
+#include "tlog.h"
+#include "settings.h"
+#include "bootprof.h"
 /* USER CODE END INCLUDE */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -153,8 +155,11 @@ USBD_AUDIO_ItfTypeDef USBD_AUDIO_fops_FS =
 static int8_t AUDIO_Init_FS(uint32_t AudioFreq, uint32_t Volume, uint32_t options)
 {
   /* USER CODE BEGIN 0 */
+  BootProf_Mark(BOOT_MS_ENUM);   // SET_CONFIGURATION
+  // 恢复保存的静音状态: GET_CUR如实返回, 开始播放时按它暂停DMA
+  USBD_AUDIO_SetMute(&hUsbDeviceFS, Settings_GetMute());
   UNUSED(AudioFreq);
-  UNUSED(Volume);
+  UNUSED(Volume);   // 特征单元只有静音控制, 音量由主机调节
   UNUSED(options);
   return (USBD_OK);
   /* USER CODE END 0 */
@@ -184,14 +189,29 @@ static int8_t AUDIO_AudioCmd_FS(uint8_t* pbuf, uint32_t size, uint8_t cmd)
 {
   /* USER CODE BEGIN 2 */
   extern void AudioCard_Play(uint16_t* buff, uint16_t size);
+  extern void AudioCard_Resync(uint16_t* buff, uint16_t size);
+  extern void AudioDMA_Pause(void);
   switch(cmd)
   {
     case AUDIO_CMD_START:
+    TLOG("audio: start, %u bytes, mute %u", size, Settings_GetMute());
+    BootProf_Mark(BOOT_MS_AUDIO);
     AudioCard_Play((uint16_t*)pbuf, size);
+    if (Settings_GetMute() != 0U)
+    {
+      AudioDMA_Pause();
+    }
     break;
 
     case AUDIO_CMD_PLAY:
-    AudioCard_Play((uint16_t*)pbuf, size);
+    if (size != AUDIO_TOTAL_BUF_SIZE / 2U)
+    {
+      TLOG("audio: resync, play %u bytes", size);  // USBD_AUDIO_Sync corrected the drift
+    }
+    if (Settings_GetMute() == 0U)  // a restart would undo the mute pause
+    {
+      AudioCard_Resync((uint16_t*)pbuf, size);
+    }
     break;
   }
   UNUSED(pbuf);
@@ -224,15 +244,17 @@ static int8_t AUDIO_MuteCtl_FS(uint8_t cmd)
   /* USER CODE BEGIN 4 */
   extern void AudioDMA_Pause(void);
   extern void AudioDMA_Resume(void);
-  static uint8_t state=0;
-  if(state){
-	  AudioDMA_Pause();
-	  state = 0;
-  } else{
-	  AudioDMA_Resume();
-	  state = 1;
+  // cmd是SET_CUR(MUTE_CONTROL)的数据: 非0静音, 0取消静音
+  TLOG("audio: mute %u", cmd);
+  Settings_SetMute((cmd != 0U) ? 1U : 0U);
+  if (cmd != 0U)
+  {
+    AudioDMA_Pause();
+  }
+  else
+  {
+    AudioDMA_Resume();
   }
-  UNUSED(cmd);
   return (USBD_OK);
   /* USER CODE END 4 */
 }
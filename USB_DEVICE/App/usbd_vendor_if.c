@@ -0,0 +1,201 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : usbd_vendor_if.c
+  * @brief          : Vendor bulk interface: telemetry IN ring, control OUT.
+  ******************************************************************************
+  * @attention
+  *
+  * The IN direction is a single producer / single consumer byte ring:
+  *  - VENDOR_Transmit_FS() is the producer, called from one task only. It never
+  *    blocks: a write that does not fit is dropped and counted.
+  *  - VENDOR_TxReady_FS() is the consumer, called by the class from the OTG_FS
+  *    interrupt each time the bulk IN endpoint is free.
+  * Only the endpoint kick needs the OTG_FS interrupt masked, the audio DMA
+  * interrupt is never disabled.
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_vendor_if.h"
+
+/* USER CODE BEGIN INCLUDE */
+#include "telemetry.h"
+/* USER CODE END INCLUDE */
+
+/** @addtogroup STM32_USB_OTG_DEVICE_LIBRARY
+  * @brief Usb device library.
+  * @{
+  */
+
+/** @addtogroup USBD_VENDOR_IF
+  * @{
+  */
+
+/** @defgroup USBD_VENDOR_IF_Private_Variables USBD_VENDOR_IF_Private_Variables
+  * @brief Private variables.
+  * @{
+  */
+
+/* USER CODE BEGIN PRIVATE_VARIABLES */
+static uint8_t vendor_tx_ring[VENDOR_TX_RING_SIZE];
+static volatile uint32_t vendor_tx_head;    /* written by the producer only */
+static volatile uint32_t vendor_tx_tail;    /* written by the consumer only */
+static volatile uint32_t vendor_tx_dropped;
+/* USER CODE END PRIVATE_VARIABLES */
+
+/**
+  * @}
+  */
+
+/** @defgroup USBD_VENDOR_IF_Exported_Variables USBD_VENDOR_IF_Exported_Variables
+  * @brief Public variables.
+  * @{
+  */
+
+extern USBD_HandleTypeDef hUsbDeviceFS;
+
+/**
+  * @}
+  */
+
+/** @defgroup USBD_VENDOR_IF_Private_FunctionPrototypes USBD_VENDOR_IF_Private_FunctionPrototypes
+  * @brief Private functions declaration.
+  * @{
+  */
+
+static int8_t VENDOR_Init_FS(void);
+static int8_t VENDOR_DeInit_FS(void);
+static int8_t VENDOR_Receive_FS(uint8_t *pbuf, uint32_t len);
+static uint16_t VENDOR_TxReady_FS(uint8_t *pbuf, uint16_t len);
+
+/**
+  * @}
+  */
+
+USBD_VENDOR_ItfTypeDef USBD_VENDOR_fops_FS =
+{
+  VENDOR_Init_FS,
+  VENDOR_DeInit_FS,
+  VENDOR_Receive_FS,
+  VENDOR_TxReady_FS,
+};
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Initializes the VENDOR media low layer, called on SET_CONFIGURATION
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t VENDOR_Init_FS(void)
+{
+  /* USER CODE BEGIN 0 */
+  /* Discard what was queued while no host was reading */
+  vendor_tx_tail = vendor_tx_head;
+  return (USBD_OK);
+  /* USER CODE END 0 */
+}
+
+/**
+  * @brief  DeInitializes the VENDOR media low layer
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t VENDOR_DeInit_FS(void)
+{
+  /* USER CODE BEGIN 1 */
+  return (USBD_OK);
+  /* USER CODE END 1 */
+}
+
+/**
+  * @brief  Data received over the bulk OUT endpoint (OTG_FS interrupt context)
+  * @param  pbuf: Buffer of data received
+  * @param  len: Number of data received (in bytes)
+  * @retval USBD_OK if all operations are OK else USBD_FAIL
+  */
+static int8_t VENDOR_Receive_FS(uint8_t *pbuf, uint32_t len)
+{
+  /* USER CODE BEGIN 2 */
+  Telemetry_Command(pbuf, len);
+  return (USBD_OK);
+  /* USER CODE END 2 */
+}
+
+/**
+  * @brief  Bulk IN endpoint free: copy the next packet out of the ring
+  *         (OTG_FS interrupt context)
+  * @param  pbuf: Packet buffer
+  * @param  len: Packet buffer size (in bytes)
+  * @retval Number of bytes to send, 0 if the ring is empty
+  */
+static uint16_t VENDOR_TxReady_FS(uint8_t *pbuf, uint16_t len)
+{
+  /* USER CODE BEGIN 3 */
+  uint32_t tail = vendor_tx_tail;
+  uint32_t used = vendor_tx_head - tail;
+  uint32_t n = (used < len) ? used : len;
+
+  for (uint32_t i = 0U; i < n; i++)
+  {
+    pbuf[i] = vendor_tx_ring[(tail + i) & (VENDOR_TX_RING_SIZE - 1U)];
+  }
+  vendor_tx_tail = tail + n;
+
+  return (uint16_t)n;
+  /* USER CODE END 3 */
+}
+
+/**
+  * @brief  Queue data on the bulk IN endpoint, all or nothing, never blocks.
+  *         Single producer: call from one task only.
+  * @param  pbuf: Data to send
+  * @param  len: Number of bytes
+  * @retval USBD_OK if queued, USBD_BUSY if the ring had no room (data dropped)
+  */
+uint8_t VENDOR_Transmit_FS(const uint8_t *pbuf, uint32_t len)
+{
+  /* USER CODE BEGIN 4 */
+  uint32_t head = vendor_tx_head;
+
+  if ((VENDOR_TX_RING_SIZE - (head - vendor_tx_tail)) < len)
+  {
+    vendor_tx_dropped++;
+    return USBD_BUSY;
+  }
+
+  for (uint32_t i = 0U; i < len; i++)
+  {
+    vendor_tx_ring[(head + i) & (VENDOR_TX_RING_SIZE - 1U)] = pbuf[i];
+  }
+  /* Data must be in the ring before the consumer can see the new head */
+  __DMB();
+  vendor_tx_head = head + len;
+
+  /* Start the endpoint if it is idle, DataIn keeps it going afterwards */
+  HAL_NVIC_DisableIRQ(OTG_FS_IRQn);
+  (void)USBD_VENDOR_Kick(&hUsbDeviceFS);
+  HAL_NVIC_EnableIRQ(OTG_FS_IRQn);
+
+  return USBD_OK;
+  /* USER CODE END 4 */
+}
+
+/**
+  * @brief  Number of writes dropped because the ring was full
+  * @retval Dropped count since reset
+  */
+uint32_t VENDOR_GetDropped_FS(void)
+{
+  /* USER CODE BEGIN 5 */
+  return vendor_tx_dropped;
+  /* USER CODE END 5 */
+}
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
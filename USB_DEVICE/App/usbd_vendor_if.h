@@ -0,0 +1,79 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : usbd_vendor_if.h
+  * @brief          : Header for usbd_vendor_if.c file.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_VENDOR_IF_H__
+#define __USBD_VENDOR_IF_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_vendor.h"
+
+/** @addtogroup STM32_USB_OTG_DEVICE_LIBRARY
+  * @brief For Usb device.
+  * @{
+  */
+
+/** @defgroup USBD_VENDOR_IF USBD_VENDOR_IF
+  * @brief Usb vendor interface device module.
+  * @{
+  */
+
+/** @defgroup USBD_VENDOR_IF_Exported_Defines USBD_VENDOR_IF_Exported_Defines
+  * @brief Defines.
+  * @{
+  */
+
+/* Size of the IN ring, power of two */
+#define VENDOR_TX_RING_SIZE      1024U
+
+/**
+  * @}
+  */
+
+/** @defgroup USBD_VENDOR_IF_Exported_Variables USBD_VENDOR_IF_Exported_Variables
+  * @brief Public variables.
+  * @{
+  */
+
+/** VENDOR_IF Interface callback. */
+extern USBD_VENDOR_ItfTypeDef USBD_VENDOR_fops_FS;
+
+/**
+  * @}
+  */
+
+/** @defgroup USBD_VENDOR_IF_Exported_FunctionsPrototype USBD_VENDOR_IF_Exported_FunctionsPrototype
+  * @brief Public functions declaration.
+  * @{
+  */
+
+uint8_t VENDOR_Transmit_FS(const uint8_t *pbuf, uint32_t len);
+uint32_t VENDOR_GetDropped_FS(void);
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_VENDOR_IF_H__ */
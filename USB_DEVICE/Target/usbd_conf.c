@@ -27,7 +27,11 @@
 #include "usbd_audio.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "tlog.h"
+#ifdef USE_USBD_COMPOSITE
+#include "usbd_vendor.h"
+#include "usbd_hid.h"
+#endif /* USE_USBD_COMPOSITE */
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -37,6 +41,31 @@
 /* USER CODE BEGIN PV */
 /* Private variables ---------------------------------------------------------*/
 
+/* Class data pool: one block per class handle, each start aligned on
+ * USBD_POOL_ALIGN (16 bytes) so audio buffers placed first in their handle
+ * satisfy the DMA_MBURST_INC8 half-word burst of the I2S TX stream.
+ * Add the handle size of every class registered in usb_device.c here. */
+#define USBD_POOL_ROUND(n)   ((((uint32_t)(n)) + (USBD_POOL_ALIGN - 1U)) & ~(USBD_POOL_ALIGN - 1U))
+#ifdef USE_USBD_COMPOSITE
+#define USBD_POOL_SIZE       (USBD_POOL_ROUND(sizeof(USBD_AUDIO_HandleTypeDef)) + \
+                              USBD_POOL_ROUND(sizeof(USBD_VENDOR_HandleTypeDef)) + \
+                              USBD_POOL_ROUND(sizeof(USBD_HID_HandleTypeDef)))
+#else
+#define USBD_POOL_SIZE       (USBD_POOL_ROUND(sizeof(USBD_AUDIO_HandleTypeDef)))
+#endif /* USE_USBD_COMPOSITE */
+
+typedef struct
+{
+  uint32_t offset;
+  uint32_t size;      /* 0: descriptor unused */
+} USBD_PoolBlockTypeDef;
+
+__attribute__((aligned(USBD_POOL_ALIGN))) static uint8_t usbd_pool[USBD_POOL_SIZE];
+static USBD_PoolBlockTypeDef usbd_pool_blocks[USBD_POOL_MAX_BLOCKS];
+static uint32_t usbd_pool_used;
+static uint32_t usbd_pool_high_water;
+static uint32_t usbd_pool_failures;
+
 /* USER CODE END PV */
 
 PCD_HandleTypeDef hpcd_USB_OTG_FS;
@@ -59,6 +88,110 @@ USBD_StatusTypeDef USBD_Get_USB_Status(HAL_StatusTypeDef hal_status);
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief  Static pool allocation.
+  *         First-fit allocation of a USBD_POOL_ALIGN aligned block inside the
+  *         compile-time sized usbd_pool arena. Called from class Init, i.e.
+  *         from the OTG_FS interrupt only, so no locking is needed.
+  * @param  size: Size of allocated memory
+  * @retval Pointer to the block, NULL if the pool or block table is full
+  */
+void *USBD_static_malloc(uint32_t size)
+{
+  uint32_t need = USBD_POOL_ROUND(size);
+  uint32_t offset = 0U;
+  uint32_t free_idx = USBD_POOL_MAX_BLOCKS;
+  uint32_t i;
+
+  if (need == 0U)
+  {
+    return NULL;
+  }
+
+  for (i = 0U; i < USBD_POOL_MAX_BLOCKS; i++)
+  {
+    if ((usbd_pool_blocks[i].size == 0U) && (free_idx == USBD_POOL_MAX_BLOCKS))
+    {
+      free_idx = i;
+    }
+  }
+  if (free_idx == USBD_POOL_MAX_BLOCKS)
+  {
+    usbd_pool_failures++;
+    return NULL;
+  }
+
+  /* Move the candidate past every used block it overlaps until it fits */
+  i = 0U;
+  while (i < USBD_POOL_MAX_BLOCKS)
+  {
+    USBD_PoolBlockTypeDef *blk = &usbd_pool_blocks[i];
+
+    if ((blk->size != 0U) && (offset < (blk->offset + blk->size)) && (blk->offset < (offset + need)))
+    {
+      offset = blk->offset + blk->size;
+      i = 0U;
+    }
+    else
+    {
+      i++;
+    }
+  }
+  if ((offset + need) > USBD_POOL_SIZE)
+  {
+    usbd_pool_failures++;
+    return NULL;
+  }
+
+  usbd_pool_blocks[free_idx].offset = offset;
+  usbd_pool_blocks[free_idx].size = need;
+  usbd_pool_used += need;
+  if (usbd_pool_used > usbd_pool_high_water)
+  {
+    usbd_pool_high_water = usbd_pool_used;
+  }
+
+  return &usbd_pool[offset];
+}
+
+/**
+  * @brief  Static pool release
+  * @param  p: Pointer to allocated  memory address
+  * @retval None
+  */
+void USBD_static_free(void *p)
+{
+  for (uint32_t i = 0U; i < USBD_POOL_MAX_BLOCKS; i++)
+  {
+    if ((usbd_pool_blocks[i].size != 0U) && (p == &usbd_pool[usbd_pool_blocks[i].offset]))
+    {
+      usbd_pool_used -= usbd_pool_blocks[i].size;
+      usbd_pool_blocks[i].size = 0U;
+      return;
+    }
+  }
+}
+
+/**
+  * @brief  Report the static pool usage.
+  * @param  stats: Filled with arena size, bytes in use, high-water mark
+  *         and number of failed allocations
+  * @retval None
+  */
+void USBD_static_pool_stats(USBD_PoolStatsTypeDef *stats)
+{
+  stats->size = USBD_POOL_SIZE;
+  stats->used = usbd_pool_used;
+  stats->high_water = usbd_pool_high_water;
+  stats->failures = usbd_pool_failures;
+}
+
+/* The generated single-block USBD_static_malloc/USBD_static_free at the end
+   of this file are replaced by the pool above. Renaming them here keeps a
+   regenerated file linking; the unreferenced copies are removed by armlink. */
+#define USBD_static_malloc  USBD_static_malloc_generated
+#define USBD_static_free    USBD_static_free_generated
+
 /* USER CODE END 1 */
 
 /*******************************************************************************
@@ -223,6 +356,7 @@ void HAL_PCD_SuspendCallback(PCD_HandleTypeDef *hpcd)
   __HAL_PCD_GATE_PHYCLOCK(hpcd);
   /* Enter in STOP mode. */
   /* USER CODE BEGIN 2 */
+  TLOG("usb: suspend");
   if (hpcd->Init.low_power_enable)
   {
     /* Set SLEEPDEEP bit and SleepOnExit of Cortex System Control Register. */
@@ -244,7 +378,7 @@ void HAL_PCD_ResumeCallback(PCD_HandleTypeDef *hpcd)
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
 {
   /* USER CODE BEGIN 3 */
-
+  TLOG("usb: resume");
   /* USER CODE END 3 */
   USBD_LL_Resume((USBD_HandleTypeDef*)hpcd->pData);
 }
@@ -261,6 +395,7 @@ static void PCD_ISOOUTIncompleteCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
 void HAL_PCD_ISOOUTIncompleteCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
 {
+  TLOG("usb: iso out incomplete, ep %u, frame %u", epnum, USB_GetCurrentFrame(hpcd->Instance));
   USBD_LL_IsoOUTIncomplete((USBD_HandleTypeDef*)hpcd->pData, epnum);
 }
 
@@ -354,9 +489,17 @@ USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
   HAL_PCD_RegisterIsoOutIncpltCallback(&hpcd_USB_OTG_FS, PCD_ISOOUTIncompleteCallback);
   HAL_PCD_RegisterIsoInIncpltCallback(&hpcd_USB_OTG_FS, PCD_ISOINIncompleteCallback);
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
+  /* FIFO RAM is 320 words: RX 128 (one 192 byte ISO packet plus setup and
+     status entries), EP0 64, EP1 is OUT only so its TX FIFO gets the minimum,
+     EP2 (vendor bulk IN) two 64 byte packets, EP3 (HID interrupt IN) the
+     minimum for its 1 byte reports. */
   HAL_PCDEx_SetRxFiFo(&hpcd_USB_OTG_FS, 0x80);
   HAL_PCDEx_SetTxFiFo(&hpcd_USB_OTG_FS, 0, 0x40);
-  HAL_PCDEx_SetTxFiFo(&hpcd_USB_OTG_FS, 1, 0x80);
+  HAL_PCDEx_SetTxFiFo(&hpcd_USB_OTG_FS, 1, 0x10);
+#ifdef USE_USBD_COMPOSITE
+  HAL_PCDEx_SetTxFiFo(&hpcd_USB_OTG_FS, 2, 0x20);
+  HAL_PCDEx_SetTxFiFo(&hpcd_USB_OTG_FS, 3, 0x10);
+#endif /* USE_USBD_COMPOSITE */
   }
   return USBD_OK;
 }
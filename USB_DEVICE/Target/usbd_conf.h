@@ -35,7 +35,21 @@
 #include "stm32f4xx_hal.h"
 
 /* USER CODE BEGIN INCLUDE */
-
+/* Class data pool (usbd_conf.c USER CODE 1), kept in USER CODE sections so
+   a CubeMX regeneration does not drop it. */
+#define USBD_POOL_ALIGN     16U
+#define USBD_POOL_MAX_BLOCKS     4U
+
+/** Static class data pool usage (see USBD_static_pool_stats). */
+typedef struct
+{
+  uint32_t size;        /*!< Arena size in bytes               */
+  uint32_t used;        /*!< Bytes currently allocated          */
+  uint32_t high_water;  /*!< Maximum of used since reset        */
+  uint32_t failures;    /*!< Allocations that did not fit       */
+} USBD_PoolStatsTypeDef;
+
+void USBD_static_pool_stats(USBD_PoolStatsTypeDef *stats);
 /* USER CODE END INCLUDE */
 
 /** @addtogroup USBD_OTG_DRIVER
@@ -63,7 +77,11 @@
   */
 
 /*---------- -----------*/
+#ifdef USE_USBD_COMPOSITE
+#define USBD_MAX_NUM_INTERFACES     4U
+#else
 #define USBD_MAX_NUM_INTERFACES     1U
+#endif /* USE_USBD_COMPOSITE */
 /*---------- -----------*/
 #define USBD_MAX_NUM_CONFIGURATION     1U
 /*---------- -----------*/
@@ -76,6 +94,15 @@
 #define USBD_SELF_POWERED     1U
 /*---------- -----------*/
 #define USBD_AUDIO_FREQ     48000U
+/*---------- -----------*/
+#define USBD_CMPSIT_ACTIVATE_AUDIO     1U
+/*---------- -----------*/
+#define USBD_CMPSIT_ACTIVATE_VENDOR     1U
+/*---------- -----------*/
+#define USBD_CMPSIT_ACTIVATE_HID     1U
+/*---------- -----------*/
+/* HID report latency is measured in CPU cycles, DWT is started by Telemetry_Init() */
+#define USBD_HID_TIMESTAMP()     (DWT->CYCCNT)
 
 /****************************************/
 /* #define for FS and HS identification */